@@ -38,6 +38,7 @@ enum ClientDiagostic_enum {
     // Payload:
     //      0:2 - This diagnostic code
     //      2:1 - The upload record type (see "upload.h" for valid values)
+    //      3:3 - The file offset received so far (the server resends from this offset)
 
 // ----------------------------------------------------------------------------
 // OBC/J1708 queried data:
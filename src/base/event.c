@@ -137,6 +137,7 @@ Event_t *evSetEventGPS(Event_t *er, const GPS_t *gps)
         er->gpsHDOP         = gps->hdop;
         er->gpsVDOP         = gps->vdop;
         er->gpsQuality      = gps->fixtype;
+        er->gpsSatellites   = gps->satellites;
 #endif
     }
     return er;
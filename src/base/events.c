@@ -57,6 +57,7 @@
 #include "tools/bintools.h"
 #include "tools/strtools.h"
 #include "tools/utctools.h"
+#include "tools/gpstools.h"
 
 #include "base/propman.h"
 #include "base/pqueue.h"
@@ -130,6 +131,24 @@ static CustomDef_t *CustomEventTable[] = {
 
 // ----------------------------------------------------------------------------
 
+/* compiled event encoder */
+// When all fields of a format definition have a fixed encoded length, the payload
+// layout and format string are the same for every event.  These are determined once
+// for each definition, and events are then encoded by writing each field directly
+// into the packet payload (rather than through 'binFmtPrintf').
+typedef struct {
+    CustomDef_t     *custDef;       // compiled definition (null if not compiled)
+    UInt8           dataLen;        // payload length
+    char            dataFmt[(PACKET_MAX_FIELD_COUNT * 3) + 3]; // payload format
+} EventEncoder_t;
+
+static EventEncoder_t FixedEventEncoder[sizeof(FixedEventTable)/sizeof(FixedEventTable[0])];
+static EventEncoder_t CustomEventEncoder[sizeof(CustomEventTable)/sizeof(CustomEventTable[0])];
+
+static void _evCompileEncoder(EventEncoder_t *enc, CustomDef_t *custDef);
+
+// ----------------------------------------------------------------------------
+
 /* add a custom format field definition */
 // This should be done at startup initialization
 utBool evAddCustomDefinition(CustomDef_t *cd)
@@ -139,6 +158,7 @@ utBool evAddCustomDefinition(CustomDef_t *cd)
     for (i = 0; i < maxSize; i++) {
         if (!CustomEventTable[i]) {
             CustomEventTable[i] = cd;
+            _evCompileEncoder(&CustomEventEncoder[i], cd);
             return utTrue;
         }
     }
@@ -171,6 +191,31 @@ static CustomDef_t *_evGetCustomDefinitionForType(ClientPacketType_t hdrType)
     return (CustomDef_t*)0;
 }
 
+/* return the compiled encoder for the specified definition (null if not compiled) */
+static EventEncoder_t *_evGetEncoderForDefinition(CustomDef_t *custDef)
+{
+    int i, maxSize;
+    
+    /* fixed formats */
+    maxSize = sizeof(FixedEventEncoder)/sizeof(FixedEventEncoder[0]);
+    for (i = 0; i < maxSize; i++) {
+        if (FixedEventEncoder[i].custDef == custDef) {
+            return &FixedEventEncoder[i];
+        }
+    }
+    
+    /* custom formats */
+    maxSize = sizeof(CustomEventEncoder)/sizeof(CustomEventEncoder[0]);
+    for (i = 0; i < maxSize; i++) {
+        if (CustomEventEncoder[i].custDef == custDef) {
+            return &CustomEventEncoder[i];
+        }
+    }
+    
+    /* not compiled */
+    return (EventEncoder_t*)0;
+}
+
 /* return a 'template' packet for the specified custom type */
 utBool evGetCustomFormatPacket(Packet_t *pkt, ClientPacketType_t cstPktType)
 {
@@ -209,11 +254,65 @@ static Int32 _round(double D) { return (D>=0.0)?(Int32)(D+0.5):(Int32)(D-0.5); }
 
 #define LIMIT_INDEX(N,L)    (((N) >= (L))? ((L) - 1) : (N))
 
+/* encode numeric field ("%*u", "%*x", "%*i") */
+static void _evPrintInt(FmtBuffer_t *bf, utBool direct, const char *fmt, int len, UInt32 val)
+{
+    if (direct) {
+        UInt8 *d = BUFFER_DATA(bf);
+        if (len <= 4) {
+            int n;
+            for (n = len - 1; n >= 0; n--) {
+                d[n] = (UInt8)(val & 0xFF);
+                val >>= 8;
+            }
+        } else {
+            binEncodeInt32(d, len, val, (fmt[2] == 'i')? utTrue : utFalse);
+        }
+        binAdvanceFmtBuffer(bf, len);
+    } else {
+        binFmtPrintf(bf, fmt, len, val);
+    }
+}
+
+/* encode GPS point field ("%*g") */
+static void _evPrintGPS(FmtBuffer_t *bf, utBool direct, int len, const GPSPoint_t *gp)
+{
+    if (direct) {
+        if (len >= 8) {
+            gpsPointEncode8(BUFFER_DATA(bf), gp);
+        } else
+        if (len >= 6) {
+            gpsPointEncode6(BUFFER_DATA(bf), gp);
+        }
+        binAdvanceFmtBuffer(bf, len);
+    } else {
+        binFmtPrintf(bf, "%*g", len, gp);
+    }
+}
+
+/* encode space padded string field ("%*p") */
+static void _evPrintPad(FmtBuffer_t *bf, utBool direct, int len, const char *s)
+{
+    if (direct) {
+        char *d = (char*)BUFFER_DATA(bf);
+        int n = strLength(s, len);
+        memcpy(d, s, n);
+        for (; n < len; n++) { d[n] = ' '; }
+        binAdvanceFmtBuffer(bf, len);
+    } else {
+        binFmtPrintf(bf, "%*p", len, s);
+    }
+}
+
 /* create Packet from Event structure */
-static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType, CustomDef_t *custDef, UInt32 *evtSeq, Event_t *er)
+// If 'enc' is specified, the definition has been compiled, and all fields are 
+// written directly into the payload.
+static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType, CustomDef_t *custDef, 
+    const EventEncoder_t *enc, UInt32 *evtSeq, Event_t *er)
 {
     UInt8 fldLen  = (UInt8)custDef->fldLen;
     FieldDef_t *fld = custDef->fld;
+    utBool direct = enc? utTrue : utFalse;
     
     /* init packet */
     pktInit(pkt, pktType, (char*)0); // payload filled-in below
@@ -238,68 +337,68 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
             
             case FIELD_STATUS_CODE      : // hex
                 // 'len' had better be '2' (however, no checking is made at this point)
-                binFmtPrintf(bf, "%*x", len, (UInt32)er->statusCode);
+                _evPrintInt(bf, direct, "%*x", len, (UInt32)er->statusCode);
                 break;
             case FIELD_TIMESTAMP        :
                 // 'len' had better be '4' (however, no checking is made at this point)
                 ndx = LIMIT_INDEX(ndx, sizeof(er->timestamp)/sizeof(er->timestamp[0]));
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->timestamp[ndx]);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->timestamp[ndx]);
                 break;
             case FIELD_INDEX            :
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->index);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->index);
                 break;
                 
             case FIELD_GPS_POINT        :
                 // 'len' had better be '6' or '8' (however, no checking is made at this point)
                 ndx = LIMIT_INDEX(ndx, sizeof(er->gpsPoint)/sizeof(er->gpsPoint[0]));
-                binFmtPrintf(bf, "%*g", len, &(er->gpsPoint[ndx]));
+                _evPrintGPS(bf, direct, len, &(er->gpsPoint[ndx]));
                 break;
             case FIELD_GPS_AGE          :
                 if ((len == 1) && (er->gpsAge > 0xFF)) {
-                    binFmtPrintf(bf, "%*u", len, (UInt32)0xFF);
+                    _evPrintInt(bf, direct, "%*u", len, (UInt32)0xFF);
                 } else 
                 if ((len == 2) && (er->gpsAge > 0xFFFF)) {
-                    binFmtPrintf(bf, "%*u", len, (UInt32)0xFFFF);
+                    _evPrintInt(bf, direct, "%*u", len, (UInt32)0xFFFF);
                 } else {
-                    binFmtPrintf(bf, "%*u", len, (UInt32)er->gpsAge);
+                    _evPrintInt(bf, direct, "%*u", len, (UInt32)er->gpsAge);
                 }
                 break;
             case FIELD_SPEED            : // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->speedKPH * 10.0) : (UInt32)ROUND(er->speedKPH);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_HEADING          : // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->heading * 100.0) : (UInt32)ROUND(er->heading * 255.0/360.0);
                 fmt   = isHiRes? "%*u" : "%*x";
-                binFmtPrintf(bf, fmt, len, uVal32);
+                _evPrintInt(bf, direct, fmt, len, uVal32);
                 break;
             case FIELD_ALTITUDE         : // double +/-
                 iVal32 = isHiRes? (Int32)ROUND(er->altitude * 10.0) : (Int32)ROUND(er->altitude);
-                binFmtPrintf(bf, "%*i", len, iVal32);
+                _evPrintInt(bf, direct, "%*i", len, iVal32);
                 break;
             case FIELD_DISTANCE         : // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->distanceKM * 10.0) : (UInt32)ROUND(er->distanceKM);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_ODOMETER         : // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->odometerKM * 10.0) : (UInt32)ROUND(er->odometerKM);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
 
             case FIELD_SEQUENCE         : // hex (UInt32)
                 seqPos   = (UInt8)BUFFER_DATA_INDEX(bf);
                 seqLen   = (UInt8)len;
                 sequence = evtSeq? (((*evtSeq)++) & SEQUENCE_MASK(len)) : 0L;
-                binFmtPrintf(bf, "%*x", len, (UInt32)sequence);
+                _evPrintInt(bf, direct, "%*x", len, (UInt32)sequence);
                 break;
                 
             case FIELD_GEOFENCE_ID      : // hex (UInt32)
                 ndx = LIMIT_INDEX(ndx, sizeof(er->geofenceID)/sizeof(er->geofenceID[0]));
-                binFmtPrintf(bf, "%*x", len, (UInt32)er->geofenceID[ndx]);
+                _evPrintInt(bf, direct, "%*x", len, (UInt32)er->geofenceID[ndx]);
                 break;
             case FIELD_TOP_SPEED        : // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->topSpeedKPH * 10.0) : (UInt32)ROUND(er->topSpeedKPH);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
 
 #ifdef EVENT_INCL_STRING
@@ -309,7 +408,7 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
                 break;
             case FIELD_STRING_PAD       :
                 ndx = LIMIT_INDEX(ndx, sizeof(er->string)/sizeof(er->string[0]));
-                binFmtPrintf(bf, "%*p", len, er->string[ndx]);
+                _evPrintPad(bf, direct, len, er->string[ndx]);
                 break;
 #endif
 
@@ -320,7 +419,7 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
                 break;
             case FIELD_ENTITY_PAD       :
                 ndx = LIMIT_INDEX(ndx, sizeof(er->entity)/sizeof(er->entity[0]));
-                binFmtPrintf(bf, "%*p", len, er->entity[ndx]);
+                _evPrintPad(bf, direct, len, er->entity[ndx]);
                 break;
 #endif
 
@@ -340,39 +439,39 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
 
 #ifdef EVENT_INCL_DIGITAL_INPUT
             case FIELD_INPUT_ID         : // hex
-                binFmtPrintf(bf, "%*x", len, (UInt32)er->inputID);
+                _evPrintInt(bf, direct, "%*x", len, (UInt32)er->inputID);
                 break;
             case FIELD_INPUT_STATE      : // hex
-                binFmtPrintf(bf, "%*x", len, (UInt32)er->inputState);
+                _evPrintInt(bf, direct, "%*x", len, (UInt32)er->inputState);
                 break;
             case FIELD_OUTPUT_ID        : // hex
-                binFmtPrintf(bf, "%*x", len, (UInt32)er->outputID);
+                _evPrintInt(bf, direct, "%*x", len, (UInt32)er->outputID);
                 break;
             case FIELD_OUTPUT_STATE     : // hex
-                binFmtPrintf(bf, "%*x", len, (UInt32)er->outputState);
+                _evPrintInt(bf, direct, "%*x", len, (UInt32)er->outputState);
                 break;
             case FIELD_ELAPSED_TIME     :
                 ndx = LIMIT_INDEX(ndx, sizeof(er->elapsedTimeSec)/sizeof(er->elapsedTimeSec[0]));
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->elapsedTimeSec[ndx]);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->elapsedTimeSec[ndx]);
                 break;
             case FIELD_COUNTER          :
                 ndx = LIMIT_INDEX(ndx, sizeof(er->counter)/sizeof(er->counter[0]));
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->counter[ndx]);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->counter[ndx]);
                 break;
 #endif
 
 #ifdef EVENT_INCL_ANALOG_INPUT
             case FIELD_SENSOR32_LOW     :
                 ndx = LIMIT_INDEX(ndx, sizeof(er->sensor32LO)/sizeof(er->sensor32LO[0]));
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->sensor32LO[ndx]);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->sensor32LO[ndx]);
                 break;
             case FIELD_SENSOR32_HIGH    :
                 ndx = LIMIT_INDEX(ndx, sizeof(er->sensor32HI)/sizeof(er->sensor32HI[0]));
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->sensor32HI[ndx]);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->sensor32HI[ndx]);
                 break;
             case FIELD_SENSOR32_AVER    :
                 ndx = LIMIT_INDEX(ndx, sizeof(er->sensor32AV)/sizeof(er->sensor32AV[0]));
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->sensor32AV[ndx]);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->sensor32AV[ndx]);
                 break;
 #endif
 #ifdef EVENT_INCL_TEMPERATURE
@@ -386,7 +485,7 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
                     if (iVal32 < -TEMPERATURE_HI_RES_INVALID) { iVal32 = -TEMPERATURE_HI_RES_INVALID; } else
                     if (iVal32 >  TEMPERATURE_HI_RES_INVALID) { iVal32 =  TEMPERATURE_HI_RES_INVALID; }
                 }
-                binFmtPrintf(bf, "%*i", len, iVal32);
+                _evPrintInt(bf, direct, "%*i", len, iVal32);
                 break;
             case FIELD_TEMP_HIGH        : // double +/-
                 ndx = LIMIT_INDEX(ndx, sizeof(er->tempHI)/sizeof(er->tempHI[0]));
@@ -398,7 +497,7 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
                     if (iVal32 < -TEMPERATURE_HI_RES_INVALID) { iVal32 = -TEMPERATURE_HI_RES_INVALID; } else
                     if (iVal32 >  TEMPERATURE_HI_RES_INVALID) { iVal32 =  TEMPERATURE_HI_RES_INVALID; }
                 }
-                binFmtPrintf(bf, "%*i", len, iVal32);
+                _evPrintInt(bf, direct, "%*i", len, iVal32);
                 break;
             case FIELD_TEMP_AVER        : // double +/-
                 ndx = LIMIT_INDEX(ndx, sizeof(er->tempAV)/sizeof(er->tempAV[0]));
@@ -410,50 +509,50 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
                     if (iVal32 < -TEMPERATURE_HI_RES_INVALID) { iVal32 = -TEMPERATURE_HI_RES_INVALID; } else
                     if (iVal32 >  TEMPERATURE_HI_RES_INVALID) { iVal32 =  TEMPERATURE_HI_RES_INVALID; }
                 }
-                binFmtPrintf(bf, "%*i", len, iVal32);
+                _evPrintInt(bf, direct, "%*i", len, iVal32);
                 break;
 #endif
 
 #ifdef EVENT_INCL_GPS_STATS
             case FIELD_GPS_DGPS_UPDATE  :
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->gpsDgpsUpdate);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->gpsDgpsUpdate);
                 break;
             case FIELD_GPS_HORZ_ACCURACY: // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->gpsHorzAccuracy * 10.0) : (UInt32)ROUND(er->gpsHorzAccuracy);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_GPS_VERT_ACCURACY: // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->gpsVertAccuracy * 10.0) : (UInt32)ROUND(er->gpsVertAccuracy);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_GPS_SATELLITES   :
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->gpsSatellites);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->gpsSatellites);
                 break;
             case FIELD_GPS_MAG_VARIATION: // double +/-
                 iVal32 = (Int32)ROUND(er->gpsMagVariation * 100.0);
-                binFmtPrintf(bf, "%*i", len, iVal32);
+                _evPrintInt(bf, direct, "%*i", len, iVal32);
                 break;
             case FIELD_GPS_QUALITY      :
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->gpsQuality);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->gpsQuality);
                 break;
             case FIELD_GPS_TYPE         :
-                binFmtPrintf(bf, "%*u", len, (UInt32)er->gps2D3D);
+                _evPrintInt(bf, direct, "%*u", len, (UInt32)er->gps2D3D);
                 break;
             case FIELD_GPS_GEOID_HEIGHT : // double +/-
                 iVal32 = isHiRes? (Int32)ROUND(er->gpsGeoidHeight * 10.0) : (Int32)ROUND(er->gpsGeoidHeight);
-                binFmtPrintf(bf, "%*i", len, iVal32);
+                _evPrintInt(bf, direct, "%*i", len, iVal32);
                 break;
             case FIELD_GPS_PDOP         : // double (values above 20.0 are considered poor)
                 uVal32 = ((len == 1) && (er->gpsPDOP >= 25.5))? 255L : (UInt32)ROUND(er->gpsPDOP * 10.0);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_GPS_HDOP         : // double (values above 20.0 are considered poor)
                 uVal32 = ((len == 1) && (er->gpsHDOP >= 25.5))? 255L : (UInt32)ROUND(er->gpsHDOP * 10.0);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_GPS_VDOP         : // double (values above 20.0 are considered poor)
                 uVal32 = ((len == 1) && (er->gpsVDOP >= 25.5))? 255L : (UInt32)ROUND(er->gpsVDOP * 10.0);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
 #endif
 
@@ -476,55 +575,55 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
             case FIELD_OBC_GENERIC: // UInt32
                 ndx = LIMIT_INDEX(ndx, sizeof(er->obcGeneric)/sizeof(er->obcGeneric[0]));
                 uVal32 = er->obcGeneric[ndx];
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_OBC_J1708_FAULT: // UInt32
                 ndx = LIMIT_INDEX(ndx, sizeof(er->obcJ1708Fault)/sizeof(er->obcJ1708Fault[0]));
                 uVal32 = er->obcJ1708Fault[ndx];
-                binFmtPrintf(bf, "%*x", len, uVal32);
+                _evPrintInt(bf, direct, "%*x", len, uVal32);
                 break;
             case FIELD_OBC_DISTANCE   : // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->obcDistanceKM * 10.0) : (UInt32)ROUND(er->obcDistanceKM);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_OBC_ENGINE_HOURS: // double
                 uVal32 = (UInt32)ROUND(er->obcEngineHours * 10.0);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_OBC_ENGINE_RPM: // UInt32
                 uVal32 = er->obcEngineRPM;
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_OBC_COOLANT_TEMP: // double
                 iVal32 = isHiRes? (UInt32)ROUND(er->obcCoolantTemp * 10.0) : (UInt32)ROUND(er->obcCoolantTemp);
-                binFmtPrintf(bf, "%*i", len, iVal32);
+                _evPrintInt(bf, direct, "%*i", len, iVal32);
                 break;
             case FIELD_OBC_COOLANT_LEVEL: // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->obcCoolantLevel * 1000.0) : (UInt32)ROUND(er->obcCoolantLevel * 100.0);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_OBC_OIL_LEVEL: // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->obcOilLevel * 1000.0) : (UInt32)ROUND(er->obcOilLevel * 100.0);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_OBC_OIL_PRESSURE: // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->obcOilPressure * 10.0) : (UInt32)ROUND(er->obcOilPressure);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_OBC_FUEL_LEVEL: // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->obcFuelLevel * 1000.0) : (UInt32)ROUND(er->obcFuelLevel * 100.0);
-                binFmtPrintf(bf, "%*i", len, uVal32);
+                _evPrintInt(bf, direct, "%*i", len, uVal32);
                 break;
             case FIELD_OBC_FUEL_ECONOMY: // double
                 uVal32 = (UInt32)ROUND(er->obcAvgFuelEcon * 10.0); // try average first
                 if (uVal32 == 0L) {
                     uVal32 = (UInt32)ROUND(er->obcFuelEconomy * 10.0); // fallback to 'instant'
                 }
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
             case FIELD_OBC_FUEL_USED: // double
                 uVal32 = isHiRes? (UInt32)ROUND(er->obcFuelUsed * 10.0) : (UInt32)ROUND(er->obcFuelUsed);
-                binFmtPrintf(bf, "%*u", len, uVal32);
+                _evPrintInt(bf, direct, "%*u", len, uVal32);
                 break;
 #endif
 
@@ -536,12 +635,58 @@ static Packet_t *_evCreateEventPacket(Packet_t *pkt, ClientPacketType_t pktType,
     pkt->seqLen   = seqLen;   // # bytes (will be '0' if not specified as a field)
     pkt->seqPos   = seqPos;   // position of sequence field
 
+    /* compiled payload format */
+    if (enc) {
+        memcpy(pkt->dataFmt, enc->dataFmt, sizeof(pkt->dataFmt));
+    }
+
     /* return full length */
     pkt->dataLen = (UInt8)BUFFER_DATA_LENGTH(bf);
     return pkt;
 
 }
 
+/* compile encoder for the specified definition */
+static void _evCompileEncoder(EventEncoder_t *enc, CustomDef_t *custDef)
+{
+    int i, len = 0;
+    
+    /* not compiled */
+    memset(enc, 0, sizeof(EventEncoder_t));
+    
+    /* fields must all have a fixed encoded length */
+    for (i = 0; i < custDef->fldLen; i++) {
+        switch ((EventFieldType_t)custDef->fld[i].type) {
+            case FIELD_STRING           : // null terminated, may be shorter than field
+            case FIELD_ENTITY           : // null terminated, may be shorter than field
+            case FIELD_BINARY           : // "%*b%*z", if shorter than field
+            case FIELD_OBC_VALUE        : // "%2u%2u%*b%*z"
+                return;
+            default:
+                len += custDef->fld[i].length;
+                break;
+        }
+    }
+    if (len > PACKET_MAX_PAYLOAD_LENGTH) {
+        return; // overflow
+    }
+
+    /* encode an empty event to obtain the payload format */
+    // If the resulting length differs, then the definition contains a field type which
+    // is not supported by this build.
+    Packet_t pkt;
+    Event_t  er;
+    memset(&er, 0, sizeof(Event_t));
+    _evCreateEventPacket(&pkt, custDef->hdrType, custDef, (EventEncoder_t*)0, (UInt32*)0, &er);
+    if ((int)pkt.dataLen != len) {
+        return;
+    }
+    enc->dataLen = pkt.dataLen;
+    memcpy(enc->dataFmt, pkt.dataFmt, sizeof(enc->dataFmt));
+    enc->custDef = custDef;
+
+}
+
 // ----------------------------------------------------------------------------
 
 /* return the event queue */
@@ -558,7 +703,7 @@ utBool evEncodePacket(Packet_t *pkt, PacketPriority_t pri, ClientPacketType_t pk
     if (pkt && er) {
         CustomDef_t *custDef = _evGetCustomDefinitionForType(pktType);
         if (custDef) {
-            _evCreateEventPacket(pkt, pktType, custDef, evSeq, er);
+            _evCreateEventPacket(pkt, pktType, custDef, _evGetEncoderForDefinition(custDef), evSeq, er);
             pkt->priority = (pri <= PRIORITY_NONE)? PRIORITY_NORMAL : pri;
             return utTrue;
         } else {
@@ -727,6 +872,12 @@ void evInitialize()
     
     /* enable overwrite */
     pqueEnableOverwrite(&eventQueue, EVENT_QUEUE_OVERWRITE);
+    
+    /* compile fixed format encoders */
+    int i, maxSize = sizeof(FixedEventTable)/sizeof(FixedEventTable[0]);
+    for (i = 0; i < maxSize; i++) {
+        _evCompileEncoder(&FixedEventEncoder[i], FixedEventTable[i]);
+    }
 
 }
 
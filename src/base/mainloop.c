@@ -190,6 +190,7 @@ static void _mainLoopRun(void *arg)
         
         /* aquire GPS */
         UInt32 gpsInterval = propGetUInt32(PROP_GPS_SAMPLE_RATE, 15L);
+        UInt32 gpsGeneration = gpsGetFixGeneration();
         if (utcIsTimerExpired(lastGPSAquisitionTimer,gpsInterval)) {
             // aquire GPS fix 
             UInt32 gpsAquireTimeoutSec = propGetUInt32(PROP_GPS_AQUIRE_WAIT, 0L);
@@ -300,7 +301,13 @@ static void _mainLoopRun(void *arg)
         protocolTransport(0,defaultEncoding);
         // -----------------
         // short loop delay
-        threadSleepMS(loopDelayMS);
+        if (utcIsVirtualTime() || utcIsTimerExpired(lastGPSAquisitionTimer,gpsInterval)) {
+            // waiting for a GPS fix, wake as soon as the GPS thread publishes a new one
+            // (always when replaying GPS data, since the clock only advances with each fix)
+            gpsWaitForFix(gpsGeneration, loopDelayMS);
+        } else {
+            threadSleepMS(loopDelayMS);
+        }
         if (loopDelayMS < STANDARD_LOOP_DELAY) {
             loopDelayMS += LOOP_DELAY_INCREMENT;
             if (loopDelayMS > STANDARD_LOOP_DELAY) {
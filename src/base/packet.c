@@ -239,42 +239,57 @@ static int _pktEncodeCSVPacket(Buffer_t *dest, Packet_t *pkt)
     return BUFFER_DATA_LENGTH(dest) - oldLen;
 }
 
+/* encode the ASCII packet header ("$HHHH", plus the encoding character if there is a payload) */
+static int _pktEncodeASCIIHeader(Buffer_t *dest, Packet_t *pkt, char encChar, int payloadLen)
+{
+    // 'payloadLen' is the encoded payload length (not including the terminator)
+    int hdrLen = (pkt->dataLen > 0)? 6 : 5;
+    if ((hdrLen + payloadLen) >= BUFFER_DATA_SIZE(dest)) {
+        logERROR(LOGSRC,"Packet encode overflow [%d >= %d]", hdrLen + payloadLen, BUFFER_DATA_SIZE(dest));
+        return PKTERR_OVERFLOW;
+    }
+    char *h = (char*)BUFFER_DATA(dest);
+    UInt8 hdr[2] = { (UInt8)(((UInt16)pkt->hdrType >> 8) & 0xFF), (UInt8)((UInt16)pkt->hdrType & 0xFF) };
+    h[0] = PACKET_ASCII_ENCODING_CHAR;
+    strEncodeHex(&h[1], 5, hdr, 2);
+    if (pkt->dataLen > 0) {
+        h[5] = encChar;
+        h[6] = 0;
+    }
+    binAdvanceBuffer(dest, hdrLen);
+    return hdrLen;
+}
+
 /* encode the specified packet into a hex string */
+// The payload is encoded directly into the destination buffer
 static int _pktEncodeHEXPacket(Buffer_t *dest, Packet_t *pkt)
 {
-    UInt16 oldLen = BUFFER_DATA_LENGTH(dest);
-    SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%c", PACKET_ASCII_ENCODING_CHAR);
-    binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
-    SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%04X", (UInt16)pkt->hdrType);
-    binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
+    int hexLen = 2 * (int)pkt->dataLen;
+    int hdrLen = _pktEncodeASCIIHeader(dest, pkt, ENCODING_HEX_CHAR, hexLen);
+    if (hdrLen < 0) {
+        return hdrLen;
+    }
     if (pkt->dataLen > 0) {
-        char hex[PACKET_MAX_ENCODED_LENGTH]; // 256 * 2 == 512
-        SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%c", ENCODING_HEX_CHAR);
-        binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
-        strEncodeHex(hex, sizeof(hex), pkt->data, pkt->dataLen);
-        SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%s", hex);
-        binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
+        strEncodeHex((char*)BUFFER_DATA(dest), hexLen + 1, pkt->data, pkt->dataLen);
+        binAdvanceBuffer(dest, hexLen);
     }
-    return BUFFER_DATA_LENGTH(dest) - oldLen;
+    return hdrLen + hexLen;
 }
 
 /* encode the specified packet into a Base64 string */
+// The payload is encoded directly into the destination buffer
 static int _pktEncodeB64Packet(Buffer_t *dest, Packet_t *pkt)
 {
-    UInt16 oldLen = BUFFER_DATA_LENGTH(dest);
-    SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%c", PACKET_ASCII_ENCODING_CHAR);
-    binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
-    SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%04X", (UInt16)pkt->hdrType);
-    binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
+    int b64Len = (((int)pkt->dataLen + 2) / 3) * 4;
+    int hdrLen = _pktEncodeASCIIHeader(dest, pkt, ENCODING_BASE64_CHAR, b64Len);
+    if (hdrLen < 0) {
+        return hdrLen;
+    }
     if (pkt->dataLen > 0) {
-        char b64[PACKET_MAX_ENCODED_LENGTH]; // ((256 + 2) / 3) * 4 == 344
-        SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%c", ENCODING_BASE64_CHAR);
-        binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
-        base64Encode(b64, sizeof(b64), pkt->data, pkt->dataLen);
-        SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%s", b64);
-        binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
+        base64Encode((char*)BUFFER_DATA(dest), b64Len + 1, pkt->data, pkt->dataLen);
+        binAdvanceBuffer(dest, b64Len);
     }
-    return BUFFER_DATA_LENGTH(dest) - oldLen;
+    return hdrLen + b64Len;
 }
 
 /* encode the specified packet into the provided buffer */
@@ -293,14 +308,13 @@ int pktEncodePacket(Buffer_t *dest, Packet_t *pkt, PacketEncoding_t encoding)
     /* binary encoding special case */
     if (ENCODING_VALUE(enc) == ENCODING_BINARY) {
         if ((3 + pkt->dataLen) <= BUFFER_DATA_SIZE(dest)) {
-            int len = binPrintf(BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), "%2x%1x%*b", 
-                (UInt32)pkt->hdrType, (UInt32)pkt->dataLen, (int)pkt->dataLen, pkt->data);
-            if (len >= 0) {
-                binAdvanceBuffer(dest, len);
-                return BUFFER_DATA_LENGTH(dest);
-            } else {
-                return PKTERR_OVERFLOW;
-            }
+            UInt8 *b = BUFFER_DATA(dest);
+            b[0] = (UInt8)(((UInt16)pkt->hdrType >> 8) & 0xFF);
+            b[1] = (UInt8)((UInt16)pkt->hdrType & 0xFF);
+            b[2] = pkt->dataLen;
+            memcpy(&b[3], pkt->data, pkt->dataLen);
+            binAdvanceBuffer(dest, 3 + pkt->dataLen);
+            return BUFFER_DATA_LENGTH(dest);
         } else {
             return PKTERR_OVERFLOW;
         }
@@ -338,7 +352,7 @@ int pktEncodePacket(Buffer_t *dest, Packet_t *pkt, PacketEncoding_t encoding)
 
     /* include checksum? */
     if (ENCODING_IS_CHECKSUM(enc)) {
-        if (3 > BUFFER_DATA_SIZE(dest)) {
+        if (4 > BUFFER_DATA_SIZE(dest)) {
             // internal error: not likely
             logERROR(LOGSRC,"Checksum packet overflow");
             return PKTERR_OVERFLOW;
@@ -351,9 +365,15 @@ int pktEncodePacket(Buffer_t *dest, Packet_t *pkt, PacketEncoding_t encoding)
     }
     
     /* ascii line terminator */
-    char eol[] = { PACKET_ASCII_ENCODING_EOL, 0 };
-    SNPRINTF((char*)BUFFER_DATA(dest), BUFFER_DATA_SIZE(dest), eol);
-    binAdvanceBuffer(dest, strlen((char*)BUFFER_DATA(dest)));
+    if (BUFFER_DATA_SIZE(dest) < 1) {
+        logERROR(LOGSRC,"Packet terminator overflow");
+        return PKTERR_OVERFLOW;
+    }
+    *BUFFER_DATA(dest) = PACKET_ASCII_ENCODING_EOL;
+    binAdvanceBuffer(dest, 1);
+    if (BUFFER_DATA_SIZE(dest) > 0) {
+        *BUFFER_DATA(dest) = 0; // terminate (not included in length)
+    }
 
     /* return total length */
     return BUFFER_DATA_LENGTH(dest);
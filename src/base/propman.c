@@ -146,6 +146,7 @@ static KeyValue_t properties[] = {
     { PROP_CFG_GPS_BPS           , "cfg.gps.bps"    , KVT_UINT32            , RO       ,  1,  "4800" },
     { PROP_CFG_GPS_MODEL         , "cfg.gps.model"  , KVT_STRING            , RO       ,  1,  "" },
     { PROP_CFG_GPS_DEBUG         , "cfg.gps.debug"  , KVT_BOOLEAN           , RO       ,  1,  "0" },
+    { PROP_CFG_GPS_REPLAY_RATE   , "cfg.gps.replay" , KVT_UINT16            , RO       ,  1,  "1" },
     { PROP_CFG_SERIAL0_PORT      , "cfg.sp0.port"   , KVT_STRING            , RO       ,  1,  "" },
     { PROP_CFG_SERIAL0_BPS       , "cfg.sp0.bps"    , KVT_UINT32            , RO       ,  1,  "" },
     { PROP_CFG_SERIAL0_DEBUG     , "cfg.sp0.debug"  , KVT_BOOLEAN           , RO       ,  1,  "0" },
@@ -184,6 +185,7 @@ static KeyValue_t properties[] = {
     { PROP_STATE_GPS_DIAGNOSTIC  , "sta.gpsdiag"    , KVT_UINT32            , RO       ,  5,  "0,0,0,0,0" }, 
     { PROP_STATE_QUEUED_EVENTS   , "sta.evtqueue"   , KVT_UINT32            , RO       ,  2,  "0,0" }, 
     { PROP_STATE_DEV_DIAGNOSTIC  , "sta.devdiag"    , KVT_UINT32            , RO|SAVE  ,  5,  "0,0,0,0,0" }, 
+    { PROP_STATE_DNS_DIAGNOSTIC  , "sta.dnsdiag"    , KVT_UINT32            , RO       ,  5,  "0,0,0,0,0" }, 
 
     // --- Communication protocol properties
     { PROP_COMM_SPEAK_FIRST      , "com.first"      , KVT_BOOLEAN           ,    SAVE  ,  1,  "1" },
@@ -194,6 +196,7 @@ static KeyValue_t properties[] = {
     { PROP_COMM_MAX_XMIT_RATE    , "com.maxrate"    , KVT_UINT32            ,    SAVE  ,  1,  "3600" },
     { PROP_COMM_MAX_DUP_EVENTS   , "com.maxduplex"  , KVT_UINT8             ,    SAVE  ,  1,  "10" },
     { PROP_COMM_MAX_SIM_EVENTS   , "com.maxsimplex" , KVT_UINT8             ,    SAVE  ,  1,  "2" },
+    { PROP_COMM_PERSISTENT       , "com.persist"    , KVT_UINT16            ,    SAVE  ,  2,  "0,60" },
 
     // --- Communication connection properties
     { PROP_COMM_SETTINGS         , "com.settings"   , KVT_STRING            ,    SAVE  ,  1,  "" },
@@ -209,6 +212,7 @@ static KeyValue_t properties[] = {
     { PROP_COMM_APN_PHONE        , "com.apnphone"   , KVT_STRING            ,    SAVE  ,  1,  "" }, // "*99***1#"
     { PROP_COMM_APN_SETTINGS     , "com.apnsett"    , KVT_STRING            ,    SAVE  ,  1,  "" },
     { PROP_COMM_MIN_SIGNAL       , "com.minsignal"  , KVT_INT16             ,    SAVE  ,  1,  "7" },
+    { PROP_COMM_DNS_TTL          , "com.dnsttl"     , KVT_UINT32            ,    SAVE  ,  2,  "3600,60" },
     { PROP_COMM_ACCESS_PIN       , "com.pin"        , KVT_BINARY            ,    SAVE  ,  8,  DFT_ACCESS_PIN },
 
     // --- Packet/Data format properties
@@ -250,6 +254,7 @@ static KeyValue_t properties[] = {
     { PROP_MOTION_DORMANT_COUNT  , "mot.dorm.cnt"   , KVT_UINT16            ,    SAVE  ,  1,  "1" },
     { PROP_MOTION_EXCESS_SPEED   , "mot.exspeed"    , KVT_UINT16|KVT_DEC(1) ,    SAVE  ,  1,  "0.0" },
     { PROP_MOTION_MOVING_INTRVL  , "mot.moving"     , KVT_UINT16            ,    SAVE  ,  1,  "0" },
+    { PROP_MOTION_SIMPLIFY       , "mot.simplify"   , KVT_UINT16            ,    SAVE  ,  3,  "0,30,300" },
 
     // --- Odometer properties
     { PROP_ODOMETER_0_VALUE      , "odo.0.value"    , KVT_UINT32            ,    SAVE  ,  1,  "0" },
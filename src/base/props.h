@@ -216,6 +216,14 @@ extern "C" {
     // Notes:
     //      - Used only when debugging this GPS device.
 
+#define PROP_CFG_GPS_REPLAY_RATE        0xEF2E
+    // Description: [optional]
+    //      [Read-Only] Playback rate of a recorded NMEA file (GPS port "replay:<file>")
+    // Get Value: 
+    //      0:2 - [UInt16] playback speed multiplier (1 to 1000)
+    // Notes:
+    //      - Used only for testing/benchmarking (see GPS_DEVICE_REPLAY).
+
 // --- General serial port 0 config
 #define PROP_CFG_SERIAL0_PORT           0xEF31
     // Description: [optional]
@@ -643,6 +651,18 @@ extern "C" {
     //     12:4 - [UInt32] reserved
     //     16:4 - [UInt32] reserved
 
+#define PROP_STATE_DNS_DIAGNOSTIC       0xF142
+    // Description: [optional]
+    //      [Read-Only] Resolved host address cache statistics (since reboot)
+    // Value:
+    //      0:4 - [UInt32] Number of addresses resolved from the cache
+    //      4:4 - [UInt32] Number of addresses resolved by DNS lookup
+    //      8:4 - [UInt32] Number of failed DNS lookups
+    //     12:4 - [UInt32] Number of lookups failed from the cache (recent failure)
+    //     16:4 - [UInt32] Number of failed lookups which used the last known address
+    // Notes:
+    //      - See PROP_COMM_DNS_TTL
+
 // ----------------------------------------------------------------------------
 // Communication protocol properties:
 
@@ -765,6 +785,26 @@ extern "C" {
     //      - Since Simplex transmissions may not guarantee delivery, only low priority, 
     //      non-critical messages should be sent via Simplex.
 
+#define PROP_COMM_PERSISTENT            0xF319
+    // Description: [optional]
+    //      Persistent Duplex connection
+    // Value: 
+    //      0:2 - [UInt16] Maximum idle seconds between Duplex sessions
+    //            Valid range: 0 to 65535 seconds (0 means this feature is inactive)
+    //      1:2 - [UInt16] TCP keep-alive interval in seconds
+    //            Valid range: 0 to 65535 seconds (0 means the system default)
+    // Special data length rules:
+    //      - A 0-length value indicates that this feature is disabled.
+    // Notes:
+    //      - When active, the Duplex connection is not closed at the end of a session
+    //      which ended without errors, and is reused by the next Duplex session if it
+    //      is still connected, and has not been idle longer than the specified time.
+    //      - Each session is still counted as a Duplex connection against the quotas
+    //      specified by PROP_COMM_MAX_CONNECTIONS.
+    //      - The server must also support keeping the connection open after the 
+    //      End-Of-Transmission, otherwise a new connection is made for each session.
+    //      - This property is optional.
+
 // ----------------------------------------------------------------------------
 // Communication connection properties:
 
@@ -920,6 +960,18 @@ extern "C" {
     //        may use this value to compare against the signal strength returned
     //        from a "AT+CSQ" comment sent to the modem.
 
+#define PROP_COMM_DNS_TTL               0xF3AE
+    // Description: [optional]
+    //      Resolved host address cache timeouts
+    // Value: 
+    //      0:4 - [UInt32] Number of seconds a resolved host address is reused
+    //            Valid range: 0 to 4294967295 seconds (0 means always resolve)
+    //      4:4 - [UInt32] Number of seconds after a failed lookup before trying again
+    //            Valid range: 0 to 4294967295 seconds (0 means always try again)
+    // Notes:
+    //      - If a lookup fails, the last known address for the host (if any) is used.
+    //      - Cache statistics are available in PROP_STATE_DNS_DIAGNOSTIC.
+
 #define PROP_COMM_ACCESS_PIN            0xF3AF
     // Description: [optional]
     //      Access PIN/Password
@@ -1366,6 +1418,29 @@ extern "C" {
     //      - This property is optional.  The client may also decide the special 
     //        conditions under which these events are generated.
 
+#define PROP_MOTION_SIMPLIFY            0xF728
+    // Description: [optional]
+    //      In-motion track simplification
+    // Value: 
+    //      0:2 - [UInt16] Maximum cross-track error in meters
+    //            Valid range: 0 to 65535 meters (0 means this feature is inactive)
+    //      1:2 - [UInt16] Maximum heading change in degrees
+    //            Valid range: 0 to 180 degrees (0 means no heading check)
+    //      2:2 - [UInt16] Maximum number of seconds between reported in-motion points
+    //            Valid range: 0 to 65535 seconds (0 means no maximum)
+    // Special data length rules:
+    //      - A 0-length value indicates that this feature is disabled.
+    // Notes:
+    //      - When active, in-motion events are held back and only those points needed
+    //        to keep the reported track within the specified cross-track error of the
+    //        actual track are sent (points along a straight road are discarded).
+    //      - A point is also sent if the heading has changed by more than the specified
+    //        number of degrees since the last sent point, or if the specified number of
+    //        seconds have elapsed since the last sent point.
+    //      - Other events (ie. start/stop) are not affected, however, any held in-motion
+    //        point is sent before the other event is queued.
+    //      - This property is optional.
+
 // ----------------------------------------------------------------------------
 // Odometer properties:
 
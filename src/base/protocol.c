@@ -430,7 +430,8 @@ static int _protocolWrite(ProtocolVars_t *pv, const UInt8 *buf, int bufLen, utBo
     // guaranteed to contain only a single packet
     
     /* print */
-    if (bufLen > 0) {
+    // (the packet is only hex-encoded if it will actually be logged)
+    if ((bufLen > 0) && logIsLevel(SYSLOG_INFO)) {
         if (*buf == PACKET_ASCII_ENCODING_CHAR) {
             logINFO(LOGSRC,"Tx%d]%.*s", pv->protoNdx, bufLen - 1, buf);
         } else {
@@ -444,7 +445,7 @@ static int _protocolWrite(ProtocolVars_t *pv, const UInt8 *buf, int bufLen, utBo
         
     if (len >= 0) {
         if (calcChksum) { 
-            cksumCalcFletcher(buf, bufLen); 
+            _cksumCalcFletcher(&(pv->fletcher), buf, bufLen); 
         }
         pv->totalWriteBytes   += len;
         pv->sessionWriteBytes += len;
@@ -458,11 +459,27 @@ static int _protocolWrite(ProtocolVars_t *pv, const UInt8 *buf, int bufLen, utBo
 /* write packet to server */
 static int _protocolWritePacket(ProtocolVars_t *pv, Packet_t *pkt)
 {
-    UInt8 buf[PACKET_MAX_ENCODED_LENGTH];
-    Buffer_t bb, *dest = binBuffer(&bb, buf, sizeof(buf), BUFFER_DESTINATION);
-    binResetBuffer(dest);
-    pktEncodePacket(dest, pkt, pv->sessionFirstEncoding); // we ignore any internal errors
-    int rtnWriteLen = _protocolWrite(pv, BUFFER_PTR(dest), BUFFER_DATA_LENGTH(dest), utTrue);
+    Buffer_t bb, *dest;
+    int rtnWriteLen;
+    
+    /* encode directly into the transport buffer, if available */
+    int xportBufSize = 0;
+    UInt8 *xportBuf = pv->xFtns->xportWriteBuffer? pv->xFtns->xportWriteBuffer(&xportBufSize) : (UInt8*)0;
+    if (xportBuf) {
+        dest = binBuffer(&bb, xportBuf, (UInt16)xportBufSize, BUFFER_DESTINATION);
+        if (pktEncodePacket(dest, pkt, pv->sessionFirstEncoding) < 0) {
+            // transport buffer overflow (ie. datagram is full)
+            rtnWriteLen = -1;
+        } else {
+            rtnWriteLen = _protocolWrite(pv, BUFFER_PTR(dest), BUFFER_DATA_LENGTH(dest), utTrue);
+        }
+    } else {
+        UInt8 buf[PACKET_MAX_ENCODED_LENGTH];
+        dest = binBuffer(&bb, buf, sizeof(buf), BUFFER_DESTINATION);
+        pktEncodePacket(dest, pkt, pv->sessionFirstEncoding); // we ignore any internal errors
+        rtnWriteLen = _protocolWrite(pv, BUFFER_PTR(dest), BUFFER_DATA_LENGTH(dest), utTrue);
+    }
+    
     pv->sessionFirstEncoding = pv->sessionEncoding;
     return rtnWriteLen;
 }
@@ -572,12 +589,22 @@ static Packet_t *_protocolParseServerPacket(ProtocolVars_t *pv, Packet_t *pkt, c
                 if (pktBufLen > 6) { // $E0FF:XXXX...
                     // encoded character, plus data
                     if (pktBuf[5] == ENCODING_BASE64_CHAR) {
-                        int len = (UInt8)base64Decode((char*)(pktBuf + 6), pktBufLen - 6, pkt->data, sizeof(pkt->data));
-                        pkt->dataLen = (len >= 0)? (UInt8)len : 0;
+                        int len = (int)base64Decode((char*)(pktBuf + 6), pktBufLen - 6, pkt->data, sizeof(pkt->data));
+                        if (len < 0) {
+                            // invalid Base64 data (or too long): ERROR_PACKET_PAYLOAD
+                            _protocolQueueError(pv,"%2x%2x", (UInt32)ERROR_PACKET_PAYLOAD, (UInt32)pkt->hdrType);
+                            return (Packet_t*)0;
+                        }
+                        pkt->dataLen = (UInt8)len;
                     } else
                     if (pktBuf[5] == ENCODING_HEX_CHAR) {
-                        int len = (UInt8)strParseHex((char*)(pktBuf + 6), pktBufLen - 6, pkt->data, sizeof(pkt->data));
-                        pkt->dataLen = (len >= 0)? (UInt8)len : 0;
+                        int len = strParseHex((char*)(pktBuf + 6), pktBufLen - 6, pkt->data, sizeof(pkt->data));
+                        if ((len * 2) != (pktBufLen - 6)) {
+                            // invalid hex data (odd length, or too long): ERROR_PACKET_PAYLOAD
+                            _protocolQueueError(pv,"%2x%2x", (UInt32)ERROR_PACKET_PAYLOAD, (UInt32)pkt->hdrType);
+                            return (Packet_t*)0;
+                        }
+                        pkt->dataLen = (UInt8)len;
                     } else
                     if (pktBuf[5] == ENCODING_CSV_CHAR) {
                         // unsupported encoding: ERROR_PACKET_ENCODING
@@ -600,9 +627,11 @@ static Packet_t *_protocolParseServerPacket(ProtocolVars_t *pv, Packet_t *pkt, c
         // The packet header is assumed to be a valid length.
         
         /* print packet */
-        UInt8 hex[PACKET_MAX_ENCODED_LENGTH];
-        UInt16 len = (UInt16)pktBuf[2] + 3;
-        logINFO(LOGSRC,"Rx%d]0x%s\n", pv->protoNdx, strEncodeHex((char*)hex, sizeof(hex), pktBuf, len)); 
+        if (logIsLevel(SYSLOG_INFO)) {
+            UInt8 hex[PACKET_MAX_ENCODED_LENGTH];
+            UInt16 len = (UInt16)pktBuf[2] + 3;
+            logINFO(LOGSRC,"Rx%d]0x%s\n", pv->protoNdx, strEncodeHex((char*)hex, sizeof(hex), pktBuf, len)); 
+        }
         
         /* parse into packet */
         pkt->hdrType = CLIENT_HEADER_TYPE(pktBuf[0],pktBuf[1]);
@@ -817,11 +846,11 @@ static utBool _protocolSendEOB(ProtocolVars_t *pv, utBool hasMoreEvents)
             // Fixed checksum length check, was "sizeof(ChecksumFletcher_t)"
             pktInit(&eob, eobType, "%*z", FLETCHER_CHECKSUM_LENGTH); // zero-fill 2 bytes
             pktEncodePacket(dest, &eob, ENCODING_BINARY); // we ignore any internal errors
-            cksumCalcFletcher(BUFFER_PTR(dest), BUFFER_DATA_LENGTH(dest)); // length should be 5
+            _cksumCalcFletcher(&(pv->fletcher), BUFFER_PTR(dest), BUFFER_DATA_LENGTH(dest)); // length should be 5
 
             /* calculate the checksum and insert it into the packet */
             ChecksumFletcher_t fcs;
-            cksumGetFletcherChecksum(&fcs); // encode
+            _cksumGetFletcherChecksum(&(pv->fletcher), &fcs); // encode
             binPrintf(BUFFER_PTR(dest)+3, FLETCHER_CHECKSUM_LENGTH, "%*b", FLETCHER_CHECKSUM_LENGTH, fcs.C);
 
         } else {
@@ -853,7 +882,7 @@ static utBool _protocolSendAllPackets(ProtocolVars_t *pv, TransportType_t xportT
 {
 
     /* reset checksum before we start transmitting */
-    cksumResetFletcher();
+    _cksumResetFletcher(&(pv->fletcher));
 
     /* transmit identification packets */
     if (!_protocolSendIdentification(pv)) {
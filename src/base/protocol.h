@@ -25,6 +25,7 @@ extern "C" {
 
 #include "tools/stdtypes.h"
 #include "tools/threads.h"
+#include "tools/checksum.h"
 #include "base/pqueue.h"
 #include "base/packet.h"
 #include "custom/transport.h"
@@ -89,6 +90,9 @@ typedef struct {
     TransportType_t         currentTransportType;       // TRANSPORT_NONE
     PacketEncoding_t        currentEncoding;            // DEFAULT_ENCODING
 
+    // Fletcher checksum of the binary packets written during the current block
+    ChecksumFletcher_t      fletcher;
+
     // session error counters 
     UInt16                  checkSumErrorCount;
     UInt16                  invalidAcctErrorCount;
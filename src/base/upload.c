@@ -46,17 +46,23 @@
 #include "tools/io.h"
 
 #include "base/propman.h"
+#include "base/cdiags.h"
 #include "base/protocol.h"
 #include "base/upload.h"
 
 // ----------------------------------------------------------------------------
 
-static long     uploadStartTime = 0L;
+static long     uploadActiveTime = 0L;      // time of last upload record
 static char     uploadFile[UPLOAD_MAX_FILENAME_SIZE + 1];
-static UInt8    *uploadData = (UInt8*)0;
+static char     uploadPath[UPLOAD_MAX_FILENAME_SIZE * 2];
+static char     uploadTemp[UPLOAD_MAX_FILENAME_SIZE * 2 + sizeof(UPLOAD_PARTIAL_EXT)];
+static FILE     *uploadStream = (FILE*)0;
 static Int32    uploadRcd  = 0L;
 static Int32    uploadSize = 0L;
 static Int32    uploadAddr = 0L;
+static Int32    uploadAckAddr = 0L;         // last acknowledged offset
+static Int32    uploadGapAddr = -1L;        // offset last acknowledged for a gap
+static Int32    uploadResumeAddr = 0L;      // data resumed from a previous partial file
 
 #if defined(TARGET_GUMSTIX)
 // map filename
@@ -81,16 +87,16 @@ static char *uploadFileMap[][2] = { { 0, 0 } };
 /* return true if upload is currently in progress */
 utBool uploadIsActive()
 {
-    return (uploadStartTime > 0L)? utTrue : utFalse;
+    return (uploadActiveTime > 0L)? utTrue : utFalse;
 }
 
-/* return true if upload expired, or not in progress */
+/* return true if no upload record has been received within the timeout */
 utBool uploadIsExpired()
 {
-    if (uploadStartTime <= 0L) {
+    if (uploadActiveTime <= 0L) {
         return utFalse;
     } else
-    if ((uploadStartTime + UPLOAD_TIMEOUT_SEC) > utcGetTimeSec()) {
+    if ((uploadActiveTime + UPLOAD_TIMEOUT_SEC) > utcGetTimeSec()) {
         return utFalse;
     } else {
         return utTrue;
@@ -100,28 +106,77 @@ utBool uploadIsExpired()
 // ----------------------------------------------------------------------------
 
 /* cancel current upload session */
+// The partially received file is kept, and is resumed if the same file is uploaded again.
 void uploadCancel()
 {
     
     /* clear start time */
-    uploadStartTime = 0L;
+    uploadActiveTime = 0L;
     
     /* clear filename */
     *uploadFile = 0;
+    *uploadPath = 0;
+    *uploadTemp = 0;
     
     /* clear len/addr */
     uploadRcd  = 0L;
     uploadSize = 0L;
     uploadAddr = 0L;
+    uploadAckAddr = 0L;
+    uploadGapAddr = -1L;
+    uploadResumeAddr = 0L;
     
-    /* free existing upload data */
-    if (uploadData) {
-        free(uploadData);
-        uploadData = (UInt8*)0;
+    /* close partial file */
+    if (uploadStream) {
+        ioCloseStream(uploadStream);
+        uploadStream = (FILE*)0;
     }
     
 }
 
+/* cancel current upload session, and delete the partially received file */
+static void _uploadDiscard()
+{
+    char temp[sizeof(uploadTemp)];
+    strcpy(temp, uploadTemp);
+    uploadCancel();
+    if (*temp) {
+        ioDeleteFile(temp);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/* acknowledge the data received so far */
+// The server sends at most a window of data beyond the last acknowledged offset, and
+// resends from the acknowledged offset after a gap, or when the connection is restored.
+static utBool _uploadAck(int protoNdx, UInt32 rcdType)
+{
+    if (uploadStream) {
+        ioFlushStream(uploadStream); // acknowledged data must be on file
+    }
+    uploadAckAddr = uploadAddr;
+    return protocolQueueDiagnostic(protoNdx,"%2x%1x%3x", (UInt32)DIAG_UPLOAD_ACK, rcdType, (UInt32)uploadAddr);
+}
+
+/* return the Fletcher checksum of the partial file */
+static utBool _uploadChecksum(ChecksumFletcher_t *fcs)
+{
+    FILE *file = ioOpenStream(uploadTemp, IO_OPEN_READ);
+    if (!file) {
+        return utFalse;
+    }
+    UInt8 buf[512];
+    long len;
+    _cksumResetFletcher(fcs);
+    while ((len = ioReadStream(file, buf, sizeof(buf))) > 0L) {
+        _cksumCalcFletcher(fcs, buf, (int)len);
+    }
+    utBool ok = ferror(file)? utFalse : utTrue;
+    ioCloseStream(file);
+    return ok;
+}
+
 // ----------------------------------------------------------------------------
 
 /* process upload record */
@@ -140,6 +195,10 @@ static utBool _uploadProcessRecord(int protoNdx, const UInt8 *rcd, int rcdLen)
     //   0:1 - Record Type [0x03]
     //   1:3 - File size
     //   4:2 - Fletcher Checksum
+    // Each record type is acknowledged with DIAG_UPLOAD_ACK, which includes the
+    // offset of the data received so far (data records are acknowledged every
+    // UPLOAD_ACK_INTERVAL bytes).  Lost records are reported with 
+    // ERROR_UPLOAD_OFFSET_GAP, and the server resends from the received offset.
     
     /* type */
     UInt32 rcdType = 0L;
@@ -155,9 +214,6 @@ static utBool _uploadProcessRecord(int protoNdx, const UInt8 *rcd, int rcdLen)
         logINFO(LOGSRC,"Upload filename ...");
         UInt8 *data = BUFFER_DATA(src);
         int dataLen = BUFFER_DATA_LENGTH(src);
-        
-        /* reset any previous upload attempts */
-        uploadCancel();
 
         /* prechecks */
         if (lenAddr <= 0L) {
@@ -196,6 +252,7 @@ static utBool _uploadProcessRecord(int protoNdx, const UInt8 *rcd, int rcdLen)
             }
             if (!destName) {
                 // Invalid filename
+                uploadCancel();
                 protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_FILE_NAME);
                 return utFalse;
             }
@@ -204,25 +261,59 @@ static utBool _uploadProcessRecord(int protoNdx, const UInt8 *rcd, int rcdLen)
             destName = tempName;
         }
         
-        /* allocate space for uploaded file */
-        uploadData = (UInt8*)malloc(lenAddr + 16); // [MALLOC] add some padding
-        if (!uploadData) {
-            logCRITICAL(LOGSRC,"OUT OF MEMORY!!");
-            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_LENGTH);
+        /* same upload resent (ie. after a reconnect)? */
+        if (uploadStream && strEquals(uploadFile, destName) && (uploadSize == lenAddr)) {
+            logINFO(LOGSRC,"Upload resumed: %s [%ld/%ld]", uploadFile, uploadAddr, uploadSize);
+            uploadActiveTime = utcGetTimeSec();
+            uploadGapAddr = -1L;
+            return _uploadAck(protoNdx, rcdType);
+        }
+        
+        /* reset any previous upload attempts */
+        uploadCancel();
+
+        /* get install file path */
+        // eg. Install into "/install/<uploadFile>"
+        char *fp = uploadPath;
+        sprintf(fp, UPLOAD_INSTALL_DIR); fp += strlen(fp);
+        if (!strStartsWith(destName,DIR_SEP)) {
+            // append '/'
+            sprintf(fp, "%s", DIR_SEP); fp += strlen(fp);
+        }
+        sprintf(fp, "%s", destName);
+        sprintf(uploadTemp, "%s%s", uploadPath, UPLOAD_PARTIAL_EXT);
+#if defined(TARGET_WINCE)
+        // for now, all directories must pre-exist
+#else
+        ioMakeDirs(uploadTemp, utTrue); // make dirs
+#endif
+
+        /* resume partially received file */
+        // (installed only if the end record checksum verifies the whole file)
+        long partLen = ioGetFileSize(uploadTemp, -1);
+        if (partLen > lenAddr) {
+            // not the same file
+            ioDeleteFile(uploadTemp);
+            partLen = 0L;
+        }
+        uploadStream = ioOpenStream(uploadTemp, ((partLen > 0L)? IO_OPEN_APPEND : IO_OPEN_WRITE));
+        if (!uploadStream) {
+            uploadCancel();
+            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_SAVE);
             return utFalse;
         }
 
-        /* allocate space for upload */
-        logINFO(LOGSRC,"Upload filename: %s ...", uploadFile);
+        /* start upload */
         strcpy(uploadFile, destName);
+        logINFO(LOGSRC,"Upload filename: %s [%ld/%ld] ...", uploadFile, ((partLen > 0L)? partLen : 0L), lenAddr);
         uploadRcd  = 0L;
         uploadSize = lenAddr;
-        uploadStartTime = utcGetTimeSec();
+        uploadAddr = (partLen > 0L)? (Int32)partLen : 0L;
+        uploadResumeAddr = uploadAddr;
+        uploadActiveTime = utcGetTimeSec();
 
         /* ok, so far */
-        // should send ACK?
-        //protocolQueueDiagnostic(protoNdx,"%2x%1x", (UInt32)DIAG_UPLOAD_ACK, (UInt32)rcdType);
-        return utTrue;
+        return _uploadAck(protoNdx, rcdType);
         
     } else 
     if (rcdType == UPLOAD_TYPE_DATA) {
@@ -234,36 +325,51 @@ static utBool _uploadProcessRecord(int protoNdx, const UInt8 *rcd, int rcdLen)
         /* Simply ignore this packet if we are not uploading */
         // This allows the client to absorb these packets without causing possibly hundreds of
         // errors sent back to the server if a upload error has occurred.
-        if (!uploadData || !(*uploadFile)) {
+        if (!uploadStream || !(*uploadFile)) {
             // No file specification
             uploadCancel();
             return utTrue;
         }
+        uploadActiveTime = utcGetTimeSec();
 
         /* prechecks */
-        if (lenAddr < uploadAddr) {
-            // Data overlap
-            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_OFFSET_OVERLAP);
+        if ((lenAddr + dataLen) > uploadSize) {
+            // data overflow
+            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_OFFSET_OVERFLOW);
             return utFalse;
         } else
         if (lenAddr > uploadAddr) {
-            // Data gap
-            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_OFFSET_GAP);
-            return utFalse;
+            // Data gap (records lost), ask the server to resend from 'uploadAddr'
+            if (uploadGapAddr != uploadAddr) {
+                uploadGapAddr = uploadAddr;
+                protocolQueueError(protoNdx,"%2x%3x", (UInt32)ERROR_UPLOAD_OFFSET_GAP, (UInt32)uploadAddr);
+            }
+            return utTrue;
         } else
-        if ((uploadAddr + BUFFER_DATA_LENGTH(src)) > uploadSize) {
-            // data overflow
-            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_OFFSET_OVERFLOW);
-            return utFalse;
+        if ((lenAddr + dataLen) <= uploadAddr) {
+            // Data overlap (already received)
+            return utTrue;
         }
         
-        /* cache */
-        memcpy(uploadData + uploadAddr, data, dataLen);
-        uploadAddr += dataLen;
+        /* write (skipping any data already received) */
+        int skip = (int)(uploadAddr - lenAddr);
+        long len = ioWriteStream(uploadStream, data + skip, dataLen - skip);
+        if (len != (dataLen - skip)) {
+            // write error
+            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_SAVE);
+            return utFalse;
+        }
+        uploadAddr += len;
+        uploadGapAddr = -1L;
         
         /* count this record */
         uploadRcd++;
         
+        /* acknowledge */
+        if (((uploadAddr - uploadAckAddr) >= UPLOAD_ACK_INTERVAL) || (uploadAddr == uploadSize)) {
+            return _uploadAck(protoNdx, rcdType);
+        }
+        
         /* ok, so far */
         return utTrue;
        
@@ -275,7 +381,7 @@ static utBool _uploadProcessRecord(int protoNdx, const UInt8 *rcd, int rcdLen)
         /* Simply ignore this packet if we are not uploading */
         // This allows the client to absorb this packet without causeing possibly hundreds of
         // errors sent back to the server if a upload error has occurred.
-        if (!uploadData || !(*uploadFile)) {
+        if (!uploadStream || !(*uploadFile)) {
             // No file specification
             uploadCancel();
             return utTrue;
@@ -288,54 +394,50 @@ static utBool _uploadProcessRecord(int protoNdx, const UInt8 *rcd, int rcdLen)
             return utFalse;
         } else
         if (uploadAddr != uploadSize) {
-            // data hole
-            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_OFFSET_GAP);
-            return utFalse;
+            // data hole, ask the server to resend from 'uploadAddr' (unless already asked)
+            if (uploadGapAddr != uploadAddr) {
+                uploadGapAddr = uploadAddr;
+                protocolQueueError(protoNdx,"%2x%3x", (UInt32)ERROR_UPLOAD_OFFSET_GAP, (UInt32)uploadAddr);
+            }
+            return utTrue;
         }
+        ioCloseStream(uploadStream);
+        uploadStream = (FILE*)0;
         
         /* check checksum */
         UInt32 cksumC0 = 0L, cksumC1 = 0L;
         binBufScanf(src, "%1x%1x", &cksumC0, &cksumC1);
         if ((cksumC0 != 0L) || (cksumC1 != 0L)) {
             ChecksumFletcher_t fcsTest = { { (UInt8)cksumC0, (UInt8)cksumC1 } }, fcsCalc;
-            _cksumResetFletcher(&fcsCalc);
-            _cksumCalcFletcher(&fcsCalc, uploadData, uploadSize);
-            if (!_cksumEqualsFletcher(&fcsCalc, &fcsTest)) {
-                // invalid checksum
+            if (!_uploadChecksum(&fcsCalc) || !_cksumEqualsFletcher(&fcsCalc, &fcsTest)) {
+                // invalid checksum (the partial file cannot be resumed)
+                _uploadDiscard();
                 protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_CHECKSUM);
                 return utFalse;
             }
+        } else
+        if (uploadResumeAddr > 0L) {
+            // the resumed data may be from another file, and cannot be verified
+            _uploadDiscard();
+            protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_CHECKSUM);
+            return utFalse;
         }
         
-        /* get install file path */
-        // eg. Install into "/install/<uploadFile>"
-        char filepath[UPLOAD_MAX_FILENAME_SIZE * 2], *fp = filepath;
-        sprintf(fp, UPLOAD_INSTALL_DIR); fp += strlen(fp);
-        if (!strStartsWith(uploadFile,DIR_SEP)) {
-            // append '/'
-            sprintf(fp, "%s", DIR_SEP); fp += strlen(fp);
+        /* install file */
+        logINFO(LOGSRC,"Upload writing file: %s ...", uploadPath);
+        if (ioExists(uploadPath)) {
+            ioDeleteFile(uploadPath);
         }
-        sprintf(fp, "%s", uploadFile);
-        
-        /* write file */
-        logINFO(LOGSRC,"Upload writing file: %s ...", filepath);
-#if defined(TARGET_WINCE)
-        // for now, all directories must pre-exist
-#else
-        ioMakeDirs(filepath, utTrue); // make dirs
-#endif
-        long fileSize = ioWriteFile(filepath, uploadData, uploadSize);
-        if (fileSize != uploadSize) {
+        if (!ioRenameFile(uploadTemp, uploadPath)) {
             // write error
             protocolQueueError(protoNdx,"%2x", (UInt32)ERROR_UPLOAD_SAVE);
             return utFalse;
         }
         
         /* success */
+        utBool ok = _uploadAck(protoNdx, rcdType);
         uploadCancel();
-        // should send ACK?
-        //protocolQueueDiagnostic(protoNdx,"%2x%1x", (UInt32)DIAG_UPLOAD_ACK, (UInt32)rcdType);
-        return utTrue;
+        return ok;
         
     } else {
         
@@ -26,14 +26,22 @@ extern "C" {
 
 // ----------------------------------------------------------------------------
 
+// maximum time between upload records (the partial file is kept for a later resume)
 #define UPLOAD_TIMEOUT_SEC              MINUTE_SECONDS(4)
 
 // ----------------------------------------------------------------------------
 
-#define UPLOAD_MAX_FILE_SIZE            200000L
+// the uploaded file is written to "<file>.part" as it is received (not buffered in 
+// memory), thus the size is limited only by the 3-byte record offset
+#define UPLOAD_MAX_FILE_SIZE            0xFFFFFFL
 #define UPLOAD_MAX_FILENAME_SIZE        64
 #define UPLOAD_MAX_FILE_BLOCKSIZE       72L
 
+#define UPLOAD_PARTIAL_EXT              ".part"
+
+// bytes received between data acknowledgements (must be less than the server window)
+#define UPLOAD_ACK_INTERVAL             1024L
+
 // ----------------------------------------------------------------------------
 
 #define UPLOAD_TYPE_FILE                0x01
@@ -0,0 +1,141 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Circular buffer string throughput benchmark ("tools/buffer.c").
+//  '-count' strings of '-length' bytes are passed through a '-size' byte buffer
+//  (put one/get one, so that strings wrap around the end of the buffer) with:
+//    string - 'bufferPutString'/'bufferGetString' (terminator found with 'memchr')
+//    data   - 'bufferPutData'/'bufferGetData' with the string length known in advance
+//  The 'data' time is the lower bound for a 'bufferGetString' that looks up the
+//  string length in a record-boundary index (the string must still be copied out).
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h" // TARGET_WINCE
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file
+#include "custom/defaults.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/stdtypes.h"
+#include "tools/strtools.h"
+#include "tools/utctools.h"
+#include "tools/buffer.h"
+
+#include "log.h"
+
+// ----------------------------------------------------------------------------
+
+#define DEFAULT_COUNT           2000000L
+#define DEFAULT_LENGTH          77L         // typical log message
+#define DEFAULT_SIZE            2000L       // serial transport buffer
+
+#define MAX_LENGTH              4096L
+
+// ----------------------------------------------------------------------------
+
+#define MODE_STRING             0
+#define MODE_DATA               1
+
+static UInt32 _runBench(int mode, CircleBuffer_t *cb, const char *s, long length, long count)
+{
+    char d[MAX_LENGTH + 1];
+    struct timeval ts0, ts1;
+    long i;
+    bufferClear(cb);
+    utcGetTimestamp(&ts0);
+    for (i = 0L; i < count; i++) {
+        if (mode == MODE_STRING) {
+            bufferPutString(cb, s);
+            if (bufferGetString(cb, d, sizeof(d)) != length) { break; }
+        } else {
+            bufferPutData(cb, s, length + 1);
+            if (bufferGetData(cb, d, length + 1) != (length + 1)) { break; }
+        }
+    }
+    utcGetTimestamp(&ts1);
+    if ((i < count) || strcmp(d, s)) {
+        fprintf(stderr, "Buffer data mismatch\n");
+        exit(1);
+    }
+    return utcGetDeltaMillis(&ts1, &ts0);
+}
+
+static void _printResult(const char *name, UInt32 ms, long count)
+{
+    printf("%-7s: %8lu ms  %7.1f ns/string\n", name, ms, ((double)ms * 1000000.0) / (double)count);
+}
+
+// ----------------------------------------------------------------------------
+
+static void _usage(const char *pgm)
+{
+    fprintf(stderr, "Usage: \n");
+    fprintf(stderr, "   %s [-count <strings>] [-length <bytes>] [-size <bytes>]\n", pgm);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    long count  = DEFAULT_COUNT;
+    long length = DEFAULT_LENGTH;
+    long size   = DEFAULT_SIZE;
+    long i;
+
+    /* args */
+    for (i = 1; i < argc; i++) {
+        if (strEqualsIgnoreCase(argv[i], "-count") && ((i + 1) < argc)) {
+            count = strParseInt32(argv[++i], DEFAULT_COUNT);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-length") && ((i + 1) < argc)) {
+            length = strParseInt32(argv[++i], DEFAULT_LENGTH);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-size") && ((i + 1) < argc)) {
+            size = strParseInt32(argv[++i], DEFAULT_SIZE);
+        } else {
+            _usage(argv[0]);
+        }
+    }
+    if ((count <= 0L) || (length <= 0L) || (length > MAX_LENGTH) || (size <= (length + 1L))) {
+        _usage(argv[0]);
+    }
+
+    /* string */
+    char s[MAX_LENGTH + 1];
+    for (i = 0L; i < length; i++) {
+        s[i] = 'a' + (char)(i % 26L);
+    }
+    s[length] = 0;
+    CircleBuffer_t *cb = bufferCreate(size);
+    if (!cb) {
+        return 1;
+    }
+    printf("Strings: %ld x %ld bytes, %ld byte buffer\n", count, length, size);
+
+    /* run */
+    _printResult("string", _runBench(MODE_STRING, cb, s, length, count), count);
+    _printResult("data",   _runBench(MODE_DATA,   cb, s, length, count), count);
+    bufferDestroy(cb);
+    return 0;
+
+}
+
+// ----------------------------------------------------------------------------
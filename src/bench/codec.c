@@ -0,0 +1,293 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Packet payload codec throughput benchmark ("tools/base64.c", "tools/strtools.c").
+//  A random '-size' byte payload is encoded/decoded '-passes' times with the
+//  'legacy' (previous per-character branch/'sprintf') and current (table driven)
+//  Base64 and hex functions.  The results of both are compared before timing.
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h" // TARGET_WINCE
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file
+#include "custom/defaults.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/stdtypes.h"
+#include "tools/strtools.h"
+#include "tools/utctools.h"
+#include "tools/base64.h"
+
+#include "log.h"
+
+// ----------------------------------------------------------------------------
+
+#define DEFAULT_SIZE            240L        // typical packet payload
+#define DEFAULT_PASSES          200000L
+
+#define MAX_SIZE                4096L
+
+// ----------------------------------------------------------------------------
+// previous "tools/base64.c" implementation
+
+static UInt8 legacyBase64Map[] = {
+    'A','B','C','D','E','F','G','H','I','J','K','L','M',
+    'N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
+    'a','b','c','d','e','f','g','h','i','j','k','l','m',
+    'n','o','p','q','r','s','t','u','v','w','x','y','z',
+    '0','1','2','3','4','5','6','7','8','9','+','/'
+};
+
+static int _legacyB64IndexOf(UInt8 ch)
+{
+    if ((ch >= 'A') && (ch <= 'Z')) { return  0 + (ch - 'A'); }
+    if ((ch >= 'a') && (ch <= 'z')) { return 26 + (ch - 'a'); }
+    if ((ch >= '0') && (ch <= '9')) { return 52 + (ch - '0'); }
+    if (ch == '+')                  { return 62;              }
+    if (ch == '/')                  { return 63;              }
+    return 0;
+}
+
+static long _legacyBase64Encode(char *b64Out, long b64OutLen, const UInt8 *dataIn, long dataInLen)
+{
+    long minOutlen = ((dataInLen + 2L) / 3L) * 4L;
+    if (b64OutLen < minOutlen) {
+        return -1L;
+    }
+    long i, d = 0L;
+    for (i = 0L; i < dataInLen; i += 3L) {
+        UInt32                  reg24  = ((UInt32)dataIn[i+0L] << 16) & 0xFF0000;
+        if ((i+1L)<dataInLen) { reg24 |= ((UInt32)dataIn[i+1L] <<  8) & 0x00FF00; }
+        if ((i+2L)<dataInLen) { reg24 |= ((UInt32)dataIn[i+2L]      ) & 0x0000FF; }
+        b64Out[d++] =                     legacyBase64Map[(reg24 >> 18) & 0x3F];
+        b64Out[d++] =                     legacyBase64Map[(reg24 >> 12) & 0x3F];
+        b64Out[d++] = ((i+1L)<dataInLen)? legacyBase64Map[(reg24 >>  6) & 0x3F] : BASE64_PAD;
+        b64Out[d++] = ((i+2L)<dataInLen)? legacyBase64Map[(reg24      ) & 0x3F] : BASE64_PAD;
+    }
+    b64Out[d] = 0;
+    return d;
+}
+
+static long _legacyBase64Decode(const char *b64In, long b64InLen, UInt8 *dataOut, long dataOutlen)
+{
+    while ((b64InLen > 0) && (b64In[b64InLen - 1] == BASE64_PAD)) { b64InLen--; }
+    long minOutlen = (((b64InLen - 1L) / 4L) * 3L) + ((b64InLen - 1L) % 4L);
+    if (((b64InLen - 1L) % 4L) == 0L) {
+        minOutlen++;
+    }
+    if (dataOutlen < minOutlen) {
+        return -1L;
+    }
+    long i, d = 0L;
+    for (i = 0L; i < b64InLen; i += 4L) {
+        UInt32                 reg24  = (_legacyB64IndexOf(b64In[i+0L]) << 18) & 0xFC0000;
+        if ((i+1L)<b64InLen) { reg24 |= (_legacyB64IndexOf(b64In[i+1L]) << 12) & 0x03F000; }
+        if ((i+2L)<b64InLen) { reg24 |= (_legacyB64IndexOf(b64In[i+2L]) <<  6) & 0x000FC0; }
+        if ((i+3L)<b64InLen) { reg24 |= (_legacyB64IndexOf(b64In[i+3L])      ) & 0x00003F; }
+                               dataOut[d++] = (UInt8)((reg24 >> 16) & 0xFF);
+        if ((i+2L)<b64InLen) { dataOut[d++] = (UInt8)((reg24 >>  8) & 0xFF); }
+        if ((i+3L)<b64InLen) { dataOut[d++] = (UInt8)((reg24      ) & 0xFF); }
+    }
+    return d;
+}
+
+// ----------------------------------------------------------------------------
+// previous "tools/strtools.c" hex implementation
+
+static int _legacyHexNybble(UInt8 ch)
+{
+    if ((ch >= '0') && (ch <= '9')) {
+        return (int)(ch - '0') & 0xF;
+    } else
+    if ((ch >= 'a') && (ch <= 'f')) {
+        return ((int)(ch - 'a') & 0xF) + 10;
+    } else
+    if ((ch >= 'A') && (ch <= 'F')) {
+        return ((int)(ch - 'A') & 0xF) + 10;
+    } else {
+        return -1;
+    }
+}
+
+static int _legacyParseHex(const char *hex, int hexLen, UInt8 *data, int dataLen)
+{
+    int len = (hexLen >= 0)? strLength(hex, hexLen) : strlen(hex);
+    const char *h = hex;
+    if ((len >= 2) && (*h == '0') && ((*(h+1) == 'x') || (*(h+1) == 'X'))) {
+        h += 2;
+        len -= 2;
+    }
+    if (len & 1) { len--; }
+    if (len < 2) {
+        return 0;
+    }
+    int i;
+    for (i = 0; (i < len) && ((i/2) < dataLen); i += 2) {
+        int c1 = _legacyHexNybble(h[i]);
+        if (c1 < 0) { break; }
+        int c2 = _legacyHexNybble(h[i+1]);
+        if (c2 < 0) { break; }
+        data[i/2] = (UInt8)(((c1 << 4) & 0xF0) | (c2 & 0x0F));
+    }
+    return i/2;
+}
+
+static char *_legacyEncodeHex(char *hex, int hexLen, const UInt8 *data, int dataLen)
+{
+    *hex = 0;
+    if ((hexLen < 0) || (hexLen >= ((dataLen * 2) + 1))) {
+        int i;
+        char *h = hex;
+        for (i = 0; i < dataLen; i++) {
+            sprintf(h, "%02X", (unsigned int)data[i] & 0xFF);
+            h += strlen(h);
+        }
+        return hex;
+    } else {
+        return (char*)0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+static UInt8                data[MAX_SIZE];
+static char                 b64[(MAX_SIZE * 4L / 3L) + 8L];
+static char                 hex[(MAX_SIZE * 2L) + 2L];
+static UInt8                out[MAX_SIZE];
+static long                 size = DEFAULT_SIZE;
+
+#define MODE_B64_DECODE         0
+#define MODE_B64_ENCODE         1
+#define MODE_HEX_PARSE          2
+#define MODE_HEX_ENCODE         3
+
+static UInt32 _runBench(int mode, utBool legacy, long passes)
+{
+    struct timeval ts0, ts1;
+    long b64Len = strlen(b64), hexLen = strlen(hex), p;
+    utcGetTimestamp(&ts0);
+    for (p = 0L; p < passes; p++) {
+        switch (mode) {
+            case MODE_B64_DECODE:
+                if (legacy) {
+                    _legacyBase64Decode(b64, b64Len, out, sizeof(out));
+                } else {
+                    base64Decode(b64, b64Len, out, sizeof(out));
+                }
+                break;
+            case MODE_B64_ENCODE:
+                if (legacy) {
+                    _legacyBase64Encode(b64, sizeof(b64), data, size);
+                } else {
+                    base64Encode(b64, sizeof(b64), data, size);
+                }
+                break;
+            case MODE_HEX_PARSE:
+                if (legacy) {
+                    _legacyParseHex(hex, hexLen, out, sizeof(out));
+                } else {
+                    strParseHex(hex, hexLen, out, sizeof(out));
+                }
+                break;
+            case MODE_HEX_ENCODE:
+                if (legacy) {
+                    _legacyEncodeHex(hex, sizeof(hex), data, size);
+                } else {
+                    strEncodeHex(hex, sizeof(hex), data, size);
+                }
+                break;
+        }
+    }
+    utcGetTimestamp(&ts1);
+    return utcGetDeltaMillis(&ts1, &ts0);
+}
+
+static void _printResult(const char *name, int mode, long passes)
+{
+    UInt32 msLegacy = _runBench(mode, utTrue,  passes);
+    UInt32 msTable  = _runBench(mode, utFalse, passes);
+    double mb = ((double)size * (double)passes) / 1000000.0; // payload bytes
+    printf("%-14s: legacy %8.1f MB/sec   table %8.1f MB/sec\n", name,
+        mb / ((msLegacy > 0L)? ((double)msLegacy / 1000.0) : 0.001),
+        mb / ((msTable  > 0L)? ((double)msTable  / 1000.0) : 0.001));
+}
+
+// ----------------------------------------------------------------------------
+
+static void _usage(const char *pgm)
+{
+    fprintf(stderr, "Usage: \n");
+    fprintf(stderr, "   %s [-size <bytes>] [-passes <count>]\n", pgm);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    long passes = DEFAULT_PASSES;
+    long i;
+
+    /* args */
+    for (i = 1; i < argc; i++) {
+        if (strEqualsIgnoreCase(argv[i], "-size") && ((i + 1) < argc)) {
+            size = strParseInt32(argv[++i], DEFAULT_SIZE);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-passes") && ((i + 1) < argc)) {
+            passes = strParseInt32(argv[++i], DEFAULT_PASSES);
+        } else {
+            _usage(argv[0]);
+        }
+    }
+    if ((size <= 0L) || (size > MAX_SIZE) || (passes <= 0L)) {
+        _usage(argv[0]);
+    }
+    srand(1);
+    for (i = 0L; i < size; i++) {
+        data[i] = (UInt8)(rand() & 0xFF);
+    }
+
+    /* compare results */
+    char b64Legacy[sizeof(b64)], hexLegacy[sizeof(hex)];
+    UInt8 outLegacy[MAX_SIZE];
+    long b64Len = base64Encode(b64, sizeof(b64), data, size);
+    _legacyBase64Encode(b64Legacy, sizeof(b64Legacy), data, size);
+    strEncodeHex(hex, sizeof(hex), data, size);
+    _legacyEncodeHex(hexLegacy, sizeof(hexLegacy), data, size);
+    long b64OutLen = base64Decode(b64, b64Len, out, sizeof(out));
+    long b64OutLegacy = _legacyBase64Decode(b64, b64Len, outLegacy, sizeof(outLegacy));
+    if (strcmp(b64, b64Legacy) || strcmp(hex, hexLegacy) ||
+        (b64OutLen != size) || (b64OutLegacy != size) || memcmp(out, outLegacy, size) ||
+        (strParseHex(hex, strlen(hex), out, sizeof(out)) != size) || memcmp(out, data, size)) {
+        fprintf(stderr, "Legacy/table results differ\n");
+        return 1;
+    }
+    printf("Payload       : %ld bytes x %ld passes\n", size, passes);
+
+    /* run */
+    _printResult("base64 decode", MODE_B64_DECODE, passes);
+    _printResult("base64 encode", MODE_B64_ENCODE, passes);
+    _printResult("hex parse",     MODE_HEX_PARSE,  passes);
+    _printResult("hex encode",    MODE_HEX_ENCODE, passes);
+    return 0;
+
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,400 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Differential test of the compiled event encoder ("base/events.c") against the
+//  'binFmtPrintf' encoding of the same definition.
+//  '-events' random events (including out-of-range values) are encoded through both
+//  paths for the fixed formats 0xE030/0xE031, and for custom definitions covering the
+//  remaining fixed length field types.  Exits with '1' if any resulting Packet_t
+//  differs (or if a definition is not compiled as expected), and reports the time
+//  of both paths.
+// ---
+// Notes:
+//  - "base/events.c" and "base/pqueue.c" are compiled into this file, so that the
+//    static encoder functions are available (neither uses the transport media).
+// ----------------------------------------------------------------------------
+
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file
+#include "base/events.c"
+#include "base/pqueue.c"
+
+#include "log.h"
+
+// ----------------------------------------------------------------------------
+
+#define DEFAULT_EVENTS          100000L
+
+#define MAX_REPORTED            5
+
+// ----------------------------------------------------------------------------
+
+/* GPS statistics */
+static FieldDef_t   CustomFields_50[] = {
+    EVENT_FIELD(FIELD_STATUS_CODE       , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_TIMESTAMP         , HI_RES, 0, 4),
+    EVENT_FIELD(FIELD_GPS_POINT         , HI_RES, 0, 8),
+    EVENT_FIELD(FIELD_GPS_AGE           , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_GPS_DGPS_UPDATE   , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_GPS_HORZ_ACCURACY , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_GPS_VERT_ACCURACY , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_GPS_SATELLITES    , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_GPS_MAG_VARIATION , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_GPS_QUALITY       , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_GPS_TYPE          , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_GPS_GEOID_HEIGHT  , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_GPS_PDOP          , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_GPS_HDOP          , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_GPS_VDOP          , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_SEQUENCE          , HI_RES, 0, 2),
+};
+
+/* digital/analog inputs, temperatures */
+static FieldDef_t   CustomFields_51[] = {
+    EVENT_FIELD(FIELD_STATUS_CODE       , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_TIMESTAMP         , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_INDEX             , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_INPUT_ID          , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_INPUT_STATE       , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_OUTPUT_ID         , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_OUTPUT_STATE      , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_ELAPSED_TIME      , LO_RES, 3, 4),
+    EVENT_FIELD(FIELD_COUNTER           , LO_RES, 0, 3),
+    EVENT_FIELD(FIELD_SENSOR32_LOW      , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_SENSOR32_HIGH     , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_SENSOR32_AVER     , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_TEMP_LOW          , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_TEMP_HIGH         , HI_RES, 1, 2),
+    EVENT_FIELD(FIELD_TEMP_AVER         , HI_RES, 2, 2),
+    EVENT_FIELD(FIELD_SEQUENCE          , LO_RES, 0, 1),
+};
+
+/* motion, padded strings, OBC */
+static FieldDef_t   CustomFields_52[] = {
+    EVENT_FIELD(FIELD_STATUS_CODE       , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_TIMESTAMP         , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_GPS_POINT         , LO_RES, 0, 6),
+    EVENT_FIELD(FIELD_SPEED             , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_HEADING           , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_ALTITUDE          , HI_RES, 0, 3),
+    EVENT_FIELD(FIELD_ODOMETER          , HI_RES, 0, 4),
+    EVENT_FIELD(FIELD_GEOFENCE_ID       , LO_RES, 1, 4),
+    EVENT_FIELD(FIELD_TOP_SPEED         , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_STRING_PAD        , LO_RES, 1, 10),
+    EVENT_FIELD(FIELD_ENTITY_PAD        , LO_RES, 0, MAX_ID_SIZE),
+    EVENT_FIELD(FIELD_OBC_GENERIC       , LO_RES, 2, 4),
+    EVENT_FIELD(FIELD_OBC_J1708_FAULT   , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_OBC_DISTANCE      , HI_RES, 0, 4),
+    EVENT_FIELD(FIELD_OBC_ENGINE_HOURS  , LO_RES, 0, 3),
+    EVENT_FIELD(FIELD_OBC_ENGINE_RPM    , LO_RES, 0, 2),
+};
+
+/* OBC levels, 4 byte sequence */
+static FieldDef_t   CustomFields_53[] = {
+    EVENT_FIELD(FIELD_STATUS_CODE       , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_TIMESTAMP         , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_OBC_COOLANT_TEMP  , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_OBC_COOLANT_LEVEL , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_OBC_OIL_LEVEL     , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_OBC_OIL_PRESSURE  , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_OBC_FUEL_LEVEL    , HI_RES, 0, 2),
+    EVENT_FIELD(FIELD_OBC_FUEL_ECONOMY  , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_OBC_FUEL_USED     , HI_RES, 0, 4),
+    EVENT_FIELD(FIELD_DISTANCE          , LO_RES, 0, 3),
+    EVENT_FIELD(FIELD_SPEED             , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_HEADING           , LO_RES, 0, 1),
+    EVENT_FIELD(FIELD_ALTITUDE          , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_SEQUENCE          , HI_RES, 0, 4),
+};
+
+/* variable length fields (not compiled, see 'main') */
+static FieldDef_t   CustomFields_54[] = {
+    EVENT_FIELD(FIELD_STATUS_CODE       , LO_RES, 0, 2),
+    EVENT_FIELD(FIELD_TIMESTAMP         , LO_RES, 0, 4),
+    EVENT_FIELD(FIELD_STRING            , LO_RES, 0, 10),
+    EVENT_FIELD(FIELD_BINARY            , LO_RES, 0, 8),
+    EVENT_FIELD(FIELD_SEQUENCE          , LO_RES, 0, 1),
+};
+
+#define CUSTOM_DEF(T,F)     { (T), (sizeof(F)/sizeof(F[0])), (F) }
+static CustomDef_t CustomPacket[] = {
+    CUSTOM_DEF(PKT_CLIENT_DMTSP_FORMAT_0, CustomFields_50),
+    CUSTOM_DEF(PKT_CLIENT_DMTSP_FORMAT_1, CustomFields_51),
+    CUSTOM_DEF(PKT_CLIENT_DMTSP_FORMAT_2, CustomFields_52),
+    CUSTOM_DEF(PKT_CLIENT_DMTSP_FORMAT_3, CustomFields_53),
+    CUSTOM_DEF(PKT_CLIENT_DMTSP_FORMAT_4, CustomFields_54),
+};
+
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    ClientPacketType_t      hdrType;
+    utBool                  compiled;   // expected
+    long                    count;
+    long                    failed;
+} DiffResult_t;
+
+static double _random(double min, double max)
+{
+    return min + ((max - min) * ((double)rand() / ((double)RAND_MAX + 1.0)));
+}
+
+static UInt32 _random32()
+{
+    return ((UInt32)(rand() & 0xFFFF) << 16) | (UInt32)(rand() & 0xFFFF);
+}
+
+/* random value, occasionally outside of the encoded field range */
+static double _randomValue(double max)
+{
+    return ((rand() % 16) == 0)? _random(-max, max * 4.0) : _random(0.0, max);
+}
+
+static void _randomString(char *s, int maxLen)
+{
+    static const char *chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-.";
+    int i, len = rand() % (maxLen + 1);
+    for (i = 0; i < len; i++) {
+        s[i] = chars[rand() % strlen(chars)];
+    }
+    s[len] = 0;
+}
+
+/* random event (all fields) */
+static void _randomEvent(Event_t *er)
+{
+    int n;
+    memset(er, 0, sizeof(Event_t));
+    er->statusCode          = (UInt16)_random32();
+    er->timestamp[0]        = _random32();
+    er->index               = _random32();
+    gpsPoint(&(er->gpsPoint[0]), _random(-90.0, 90.0), _random(-180.0, 180.0));
+    er->gpsAge              = ((rand() % 4) == 0)? _random32() : (UInt32)(rand() % 600);
+    er->speedKPH            = _randomValue(250.0);
+    er->heading             = _random(0.0, 360.0);
+    er->altitude            = _random(-500.0, 9000.0);
+    er->distanceKM          = _randomValue(1000000.0);
+    er->odometerKM          = _randomValue(1000000.0);
+    er->geofenceID[0]       = _random32();
+    er->geofenceID[1]       = _random32();
+    er->topSpeedKPH         = _randomValue(250.0);
+    for (n = 0; n < 2; n++) {
+        _randomString(er->entity[n], MAX_ID_SIZE);
+        _randomString(er->string[n], MAX_ID_SIZE);
+    }
+    er->inputID             = _random32();
+    er->inputState          = _random32();
+    er->outputID            = _random32();
+    er->outputState         = _random32();
+    for (n = 0; n < 8; n++) {
+        er->elapsedTimeSec[n] = _random32();
+    }
+    er->counter[0]          = _random32();
+    er->sensor32LO[0]       = _random32();
+    er->sensor32HI[0]       = _random32();
+    er->sensor32AV[0]       = _random32();
+    for (n = 0; n < 4; n++) {
+        er->tempLO[n]       = _random(-4000.0, 4000.0); // includes clipped values
+        er->tempHI[n]       = _random(-4000.0, 4000.0);
+        er->tempAV[n]       = _random(-4000.0, 4000.0);
+    }
+    er->gpsDgpsUpdate       = (UInt32)(rand() % 3600);
+    er->gpsHorzAccuracy     = _randomValue(300.0);
+    er->gpsVertAccuracy     = _randomValue(300.0);
+    er->gpsSatellites       = (UInt32)(rand() % 13);
+    er->gpsMagVariation     = _random(-180.0, 180.0);
+    er->gpsQuality          = (UInt32)(rand() % 3);
+    er->gps2D3D             = (UInt32)(rand() % 4);
+    er->gpsGeoidHeight      = _random(-120.0, 120.0);
+    er->gpsPDOP             = _randomValue(30.0); // includes values above 25.5
+    er->gpsHDOP             = _randomValue(30.0);
+    er->gpsVDOP             = _randomValue(30.0);
+    for (n = 0; n < 10; n++) {
+        er->obcGeneric[n]   = _random32();
+    }
+    er->obcJ1708Fault[0]    = _random32();
+    er->obcJ1708Fault[1]    = _random32();
+    er->obcDistanceKM       = _randomValue(1000000.0);
+    er->obcEngineHours      = _randomValue(100000.0);
+    er->obcEngineRPM        = (UInt32)(rand() % 8000);
+    er->obcCoolantTemp      = _random(-40.0, 150.0);
+    er->obcCoolantLevel     = _randomValue(100.0);
+    er->obcOilLevel         = _randomValue(100.0);
+    er->obcOilPressure      = _randomValue(700.0);
+    er->obcFuelLevel        = _randomValue(100.0);
+    er->obcFuelEconomy      = _randomValue(50.0);
+    er->obcAvgFuelEcon      = ((rand() % 2) == 0)? 0.0 : _randomValue(50.0);
+    er->obcFuelUsed         = _randomValue(100000.0);
+}
+
+// ----------------------------------------------------------------------------
+
+/* report the first difference between two packets */
+static void _printDiff(const Packet_t *pc, const Packet_t *pf, long evNdx)
+{
+    int i;
+    printf("  0x%04lX event #%ld:", (UInt32)pc->hdrType, evNdx);
+    if ((pc->sequence != pf->sequence) || (pc->seqPos != pf->seqPos) || (pc->seqLen != pf->seqLen)) {
+        printf(" sequence 0x%08lX/%u/%u, expected 0x%08lX/%u/%u\n",
+            (UInt32)pc->sequence, pc->seqPos, pc->seqLen, (UInt32)pf->sequence, pf->seqPos, pf->seqLen);
+    } else
+    if (pc->dataLen != pf->dataLen) {
+        printf(" length %u, expected %u\n", pc->dataLen, pf->dataLen);
+    } else
+    if (strcmp(pc->dataFmt, pf->dataFmt) != 0) {
+        printf(" format \"%s\", expected \"%s\"\n", pc->dataFmt, pf->dataFmt);
+    } else {
+        for (i = 0; (i < (int)sizeof(pc->data)) && (pc->data[i] == pf->data[i]); i++);
+        if (i < (int)sizeof(pc->data)) {
+            printf(" byte %d 0x%02X, expected 0x%02X\n", i, pc->data[i], pf->data[i]);
+        } else {
+            printf(" packet header\n");
+        }
+    }
+}
+
+/* encode 'count' events through both paths */
+static void _check(DiffResult_t *r, CustomDef_t *custDef, Event_t *ev, long count)
+{
+    EventEncoder_t *enc = _evGetEncoderForDefinition(custDef);
+    UInt32 seqC = _random32(), seqF = seqC;
+    long i;
+    if ((enc? utTrue : utFalse) != r->compiled) {
+        printf("  0x%04lX is %scompiled\n", (UInt32)custDef->hdrType, enc? "" : "not ");
+        r->failed++;
+    }
+    for (i = 0L; i < count; i++) {
+        Packet_t pc, pf;
+        memset(&pc, 0xA5, sizeof(Packet_t)); // 'pktInit' must clear everything
+        memset(&pf, 0x5A, sizeof(Packet_t));
+        _evCreateEventPacket(&pc, custDef->hdrType, custDef, enc, &seqC, &ev[i]);
+        _evCreateEventPacket(&pf, custDef->hdrType, custDef, (EventEncoder_t*)0, &seqF, &ev[i]);
+        r->count++;
+        if (memcmp(&pc, &pf, sizeof(Packet_t)) != 0) {
+            if (r->failed < MAX_REPORTED) {
+                _printDiff(&pc, &pf, i);
+            }
+            r->failed++;
+        }
+    }
+}
+
+static void _printResult(const DiffResult_t *r)
+{
+    printf("0x%04lX (%-8s): %8ld checked  %s\n", (UInt32)r->hdrType,
+        r->compiled? "compiled" : "printf", r->count, r->failed? "FAILED" : "ok");
+}
+
+/* time 'count' events through both paths, for each compiled definition */
+static void _timePaths(CustomDef_t **defs, int defCount, Event_t *ev, long count)
+{
+    struct timeval ts0, ts1;
+    UInt32 seq = 0L;
+    Packet_t pkt;
+    long i;
+    int d, pass;
+    UInt32 ms[2];
+    for (pass = 0; pass < 2; pass++) {
+        utcGetTimestamp(&ts0);
+        for (d = 0; d < defCount; d++) {
+            EventEncoder_t *enc = _evGetEncoderForDefinition(defs[d]);
+            if (!enc) {
+                continue;
+            }
+            for (i = 0L; i < count; i++) {
+                _evCreateEventPacket(&pkt, defs[d]->hdrType, defs[d], (pass == 0)? enc : (EventEncoder_t*)0, &seq, &ev[i]);
+            }
+        }
+        utcGetTimestamp(&ts1);
+        ms[pass] = utcGetDeltaMillis(&ts1, &ts0);
+    }
+    printf("Time (compiled) : %8lu ms\n", ms[0]);
+    printf("Time (printf)   : %8lu ms\n", ms[1]);
+}
+
+// ----------------------------------------------------------------------------
+
+static void _usage(const char *pgm)
+{
+    fprintf(stderr, "Usage: \n");
+    fprintf(stderr, "   %s [-events <count>]\n", pgm);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    long events = DEFAULT_EVENTS;
+    long i, failed = 0L;
+    int d;
+
+    /* args */
+    for (i = 1; i < argc; i++) {
+        if (strEqualsIgnoreCase(argv[i], "-events") && ((i + 1) < argc)) {
+            events = strParseInt32(argv[++i], DEFAULT_EVENTS);
+        } else {
+            _usage(argv[0]);
+        }
+    }
+    if (events <= 0L) {
+        _usage(argv[0]);
+    }
+    srand(1);
+
+    /* compile fixed/custom definitions */
+    evInitialize();
+    CustomDef_t *defs[2 + (sizeof(CustomPacket)/sizeof(CustomPacket[0]))];
+    int defCount = 0;
+    defs[defCount++] = &FixedPacket_30;
+    defs[defCount++] = &FixedPacket_31;
+    for (d = 0; d < (int)(sizeof(CustomPacket)/sizeof(CustomPacket[0])); d++) {
+        if (!evAddCustomDefinition(&CustomPacket[d])) {
+            fprintf(stderr, "Unable to add custom definition 0x%04lX\n", (UInt32)CustomPacket[d].hdrType);
+            return 1;
+        }
+        defs[defCount++] = &CustomPacket[d];
+    }
+
+    /* events (generated before timing) */
+    Event_t *ev = (Event_t*)malloc(events * sizeof(Event_t));
+    if (!ev) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (i = 0L; i < events; i++) {
+        _randomEvent(&ev[i]);
+    }
+
+    /* compare */
+    for (d = 0; d < defCount; d++) {
+        utBool compiled = (defs[d]->hdrType != PKT_CLIENT_DMTSP_FORMAT_4)? utTrue : utFalse;
+        DiffResult_t r = { defs[d]->hdrType, compiled, 0L, 0L };
+        _check(&r, defs[d], ev, events);
+        _printResult(&r);
+        failed += r.failed;
+    }
+
+    /* time */
+    _timePaths(defs, defCount, ev, events);
+
+    free(ev);
+    return failed? 1 : 0;
+
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,212 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Server-side geozone evaluation benchmark ("server/geozone.c").
+//  Generates a zone file of '-zones' radius/rectangle zones, and then checks
+//  '-fixes' fixes from '-devices' devices (random walks starting at zones)
+//  against the loaded zones, reporting the index build time and the number of
+//  fixes checked per second.
+// ----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "tools/stdtypes.h"
+#include "tools/strtools.h"
+#include "tools/utctools.h"
+#include "tools/gpstools.h"
+
+#include "base/statcode.h"
+
+#include "server/defaults.h"
+#include "server/log.h"
+#include "server/events.h"
+#include "server/geozone.h"
+
+// ----------------------------------------------------------------------------
+
+#define DEFAULT_ZONES           100000L
+#define DEFAULT_FIXES           1000000L
+#define DEFAULT_DEVICES         1000L
+
+// zone area (continental US)
+#define AREA_LAT_MIN            30.0
+#define AREA_LAT_MAX            45.0
+#define AREA_LON_MIN            -120.0
+#define AREA_LON_MAX            -75.0
+
+// device step between fixes (degrees, about 200 meters)
+#define DEVICE_STEP             0.002
+
+// ----------------------------------------------------------------------------
+
+static UInt32 arriveCount = 0L;
+static UInt32 departCount = 0L;
+
+static void _handleEvent(Packet_t *pkt, Event_t *ev)
+{
+    if (ev->statusCode == STATUS_GEOFENCE_ARRIVE) {
+        arriveCount++;
+    } else
+    if (ev->statusCode == STATUS_GEOFENCE_DEPART) {
+        departCount++;
+    }
+}
+
+static double _random(double min, double max)
+{
+    return min + ((max - min) * ((double)rand() / ((double)RAND_MAX + 1.0)));
+}
+
+// ----------------------------------------------------------------------------
+
+/* write zone file, returns the zone centers */
+static GPSPoint_t *_writeZones(const char *zoneFile, long zoneCount)
+{
+    FILE *file = fopen(zoneFile, "w");
+    GPSPoint_t *center = (GPSPoint_t*)malloc(zoneCount * sizeof(GPSPoint_t));
+    if (!file || !center) {
+        fprintf(stderr, "Unable to create zone file: %s\n", zoneFile);
+        if (file) { fclose(file); }
+        free(center);
+        return (GPSPoint_t*)0;
+    }
+    long z;
+    for (z = 0L; z < zoneCount; z++) {
+        UInt32 zoneID = (UInt32)(z % 65535L) + 1L;
+        double lat = _random(AREA_LAT_MIN, AREA_LAT_MAX);
+        double lon = _random(AREA_LON_MIN, AREA_LON_MAX);
+        gpsPoint(&center[z], lat, lon);
+        if ((z % 10L) == 9L) {
+            // bounded rectangle (about 1km)
+            fprintf(file, "%lu,1,1,%.5f,%.5f,%.5f,%.5f\n", zoneID, lat + 0.005, lon - 0.005, lat - 0.005, lon + 0.005);
+        } else {
+            // point/radius
+            fprintf(file, "%lu,0,%d,%.5f,%.5f,0,0\n", zoneID, (int)_random(100.0, 1000.0), lat, lon);
+        }
+    }
+    fclose(file);
+    return center;
+}
+
+// ----------------------------------------------------------------------------
+
+static void _usage(const char *pgm)
+{
+    fprintf(stderr, "Usage: \n");
+    fprintf(stderr, "   %s [-zones <count>] [-fixes <count>] [-devices <count>]\n", pgm);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    long zoneCount   = DEFAULT_ZONES;
+    long fixCount    = DEFAULT_FIXES;
+    long deviceCount = DEFAULT_DEVICES;
+    int i;
+
+    /* args */
+    for (i = 1; i < argc; i++) {
+        if (strEqualsIgnoreCase(argv[i], "-zones") && ((i + 1) < argc)) {
+            zoneCount = strParseInt32(argv[++i], DEFAULT_ZONES);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-fixes") && ((i + 1) < argc)) {
+            fixCount = strParseInt32(argv[++i], DEFAULT_FIXES);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-devices") && ((i + 1) < argc)) {
+            deviceCount = strParseInt32(argv[++i], DEFAULT_DEVICES);
+        } else {
+            _usage(argv[0]);
+        }
+    }
+    if ((zoneCount <= 0L) || (fixCount <= 0L) || (deviceCount <= 0L)) {
+        _usage(argv[0]);
+    }
+    logSetCategoryLevel(LOGCAT_SERVER, LOGLVL_WARNING);
+    srand(1);
+
+    /* zones */
+    char zoneFile[64];
+    sprintf(zoneFile, "/tmp/bench_geozone_%d.txt", (int)getpid());
+    GPSPoint_t *center = _writeZones(zoneFile, zoneCount);
+    if (!center) {
+        return 1;
+    }
+    struct timeval ts0, ts1;
+    utcGetTimestamp(&ts0);
+    int loaded = geozLoadEvalGeozones(zoneFile);
+    utcGetTimestamp(&ts1);
+    unlink(zoneFile);
+    if (loaded <= 0) {
+        fprintf(stderr, "Unable to load zones\n");
+        return 1;
+    }
+    printf("Zones  : %d loaded/indexed in %lu ms\n", loaded, utcGetDeltaMillis(&ts1, &ts0));
+
+    /* fixes (generated before timing) */
+    GPSPoint_t *device = (GPSPoint_t*)malloc(deviceCount * sizeof(GPSPoint_t));
+    GPSPoint_t *fix = (GPSPoint_t*)malloc(fixCount * sizeof(GPSPoint_t));
+    char (*deviceID)[MAX_ID_SIZE + 1] = malloc(deviceCount * (MAX_ID_SIZE + 1));
+    if (!device || !fix || !deviceID) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    long d, f;
+    for (d = 0L; d < deviceCount; d++) {
+        gpsPointCopy(&device[d], &center[rand() % zoneCount]);
+        sprintf(deviceID[d], "dev%ld", d);
+    }
+    for (f = 0L; f < fixCount; f++) {
+        GPSPoint_t *gp = &device[f % deviceCount];
+        gp->latitude  += _random(-DEVICE_STEP, DEVICE_STEP);
+        gp->longitude += _random(-DEVICE_STEP, DEVICE_STEP);
+        gpsPointCopy(&fix[f], gp);
+    }
+
+    /* check fixes */
+    Event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.statusCode = STATUS_LOCATION;
+    geozSetEvalEventHandler(&_handleEvent);
+    utcGetTimestamp(&ts0);
+    for (f = 0L; f < fixCount; f++) {
+        d = f % deviceCount;
+        ev.timestamp[0] = 1000000L + (UInt32)(f / deviceCount);
+        gpsPointCopy(&(ev.gpsPoint[0]), &fix[f]);
+        geozCheckEvent("bench", deviceID[d], &ev);
+    }
+    utcGetTimestamp(&ts1);
+    UInt32 ms = utcGetDeltaMillis(&ts1, &ts0);
+    printf("Fixes  : %ld from %ld devices in %lu ms (%.0f fixes/sec)\n",
+        fixCount, deviceCount, ms, (ms > 0L)? ((double)fixCount * 1000.0 / (double)ms) : 0.0);
+    printf("Events : %lu arrive, %lu depart\n", arriveCount, departCount);
+
+    free(center);
+    free(device);
+    free(fix);
+    free(deviceID);
+    return 0;
+
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,218 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Batch distance throughput benchmark ("tools/gpstools.c"), single thread.
+//  '-points' random points (a track of 200 meter steps) are measured with:
+//    scalar    - 'gpsMetersToPoint' from one point to each point
+//    batch     - 'gpsMetersToPoints' (structure-of-arrays)
+//    seg-scalar- 'gpsMetersToPoint' between consecutive points
+//    polyline  - 'gpsPolylineMeters'
+//    libm      - only the libm calls made per point by 'gpsMetersToPoints'
+//                (2 sin, cos, asin, sqrt), with the same (precalculated) arguments
+// ---
+// Notes:
+//  - The 'libm' time is the lower bound for a vectorized batch kernel that still
+//    calls the scalar libm functions.  The difference between 'batch' and 'libm' is
+//    the part (radian conversion, products, range checks, loads/stores) that an
+//    SSE/AVX/NEON kernel could speed up.
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h" // TARGET_WINCE
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file
+#include "custom/defaults.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "tools/stdtypes.h"
+#include "tools/strtools.h"
+#include "tools/utctools.h"
+#include "tools/gpstools.h"
+
+#include "log.h"
+
+// ----------------------------------------------------------------------------
+
+#define DEFAULT_POINTS          1000000L
+#define DEFAULT_PASSES          5L
+
+// track step (degrees, about 200 meters)
+#define TRACK_STEP              0.002
+
+// ----------------------------------------------------------------------------
+
+static GPSPoint_t           *point  = (GPSPoint_t*)0;    // array-of-structures
+static double               *lat    = (double*)0;        // structure-of-arrays
+static double               *lon    = (double*)0;
+static double               *meters = (double*)0;
+static double               *argSinLat = (double*)0;     // libm arguments
+static double               *argSinLon = (double*)0;
+static double               *argCos    = (double*)0;
+static double               *argSqrt   = (double*)0;
+static long                 pointCount = 0L;
+
+static volatile double      checkSum = 0.0;              // keeps results live
+
+static double _random(double min, double max)
+{
+    return min + ((max - min) * ((double)rand() / ((double)RAND_MAX + 1.0)));
+}
+
+// ----------------------------------------------------------------------------
+
+#define MODE_SCALAR             0
+#define MODE_BATCH              1
+#define MODE_SEG_SCALAR         2
+#define MODE_POLYLINE           3
+#define MODE_LIBM               4
+
+static UInt32 _runBench(int mode, long passes)
+{
+    struct timeval ts0, ts1;
+    long p, i;
+    utcGetTimestamp(&ts0);
+    for (p = 0L; p < passes; p++) {
+        double sum = 0.0;
+        switch (mode) {
+            case MODE_SCALAR:
+                for (i = 0L; i < pointCount; i++) {
+                    sum += gpsMetersToPoint(&point[0], &point[i]);
+                }
+                break;
+            case MODE_BATCH:
+                gpsMetersToPoints(&point[0], lat, lon, (int)pointCount, meters);
+                sum = meters[pointCount - 1L];
+                break;
+            case MODE_SEG_SCALAR:
+                for (i = 1L; i < pointCount; i++) {
+                    sum += gpsMetersToPoint(&point[i - 1L], &point[i]);
+                }
+                break;
+            case MODE_POLYLINE:
+                sum = gpsPolylineMeters(lat, lon, (int)pointCount, (double*)0);
+                break;
+            case MODE_LIBM:
+                for (i = 0L; i < pointCount; i++) {
+                    sum += sin(argSinLat[i]) + sin(argSinLon[i]) + cos(argCos[i]) + asin(sqrt(argSqrt[i]));
+                }
+                break;
+        }
+        checkSum += sum;
+    }
+    utcGetTimestamp(&ts1);
+    return utcGetDeltaMillis(&ts1, &ts0);
+}
+
+static void _printResult(const char *name, UInt32 ms, long passes)
+{
+    double sec = (ms > 0L)? ((double)ms / 1000.0) : 0.001;
+    printf("%-10s: %8lu ms  %7.2f M points/sec\n", name, ms,
+        ((double)pointCount * (double)passes) / (sec * 1000000.0));
+}
+
+// ----------------------------------------------------------------------------
+
+static void _usage(const char *pgm)
+{
+    fprintf(stderr, "Usage: \n");
+    fprintf(stderr, "   %s [-points <count>] [-passes <count>]\n", pgm);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    long passes = DEFAULT_PASSES;
+    long i;
+
+    /* args */
+    pointCount = DEFAULT_POINTS;
+    for (i = 1; i < argc; i++) {
+        if (strEqualsIgnoreCase(argv[i], "-points") && ((i + 1) < argc)) {
+            pointCount = strParseInt32(argv[++i], DEFAULT_POINTS);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-passes") && ((i + 1) < argc)) {
+            passes = strParseInt32(argv[++i], DEFAULT_PASSES);
+        } else {
+            _usage(argv[0]);
+        }
+    }
+    if ((pointCount < 2L) || (passes <= 0L)) {
+        _usage(argv[0]);
+    }
+    srand(1);
+
+    /* points (random track) */
+    point  = (GPSPoint_t*)malloc(pointCount * sizeof(GPSPoint_t));
+    lat    = (double*)malloc(pointCount * sizeof(double));
+    lon    = (double*)malloc(pointCount * sizeof(double));
+    meters = (double*)malloc(pointCount * sizeof(double));
+    argSinLat = (double*)malloc(pointCount * sizeof(double));
+    argSinLon = (double*)malloc(pointCount * sizeof(double));
+    argCos    = (double*)malloc(pointCount * sizeof(double));
+    argSqrt   = (double*)malloc(pointCount * sizeof(double));
+    if (!point || !lat || !lon || !meters || !argSinLat || !argSinLon || !argCos || !argSqrt) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    double y = 37.0, x = -122.0;
+    for (i = 0L; i < pointCount; i++) {
+        y += _random(-TRACK_STEP, TRACK_STEP);
+        x += _random(-TRACK_STEP, TRACK_STEP);
+        if ((y > 80.0) || (y < -80.0)) { y = 37.0; }
+        if ((x >= 180.0) || (x <= -180.0)) { x = -122.0; }
+        gpsPoint(&point[i], y, x);
+        lat[i] = y;
+        lon[i] = x;
+    }
+    for (i = 0L; i < pointCount; i++) {
+        // arguments of the libm calls made by 'gpsMetersToPoints' (from 'point[0]')
+        double radLatS = lat[0] * RADIANS, radLatE = lat[i] * RADIANS;
+        double sinLat, sinLon;
+        argSinLat[i] = (radLatE - radLatS) / 2.0;
+        argSinLon[i] = ((lon[i] - lon[0]) * RADIANS) / 2.0;
+        argCos[i]    = radLatE;
+        sinLat = sin(argSinLat[i]);
+        sinLon = sin(argSinLon[i]);
+        argSqrt[i]   = (sinLat * sinLat) + (cos(radLatS) * cos(radLatE) * sinLon * sinLon);
+    }
+    printf("Points    : %ld x %ld passes\n", pointCount, passes);
+
+    /* run */
+    _printResult("scalar",     _runBench(MODE_SCALAR,     passes), passes);
+    _printResult("batch",      _runBench(MODE_BATCH,      passes), passes);
+    _printResult("seg-scalar", _runBench(MODE_SEG_SCALAR, passes), passes);
+    _printResult("polyline",   _runBench(MODE_POLYLINE,   passes), passes);
+    _printResult("libm",       _runBench(MODE_LIBM,       passes), passes);
+
+    free(point);
+    free(lat);
+    free(lon);
+    free(meters);
+    free(argSinLat);
+    free(argSinLon);
+    free(argCos);
+    free(argSqrt);
+    return 0;
+
+}
+
+// ----------------------------------------------------------------------------
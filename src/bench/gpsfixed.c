@@ -0,0 +1,267 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Differential test of the fixed-point GPS distance path ('GPS_FIXED_POINT', see
+//  "tools/gpstools.c") against the 'double' Haversine calculation.
+//  '-pairs' random point pairs (separations up to GPS_FIXED_MAX_DELTA, latitudes
+//  below 80 degrees, including pairs crossing the 180 meridian) are checked through
+//  each public distance function, and the degree/microdegree conversion is checked
+//  against 'double' rounding.  Exits with '1' if any result is outside the documented
+//  error bound (0.2% or 0.3 meters), and reports the time of both paths.
+// ---
+// Notes:
+//  - "tools/gpstools.c" is compiled into this file with GPS_FIXED_POINT defined, so
+//    that both paths are available (the 'double' Haversine is always compiled).
+// ----------------------------------------------------------------------------
+
+#define GPS_FIXED_POINT
+#include "tools/gpstools.c"
+
+#include <stdlib.h>
+
+#include "tools/utctools.h"
+
+#include "log.h"
+
+// ----------------------------------------------------------------------------
+
+#define DEFAULT_PAIRS           1000000L
+
+#define MAX_ERROR_RATIO         0.002       // 0.2%
+#define MAX_ERROR_METERS        0.3
+#define MAX_LATITUDE            80.0
+
+#define POLY_POINTS             64
+
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    const char              *name;
+    long                    count;
+    long                    failed;
+    double                  maxErrMeters;
+    double                  maxErrRatio;
+} DiffResult_t;
+
+static double _random(double min, double max)
+{
+    return min + ((max - min) * ((double)rand() / ((double)RAND_MAX + 1.0)));
+}
+
+/* reference 'double' distance */
+static double _doubleMeters(const GPSPoint_t *gpS, const GPSPoint_t *gpE)
+{
+    double radLatS = gpS->latitude * RADIANS, radLatE = gpE->latitude * RADIANS;
+    return _gpsHaversineMeters(radLatS, gpS->longitude * RADIANS, cos(radLatS),
+        radLatE, gpE->longitude * RADIANS, cos(radLatE));
+}
+
+/* random pair within GPS_FIXED_MAX_DELTA */
+static void _randomPair(GPSPoint_t *gpS, GPSPoint_t *gpE)
+{
+    double maxDelta = (double)GPS_FIXED_MAX_DELTA / (double)MICRODEGREES;
+    gpsPoint(gpS, _random(-MAX_LATITUDE, MAX_LATITUDE), _random(-180.0, 180.0));
+    double lat = gpS->latitude  + _random(-maxDelta, maxDelta);
+    double lon = gpS->longitude + _random(-maxDelta, maxDelta);
+    if (lon >=  180.0) { lon -= 360.0; } // crosses 180 meridian
+    if (lon <= -180.0) { lon += 360.0; }
+    gpsPoint(gpE, lat, lon);
+}
+
+/* compare a fixed-point distance to the reference distance */
+static void _check(DiffResult_t *r, double fixed, double ref)
+{
+    double err = fabs(fixed - ref);
+    r->count++;
+    if ((err > MAX_ERROR_METERS) && (err > (ref * MAX_ERROR_RATIO))) {
+        r->failed++;
+    }
+    if (err > r->maxErrMeters) {
+        r->maxErrMeters = err;
+    }
+    if ((ref > (MAX_ERROR_METERS / MAX_ERROR_RATIO)) && ((err / ref) > r->maxErrRatio)) {
+        r->maxErrRatio = err / ref;
+    }
+}
+
+static void _printResult(const DiffResult_t *r)
+{
+    printf("%-16s: %8ld checked  max error %7.3f m / %6.4f%%  %s\n", r->name, r->count,
+        r->maxErrMeters, r->maxErrRatio * 100.0, r->failed? "FAILED" : "ok");
+}
+
+// ----------------------------------------------------------------------------
+
+/* microdegree conversion */
+static long _checkMicroDegrees(long count)
+{
+    long i, failed = 0L;
+    for (i = 0L; i < count; i++) {
+        double deg = _random(-180.0, 180.0);
+        if (i < 8L) { deg = (double)(i - 4L) * 45.0; } // exact values
+        double m = deg * 1000000.0;
+        Int32 ref = (deg >= 0.0)? (Int32)(m + 0.5) : (Int32)(m - 0.5);
+        Int32 ud = _gpsMicroDegrees(deg);
+        if ((ud - ref > 1L) || (ref - ud > 1L) || ((i < 8L) && (ud != ref))) {
+            if (failed < 5L) {
+                printf("  microdegrees(%.9f) = %ld, expected %ld\n", deg, (long)ud, (long)ref);
+            }
+            failed++;
+        }
+    }
+    printf("%-16s: %8ld checked  %s\n", "microdegrees", count, failed? "FAILED" : "ok");
+    return failed;
+}
+
+/* time 'count' distances through both paths */
+static void _timePaths(const GPSPoint_t *gpS, const GPSPoint_t *gpE, long count)
+{
+    struct timeval ts0, ts1;
+    volatile double sum = 0.0;
+    long i;
+    utcGetTimestamp(&ts0);
+    for (i = 0L; i < count; i++) {
+        sum += gpsMetersToPoint(&gpS[i], &gpE[i]);
+    }
+    utcGetTimestamp(&ts1);
+    UInt32 fixedMS = utcGetDeltaMillis(&ts1, &ts0);
+    utcGetTimestamp(&ts0);
+    for (i = 0L; i < count; i++) {
+        sum += _doubleMeters(&gpS[i], &gpE[i]);
+    }
+    utcGetTimestamp(&ts1);
+    UInt32 doubleMS = utcGetDeltaMillis(&ts1, &ts0);
+    printf("Time (fixed)    : %8lu ms\n", fixedMS);
+    printf("Time (double)   : %8lu ms\n", doubleMS);
+}
+
+// ----------------------------------------------------------------------------
+
+static void _usage(const char *pgm)
+{
+    fprintf(stderr, "Usage: \n");
+    fprintf(stderr, "   %s [-pairs <count>]\n", pgm);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    long pairs = DEFAULT_PAIRS;
+    long i, j;
+
+    /* args */
+    for (i = 1; i < argc; i++) {
+        if (strEqualsIgnoreCase(argv[i], "-pairs") && ((i + 1) < argc)) {
+            pairs = strParseInt32(argv[++i], DEFAULT_PAIRS);
+        } else {
+            _usage(argv[0]);
+        }
+    }
+    if (pairs < POLY_POINTS) {
+        _usage(argv[0]);
+    }
+    srand(1);
+
+    /* pairs (generated before timing) */
+    GPSPoint_t *gpS = (GPSPoint_t*)malloc(pairs * sizeof(GPSPoint_t));
+    GPSPoint_t *gpE = (GPSPoint_t*)malloc(pairs * sizeof(GPSPoint_t));
+    if (!gpS || !gpE) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (i = 0L; i < pairs; i++) {
+        _randomPair(&gpS[i], &gpE[i]);
+    }
+
+    /* conversion */
+    long failed = _checkMicroDegrees(pairs);
+
+    /* gpsMetersToPoint */
+    DiffResult_t rPoint = { "gpsMetersToPoint", 0L, 0L, 0.0, 0.0 };
+    for (i = 0L; i < pairs; i++) {
+        _check(&rPoint, gpsMetersToPoint(&gpS[i], &gpE[i]), _doubleMeters(&gpS[i], &gpE[i]));
+    }
+    _printResult(&rPoint);
+
+    /* gpsFixContextMetersToPoint */
+    DiffResult_t rCtx = { "fixContext", 0L, 0L, 0.0, 0.0 };
+    for (i = 0L; i < pairs; i++) {
+        GPS_t fix;
+        GPSFixContext_t ctx;
+        gpsClear(&fix);
+        fix.fixtime = 1L;
+        gpsPointCopy(&(fix.point), &gpS[i]);
+        gpsFixContextInit(&ctx, &fix, 1L);
+        _check(&rCtx, gpsFixContextMetersToPoint(&ctx, &gpE[i]), _doubleMeters(&gpS[i], &gpE[i]));
+    }
+    _printResult(&rCtx);
+
+    /* gpsMetersToPoints/gpsPolylineMeters (one 'from' point, nearby 'to' points) */
+    DiffResult_t rPoints = { "gpsMetersToPoints", 0L, 0L, 0.0, 0.0 };
+    DiffResult_t rPoly   = { "gpsPolylineMeters", 0L, 0L, 0.0, 0.0 };
+    double lat[POLY_POINTS], lon[POLY_POINTS], meters[POLY_POINTS], segMeters[POLY_POINTS];
+    for (i = 0L; (i + POLY_POINTS) <= pairs; i += POLY_POINTS) {
+        for (j = 0L; j < POLY_POINTS; j++) {
+            // 'to' points around the first 'from' point
+            double dLat = gpE[i + j].latitude - gpS[i + j].latitude;
+            double dLon = gpE[i + j].longitude - gpS[i + j].longitude;
+            if (dLon >  180.0) { dLon -= 360.0; }
+            if (dLon < -180.0) { dLon += 360.0; }
+            lat[j] = gpS[i].latitude + (dLat / 2.0);
+            lon[j] = gpS[i].longitude + (dLon / 2.0);
+            if (lon[j] >=  180.0) { lon[j] -= 360.0; }
+            if (lon[j] <= -180.0) { lon[j] += 360.0; }
+        }
+        gpsMetersToPoints(&gpS[i], lat, lon, POLY_POINTS, meters);
+        gpsPolylineMeters(lat, lon, POLY_POINTS, segMeters);
+        for (j = 0L; j < POLY_POINTS; j++) {
+            GPSPoint_t gp;
+            gpsPoint(&gp, lat[j], lon[j]);
+            _check(&rPoints, meters[j], _doubleMeters(&gpS[i], &gp));
+            if (j > 0L) {
+                GPSPoint_t gp0;
+                gpsPoint(&gp0, lat[j - 1], lon[j - 1]);
+                _check(&rPoly, segMeters[j - 1], _doubleMeters(&gp0, &gp));
+            }
+        }
+    }
+    _printResult(&rPoints);
+    _printResult(&rPoly);
+
+    /* long distances (Haversine fallback) */
+    DiffResult_t rLong = { "long distance", 0L, 0L, 0.0, 0.0 };
+    for (i = 0L; i < pairs; i++) {
+        GPSPoint_t gp;
+        gpsPoint(&gp, _random(-MAX_LATITUDE, MAX_LATITUDE), _random(-179.0, 179.0));
+        _check(&rLong, gpsMetersToPoint(&gpS[i], &gp), _doubleMeters(&gpS[i], &gp));
+    }
+    _printResult(&rLong);
+
+    /* time */
+    _timePaths(gpS, gpE, pairs);
+
+    failed += rPoint.failed + rCtx.failed + rPoints.failed + rPoly.failed + rLong.failed;
+    free(gpS);
+    free(gpE);
+    return failed? 1 : 0;
+
+}
+
+// ----------------------------------------------------------------------------
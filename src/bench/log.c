@@ -0,0 +1,125 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Minimal logging for the benchmark programs (messages from the "tools/"
+//  modules are written to stdout).
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h" // TARGET_WINCE
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file 
+#include "custom/defaults.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "tools/stdtypes.h"
+
+#include "log.h"
+
+// ----------------------------------------------------------------------------
+
+/* maintain debug mode */
+static utBool _isDebugMode = utFalse;
+utBool isDebugMode() { return _isDebugMode; }
+void setDebugMode(utBool mode) { _isDebugMode = mode; }
+
+// ----------------------------------------------------------------------------
+
+/* extract the source file name from the full path (ie. from '__FILE__') */
+const char *logSrcFile(const char *fn)
+{
+    const char *f = fn, *s = fn;
+    if (fn) {
+        for (; *s; s++) { if ((*s == '/') || (*s == '\\')) { f = s + 1; } }
+    }
+    return f;
+}
+
+// ----------------------------------------------------------------------------
+
+static void _logVMsg(const char *ftn, int line, const char *type, const char *fmt, va_list ap)
+{
+    
+    /* file:line */
+    if (ftn) {
+        fprintf(stdout, "[%s:%d] ", logSrcFile(ftn), line);
+    }
+    
+    /* message header */
+    if (type) { 
+        fprintf(stdout, "%s", type); 
+    }
+    
+    /* print the message */
+    vprintf(fmt, ap);
+    
+    /* trailing newline */
+    if (fmt[strlen(fmt)-1] != '\n') { 
+        fprintf(stdout, "\n"); 
+    }
+    
+}
+
+// ----------------------------------------------------------------------------
+
+void logDebug_(const char *ftn, int line, const char *fmt, ...)
+{
+    if (isDebugMode()) {
+        va_list ap;
+        va_start(ap, fmt);
+        _logVMsg(ftn, line, "DEBUG: ", fmt, ap);
+        va_end(ap);
+    }
+}
+
+void logInfo_(const char *ftn, int line, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    _logVMsg(ftn, line, "INFO: ", fmt, ap);
+    va_end(ap);
+}
+
+void logWarning_(const char *ftn, int line, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    _logVMsg(ftn, line, "WARN: ", fmt, ap);
+    va_end(ap);
+}
+
+void logError_(const char *ftn, int line, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    _logVMsg(ftn, line, "ERROR: ", fmt, ap);
+    va_end(ap);
+}
+
+void logCritical_(const char *ftn, int line, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    _logVMsg(ftn, line, "CRITICAL: ", fmt, ap);
+    va_end(ap);
+}
+
+// ----------------------------------------------------------------------------
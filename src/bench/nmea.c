@@ -0,0 +1,272 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  NMEA-0183 parser throughput benchmark ("tools/nmea.c").
+//  The sentences of an NMEA log file (default "src/bench/sample.nmea") are parsed
+//  '-passes' times with:
+//    legacy   - 'strParseArray'/'strParseDouble' (the previous "custom/gps.c" method)
+//    tokenize - 'nmeaParseSentence'
+//    assemble - 'nmeaParseSentence' + 'nmeaAddSentence' (as "custom/gps.c")
+// ---
+// Notes:
+//  - "src/bench/sample.nmea" is a simulated 5 minute drive in the output format of a
+//    typical 1Hz receiver (GGA, GSA, GSV every 5 seconds, RMC, VTG), starting without
+//    a fix, and containing one sentence with a checksum error.
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h" // TARGET_WINCE
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file
+#include "custom/defaults.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/stdtypes.h"
+#include "tools/strtools.h"
+#include "tools/utctools.h"
+#include "tools/checksum.h"
+#include "tools/gpstools.h"
+#include "tools/nmea.h"
+#include "tools/io.h"
+
+#include "log.h"
+
+// ----------------------------------------------------------------------------
+
+#define DEFAULT_NMEA_FILE       "src/bench/sample.nmea"
+#define DEFAULT_PASSES          200L
+
+#define MAX_SENTENCE_SIZE       256
+
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    long                    count;      // sentences parsed
+    long                    bytes;      // sentence bytes parsed
+    long                    errors;     // sentences rejected
+    long                    merged;     // sentences merged into a fix
+    UInt32                  ms;         // elapsed time
+} BenchResult_t;
+
+static char                 **sentence  = (char**)0;
+static int                  *sentLen    = (int*)0;
+static long                 sentCount   = 0L;
+
+// ----------------------------------------------------------------------------
+
+/* load the log file sentences (line terminators removed) */
+static utBool _loadSentences(const char *nmeaFile)
+{
+    long fileLen = ioGetFileSize(nmeaFile, -1);
+    char *data = (fileLen > 0L)? (char*)malloc(fileLen + 1L) : (char*)0;
+    if (!data || (ioReadFile(nmeaFile, data, fileLen) != fileLen)) {
+        fprintf(stderr, "Unable to read file: %s\n", nmeaFile);
+        return utFalse;
+    }
+    data[fileLen] = 0;
+    long i, max = fileLen / 8L + 1L;
+    sentence = (char**)malloc(max * sizeof(char*));
+    sentLen  = (int*)malloc(max * sizeof(int));
+    if (!sentence || !sentLen) {
+        fprintf(stderr, "Out of memory\n");
+        return utFalse;
+    }
+    char *s = data;
+    for (i = 0L; i <= fileLen; i++) {
+        if ((data[i] == '\r') || (data[i] == '\n') || (data[i] == 0)) {
+            data[i] = 0;
+            int len = (int)(&data[i] - s);
+            if ((len > 0) && (len < MAX_SENTENCE_SIZE) && (sentCount < max)) {
+                sentence[sentCount] = s;
+                sentLen[sentCount]  = len;
+                sentCount++;
+            }
+            s = &data[i + 1];
+        }
+    }
+    return (sentCount > 0L)? utTrue : utFalse;
+}
+
+// ----------------------------------------------------------------------------
+
+/* parse latitude/longitude "ddmm.mmmm" (previous "custom/gps.c" method) */
+static double _legacyCoord(const char *s, const char *d, double dft)
+{
+    double v = strParseDouble(s, 99999.0);
+    if (v < 99999.0) {
+        double deg = (double)((long)v / 100L);
+        deg += (v - (deg * 100.0)) / 60.0;
+        return (!strcmp(d,"S") || !strcmp(d,"W"))? -deg : deg;
+    } else {
+        return dft;
+    }
+}
+
+/* parse sentence fields (previous "custom/gps.c" method) */
+static int _legacyParse(const char *line, GPS_t *gps)
+{
+    char fldData[MAX_SENTENCE_SIZE], *fld[22];
+    memset(fld, 0, sizeof(fld));
+    strncpy(fldData, line, sizeof(fldData) - 1);
+    fldData[sizeof(fldData) - 1] = 0;
+    int n = strParseArray(fldData, fld, 20);
+#define FLD(N)  (((N) < n)? fld[(N)] : "")
+    if (!cksumIsValidCharXOR(&line[1], (int*)0)) {
+        return -1;
+    }
+    if (strEqualsIgnoreCase(FLD(0),"$GPRMC")) {
+        if (*FLD(2) == 'A') {
+            gps->fixtime   = strParseUInt32(FLD(1), 0L) + strParseUInt32(FLD(9), 0L);
+            gps->point.latitude  = _legacyCoord(FLD(3), FLD(4), 90.0);
+            gps->point.longitude = _legacyCoord(FLD(5), FLD(6), 180.0);
+            gps->speedKPH  = strParseDouble(FLD(7), -1.0) * KILOMETERS_PER_KNOT;
+            gps->heading   = strParseDouble(FLD(8), -1.0);
+            return 1;
+        }
+    } else
+    if (strEqualsIgnoreCase(FLD(0),"$GPGGA")) {
+        if (strParseUInt32(FLD(6), 0L) != 0L) {
+            gps->fixtime   = strParseUInt32(FLD(1), 0L);
+            gps->point.latitude  = _legacyCoord(FLD(2), FLD(3), 90.0);
+            gps->point.longitude = _legacyCoord(FLD(4), FLD(5), 180.0);
+            gps->satellites = (UInt16)strParseUInt32(FLD(7), 0L);
+            gps->hdop      = strParseDouble(FLD(8), GPS_UNDEFINED_DOP);
+            gps->altitude  = strParseDouble(FLD(9), 0.0);
+            return 1;
+        }
+    } else
+    if (strEqualsIgnoreCase(FLD(0),"$GPGSA")) {
+        gps->pdop = strParseDouble(FLD(15), GPS_UNDEFINED_DOP);
+        gps->hdop = strParseDouble(FLD(16), GPS_UNDEFINED_DOP);
+        gps->vdop = strParseDouble(FLD(17), GPS_UNDEFINED_DOP);
+        return 1;
+    } else
+    if (strEqualsIgnoreCase(FLD(0),"$GPVTG")) {
+        gps->heading  = strParseDouble(FLD(1), -1.0);
+        gps->speedKPH = strParseDouble(FLD(7), -1.0);
+        return 1;
+    }
+#undef FLD
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+#define MODE_LEGACY             0
+#define MODE_TOKENIZE           1
+#define MODE_ASSEMBLE           2
+
+static void _runBench(int mode, long passes, BenchResult_t *r)
+{
+    NMEAParser_t parser;
+    NMEASentence_t ns;
+    GPS_t gps;
+    char buf[MAX_SENTENCE_SIZE];
+    struct timeval ts0, ts1;
+    long p, s;
+
+    memset(r, 0, sizeof(BenchResult_t));
+    memset(&gps, 0, sizeof(gps));
+    nmeaParserInit(&parser, NMEA0183_GPRMC | NMEA0183_GPGGA | NMEA0183_GPGSA | NMEA0183_GPVTG);
+    utcGetTimestamp(&ts0);
+    for (p = 0L; p < passes; p++) {
+        for (s = 0L; s < sentCount; s++) {
+            int rtn;
+            if (mode == MODE_LEGACY) {
+                rtn = _legacyParse(sentence[s], &gps);
+            } else {
+                memcpy(buf, sentence[s], sentLen[s] + 1); // parsed in place
+                rtn = nmeaParseSentence(&ns, buf);
+                if ((rtn > 0) && (mode == MODE_ASSEMBLE)) {
+                    rtn = nmeaAddSentence(&parser, &ns);
+                }
+            }
+            if (rtn < 0) {
+                r->errors++;
+            } else
+            if (rtn > 0) {
+                r->merged++;
+            }
+            r->bytes += sentLen[s];
+        }
+    }
+    utcGetTimestamp(&ts1);
+    r->count = passes * sentCount;
+    r->ms    = utcGetDeltaMillis(&ts1, &ts0);
+}
+
+static void _printResult(const char *name, const BenchResult_t *r)
+{
+    double sec = (r->ms > 0L)? ((double)r->ms / 1000.0) : 0.001;
+    printf("%-9s: %8ld ms  %10.0f sentences/sec  %7.2f MB/sec  (%ld ok, %ld rejected)\n",
+        name, (long)r->ms, (double)r->count / sec, (double)r->bytes / (sec * 1000000.0),
+        r->merged, r->errors);
+}
+
+// ----------------------------------------------------------------------------
+
+static void _usage(const char *pgm)
+{
+    fprintf(stderr, "Usage: \n");
+    fprintf(stderr, "   %s [-passes <count>] [<nmeaFile>]\n", pgm);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *nmeaFile = DEFAULT_NMEA_FILE;
+    long passes = DEFAULT_PASSES;
+    int i;
+
+    /* args */
+    for (i = 1; i < argc; i++) {
+        if (strEqualsIgnoreCase(argv[i], "-passes") && ((i + 1) < argc)) {
+            passes = strParseInt32(argv[++i], DEFAULT_PASSES);
+        } else
+        if (*argv[i] != '-') {
+            nmeaFile = argv[i];
+        } else {
+            _usage(argv[0]);
+        }
+    }
+    if (passes <= 0L) {
+        _usage(argv[0]);
+    }
+
+    /* load */
+    if (!_loadSentences(nmeaFile)) {
+        return 1;
+    }
+    printf("File     : %s (%ld sentences x %ld passes)\n", nmeaFile, sentCount, passes);
+
+    /* run */
+    BenchResult_t r;
+    _runBench(MODE_LEGACY, passes, &r);
+    _printResult("legacy", &r);
+    _runBench(MODE_TOKENIZE, passes, &r);
+    _printResult("tokenize", &r);
+    _runBench(MODE_ASSEMBLE, passes, &r);
+    _printResult("assemble", &r);
+    return 0;
+
+}
+
+// ----------------------------------------------------------------------------
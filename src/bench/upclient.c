@@ -0,0 +1,47 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Client side of the upload test (see "upload.c").
+//  "base/upload.c" is compiled into this file with the client functions renamed,
+//  since the server upload functions use the same names.
+// ----------------------------------------------------------------------------
+
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file
+#define ENABLE_UPLOAD
+
+#define uploadIsActive          clientUploadIsActive
+#define uploadIsExpired         clientUploadIsExpired
+#define uploadCancel            clientUploadCancel
+#define uploadProcessRecord     clientUploadProcessRecord
+
+// informational messages are shown only in debug mode ('-v')
+#define logInfo_                logDebug_
+#define logWarning_             logDebug_
+
+#include "base/upload.c"
+
+// ----------------------------------------------------------------------------
+
+/* return the directory where uploaded files are installed */
+const char *clientUploadInstallDir()
+{
+    return UPLOAD_INSTALL_DIR;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,322 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Upload state machine test ("server/upload.c" against the client "base/upload.c").
+//  Random data is uploaded through a simulated link which drops every '-drop'th
+//  server record, and optionally reconnects at round '-reconnect' (the client then
+//  resumes from its partial file).  An acknowledgement timeout is forced whenever
+//  the exchange stalls.  Without options a set of standard cases is run.  Exits
+//  with '1' if any installed file does not match the uploaded data.
+// ---
+// Notes:
+//  - "server/upload.c" is compiled into this file with the acknowledgement timer
+//    replaced, and "base/upload.c" is compiled by "upclient.c".
+//  - '-stale' leaves a partial file from another upload on the client, and
+//    '-legacy' discards the client acknowledgements (as a client built before
+//    upload acknowledgements were added).
+//  - The client installs into its UPLOAD_INSTALL_DIR (see "base/upload.c").
+// ----------------------------------------------------------------------------
+
+#define utcIsTimerExpired       _benchTimerExpired
+
+// informational messages are shown only in debug mode ('-v')
+#define logInfo_                logDebug_
+#define logWarning_             logDebug_
+
+#include "server/upload.c"
+
+#include <stdarg.h>
+
+#include "tools/bintools.h"
+
+// ----------------------------------------------------------------------------
+
+#define UPLOAD_FILE             "bench_upload.bin"
+#define UPLOAD_PARTIAL_EXT      ".part"     // see the client "base/upload.h"
+
+#define MAX_QUEUE               8192        // server records queued per round
+#define MAX_REPLIES             512         // client replies queued per round
+#define MAX_REPLY_SIZE          64
+#define MAX_ROUNDS              200000L
+
+// ----------------------------------------------------------------------------
+// client side ("upclient.c")
+
+utBool clientUploadIsActive();
+void clientUploadCancel();
+utBool clientUploadProcessRecord(int protoNdx, const UInt8 *rcd, int rcdLen);
+const char *clientUploadInstallDir();
+
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    const char              *name;
+    Int32                   size;
+    int                     drop;       // drop every Nth server record (0 = none)
+    long                    reconnect;  // round at which the link reconnects (0 = none)
+    utBool                  stale;      // partial file from another upload
+    utBool                  legacy;     // client acknowledgements discarded
+} UploadCase_t;
+
+static UploadCase_t StandardCases[] = {
+    { "1 byte"              ,       1,  0,  0, utFalse, utFalse },
+    { "1 record"            ,     245,  0,  0, utFalse, utFalse },
+    { "100K"                ,  100000,  0,  0, utFalse, utFalse },
+    { "1M"                  , 1000000,  0,  0, utFalse, utFalse },
+    { "100K drop 3"         ,  100000,  3,  0, utFalse, utFalse },
+    { "100K drop 7"         ,  100000,  7,  0, utFalse, utFalse },
+    { "100K drop 11"        ,  100000, 11,  0, utFalse, utFalse },
+    { "1M drop 5"           , 1000000,  5,  0, utFalse, utFalse },
+    { "100K reconnect"      ,  100000,  0, 50, utFalse, utFalse },
+    { "100K reconnect drop" ,  100000,  7, 50, utFalse, utFalse },
+    { "100K stale partial"  ,  100000,  0,  0, utTrue , utFalse },
+    { "100K legacy client"  ,  100000,  0,  0, utFalse, utTrue  },
+};
+
+// ----------------------------------------------------------------------------
+// simulated link
+
+static utBool       forceTimeout = utFalse;
+
+/* server records (server to client) */
+static UInt8        srvRcd[MAX_QUEUE][PACKET_MAX_PAYLOAD_LENGTH];
+static int          srvRcdLen[MAX_QUEUE];
+static int          srvRcdCount = 0;
+static long         srvRcdTotal = 0L;       // all records sent (including dropped)
+
+/* client replies (client to server) */
+static UInt8        cliReply[MAX_REPLIES][MAX_REPLY_SIZE];
+static int          cliReplyLen[MAX_REPLIES];
+static utBool       cliReplyError[MAX_REPLIES];
+static int          cliReplyCount = 0;
+
+/* the acknowledgement timer expires only when forced */
+utBool _benchTimerExpired(TimerSec_t timer, Int32 interval)
+{
+    return forceTimeout;
+}
+
+/* server 'protocol.c' */
+const char *protGetAccountID() { return "account"; }
+const char *protGetDeviceID()  { return "device"; }
+utBool protUploadPacket(const UInt8 *val, UInt8 valLen)
+{
+    if (srvRcdCount >= MAX_QUEUE) {
+        return utFalse;
+    }
+    memcpy(srvRcd[srvRcdCount], val, valLen);
+    srvRcdLen[srvRcdCount++] = valLen;
+    return utTrue;
+}
+
+/* client 'protocol.c' */
+static utBool _queueReply(utBool isError, const char *fmt, va_list ap)
+{
+    if (cliReplyCount >= MAX_REPLIES) {
+        return utFalse;
+    }
+    cliReplyLen[cliReplyCount]   = binVPrintf(cliReply[cliReplyCount], MAX_REPLY_SIZE, fmt, ap);
+    cliReplyError[cliReplyCount] = isError;
+    cliReplyCount++;
+    return utTrue;
+}
+utBool protocolQueueError(int protoNdx, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    utBool rtn = _queueReply(utTrue, fmt, ap);
+    va_end(ap);
+    return rtn;
+}
+utBool protocolQueueDiagnostic(int protoNdx, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    utBool rtn = _queueReply(utFalse, fmt, ap);
+    va_end(ap);
+    return rtn;
+}
+
+/* deliver queued server records to the client (dropping every Nth) */
+static void _deliver(const UploadCase_t *c)
+{
+    int i, n = srvRcdCount;
+    srvRcdCount = 0;
+    for (i = 0; i < n; i++) {
+        srvRcdTotal++;
+        if ((c->drop > 0) && ((srvRcdTotal % c->drop) == 0L)) {
+            continue; // lost
+        }
+        clientUploadProcessRecord(0, srvRcd[i], srvRcdLen[i]);
+    }
+}
+
+/* deliver queued client replies to the server (returns true if records were sent) */
+static utBool _feedback(const UploadCase_t *c)
+{
+    utBool sent = utFalse;
+    int i, n = cliReplyCount;
+    cliReplyCount = 0;
+    for (i = 0; i < n; i++) {
+        UInt32 key = 0L;
+        binScanf(cliReply[i], cliReplyLen[i], "%2x", &key);
+        if (!cliReplyError[i]) {
+            if (!c->legacy) {
+                sent |= uploadHandleAck(cliReply[i] + 2, cliReplyLen[i] - 2);
+            }
+        } else {
+            sent |= uploadHandleError((UInt16)key, cliReply[i] + 2, cliReplyLen[i] - 2);
+        }
+    }
+    return sent;
+}
+
+// ----------------------------------------------------------------------------
+
+/* upload random data, and compare the installed file */
+static utBool _runCase(const UploadCase_t *c)
+{
+    char path[256], part[256 + sizeof(UPLOAD_PARTIAL_EXT)];
+    long rounds = 0L, timeouts = 0L;
+    Int32 i;
+
+    /* data */
+    UInt8 *data = (UInt8*)malloc(c->size), *inst = (UInt8*)malloc(c->size + 1L);
+    if (!data || !inst) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    srand((unsigned int)c->size);
+    for (i = 0L; i < c->size; i++) {
+        data[i] = (UInt8)rand();
+    }
+
+    /* client files */
+    sprintf(path, "%s/%s", clientUploadInstallDir(), UPLOAD_FILE);
+    sprintf(part, "%s%s", path, UPLOAD_PARTIAL_EXT);
+    ioMakeDirs(path, utTrue);
+    ioDeleteFile(path);
+    ioDeleteFile(part);
+    if (c->stale) {
+        // same name, different content
+        for (i = 0L; i < (c->size / 2L); i++) { inst[i] = (UInt8)~data[i]; }
+        ioWriteFile(part, inst, c->size / 2L);
+    }
+
+    /* upload */
+    srvRcdCount = cliReplyCount = 0;
+    srvRcdTotal = 0L;
+    clientUploadCancel();
+    uploadSendData(UPLOAD_FILE, data, c->size);
+    while (uploadIsActive() && (rounds < MAX_ROUNDS)) {
+        rounds++;
+        _deliver(c);
+        if ((c->reconnect > 0L) && (rounds == c->reconnect)) {
+            // link lost, the client reconnects
+            srvRcdCount = cliReplyCount = 0;
+            clientUploadCancel();
+            uploadResume();
+            uploadCheck();
+            continue;
+        }
+        utBool sent = _feedback(c);
+        if (!sent && uploadIsActive() && (srvRcdCount == 0) && !uploadHandleEOB()) {
+            // stalled
+            forceTimeout = utTrue;
+            uploadCheck();
+            forceTimeout = utFalse;
+            timeouts++;
+        }
+    }
+    _deliver(c); // records sent with the last reply
+
+    /* compare */
+    long instLen = ioReadFile(path, inst, c->size + 1L);
+    utBool ok = (!uploadIsActive() && (instLen == c->size) && (memcmp(inst, data, c->size) == 0))? utTrue : utFalse;
+    printf("%-20s: %8ld bytes  %6ld records  %5ld rounds  %3ld timeouts  %s\n",
+        c->name, (long)c->size, srvRcdTotal, rounds, timeouts, ok? "ok" : "FAILED");
+
+    /* clean up */
+    _uploadFree();
+    clientUploadCancel();
+    ioDeleteFile(path);
+    ioDeleteFile(part);
+    free(data);
+    free(inst);
+    return ok;
+
+}
+
+// ----------------------------------------------------------------------------
+
+static void _usage(const char *pgm)
+{
+    fprintf(stderr, "Usage: \n");
+    fprintf(stderr, "   %s [-size <bytes> [-drop <n>] [-reconnect <round>] [-stale] [-legacy]] [-v]\n", pgm);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    UploadCase_t one = { "upload", 0L, 0, 0L, utFalse, utFalse };
+    long failed = 0L;
+    int i;
+
+    /* args */
+    for (i = 1; i < argc; i++) {
+        if (strEqualsIgnoreCase(argv[i], "-size") && ((i + 1) < argc)) {
+            one.size = strParseInt32(argv[++i], 0L);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-drop") && ((i + 1) < argc)) {
+            one.drop = (int)strParseInt32(argv[++i], 0L);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-reconnect") && ((i + 1) < argc)) {
+            one.reconnect = strParseInt32(argv[++i], 0L);
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-stale")) {
+            one.stale = utTrue;
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-legacy")) {
+            one.legacy = utTrue;
+        } else
+        if (strEqualsIgnoreCase(argv[i], "-v")) {
+            setDebugMode(utTrue);
+        } else {
+            _usage(argv[0]);
+        }
+    }
+    if ((one.size < 0L) || (one.size > UPLOAD_MAX_FILE_SIZE) || (one.drop == 1)) {
+        _usage(argv[0]);
+    }
+
+    /* run */
+    if (one.size > 0L) {
+        failed += _runCase(&one)? 0L : 1L;
+    } else {
+        int n = sizeof(StandardCases)/sizeof(StandardCases[0]);
+        for (i = 0; i < n; i++) {
+            failed += _runCase(&StandardCases[i])? 0L : 1L;
+        }
+    }
+    return failed? 1 : 0;
+
+}
+
+// ----------------------------------------------------------------------------
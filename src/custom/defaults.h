@@ -102,6 +102,7 @@ extern "C" {
 // Gumstix directives
 
 #if defined(TARGET_GUMSTIX)
+#  define GPS_FIXED_POINT       // fixed-point GPS distance calcs (no FPU)
 #  define ENABLE_GEOZONE
 #  define ENABLE_REBOOT
 #  define ENABLE_UPLOAD
@@ -455,6 +456,17 @@ extern "C" {
 //#  define GPS_DEVICE_SIMULATOR
 #endif
 
+// ----------------------------------------------------------------------------
+// GPS replay (testing/benchmarking only)
+// Reads recorded NMEA-0183 data from a file (or pty) specified as GPS port "replay:<file>".
+// Recorded files are played back at the rate specified by PROP_CFG_GPS_REPLAY_RATE, and
+// the utctools clock follows the replayed fix times (see 'utcSetVirtualTime').
+
+// define to compile with GPS replay support
+#if !defined(TARGET_WINCE)
+#  define GPS_DEVICE_REPLAY
+#endif
+
 // ----------------------------------------------------------------------------
 // Feature list
 
@@ -488,8 +500,13 @@ extern "C" {
 #else
 #  define _F_GDS                ""
 #endif
+#if defined(GPS_DEVICE_REPLAY)
+#  define _F_GDR                "/GPReplay"     // GPS replay
+#else
+#  define _F_GDR                ""
+#endif
 #if !defined(APPLICATION_FEATURES)
-#  define APPLICATION_FEATURES _F_STM _F_RBT _F_UPL _F_GUI _F_GZO _F_GDS
+#  define APPLICATION_FEATURES _F_STM _F_RBT _F_UPL _F_GUI _F_GZO _F_GDS _F_GDR
 #endif
 
 // ----------------------------------------------------------------------------
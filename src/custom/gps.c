@@ -57,6 +57,9 @@
 #include <ctype.h>
 #include <time.h>
 #include <math.h>
+#if defined(GPS_DEVICE_REPLAY)
+#  include <sys/stat.h>
+#endif
 
 #include "custom/log.h"
 #include "custom/gps.h"
@@ -67,6 +70,7 @@
 #include "tools/strtools.h"
 #include "tools/checksum.h"
 #include "tools/comport.h"
+#include "tools/nmea.h"
 
 #include "base/events.h"
 #include "base/propman.h"
@@ -107,6 +111,11 @@
 /* simjulator port name */
 #define GPS_SIMULATOR_PORT      "sim"
 
+/* replay port name prefix ("replay:<file>") */
+#define GPS_REPLAY_PREFIX       "replay:"
+#define MAX_REPLAY_RATE         1000L
+#define REPLAY_STEP_TIMEOUT_MS  30000L // max wait for the main loop to handle a fix
+
 /* GPS bps */
 #define DEFAULT_GPS_SPEED       4800L // 8N1 assumed
 
@@ -118,10 +127,6 @@
 // delta must be at least this value to cause a system clock update
 #define MIN_DELTA_CLOCK_TIME    5L
 
-/* maximum number of allowed seconds in a $GP record 'cycle' */
-// In most GPS receivers, the default 'cycle' is 1 second
-#define GP_EXPIRE               5L
-
 /* power-save threshold */
 // if PROP_GPS_SAMPLE_RATE is >= this value, the GPS port will not be openned
 // until 'gpsAquire' is called, and will be closed after a GPS fix is aquired.
@@ -134,9 +139,8 @@
 #define ASCII_XOFF              19 // DC3, CTL_S
 // ----------------------------------------------------------------------------
 
-#define SUPPORT_TYPE_GPRMC      0x0001 // should always be defined
-#define SUPPORT_TYPE_GPGGA      0x0002 // altitude, HDOP
-#define SUPPORT_TYPE_GPGSA      0x0004 // PDOP, HDOP, VDOP
+/* NMEA-0183 sentence types merged into each fix ($GPRMC should always be included) */
+#define GPS_NMEA_TYPES          (NMEA0183_GPRMC | NMEA0183_GPGGA | NMEA0183_GPGSA | NMEA0183_GPVTG)
 
 // ----------------------------------------------------------------------------
 
@@ -144,16 +148,33 @@
 static utBool                   gpsSimulator = utFalse;
 #endif
 
+#if defined(GPS_DEVICE_REPLAY)
+static FILE                     *gpsReplayFile          = (FILE*)0;
+static utBool                   gpsReplayDone           = utFalse;
+static utBool                   gpsReplayPaced          = utFalse; // regular file (not a pty)
+static UInt32                   gpsReplayRate           = 1L;
+static UInt32                   gpsReplaySec            = 0L; // last replayed fix time
+static UInt32                   gpsReplayMS             = 0L;
+#endif
+
 static ComPort_t                gpsComPort;
 static utBool                   gpsPortDebug;
 
-static GPS_t                    gpsFixLast;
-static GPS_t                    gpsFixUnsafe;
+static NMEAParser_t             gpsParser;
 
-static double                   gpsLastPDOP             = GPS_UNDEFINED_DOP;
-static double                   gpsLastHDOP             = GPS_UNDEFINED_DOP;
-static double                   gpsLastVDOP             = GPS_UNDEFINED_DOP;
-static TimerSec_t               gpsLastHDOPTimer        = 0L;
+/* latest published fix */
+// Written only by the GPS reader, read lock-free by everyone else.
+static GPS_t                    gpsFixSlot;
+static threadSeqLock_t          gpsFixSeqLock;
+static volatile UInt32          gpsFixGeneration        = 0L;
+
+/* epoch being assembled (reader only) */
+static UInt32                   gpsEpochTOD             = 0L;
+static UInt32                   gpsEpochNMEA            = 0L;       // sentence types merged
+static utBool                   gpsEpochPublished       = utFalse;  // generation advanced
+static utBool                   gpsEpochPending         = utFalse;  // waiting for $GPGGA
+static GPS_t                    gpsEpochFix;                        // pending fix
+static utBool                   gpsExpectGPGGA          = utFalse;  // receiver sends $GPGGA
 
 static utBool                   gpsIsStale              = utFalse;
 static UInt32                   gpsSampleCount_A        = 0L; // valid
@@ -171,23 +192,30 @@ static UInt32                   gpsAquireTimeoutMS      = 0L;
 #if defined(GPS_THREAD)
 static utBool                   gpsRunThread = utFalse;
 static threadThread_t           gpsThread;
-static threadMutex_t            gpsMutex;
+static threadMutex_t            gpsFixMutex;
+static threadCond_t             gpsFixCond;
 static threadMutex_t            gpsSampleMutex;
 static threadMutex_t            gpsAquireMutex;
 static threadCond_t             gpsAquireCond;
 #define SAMPLE_LOCK             MUTEX_LOCK(&gpsSampleMutex);
 #define SAMPLE_UNLOCK           MUTEX_UNLOCK(&gpsSampleMutex);
-#define GPS_LOCK                MUTEX_LOCK(&gpsMutex);
-#define GPS_UNLOCK              MUTEX_UNLOCK(&gpsMutex);
+#define FIX_LOCK                MUTEX_LOCK(&gpsFixMutex);
+#define FIX_UNLOCK              MUTEX_UNLOCK(&gpsFixMutex);
+#define FIX_NOTIFY              CONDITION_NOTIFY(&gpsFixCond);
 #define AQUIRE_LOCK             MUTEX_LOCK(&gpsAquireMutex);
 #define AQUIRE_UNLOCK           MUTEX_UNLOCK(&gpsAquireMutex);
 #define AQUIRE_WAIT             CONDITION_WAIT(&gpsAquireCond, &gpsAquireMutex);
 #define AQUIRE_NOTIFY           CONDITION_NOTIFY(&gpsAquireCond);
+#if defined(GPS_DEVICE_REPLAY)
+static threadCond_t             gpsReplayCond;
+static UInt32                   gpsReplayStepGeneration = 0L; // last fix handled by the main loop
+#endif
 #else
 #define SAMPLE_LOCK     
 #define SAMPLE_UNLOCK   
-#define GPS_LOCK        
-#define GPS_UNLOCK      
+#define FIX_LOCK        
+#define FIX_UNLOCK      
+#define FIX_NOTIFY      
 #define AQUIRE_LOCK             
 #define AQUIRE_UNLOCK           
 #define AQUIRE_WAIT             
@@ -260,6 +288,131 @@ static void _gpsConfigGarmin(ComPort_t *com)
 
 // ----------------------------------------------------------------------------
 
+#if defined(GPS_DEVICE_REPLAY)
+
+/* open recorded NMEA file (or pty) */
+// The file remains open when the GPS port is 'closed', so that replay continues from
+// where it left off.  It is closed once the end of the file has been reached.
+static utBool _gpsReplayOpen(const char *fileName)
+{
+    if (gpsReplayFile) {
+        return utTrue; // already open
+    } else
+    if (gpsReplayDone) {
+        return utFalse; // already replayed
+    }
+    gpsReplayFile = fopen(fileName, "r");
+    if (!gpsReplayFile) {
+        logWARNING(LOGSRC,"Unable to open GPS replay file '%s'", fileName);
+        return utFalse;
+    }
+    struct stat st;
+    gpsReplayPaced = ((fstat(fileno(gpsReplayFile),&st) == 0) && S_ISREG(st.st_mode))? utTrue : utFalse;
+    gpsReplayRate  = propGetUInt32(PROP_CFG_GPS_REPLAY_RATE, 1L);
+    if (gpsReplayRate < 1L) { gpsReplayRate = 1L; }
+    if (gpsReplayRate > MAX_REPLAY_RATE) { gpsReplayRate = MAX_REPLAY_RATE; }
+    if (gpsReplayPaced) {
+        logINFO(LOGSRC,"Replaying GPS file: %s [%lux]", fileName, gpsReplayRate);
+    } else {
+        logINFO(LOGSRC,"Replaying GPS device: %s", fileName);
+    }
+    return utTrue;
+}
+
+#if defined(GPS_THREAD)
+/* wait until the main loop has handled the latest published fix */
+// The main loop is stepped once per replayed fix (see 'gpsWaitForFix'), so that the 
+// events generated from a replay do not depend on thread scheduling.
+static void _gpsReplayWaitStep()
+{
+    utBool timeout = utFalse;
+    struct timespec waitTime;
+    utcGetAbsoluteTimespec(&waitTime, REPLAY_STEP_TIMEOUT_MS);
+    FIX_LOCK {
+        while (gpsRunThread && (gpsReplayStepGeneration != gpsFixGeneration)) {
+            if (threadConditionTimedWait(&gpsReplayCond, &gpsFixMutex, &waitTime) != 0) {
+                timeout = utTrue;
+                break;
+            }
+        }
+    } FIX_UNLOCK
+    if (timeout) {
+        logWARNING(LOGSRC,"GPS replay: fix #%lu not handled by main loop", gpsFixGeneration);
+    }
+}
+#endif
+
+/* advance the virtual clock to the time of the specified $GPRMC/$GPGGA sentence */
+// The clock is not advanced until the main loop has handled the previous fix.  When
+// replaying a recorded file, this also sleeps for the (scaled) time between fixes.
+static void _gpsReplayAdvanceClock(const char *data)
+{
+    char buf[128];
+    NMEASentence_t ns;
+    strncpy(buf, data, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = 0;
+    int type = nmeaParseSentence(&ns, buf);
+    if (((type != NMEA0183_GPRMC) && (type != NMEA0183_GPGGA)) || (ns.count < 2)) {
+        return;
+    }
+
+    /* fix time */
+    // $GPGGA carries no date, the day is taken from the (virtual) clock
+    UInt32 hms = strParseUInt32(ns.fld[1], 0L);
+    UInt32 dmy = ((type == NMEA0183_GPRMC) && (ns.count > 9))? strParseUInt32(ns.fld[9], 0L) : 0L;
+    if (!dmy && !utcIsVirtualTime()) {
+        return; // wait for the first dated $GPRMC
+    }
+    UInt32 sec = nmeaGetUTCSeconds(dmy, hms);
+    UInt32 ms  = 0L;
+    const char *frac = strchr(ns.fld[1], '.');
+    if (frac) {
+        int d;
+        for (frac++, d = 0; d < 3; d++) {
+            ms = (ms * 10L) + (isdigit(*frac)? (UInt32)(*frac++ - '0') : 0L);
+        }
+    }
+
+    /* step */
+#if defined(GPS_THREAD)
+    _gpsReplayWaitStep();
+#endif
+
+    /* pace playback */
+    if (gpsReplayPaced && (gpsReplaySec > 0L)) {
+        Int32 deltaMS = ((Int32)(sec - gpsReplaySec) * 1000L) + ((Int32)ms - (Int32)gpsReplayMS);
+        if (deltaMS > 0L) {
+            threadSleepMS((UInt32)deltaMS / gpsReplayRate);
+        }
+    }
+    gpsReplaySec = sec;
+    gpsReplayMS  = ms;
+    utcSetVirtualTime(sec, ms);
+
+}
+
+/* read a single line from the replay file */
+static int _gpsReplayReadLine(char *data, int dataSize)
+{
+    if (!fgets(data, dataSize, gpsReplayFile)) {
+        logINFO(LOGSRC,"GPS replay complete");
+        fclose(gpsReplayFile);
+        gpsReplayFile = (FILE*)0;
+        gpsReplayDone = utTrue;
+        return -1;
+    }
+    int len = strlen(data);
+    while ((len > 0) && ((data[len - 1] == '\n') || (data[len - 1] == '\r'))) {
+        data[--len] = 0;
+    }
+    if ((len > 7) && (data[0] == '$') && (!strncmp(&data[3],"RMC,",4) || !strncmp(&data[3],"GGA,",4))) {
+        _gpsReplayAdvanceClock(data);
+    }
+    return len;
+}
+
+#endif // defined(GPS_DEVICE_REPLAY)
+
 /* open gps serial port */
 static utBool _gpsOpen()
 {
@@ -279,6 +432,13 @@ static utBool _gpsOpen()
     }
 #endif
 
+    /* replay mode? */
+#if defined(GPS_DEVICE_REPLAY)
+    if (strStartsWithIgnoreCase(portName,GPS_REPLAY_PREFIX)) {
+        return _gpsReplayOpen(portName + strlen(GPS_REPLAY_PREFIX));
+    }
+#endif
+
     /* speed */
     long bpsSpeed = (long)propGetUInt32(PROP_CFG_GPS_BPS, -1L);
     if (bpsSpeed <= 0L) { bpsSpeed = DEFAULT_GPS_SPEED; }
@@ -358,6 +518,13 @@ static utBool gpsUpdateSystemClock(long fixtime)
     }
 #endif
     
+    /* never update if we're replaying recorded data (the replay sets the virtual clock) */
+#if defined(GPS_DEVICE_REPLAY)
+    if (gpsReplayFile || gpsReplayDone) {
+        return utFalse;
+    }
+#endif
+    
     /* update clock */
     logDEBUG(LOGSRC,"System clock out-of-sync: %ld [delta %ld sec]", fixtime, d);
     utcSetTimeSec(fixtime);
@@ -367,80 +534,81 @@ static utBool gpsUpdateSystemClock(long fixtime)
 
 // ----------------------------------------------------------------------------
 
-/* parse YMD/HMS into UTC Epoch seconds */
-static UInt32 _gpsGetUTCSeconds(UInt32 dmy, UInt32 hms)
+/* write the latest-fix slot (advancing the generation for a new fix) */
+static void _gpsWriteFixSlot(const GPS_t *fix, utBool newFix)
 {
 
-    /* time of day [TOD] */
-    int    HH  = (int)((hms / 10000L) % 100L);
-    int    MM  = (int)((hms / 100L) % 100L);
-    int    SS  = (int)(hms % 100L);
-    UInt32 TOD = (HH * 3600L) + (MM * 60L) + SS;
-
-    /* current UTC day */
-    long DAY = 0L;
-    if (dmy) {
-        int    yy  = (int)(dmy % 100L) + 2000;
-        int    mm  = (int)((dmy / 100L) % 100L);
-        int    dd  = (int)((dmy / 10000L) % 100L);
-        long   yr  = ((long)yy * 1000L) + (long)(((mm - 3) * 1000) / 12);
-        DAY        = ((367L * yr + 625L) / 1000L) - (2L * (yr / 1000L))
-                     + (yr / 4000L) - (yr / 100000L) + (yr / 400000L)
-                     + (long)dd - 719469L;
-    } else {
-        // we don't have the day, so we need to figure out as close as we can what it should be.
-        UInt32 utc = utcGetTimeSec();
-        if (utc < MIN_CLOCK_TIME) {
-            // the system clock time is not valid
-            logWARNING(LOGSRC,"Current clock time is prior to minimum time! [%lu]", utc);
-            DAY = 0L;
-        } else {
-            UInt32 tod = utc % DAY_SECONDS(1);
-            DAY        = utc / DAY_SECONDS(1);
-            Int32  dif = tod - TOD; // difference should be small (ie. < 1 hour)
-            if (labs(dif) > HOUR_SECONDS(12)) { // 12 to 18 hours
-                // > 12 hour difference, assume we've crossed a day boundary
-                if (tod > TOD) {
-                    // tod > TOD likely represents the next day
-                    DAY++;
-                } else {
-                    // tod < TOD likely represents the previous day
-                    DAY--;
-                }
-            }
-        }
+    /* update slot */
+    threadSeqWriteBegin(&gpsFixSeqLock);
+    memcpy(&gpsFixSlot, fix, sizeof(GPS_t));
+    if (newFix) { gpsFixGeneration++; }
+    threadSeqWriteEnd(&gpsFixSeqLock);
+
+    /* wake waiters */
+    if (newFix) {
+        FIX_LOCK {
+            FIX_NOTIFY
+        } FIX_UNLOCK
     }
-    
-    /* return UTC seconds */
-    UInt32 sec = DAY_SECONDS(DAY) + TOD;
-    return sec;
-    
+
 }
 
-/* parse latitude */
-static double getLatitude(const char *s, const char *d)
+/* publish the epoch fix to the latest-fix slot */
+// Called by the GPS reader only (single writer), after each sentence merged into the
+// epoch.  The generation is advanced once per epoch: when the epoch has its $GPRMC and
+// $GPGGA, or only its $GPRMC if the receiver does not send $GPGGA (learned from the
+// previous epoch).  Later sentences of a published epoch update it in place.  An epoch 
+// whose expected $GPGGA did not arrive is published when the next epoch starts.
+static void _gpsPublishFix(const NMEAParser_t *np)
 {
-    double _lat = strParseDouble(s, 99999.0);
-    if (_lat < 99999.0) {
-        double lat = (double)((long)_lat / 100L); // _lat is always positive here
-        lat += (_lat - (lat * 100.0)) / 60.0;
-        return !strcmp(d,"S")? -lat : lat;
+    const GPS_t *fix = &(np->fix);
+
+    /* new epoch? */
+    if (np->epochTOD != gpsEpochTOD) {
+        if (gpsEpochPending) {
+            // the expected $GPGGA did not arrive
+            _gpsWriteFixSlot(&gpsEpochFix, utTrue);
+        }
+        if (gpsEpochNMEA & NMEA0183_GPRMC) {
+            gpsExpectGPGGA = (gpsEpochNMEA & NMEA0183_GPGGA)? utTrue : utFalse;
+        }
+        gpsEpochTOD       = np->epochTOD;
+        gpsEpochPublished = utFalse;
+        gpsEpochPending   = utFalse;
+    }
+    gpsEpochNMEA = fix->nmea;
+
+    /* publish */
+    if (gpsEpochPublished) {
+        // update published epoch in place
+        _gpsWriteFixSlot(fix, utFalse);
+    } else
+    if (!(fix->nmea & NMEA0183_GPRMC)) {
+        // wait for $GPRMC
+    } else
+    if ((fix->nmea & NMEA0183_GPGGA) || !gpsExpectGPGGA) {
+        // complete fix
+        _gpsWriteFixSlot(fix, utTrue);
+        gpsEpochPublished = utTrue;
+        gpsEpochPending   = utFalse;
     } else {
-        return 90.0; // invalid latitude
+        // wait for $GPGGA
+        memcpy(&gpsEpochFix, fix, sizeof(GPS_t));
+        gpsEpochPending = utTrue;
     }
+
 }
 
-/* parse longitude */
-static double getLongitude(const char *s, const char *d)
+/* copy the latest published fix, returns the fix generation */
+static UInt32 _gpsReadFixSlot(GPS_t *gps)
 {
-    double _lon = strParseDouble(s, 99999.0);
-    if (_lon < 99999.0) {
-        double lon = (double)((long)_lon / 100L); // _lon is always positive here
-        lon += (_lon - (lon * 100.0)) / 60.0;
-        return !strcmp(d,"W")? -lon : lon;
-    } else {
-        return 180.0; // invalid longitude
-    }
+    UInt32 seq, gen;
+    do {
+        seq = threadSeqReadBegin(&gpsFixSeqLock);
+        memcpy(gps, &gpsFixSlot, sizeof(GPS_t));
+        gen = gpsFixGeneration;
+    } while (threadSeqReadRetry(&gpsFixSeqLock, seq));
+    return gen;
 }
 
 /* read a single line from the GPS receiver */
@@ -502,6 +670,11 @@ static int _gpsReadLine(ComPort_t *com, char *data, int dataSize, long timeoutMS
         //logDEBUG(LOGSRC,"GPS SIM[%d]: %s", simCount, data);
         return (d - data);
     }
+#endif
+#if defined(GPS_DEVICE_REPLAY)
+    if (gpsReplayFile) {
+        return _gpsReplayReadLine(data, dataSize);
+    }
 #endif
     return comPortReadLine(com, data, dataSize, timeoutMS);
 }
@@ -576,6 +749,11 @@ static int _gpsReadGPSFix(UInt32 timeoutMS)
         /* read data */
         dataLen = _gpsReadLine(com, data, sizeof(data), readTimeoutMS);
         if (dataLen < 0) {
+#if defined(GPS_DEVICE_REPLAY)
+            if (gpsReplayDone) {
+                return -1; // end of replay file
+            }
+#endif
             // com port closed? (not likely on the GumStix)
             if (utcIsTimerExpired(gpsLastReadErrorTimer,600L)) {
                 gpsLastReadErrorTimer = utcGetTimer();
@@ -635,7 +813,8 @@ static int _gpsReadGPSFix(UInt32 timeoutMS)
 #endif
 
         /* NMEA-0183 sentence */
-        if (strStartsWith(data, "$GP")) {
+        // "$GP" GPS, "$GN" multi-GNSS, "$GL" GLONASS, etc. (proprietary "$P" are ignored by the parser)
+        if (data[1] != 'P') {
 
             // http://www.scientificcomponent.com/nmea0183.htm
             // http://home.mira.net/~gnb/gps/nmea.html
@@ -709,105 +888,58 @@ static int _gpsReadGPSFix(UInt32 timeoutMS)
 
             utBool validFix_GPRMC = utFalse;
             utBool validFix_GPGGA = utFalse;
-            char fldData[256], *fld[22];
-            memset(fld, 0, sizeof(fld));
-            strncpy(fldData, data, sizeof(fldData) - 1); // local copy
-            fldData[sizeof(fldData) - 1] = 0; // safety net terminator
-            strParseArray(fldData, fld, 20);
-
-            /* checksum (XOR sum of all characters between '$' and '*', exclusive) */
-            if (!cksumIsValidCharXOR(&data[1],(int*)0)) {
-                logWARNING(LOGSRC,"GPS record failed checksum: %s", fld[0]);
+            NMEASentence_t ns;
+
+            /* split fields in place, test checksum */
+            // (XOR sum of all characters between '$' and '*', exclusive)
+            int type = nmeaParseSentence(&ns, data);
+            if (type == NMEA_ERR_CHECKSUM) {
+                logWARNING(LOGSRC,"GPS record failed checksum: %s", ns.fld[0]);
                 continue; // skip this record
+            } else
+            if (type <= 0) {
+                // unsupported record type
+                continue;
             }
 
-            /* handle record type */
+            /* merge into the current epoch */
             // We cannot assume that the GPRMC will arrive before GPGGA, or visa-versa.
-            // so we must handle either case.
-            if (strEqualsIgnoreCase(fld[0],"$GPRMC")) {
-#if defined(SUPPORT_TYPE_GPRMC)
-                if (*fld[2] == 'A') {
+            // The parser merges all sentences with the same time-of-day into a single fix.
+            int rtn = nmeaAddSentence(&gpsParser, &ns);
+            if (rtn == NMEA_FIX_BADTIME) {
+                // The fixtime is invalid
+                // ($GPGGA: this can occur if the system clock time hasn't yet been updated)
+                if (type == NMEA0183_GPRMC) {
+                    logERROR(LOGSRC,"$GPRMC invalid fixtime: %s %s", ns.fld[1], ns.fld[9]);
+                } else {
+                    logINFO(LOGSRC,"%s invalid fixtime: %s", ns.fld[0], ns.fld[1]);
+                }
+            } else
+            if (rtn == NMEA_FIX_BADPOINT) {
+                // We have an valid record, but the lat/lon appears to be invalid!
+                logWARNING(LOGSRC,"%s invalid lat/lon", ns.fld[0]);
+            } else
+            if (rtn == NMEA_FIX_MERGED) {
+                _gpsPublishFix(&gpsParser);
+                validFix_GPRMC = (type == NMEA0183_GPRMC)? utTrue : utFalse;
+                validFix_GPGGA = (type == NMEA0183_GPGGA)? utTrue : utFalse;
+            }
+
+            /* count record types */
+            if (type == NMEA0183_GPRMC) {
+                if (rtn != NMEA_FIX_NOFIX) {
                     // "A" - valid gps fix
-                    
-                    /* parse */
-                    UInt32 hms       = strParseUInt32(fld[1], 0L);
-                    UInt32 dmy       = strParseUInt32(fld[9], 0L);
-                    UInt32 fixtime   = _gpsGetUTCSeconds(dmy, hms);
-                    double latitude  = getLatitude (fld[3], fld[4]);
-                    double longitude = getLongitude(fld[5], fld[6]);
-                    double knots     = strParseDouble(fld[7], -1.0);
-                    double heading   = strParseDouble(fld[8], -1.0);
-                    double speedKPH  = (knots >= 0.0)? (knots * KILOMETERS_PER_KNOT) : -1.0;
-                    
-                    /* HDOP expired? */
-                    if (utcIsTimerExpired(gpsLastHDOPTimer,60L)) {
-                        gpsLastPDOP = GPS_UNDEFINED_DOP;
-                        gpsLastHDOP = GPS_UNDEFINED_DOP;
-                        gpsLastVDOP = GPS_UNDEFINED_DOP;
-                        // do not reset timer
-                    }
-                    
-                    /* save */
-                    if (fixtime < MIN_CLOCK_TIME) {
-                        
-                        // The fixtime is invalid
-                        char dt[32];
-                        utcFormatDateTime(dt, fixtime);
-                        logERROR(LOGSRC,"$GPRMC invalid fixtime: [%lu] %s UTC", fixtime, dt);
-                        logERROR(LOGSRC,"GPS: %s", data);
-                        
-                    } else
-                    if ((latitude  >=  90.0) || (latitude  <=  -90.0) ||
-                        (longitude >= 180.0) || (longitude <= -180.0)   ) {
-                            
-                        // We have an valid record, but the lat/lon appears to be invalid!
-                        logWARNING(LOGSRC,"$GPRMC invalid lat/lon: %.5lf/%.5lf", latitude, longitude);
-                        
-                    } else {
-                        
-                        GPS_LOCK {
-                            // If the $GPGGA came first, we don't want to indiscriminately clear
-                            // out the GPS structure before adding the $GPRMC data.
-                            if ((gpsFixUnsafe.fixtype == 0)                  ||     // no GPS fix
-                                (gpsFixUnsafe.fixtime < MIN_CLOCK_TIME)      ||     // uninitialized fixtime
-                                (gpsFixUnsafe.fixtime > fixtime)             ||     // fixtime in the future
-                                ((fixtime - gpsFixUnsafe.fixtime) > GP_EXPIRE) ) {  // expired fixtime
-                                gpsClear(&gpsFixUnsafe);
-                                gpsFixUnsafe.fixtype = 1; // GPS
-                            } else
-                            if ((gpsFixUnsafe.point.latitude  != latitude ) ||      // latitude  changed (no GGA?)
-                                (gpsFixUnsafe.point.longitude != longitude)   ) {   // longitude changed (no GGA?)
-                                gpsClear(&gpsFixUnsafe);
-                                gpsFixUnsafe.fixtype = 1; // GPS
-                            } else {
-                                // I will be adding to the existing data
-                            }
-                            gpsFixUnsafe.ageTimer        = utcGetTimer();
-                            gpsFixUnsafe.fixtime         = fixtime;
-                            gpsFixUnsafe.speedKPH        = speedKPH;
-                            gpsFixUnsafe.heading         = heading;
-                            gpsFixUnsafe.point.latitude  = latitude;
-                            gpsFixUnsafe.point.longitude = longitude;
-                            gpsFixUnsafe.pdop            = gpsLastPDOP;
-                            gpsFixUnsafe.hdop            = gpsLastHDOP;
-                            gpsFixUnsafe.vdop            = gpsLastVDOP;
-                            gpsFixUnsafe.nmea           |= NMEA0183_GPRMC;
-                            if (gpsFixUnsafe.nmea & NMEA0183_GPGGA) {
-                                gpsCopy(&gpsFixLast, &gpsFixUnsafe);
-                            }
-                        } GPS_UNLOCK
-                        validFix_GPRMC = utTrue;
-
-                        /* update system clock ($GPRMC records only!) */
-                        gpsUpdateSystemClock(fixtime + 2L);
 
+                    /* update system clock ($GPRMC records only!) */
+                    if (validFix_GPRMC) {
+                        gpsUpdateSystemClock(gpsParser.fix.fixtime + 2L);
                     }
-                            
+
                     /* count valid record type */
                     SAMPLE_LOCK { // locked to prevent external access
                         gpsSampleCount_A++;
                         if (gpsLastSampleTimer == 0L) {
-                            logINFO(LOGSRC,"First $GPRMC record (A) @%lu", fixtime);
+                            logINFO(LOGSRC,"First $GPRMC record (A) @%lu", gpsParser.fix.fixtime);
                         } 
                         gpsLastSampleTimer = utcGetTimer();
                         if (validFix_GPRMC) { gpsLastValidTimer = utcGetTimer(); }
@@ -828,111 +960,11 @@ static int _gpsReadGPSFix(UInt32 timeoutMS)
                     // No valid fix aquired
 
                 }
-#endif
-            } else
-            if (strEqualsIgnoreCase(fld[0],"$GPGGA")) {
-#if defined(SUPPORT_TYPE_GPGGA)
-                if (*fld[6] != '0') {
-                    // "1" = GPS
-                    // "2" = DGPS
-
-                    /* parse */
-                    UInt32 hms       = strParseUInt32(fld[1], 0L);
-                    UInt32 dmy       = 0L; // we don't know the day
-                    UInt32 fixtime   = _gpsGetUTCSeconds(dmy, hms);
-                    double latitude  = getLatitude (fld[2], fld[3]);
-                    double longitude = getLongitude(fld[4], fld[5]);
-                    gpsLastHDOP      = strParseDouble(fld[8], GPS_UNDEFINED_DOP);
-                    int    fixtype   = (int)strParseUInt32(fld[6], 1L); // 1=GPS, 2=DGPS, 3=PPS?, ...
-                    double altitude  = strParseDouble(fld[9], 0.0);
-
-                    /* PDOP/VDOP expired? */
-                    if (utcIsTimerExpired(gpsLastHDOPTimer,60L)) {
-                        gpsLastPDOP = GPS_UNDEFINED_DOP;
-                        gpsLastVDOP = GPS_UNDEFINED_DOP;
-                    }
-                    gpsLastHDOPTimer = utcGetTimer(); // reset timer
-
-                    /* save */
-                    if (fixtime < MIN_CLOCK_TIME) {
-                        // The fixtime is invalid
-                        // (this can occur if the system clock time hasn't yet been updated)
-                        char dt[32];
-                        utcFormatDateTime(dt, fixtime);
-                        logINFO(LOGSRC,"$GPGGA invalid fixtime: [%lu] %s UTC", fixtime, dt);
-                        logINFO(LOGSRC,"GPS: %s", data);
-                    } else
-                    if ((latitude  >=  90.0) || (latitude  <=  -90.0) ||
-                        (longitude >= 180.0) || (longitude <= -180.0)   ) {
-                        // We have an valid record, but the lat/lon appears to be invalid!
-                        logWARNING(LOGSRC,"$GPGGA invalid lat/lon: %.5lf/%.5lf", latitude, longitude);
-                    } else {
-                        GPS_LOCK {
-                            // If the $GPRMC came first, we don't want to indiscriminately clear
-                            // out the GPS structure before adding the $GPGGA data.
-                            if ((gpsFixUnsafe.fixtype == 0)                  ||      // no GPS fix
-                                (gpsFixUnsafe.fixtime < MIN_CLOCK_TIME)      ||      // uninitialized fixtime
-                                (gpsFixUnsafe.fixtime > fixtime)             ||      // fixtime in the future
-                                ((fixtime - gpsFixUnsafe.fixtime) > GP_EXPIRE) ) {   // expired fixtime
-                                gpsClear(&gpsFixUnsafe);
-                            } else
-                            if ((gpsFixUnsafe.point.latitude  != latitude ) ||      // latitude  changed (no GGA?)
-                                (gpsFixUnsafe.point.longitude != longitude)   ) {   // longitude changed (no GGA?)
-                                //gpsClear(&gpsFixUnsafe);
-                            } else {
-                                // I will be adding to the existing data
-                            }
-                            gpsFixUnsafe.ageTimer        = utcGetTimer();
-                            gpsFixUnsafe.fixtime         = fixtime;
-                            gpsFixUnsafe.altitude        = altitude;
-                            gpsFixUnsafe.point.latitude  = latitude;
-                            gpsFixUnsafe.point.longitude = longitude;
-                            gpsFixUnsafe.fixtype         = fixtype;
-                            gpsFixUnsafe.pdop            = gpsLastPDOP;
-                            gpsFixUnsafe.hdop            = gpsLastHDOP;
-                            gpsFixUnsafe.vdop            = gpsLastVDOP;
-                            gpsFixUnsafe.nmea           |= NMEA0183_GPGGA;
-                            if (gpsFixUnsafe.nmea & NMEA0183_GPRMC) {
-                                gpsCopy(&gpsFixLast, &gpsFixUnsafe);
-                            }
-                        } GPS_UNLOCK
-                        validFix_GPGGA = utTrue;
-                    }
-                            
-                    /* count valid record type */
-                    SAMPLE_LOCK { // locked to prevent external access to 'gpsLastValidTimer'
-                        if (validFix_GPGGA) { gpsLastValidTimer = utcGetTimer(); }
-                    } SAMPLE_UNLOCK
-
-                }
-#endif
             } else
-            if (strEqualsIgnoreCase(fld[0],"$GPGSA")) {
-#if defined(SUPPORT_TYPE_GPGSA)
-                if ((*fld[2] != '2') || (*fld[2] != '3')) {
-                    // "2" = 2D
-                    // "3" = 3D
-
-                    /* parse */
-                    gpsLastPDOP = strParseDouble(fld[15], GPS_UNDEFINED_DOP);
-                    gpsLastHDOP = strParseDouble(fld[16], GPS_UNDEFINED_DOP);
-                    gpsLastVDOP = strParseDouble(fld[17], GPS_UNDEFINED_DOP);
-                    gpsLastHDOPTimer = utcGetTimer();
-                    
-                    /* save */
-                    GPS_LOCK {
-                        gpsFixUnsafe.pdop  = gpsLastPDOP;
-                        gpsFixUnsafe.hdop  = gpsLastHDOP;
-                        gpsFixUnsafe.vdop  = gpsLastVDOP;
-                        gpsFixUnsafe.nmea |= NMEA0183_GPGSA;
-                    } GPS_UNLOCK
-                    
-                }
-#endif
-            } else {
-                
-                // unsupported record type
-                
+            if (validFix_GPGGA) {
+                SAMPLE_LOCK { // locked to prevent external access to 'gpsLastValidTimer'
+                    gpsLastValidTimer = utcGetTimer();
+                } SAMPLE_UNLOCK
             }
 
             /* valid fix? */
@@ -943,7 +975,7 @@ static int _gpsReadGPSFix(UInt32 timeoutMS)
 
         } else {
 
-            // sentence does not start with "$GP..."
+            // proprietary sentence
 
         }
              
@@ -979,6 +1011,13 @@ static void _gpsThreadRunnable(void *arg)
     /* non-simulator loop */
     TimerSec_t gpsLastOpenErrorTimer = 0L;
     while (gpsRunThread) {
+
+#if defined(GPS_DEVICE_REPLAY)
+        /* replay complete? */
+        if (gpsReplayDone) {
+            break;
+        }
+#endif
         
         /* power-conservation */
         // The HP hw6945 turns off the GPS receiver when the comport is closed.  To conserve
@@ -1066,12 +1105,18 @@ static void _gpsThreadRunnable(void *arg)
     /* once this thread stops, it isn't starting again */
     // The following resources should be released:
     //  - gpsComPort
-    //  - gpsMutex
+    //  - gpsFixMutex
+    //  - gpsFixCond
     //  - gpsSampleMutex
     //  - gpsAquireMutex
     //  - gpsAquireCond
     //  - And everything in the supported GPS modules
     //  - ???
+#if defined(GPS_DEVICE_REPLAY)
+    if (gpsReplayDone) {
+        logINFO(LOGSRC,"GPS thread is terminating (replay complete) ...");
+    } else
+#endif
     logERROR(LOGSRC,"GPS thread is terminating ...");
     threadExit();    
 
@@ -1122,15 +1167,20 @@ void gpsInitialize(eventAddFtn_t queueEvent)
     comPortInitStruct(&gpsComPort);
 
     /* clear gps struct */
-    gpsClear(&gpsFixLast);
-    gpsClear(&gpsFixUnsafe);
+    gpsClear(&gpsFixSlot);
+    threadSeqLockInit(&gpsFixSeqLock);
+    nmeaParserInit(&gpsParser, GPS_NMEA_TYPES);
     
 #if defined(GPS_THREAD)
     /* create mutex's */
-    threadMutexInit(&gpsMutex);
+    threadMutexInit(&gpsFixMutex);
+    threadConditionInit(&gpsFixCond);
     threadMutexInit(&gpsSampleMutex);
     threadMutexInit(&gpsAquireMutex);
     threadConditionInit(&gpsAquireCond);
+#if defined(GPS_DEVICE_REPLAY)
+    threadConditionInit(&gpsReplayCond);
+#endif
 #endif
 
     /* GPS module initialization */
@@ -1216,6 +1266,7 @@ GPS_t *gpsAquire(GPS_t *gps, UInt32 timeoutMS)
     for (;accumTimeoutMS < timeoutMS;) {
         
         /* get latest fix */
+        UInt32 gen = gpsGetFixGeneration();
         GPS_t *g = gpsGetLastGPS(gps, -1);
         if (g && (utcGetTimerAgeSec(g->ageTimer) <= 7L)) {
             // The latest fix occurred within the last 7 seconds.
@@ -1225,7 +1276,7 @@ GPS_t *gpsAquire(GPS_t *gps, UInt32 timeoutMS)
         /* wait for next fix */
         UInt32 tmo = timeoutMS - accumTimeoutMS;
         if (tmo > 1000L) { tmo = 1000L; }
-        threadSleepMS(tmo);
+        gpsWaitForFix(gen, tmo);
         accumTimeoutMS += tmo;
 
     }
@@ -1278,36 +1329,11 @@ GPS_t *gpsAquire(GPS_t *gps, UInt32 timeoutMS)
 /* get last aquired GPS fix */
 GPS_t *gpsGetLastGPS(GPS_t *gps, Int16 maxAgeSec)
 {
-    // no blocking
+    // no blocking (lock-free read of the latest published fix)
     if (gps) {
         
         /* get latest fix */
-        GPS_LOCK {
-            // gpsFixLast   - contains the most recent fix that has all the GPS components
-            // gpsFixUnsafe - contains the fix-in-progress
-            if (gpsFixUnsafe.fixtime < (gpsFixLast.fixtime + GP_EXPIRE)) {
-                // The last fix is within 5 seconds of the new fix-in-process.
-                // During normal GPS aquisition, the fix times will likely be the same.
-                // If not the same, then the fix-in-process may have just started on 
-                // the next sample.
-                memcpy(gps, &gpsFixLast, sizeof(GPS_t));
-            } else
-            if (gpsFixUnsafe.nmea & NMEA0183_GPRMC) {
-                // The last fix ('gpsFixLast') is stale.
-                // The fix-in-process at least has the GPRMC
-                // One of the following may have occured:
-                //  - We stopped getting GPGGA records (or don't get them).
-                //  - We just started getting valid GPS fixes again and we happen to have been 
-                //    called when we are between GPRMC/GPGGA records (unlikely, but possible).
-                //logDEBUG(LOGSRC,"We don't have a valid $GPGGA record"); 
-                memcpy(gps, &gpsFixUnsafe, sizeof(GPS_t));
-            } else {
-                // The fix-in-process doesn't have a GPRMC.
-                // The last fix is stale, but return it anyway.
-                memcpy(gps, &gpsFixLast, sizeof(GPS_t)); 
-                // fix may still be invalid
-            }
-        } GPS_UNLOCK
+        _gpsReadFixSlot(gps);
         
         /* check fix */
         if (!gpsIsValid(gps)) {
@@ -1330,3 +1356,45 @@ GPS_t *gpsGetLastGPS(GPS_t *gps, Int16 maxAgeSec)
 }
 
 // ----------------------------------------------------------------------------
+
+/* return the generation of the latest published fix */
+// The generation is advanced each time the GPS reader publishes a new fix.
+UInt32 gpsGetFixGeneration()
+{
+    return gpsFixGeneration;
+}
+
+/* wait until the fix generation differs from 'generation' */
+// Returns the current generation.  In non-thread mode this simply sleeps 'timeoutMS'.
+// Called by the main loop after handling fix 'generation', which also releases a GPS
+// replay to publish its next fix.
+UInt32 gpsWaitForFix(UInt32 generation, UInt32 timeoutMS)
+{
+#if defined(GPS_THREAD)
+    if (!gpsRunThread) {
+        // no GPS thread to publish fixes
+        threadSleepMS(timeoutMS);
+        return gpsFixGeneration;
+    }
+    struct timespec waitTime;
+    utcGetAbsoluteTimespec(&waitTime, timeoutMS);
+    FIX_LOCK {
+#if defined(GPS_DEVICE_REPLAY)
+        if (gpsReplayStepGeneration != generation) {
+            gpsReplayStepGeneration = generation;
+            CONDITION_NOTIFY(&gpsReplayCond);
+        }
+#endif
+        while (gpsFixGeneration == generation) {
+            if (threadConditionTimedWait(&gpsFixCond, &gpsFixMutex, &waitTime) != 0) {
+                break; // timeout
+            }
+        }
+    } FIX_UNLOCK
+#else
+    threadSleepMS(timeoutMS);
+#endif
+    return gpsFixGeneration;
+}
+
+// ----------------------------------------------------------------------------
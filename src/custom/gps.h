@@ -64,6 +64,9 @@ GPS_t *gpsCheckMinimums(GPS_t *gps);
 GPS_t *gpsAquire(GPS_t *gps, UInt32 timeoutMS);
 GPS_t *gpsGetLastGPS(GPS_t *gps, Int16 maxAgeSec);
 
+UInt32 gpsGetFixGeneration();
+UInt32 gpsWaitForFix(UInt32 generation, UInt32 timeoutMS);
+
 // ----------------------------------------------------------------------------
 
 GPSDiagnostics_t *gpsGetDiagnostics(GPSDiagnostics_t *stats);
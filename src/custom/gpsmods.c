@@ -40,6 +40,7 @@
 
 #include "modules/motion.h"
 #include "modules/odometer.h"
+#include "modules/track.h"
 #if defined(ENABLE_GEOZONE)
 #  include "modules/geozone.h"
 #endif
@@ -47,6 +48,8 @@
 #include "base/events.h"
 
 #include "tools/stdtypes.h"
+#include "tools/gpstools.h"
+#include "tools/utctools.h"
 
 // ----------------------------------------------------------------------------
 
@@ -54,6 +57,10 @@
 void gpsModuleInitialize(eventAddFtn_t queueEvent)
 {
 
+    /* track simplification (filters events queued by the modules below) */
+    trackInitialize(queueEvent);
+    queueEvent = &trackQueueEvent;
+
     /* motion */
     motionInitialize(queueEvent);
 
@@ -75,16 +82,20 @@ void gpsModuleInitialize(eventAddFtn_t queueEvent)
 void gpsModuleCheckEvents(GPS_t *lastFix, GPS_t *newFix)
 {
     // NOTE: 'newFix' may be NULL if a new fix is not available
+
+    /* derived fix values (computed once, shared by all modules) */
+    GPSFixContext_t ctx;
+    gpsFixContextInit(&ctx, newFix, utcGetTimeSec());
     
     /* motion */
-    motionCheckGPS(lastFix, newFix);
+    motionCheckGPS(&ctx);
     
     /* odometer */
-    odomCheckGPS(lastFix, newFix);
+    odomCheckGPS(&ctx);
 
     /* geozone (if enabled) */
 #if defined(ENABLE_GEOZONE)
-    geozCheckGPS(lastFix, newFix);
+    geozCheckGPS(&ctx);
 #endif
 
     // Add other modules to this list as needed
@@ -97,6 +108,10 @@ void gpsModuleCheckEvents(GPS_t *lastFix, GPS_t *newFix)
 // (approximately once per second)
 void gpsModulePeriodic()
 {
+
+    /* track simplification */
+    trackPeriodic();
+
     // Add other modules to this list as needed
 }
 
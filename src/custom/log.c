@@ -97,6 +97,13 @@
 
 #define FLUSH_MODULO            5L
 
+// This value may be overridden in "defaults.h" by defining "LOGGING_MESSAGE_FILE_SIZE"
+#if defined(LOGGING_MESSAGE_FILE_SIZE)
+#  define MAX_AUX_FILE_SIZE     LOGGING_MESSAGE_FILE_SIZE
+#else
+#  define MAX_AUX_FILE_SIZE     (256L * 1024L) // rotated to "<file>.1" when exceeded
+#endif
+
 // ----------------------------------------------------------------------------
 
 static char                 syslogName[32];
@@ -111,19 +118,59 @@ static threadMutex_t        syslogMutex;
 #define LOG_LOCK            MUTEX_LOCK(&syslogMutex);
 #define LOG_UNLOCK          MUTEX_UNLOCK(&syslogMutex);
 
+/* log record */
+// Messages are queued to the logging thread as a record header followed by 'msgLen'
+// bytes of message text.  The "name.level[file:line]" prefix is formatted by the
+// logging thread ('fn' is always a '__FILE__' string constant, so it is not copied).
+typedef struct {
+    UInt32                  seq;        // orders records queued on different rings
+    const char              *fn;        // source file
+    UInt16                  line;       // source line
+    UInt8                   level;      // SYSLOG_xxx
+    UInt8                   rsvd;
+    UInt16                  msgLen;     // message text length (no terminator/newline)
+} LogRecord_t;
+
+typedef struct {
+    LogRecord_t             rec;
+    char                    text[MAX_MESSAGE_LENGTH + 2];
+} LogEntry_t;
+
 #if defined(SYSLOG_THREAD)
 #  define LOG_BUFFER_SIZE   3000 // should be sufficient for most cases
 static utBool               syslogRunThread = utFalse;
 static threadThread_t       syslogThread;
-static CircleBuffer_t       *syslogBuffer = (CircleBuffer_t*)0;
+static CircleBuffer_t       *syslogBuffer = (CircleBuffer_t*)0; // shared (locked) ring
 static threadCond_t         syslogCond;
 static struct timespec      syslogCondWaitTime;
+static volatile utBool      syslogThreadWaiting = utFalse;
+static volatile UInt32      syslogSequence = 0L;
+static volatile UInt32      syslogDropCount = 0L;
 #  define LOG_WAIT(T)       CONDITION_TIMED_WAIT(&syslogCond,&syslogMutex,utcGetAbsoluteTimespec(&syslogCondWaitTime,(T)));
 #  define LOG_NOTIFY        CONDITION_NOTIFY(&syslogCond);
 #endif
 
+// Per-thread rings: each logging thread gets its own single-producer ring, so that
+// queueing a message does not require the log lock.  Threads started after all
+// rings have been assigned use the shared ring.
+#if defined(SYSLOG_THREAD) && defined(BUFFER_SPSC) && defined(__GNUC__)
+#  define LOG_THREAD_RINGS
+#  define LOG_MAX_THREAD_RINGS  MAX_THREADS
+#  define LOG_RING_SIZE     2000
+#  define LOG_BARRIER()     __sync_synchronize()
+#  define LOG_NEXT_SEQ()    __sync_fetch_and_add(&syslogSequence, 1L)
+static CircleBuffer_t       *syslogRing[LOG_MAX_THREAD_RINGS];
+static volatile int         syslogRingCount = 0;
+static __thread int         syslogThreadRing = 0; // 0=unassigned, -1=shared, else index + 1
+#else
+#  define LOG_MAX_THREAD_RINGS  0
+#  define LOG_BARRIER()
+#  define LOG_NEXT_SEQ()    (syslogSequence++)
+#endif
+
 #if defined(LOGGING_MESSAGE_FILE) && defined(LOGGING_AUX_DIRECTORY)
 static FILE                 *syslogAuxFile = (FILE*)0;
+static long                 syslogAuxSize  = 0L;
 #endif
 
 static UInt32               syslogMsgCount = 0L;
@@ -172,17 +219,61 @@ const char *logSrcFile(const char *fn)
 
 // ----------------------------------------------------------------------------
 
+/* return the source file name (without path or extension) */
+// Only called by the thread formatting log records, so the cache requires no lock.
+#define SRC_CACHE_SIZE          16
+static struct {
+    const char  *fn;
+    const char  *name;
+    int         nameLen;
+} logSrcCache[SRC_CACHE_SIZE];
+static int logSrcCacheNext = 0;
+static const char *_logSrcName(const char *fn, int *nameLen)
+{
+    int i;
+    for (i = 0; i < SRC_CACHE_SIZE; i++) {
+        if (logSrcCache[i].fn == fn) {
+            *nameLen = logSrcCache[i].nameLen;
+            return logSrcCache[i].name;
+        }
+    }
+    int fnLen = strlen(fn), fi = fnLen - 1, fLen = fnLen;
+    const char *f = fn, *fp = (char*)0;
+    for (; fi >= 0; fi--) {
+        if (fn[fi] == '.') { fp = &fn[fi]; }
+        if ((fn[fi] == '/') || (fn[fi] == '\\')) { 
+            f = &fn[fi + 1];
+            fLen = fp? (fp - f) : (fnLen - (fi + 1));
+            break;
+        }
+    }
+    i = logSrcCacheNext;
+    logSrcCacheNext = (logSrcCacheNext + 1) % SRC_CACHE_SIZE;
+    logSrcCache[i].fn      = fn;
+    logSrcCache[i].name    = f;
+    logSrcCache[i].nameLen = fLen;
+    *nameLen = fLen;
+    return f;
+}
+
+// ----------------------------------------------------------------------------
+
 /* syslog output */
 #if defined(INCLUDE_SYSLOG_SUPPORT)
-static void _logSyslogPrint(int level, const char *trace, const char *fmt, va_list ap)
+static void _logSyslogPrint(int level, const char *fn, int line, const char *fmt, va_list ap)
 {
     char buf[MAX_MESSAGE_LENGTH];
     if (!syslogInit) { logInitialize(0); } // <-- if not yet initialized
-    int maxLen = 1 + strlen(trace) + 2 + strlen(fmt) + 1;
-    if (trace && *trace && (maxLen < sizeof(buf))) {
-        // combine 'trace' with 'fmt'
-        sprintf(buf, "[%s] %s", trace, fmt);
-        fmt = buf;
+    if (fn && *fn && (line > 0)) {
+        // combine 'fn:line' with 'fmt' 
+        // It is important that 'fn' not contain any string formatting characters
+        const char *f = logSrcFile(fn), *fp = strchr(f, '.');
+        int fLen = fp? (fp - f) : strlen(f);
+        int maxLen = 1 + fLen + 7 + 2 + strlen(fmt) + 1;
+        if (maxLen < sizeof(buf)) {
+            sprintf(buf, "[%.*s:%d] %s", fLen, f, line, fmt);
+            fmt = buf;
+        }
     }
     vsyslog(level, fmt, ap);
 }
@@ -199,19 +290,29 @@ static void _logAuxlogPrint(int level, const char *msg, int msgLen)
     //  - Allow the aux storage media to be removed at any time.
     if (syslogAuxFile || ioIsDirectory(LOGGING_AUX_DIRECTORY)) {
         // aux-storage dir exists (SD/MMC card is available)
-        // Note: opening/closing the log file multiple times does impact
-        // performance, so this feature should only be used for debugging purposes.
+        // The file remains open, and is flushed when the log queue is empty.
         if (!syslogAuxFile) {
             // open aux file
             syslogAuxFile = ioOpenStream(LOGGING_MESSAGE_FILE, IO_OPEN_APPEND);
+            if (syslogAuxFile && (fseek(syslogAuxFile, 0L, SEEK_END) == 0)) {
+                syslogAuxSize = ftell(syslogAuxFile);
+            } else {
+                syslogAuxSize = 0L;
+            }
         }
         if (syslogAuxFile) {
             // aux file is open, continue ...
             if (msgLen < 0) { msgLen = strlen(msg); } // includes '\n'
-            if (fwrite(msg,1,msgLen,syslogAuxFile) < 0) {
-                // write error occurred, close file
+            if (fwrite(msg,1,msgLen,syslogAuxFile) != msgLen) {
+                // write error occurred (media removed?), close file
                 ioCloseStream(syslogAuxFile);
                 syslogAuxFile = (FILE*)0;
+            } else
+            if ((syslogAuxSize += msgLen) >= MAX_AUX_FILE_SIZE) {
+                // rotate: the current file becomes "<file>.1"
+                ioCloseStream(syslogAuxFile);
+                syslogAuxFile = (FILE*)0;
+                ioRenameFile(LOGGING_MESSAGE_FILE, LOGGING_MESSAGE_FILE ".1");
             }
         }
     }
@@ -228,28 +329,44 @@ static void _logConsolePrint(int level, const char *msg, int msgLen)
 }
 #endif
 
-/* lock and log */
-static void _logMessagePrint(const char *msg, int msgLen)
+/* format record and print */
+static void _logMessagePrint(const LogRecord_t *rec, const char *text)
 {
+    int level = rec->level;
 
-    /* nothing to print? */
-    if (!msg || !*msg || (msgLen <= 0)) {
-        return;
+    /* 'Level' title */
+    const char *lvlName = "?";
+    switch (level) {
+        case SYSLOG_CRITICAL: lvlName = "CRITICAL";  break; // Critical errors
+        case SYSLOG_ERROR:    lvlName = "ERROR";     break; // General errors
+        case SYSLOG_WARNING:  lvlName = "WARN";      break; // Warnings
+        case SYSLOG_INFO:     lvlName = "info";      break; // Informational
+        case SYSLOG_DEBUG:    lvlName = "dbug";      break; // Debug
     }
 
-    /* skip first message character */
-    int level = *msg - '0';
-    const char *m = msg + 1;
-    int mLen = msgLen - 1;
+    /* format the message */
+    char msg[MAX_MESSAGE_LENGTH + 80];
+    int msgLen = 0;
+    if (rec->fn && *(rec->fn) && (rec->line > 0)) {
+        // pre-pend function information
+        int fLen;
+        const char *f = _logSrcName(rec->fn, &fLen);
+        if (fLen > 24) { fLen = 24; }
+        msgLen = sprintf(msg, "%s.%s[%.*s:%d] ", syslogName, lvlName, fLen, f, rec->line);
+    }
+    memcpy(&msg[msgLen], text, rec->msgLen);
+    msgLen += rec->msgLen;
+    msg[msgLen++] = '\n';
+    msg[msgLen] = 0;
 
     /* aux file logging */
 #if defined(LOGGING_MESSAGE_FILE) && defined(LOGGING_AUX_DIRECTORY)
-    _logAuxlogPrint(level, m, mLen);
+    _logAuxlogPrint(level, msg, msgLen);
 #endif
 
     /* console logging */
 #if defined(LOGGING_CONSOLE)
-    _logConsolePrint(level, m, mLen);
+    _logConsolePrint(level, msg, msgLen);
 #endif
 
 }
@@ -259,9 +376,7 @@ static void _logMessageFlush()
 {
 #if defined(LOGGING_MESSAGE_FILE) && defined(LOGGING_AUX_DIRECTORY)
     if (syslogAuxFile) {
-        //if (isDebugMode()) { fprintf(CONSOLE_OUTPUT, "Flush ...\n"); } // ignore returned error code
-        ioCloseStream(syslogAuxFile); // flush & close
-        syslogAuxFile = (FILE*)0;
+        ioFlushStream(syslogAuxFile);
     }
 #endif
 #if defined(LOGGING_CONSOLE)
@@ -271,6 +386,31 @@ static void _logMessageFlush()
 
 // ----------------------------------------------------------------------------
 
+#if defined(LOG_THREAD_RINGS)
+/* return the calling thread's ring (null if the shared ring must be used) */
+static CircleBuffer_t *_logGetThreadRing()
+{
+    if (syslogThreadRing == 0) {
+        // first message from this thread
+        syslogThreadRing = -1; // shared, unless a ring is assigned below
+        if (syslogRingCount < LOG_MAX_THREAD_RINGS) {
+            CircleBuffer_t *cb = bufferCreate(LOG_RING_SIZE); // (outside of the lock)
+            LOG_LOCK {
+                if (cb && (syslogRingCount < LOG_MAX_THREAD_RINGS)) {
+                    syslogRing[syslogRingCount] = cb;
+                    LOG_BARRIER();
+                    syslogRingCount++; // publish
+                    syslogThreadRing = syslogRingCount;
+                    cb = (CircleBuffer_t*)0;
+                }
+            } LOG_UNLOCK
+            if (cb) { bufferDestroy(cb); }
+        }
+    }
+    return (syslogThreadRing > 0)? syslogRing[syslogThreadRing - 1] : (CircleBuffer_t*)0;
+}
+#endif
+
 /* base logging print function */
 static void _logPrint(utBool force, int level, const char *fn, int line, const char *fmt, va_list ap)
 {
@@ -288,87 +428,70 @@ static void _logPrint(utBool force, int level, const char *fn, int line, const c
     if (!force && (level > syslogLevel)) {
         return;
     }
-        
-    /* extract source file from name */
-    // It is important that 'fn' not contain any string formatting characters
-    char trace[80];
-    if (fn && *fn && (line > 0)) {
-        int fnLen = strlen(fn), fi = fnLen - 1, fLen = 0;
-        const char *f = (char*)fn, *fp = (char*)0;
-        for (; fi >= 0; fi--) {
-            if (fn[fi] == '.') { fp = &fn[fi]; }
-            if ((fn[fi] == '/') || (fn[fi] == '\\')) { 
-                f = &fn[fi + 1];
-                fLen = fp? (fp - f) : (fnLen - (fi + 1));
-                break;
-            }
-        }
-        if ((fLen + 7) < sizeof(trace)) {
-            sprintf(trace,"%.*s:%d",fLen,f,line);
-            fn = trace;
-        }
-    }
 
     /* syslog */
 #if defined(INCLUDE_SYSLOG_SUPPORT)
     if (syslogEnabled) {
-        _logSyslogPrint(level, fn, fmt, ap);
+        _logSyslogPrint(level, fn, line, fmt, ap);
         return;
     } 
 #endif
 
-    /* 'Level' title */
-    const char *lvlName = "?";
-    switch (level) {
-        case SYSLOG_CRITICAL: lvlName = "CRITICAL";  break; // Critical errors
-        case SYSLOG_ERROR:    lvlName = "ERROR";     break; // General errors
-        case SYSLOG_WARNING:  lvlName = "WARN";      break; // Warnings
-        case SYSLOG_INFO:     lvlName = "info";      break; // Informational
-        case SYSLOG_DEBUG:    lvlName = "dbug";      break; // Debug
-    }
-
-    /* format the message */
-    char msg[MAX_MESSAGE_LENGTH + 2];
-    int msgLen = 0;
-    if (fn && *fn) {
-        // pre-pend function information
-        msgLen = sprintf(msg, "%d%s.%s[%s] ", level % 10, syslogName, lvlName, fn);
-    }
-    // append message
+    /* format the message text */
     // (Note: Windows return value for 'VSNPRINTF' is different than Linux)
-    int bufSize = MAX_MESSAGE_LENGTH - msgLen;
-    int vsnLen = VSNPRINTF(&msg[msgLen], bufSize, fmt, ap);
-    if ((vsnLen < 0) || (vsnLen >= bufSize)) {
+    LogEntry_t e;
+    int vsnLen = VSNPRINTF(e.text, MAX_MESSAGE_LENGTH, fmt, ap);
+    if ((vsnLen < 0) || (vsnLen >= MAX_MESSAGE_LENGTH)) {
         // Windows returns '-1' if the written length exceeds 'bufSize'
         // Linux returns the number of bytes that _would_ have been written
-        msgLen = MAX_MESSAGE_LENGTH;
-    } else {
-        // 'vsnLen' bytes written
-        msgLen += vsnLen;
+        vsnLen = MAX_MESSAGE_LENGTH - 1;
     }
-    // trailing '\n'
-    if (msg[msgLen - 1] != '\n') {
-        strcpy(&msg[msgLen++], "\n");
-    } else {
-        msg[msgLen] = 0;
+    if ((vsnLen > 0) && (e.text[vsnLen - 1] == '\n')) {
+        vsnLen--; // a trailing '\n' is added when printed
     }
+    e.rec.fn     = fn;
+    e.rec.line   = (line > 0)? (UInt16)line : 0;
+    e.rec.level  = (UInt8)level;
+    e.rec.rsvd   = 0;
+    e.rec.msgLen = (UInt16)vsnLen;
 
-    /* output message */
-    LOG_LOCK {
+    /* queue message */
 #if defined(SYSLOG_THREAD)
-        if (syslogRunThread) {
-            if (!bufferPutData(syslogBuffer,msg,msgLen+1)) { // <-- incl terminator
-                // this log message will be discarded
-                if (isDebugMode()) { fprintf(CONSOLE_OUTPUT, "Log overflow! [%s]\n", msg); } // ignore returned error code
+    if (syslogRunThread) {
+        int recLen = sizeof(LogRecord_t) + vsnLen;
+        int putLen = 0;
+#if defined(LOG_THREAD_RINGS)
+        CircleBuffer_t *ring = _logGetThreadRing();
+        if (ring) {
+            // this thread is the only producer on this ring, no lock required
+            e.rec.seq = LOG_NEXT_SEQ();
+            putLen = bufferPutData(ring, &e, recLen);
+            LOG_BARRIER(); // publish record before checking 'syslogThreadWaiting'
+            if (syslogThreadWaiting) {
+                LOG_LOCK { LOG_NOTIFY; } LOG_UNLOCK
             }
-            LOG_NOTIFY;
-        } else 
+        } else
 #endif
         {
-            _logMessagePrint(msg, msgLen);
-            if ((syslogMsgCount % FLUSH_MODULO) == 0) {
-                _logMessageFlush();
-            }
+            LOG_LOCK {
+                e.rec.seq = LOG_NEXT_SEQ();
+                putLen = bufferPutData(syslogBuffer, &e, recLen);
+                LOG_NOTIFY;
+            } LOG_UNLOCK
+        }
+        if (putLen <= 0) {
+            // this log message will be discarded (counted, and reported by the logging thread)
+            syslogDropCount++;
+        }
+        return;
+    }
+#endif
+
+    /* output message */
+    LOG_LOCK {
+        _logMessagePrint(&e.rec, e.text);
+        if ((syslogMsgCount % FLUSH_MODULO) == 0) {
+            _logMessageFlush();
         }
         syslogMsgCount++;
     } LOG_UNLOCK
@@ -507,40 +630,115 @@ void logCritical_(const char *ftn, int line, const char *fmt, ...)
 
 #if defined(SYSLOG_THREAD)
 
+/* next record from each ring (consumer side, used by the logging thread only) */
+static LogEntry_t           syslogPending[LOG_MAX_THREAD_RINGS + 1];
+static utBool               syslogHasPending[LOG_MAX_THREAD_RINGS + 1];
+
+/* load the next record from the specified ring, return false if the ring is empty */
+static utBool _logLoadRecord(int r, CircleBuffer_t *cb)
+{
+    utBool ok = utFalse;
+    if (!syslogHasPending[r] && cb) {
+        // records are published whole, so a non-empty ring contains a complete record
+#if !defined(BUFFER_SPSC)
+        LOG_LOCK {
+#endif
+        if (bufferGetLength(cb) >= (long)sizeof(LogRecord_t)) {
+            LogEntry_t *e = &syslogPending[r];
+            bufferGetData(cb, &(e->rec), sizeof(LogRecord_t));
+            if (e->rec.msgLen > MAX_MESSAGE_LENGTH) { e->rec.msgLen = MAX_MESSAGE_LENGTH; } // (internal error)
+            bufferGetData(cb, e->text, e->rec.msgLen);
+            syslogHasPending[r] = utTrue;
+            ok = utTrue;
+        }
+#if !defined(BUFFER_SPSC)
+        } LOG_UNLOCK
+#endif
+    }
+    return ok || syslogHasPending[r];
+}
+
+/* print all queued records (in sequence order), return number of records printed */
+static int _logDrainRecords()
+{
+    int count = 0;
+    for (;;) {
+        int r, next = -1;
+        _logLoadRecord(0, syslogBuffer);
+#if defined(LOG_THREAD_RINGS)
+        int ringCount = syslogRingCount;
+        LOG_BARRIER();
+        for (r = 0; r < ringCount; r++) {
+            _logLoadRecord(r + 1, syslogRing[r]);
+        }
+#endif
+        for (r = 0; r <= LOG_MAX_THREAD_RINGS; r++) {
+            if (syslogHasPending[r]) {
+                if ((next < 0) || ((Int32)(syslogPending[r].rec.seq - syslogPending[next].rec.seq) < 0L)) {
+                    next = r;
+                }
+            }
+        }
+        if (next < 0) {
+            break; // all rings are empty
+        }
+        _logMessagePrint(&(syslogPending[next].rec), syslogPending[next].text);
+        syslogHasPending[next] = utFalse;
+        count++;
+    }
+    if (syslogDropCount > 0L) {
+        UInt32 dropCount = syslogDropCount;
+        syslogDropCount = 0L;
+        LogEntry_t e;
+        memset(&e, 0, sizeof(e));
+        e.rec.level  = SYSLOG_WARNING;
+        e.rec.msgLen = sprintf(e.text, "Log overflow! %lu message(s) discarded", dropCount);
+        _logMessagePrint(&(e.rec), e.text);
+    }
+    return count;
+}
+
+/* return true if any ring contains a record */
+static utBool _logHaveRecords()
+{
+    if (bufferGetLength(syslogBuffer) > 0L) {
+        return utTrue;
+    }
+#if defined(LOG_THREAD_RINGS)
+    int r;
+    for (r = 0; r < syslogRingCount; r++) {
+        if (bufferGetLength(syslogRing[r]) > 0L) {
+            return utTrue;
+        }
+    }
+#endif
+    return utFalse;
+}
+
 /* thread main */
 static void _syslogThreadRunnable(void *arg)
 {
-    char data[MAX_MESSAGE_LENGTH + 2];
-    int maxDataLen = sizeof(data);
     while (syslogRunThread) {
         
-        /* wait for data */
-        int len = 0;
-        while (syslogRunThread && (len <= 0)) {
-            LOG_LOCK {
-                // get a single string
-                len = bufferGetString(syslogBuffer, data, maxDataLen);
-            } LOG_UNLOCK
-            if (len <= 0L) {
-                // queue is empty, flush output now (outside of the lock!)
-                _logMessageFlush();
-                // wait until we have something in the queue
-                LOG_LOCK {
-                    if (bufferGetLength(syslogBuffer) <= 0L) {
-                        // still nothing in the queue
-                        // wait a few seconds, or until we get notified
-                        LOG_WAIT(5000L);
-                    }
-                } LOG_UNLOCK
-            }
-        }
-        if (!syslogRunThread) {
-            break;
+        /* print queued records */
+        if (_logDrainRecords() > 0) {
+            continue;
         }
 
-        /* print string */
-        //fprintf(CONSOLE_OUTPUT, "{Thread} ");  // ignore returned error code
-        _logMessagePrint(data, len);
+        /* queue is empty, flush output now (outside of the lock!) */
+        _logMessageFlush();
+
+        /* wait until we have something in the queue */
+        LOG_LOCK {
+            syslogThreadWaiting = utTrue;
+            LOG_BARRIER(); // publish 'syslogThreadWaiting' before checking the rings
+            if (syslogRunThread && !_logHaveRecords()) {
+                // still nothing in the queue
+                // wait a few seconds, or until we get notified
+                LOG_WAIT(5000L);
+            }
+            syslogThreadWaiting = utFalse;
+        } LOG_UNLOCK
 
     }
     // once this thread stops, it isn't starting again
@@ -69,6 +69,7 @@
 #include "tools/threads.h"
 #include "tools/io.h"
 #include "tools/comport.h"
+#include "tools/sockets.h"
 
 #include "base/cerrors.h"
 #include "base/propman.h"
@@ -78,7 +79,7 @@
 #include "base/accting.h"
 #include "base/events.h"
 #include "base/protocol.h"
-#if defined(ENBALE_UPLOAD)
+#if defined(ENABLE_UPLOAD)
 #  include "base/upload.h"
 #endif
 
@@ -247,6 +248,14 @@ static void _propertyPreGET(PropertyRefresh_t mode, Key_t key, UInt8 *args, int
                     propSetUInt32AtIndex(PROP_STATE_GPS_DIAGNOSTIC, i, gpsStats[i]);
                 }
             } break;
+            case PROP_STATE_DNS_DIAGNOSTIC: {
+                // return resolved host cache statistics
+                int i;
+                UInt32 *dnsStats = (UInt32*)socketGetResolveStats((SocketResolveStats_t*)0);
+                for (i = 0; i < (sizeof(SocketResolveStats_t)/sizeof(UInt32)); i++) {
+                    propSetUInt32AtIndex(PROP_STATE_DNS_DIAGNOSTIC, i, dnsStats[i]);
+                }
+            } break;
             case PROP_STATE_QUEUED_EVENTS: {
                 // update property with number of events
                 Int32 evQueCnt = 0L, evTotCnt = 0L;
@@ -412,6 +421,9 @@ static CommandError_t _cmdSaveProperties(int protoNdx, Key_t key, const UInt8 *d
 // ----------------------------------------------------------------------------
 
 /* initialize properties */
+#if defined(GPS_DEVICE_REPLAY)
+static char gpsPortBuffer[256];
+#endif
 void startupPropInitialize(utBool loadPropCache)
 {
 
@@ -421,6 +433,11 @@ void startupPropInitialize(utBool loadPropCache)
     /* firmware */
     propInitFromString(PROP_STATE_FIRMWARE, DMTP_NAME_TYPE_VERSION);
 
+#if defined(GPS_DEVICE_REPLAY)
+    /* GPS port may be a "replay:<file>" path (longer than the default property capacity) */
+    propSetAltBuffer(PROP_CFG_GPS_PORT, gpsPortBuffer, sizeof(gpsPortBuffer));
+#endif
+
 #if defined(TRANSPORT_MEDIA_SERIAL)
     /* AccountID/DeviceID may be writable via BlueTooth transport (for OTA configuration) */
     propSetReadOnly(PROP_STATE_ACCOUNT_ID, utFalse);
@@ -660,9 +677,9 @@ void startupMainLoopCallback()
 #endif
 
     /* Expired upload */
-#if defined(ENBALE_UPLOAD)
+#if defined(ENABLE_UPLOAD)
     if (uploadIsExpired()) {
-        // upload did not complete in allowed time
+        // no upload record received in allowed time
         uploadCancel();
     }
 #endif
@@ -724,6 +741,9 @@ static void _usage(const char *pgm)
 #endif
     fprintf(out, "    [-comlog]                  - Enable commPort data logging\n");
     fprintf(out, "    [-gps <port> [<model>]]    - GPS serial port\n");
+#if defined(GPS_DEVICE_REPLAY)
+    fprintf(out, "    [-replay <file> [<rate>]]  - Replay recorded NMEA file (1 to 1000 times speed)\n");
+#endif
 #if defined(TRANSPORT_MEDIA_SOCKET) || defined(TRANSPORT_MEDIA_GPRS)
     fprintf(out, "    [-server <host> [<port>]]  - Server protocol host and port\n");
 #endif
@@ -944,6 +964,26 @@ int startupDMTP(int argc, char *argv[], int runInThread)
                 return 3;
             }
         } else 
+#if defined(GPS_DEVICE_REPLAY)
+        if (strEqualsIgnoreCase(argv[argp], "-replay")) {
+            // -replay <file> [<rate>]
+            argp++;
+            if ((argp < argc) && (*argv[argp] != '-')) {
+                char replayPort[256];
+                sprintf(replayPort, "replay:%.*s", (int)(sizeof(replayPort) - 8), argv[argp]);
+                propSetString(PROP_CFG_GPS_PORT, replayPort);
+                // parse 'rate', if specified
+                if (((argp + 1) < argc) && isdigit(*argv[argp + 1])) {
+                    argp++;
+                    propInitFromString(PROP_CFG_GPS_REPLAY_RATE, argv[argp]);
+                }
+            } else {
+                logCRITICAL(LOGSRC,"Missing GPS replay file ...\n");
+                _usage(pgmName);
+                return 3;
+            }
+        } else 
+#endif
 #if defined(TRANSPORT_MEDIA_SOCKET) || defined(TRANSPORT_MEDIA_GPRS)
         if (strEqualsIgnoreCase(argv[argp], "-server")) {
             // -server <host> [<port>]
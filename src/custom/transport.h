@@ -64,6 +64,10 @@ typedef struct {
     int                 (*xportReadPacket)(UInt8 *buf, int bufLen);
     void                (*xportReadFlush)(void);
     int                 (*xportWritePacket)(const UInt8 *buf, int bufLen);
+    // optional: returns a transport owned buffer into which the next packet may be
+    // encoded, and its size (a subsequent 'xportWritePacket' of this buffer does
+    // not copy the data).  May be null, or return null, if not supported.
+    UInt8 *             (*xportWriteBuffer)(int *bufSize);
 } TransportFtns_t;
 
 // ----------------------------------------------------------------------------
@@ -279,8 +279,15 @@ static int _serdevReadData()
         }
 
         /* place char in buffer */
+#if defined(BUFFER_SPSC)
+        // this thread is the only producer, the lock is only needed for the notify
+        utBool added = bufferPutString(serBuffer, buf);
         BUFFER_LOCK {
-            if (!bufferPutString(serBuffer, buf)) {
+#else
+        BUFFER_LOCK {
+            utBool added = bufferPutString(serBuffer, buf);
+#endif
+            if (!added) {
                 // This means that we will be losing packets
                 // The buffer is large enough that we should never get backed up.
                 // This would only occur if the main thread somehow stopped pulling
@@ -368,9 +375,13 @@ static int serdevReadLine(char *data, int dataLen, UInt32 timeoutMS)
     for (;;) {
 
         /* get string */
+#if defined(BUFFER_SPSC)
+        len = bufferGetString(serBuffer, data, dataLen); // single consumer
+#else
         BUFFER_LOCK {
             len = bufferGetString(serBuffer, data, dataLen);
         } BUFFER_UNLOCK
+#endif
 
         /* error? (unlikely) */
         if (len < 0) {
@@ -384,7 +395,9 @@ static int serdevReadLine(char *data, int dataLen, UInt32 timeoutMS)
                 // wait for data
                 //threadSleepMS(100L);
                 BUFFER_LOCK {
-                    BUFFER_WAIT(1000L);
+                    if (bufferGetLength(serBuffer) <= 0L) {
+                        BUFFER_WAIT(1000L);
+                    }
                 } BUFFER_UNLOCK
                 continue;
             } else {
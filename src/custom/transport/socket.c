@@ -74,6 +74,9 @@ typedef struct {
     TransportType_t             type;
     utBool                      isOpen;
     Socket_t                    sock;
+    utBool                      isHeld;             // idle persistent Duplex connection
+    TimerSec_t                  heldTimer;          // time the connection became idle
+    utBool                      hadError;           // read/write error during this session
 #if defined(TARGET_WINCE)
     HRASCONN                    rasConn;
     utBool                      rasDisconnect;
@@ -94,6 +97,9 @@ static TransportFtns_t          sockXportFtns = { MEDIA_SOCKET, "XportSocket" };
 static UInt8                    sockDatagramData[2000];
 static Buffer_t                 sockDatagramBuffer;
 
+// Duplex packets are encoded directly into this buffer before being written.
+static UInt8                    sockWriteData[PACKET_MAX_ENCODED_LENGTH];
+
 // ----------------------------------------------------------------------------
 
 static const char *socket_transportTypeName(TransportType_t type)
@@ -121,6 +127,22 @@ static utBool socket_transportIsOpen()
     return sockXport.isOpen;
 }
 
+/* return the persistent Duplex connection idle timeout (0 if not persistent) */
+static UInt32 _transportPersistentIdleSec()
+{
+    return propGetUInt32AtIndex(PROP_COMM_PERSISTENT, 0, 0L);
+}
+
+/* close an idle persistent Duplex connection */
+static void _transportReleaseHeld()
+{
+    if (sockXport.isHeld) {
+        logDEBUG(LOGSRC,"Closing idle Duplex connection ...");
+        socketCloseClient(&(sockXport.sock));
+        sockXport.isHeld = utFalse;
+    }
+}
+
 /* close transport */
 static utBool socket_transportClose(utBool sendUDP)
 {
@@ -136,10 +158,23 @@ static utBool socket_transportClose(utBool sendUDP)
             int dataLen = BUFFER_DATA_LENGTH(bf);
             int err = socketWriteUDP(&(sockXport.sock), data, dataLen);
             rtn = (err < 0)? utFalse : utTrue;
+        } else
+        if (sockXport.type == TRANSPORT_DUPLEX) {
+            // send any queued packets
+            int err = socketFlushTCP(&(sockXport.sock));
+            rtn = (err < 0)? utFalse : utTrue;
         }
         
         /* close socket */
-        socketCloseClient(&(sockXport.sock));
+        if (rtn && !sockXport.hadError && (sockXport.type == TRANSPORT_DUPLEX) && 
+            (_transportPersistentIdleSec() > 0L)) {
+            // keep the connection open for the next Duplex session
+            logDEBUG(LOGSRC,"Holding Duplex connection for reuse ...");
+            sockXport.isHeld = utTrue;
+            sockXport.heldTimer = utcGetTimer();
+        } else {
+            socketCloseClient(&(sockXport.sock));
+        }
         
         /* transport is closed */
         sockXport.type   = TRANSPORT_NONE;
@@ -180,6 +215,34 @@ static utBool socket_transportOpen(TransportType_t type)
         return utFalse;
     }
     //logINFO(LOGSRC,"transportOpen: host=%s port=%d", host, port);
+
+    /* reuse idle persistent Duplex connection */
+    if (sockXport.isHeld) {
+        UInt32 idleSec = _transportPersistentIdleSec();
+        if ((type != TRANSPORT_DUPLEX) || (idleSec == 0L)) {
+            // not reusable for this session
+            _transportReleaseHeld();
+        } else
+        if (utcIsTimerExpired(sockXport.heldTimer,idleSec)) {
+            logDEBUG(LOGSRC,"Duplex connection idle timeout");
+            _transportReleaseHeld();
+        } else
+        if ((sockXport.sock.port != port) || !strEquals(sockXport.sock.host, host)) {
+            // host/port changed
+            _transportReleaseHeld();
+        } else
+        if (!socketIsConnectedTCP(&(sockXport.sock))) {
+            logDEBUG(LOGSRC,"Duplex connection closed by server");
+            _transportReleaseHeld();
+        } else {
+            sockXport.isHeld   = utFalse;
+            sockXport.hadError = utFalse;
+            sockXport.type     = type;
+            sockXport.isOpen   = utTrue;
+            logDEBUG(LOGSRC,"Reusing %s Transport ...\n", socket_transportTypeName(type));
+            return sockXport.isOpen;
+        }
+    }
     
 #if defined(TARGET_WINCE)
 
@@ -202,6 +265,11 @@ static utBool socket_transportOpen(TransportType_t type)
     
 #endif
 
+    /* resolved host cache timeouts */
+    socketSetResolveTTL(
+        propGetUInt32AtIndex(PROP_COMM_DNS_TTL, 0, SOCKET_DNS_DEFAULT_TTL),
+        propGetUInt32AtIndex(PROP_COMM_DNS_TTL, 1, SOCKET_DNS_DEFAULT_NEG_TTL));
+
     /* open */
     int err = 0;
     switch (type) {
@@ -233,6 +301,11 @@ static utBool socket_transportOpen(TransportType_t type)
     }
     sockXport.type = type;
     sockXport.isOpen = utTrue;
+    sockXport.hadError = utFalse;
+    if ((type == TRANSPORT_DUPLEX) && (_transportPersistentIdleSec() > 0L)) {
+        // detect a broken connection while idle between sessions
+        socketEnableKeepAlive(&(sockXport.sock), (int)propGetUInt32AtIndex(PROP_COMM_PERSISTENT, 1, 0L));
+    }
     // fall through to 'true' return below
 
     /* reset buffers and return success */
@@ -277,7 +350,7 @@ static int _transportRead(UInt8 *buf, int bufLen)
 }
 
 /* read packet from transport */
-static int socket_transportReadPacket(UInt8 *buf, int bufLen)
+static int _transportReadPacket(UInt8 *buf, int bufLen)
 {
     UInt8 *b = buf;
     int readLen, len;
@@ -360,8 +433,37 @@ static int socket_transportReadPacket(UInt8 *buf, int bufLen)
     
 }
 
+static int socket_transportReadPacket(UInt8 *buf, int bufLen)
+{
+    int readLen = _transportReadPacket(buf, bufLen);
+    if (readLen <= 0) {
+        // timeout, or error (the connection may hold a partial packet)
+        sockXport.hadError = utTrue;
+    }
+    return readLen;
+}
+
 // ----------------------------------------------------------------------------
 
+/* return buffer into which the next packet may be encoded */
+static UInt8 *socket_transportWriteBuffer(int *bufSize)
+{
+    if (!sockXport.isOpen) {
+        return (UInt8*)0;
+    }
+    switch (sockXport.type) {
+        case TRANSPORT_SIMPLEX:
+            // encode directly into the queued datagram
+            *bufSize = BUFFER_DATA_SIZE(&sockDatagramBuffer);
+            return BUFFER_DATA(&sockDatagramBuffer);
+        case TRANSPORT_DUPLEX:
+            *bufSize = sizeof(sockWriteData);
+            return sockWriteData;
+        default:
+            return (UInt8*)0;
+    }
+}
+
 /* write packet to transport */
 static int socket_transportWritePacket(const UInt8 *buf, int bufLen)
 {
@@ -389,12 +491,22 @@ static int socket_transportWritePacket(const UInt8 *buf, int bufLen)
     switch (sockXport.type) {
         case TRANSPORT_SIMPLEX:
             // queue data until the close
+            if (buf == BUFFER_DATA(&sockDatagramBuffer)) {
+                // already encoded in place (see 'socket_transportWriteBuffer')
+                if (bufLen > BUFFER_DATA_SIZE(&sockDatagramBuffer)) {
+                    return -1;
+                }
+                binAdvanceBuffer(&sockDatagramBuffer, bufLen);
+                return bufLen;
+            }
             len = binBufPrintf(&sockDatagramBuffer, "%*b", bufLen, buf);
             return len;
         case TRANSPORT_DUPLEX:
-            len = socketWriteTCP(&(sockXport.sock), buf, bufLen);
+            // queued packets are sent before the next read (or on close)
+            len = socketQueueTCP(&(sockXport.sock), buf, bufLen);
             if (len < 0) {
                 logERROR(LOGSRC,"Socket write error: %d", len);
+                sockXport.hadError = utTrue;
                 return -1;
             }
             return len;
@@ -436,6 +548,7 @@ const TransportFtns_t *socket_transportInitialize()
     sockXportFtns.xportReadFlush    = &socket_transportReadFlush;
     sockXportFtns.xportReadPacket   = &socket_transportReadPacket;
     sockXportFtns.xportWritePacket  = &socket_transportWritePacket;
+    sockXportFtns.xportWriteBuffer  = &socket_transportWriteBuffer;
     return &sockXportFtns;
     
 }
@@ -45,39 +45,92 @@
 
 #define DEFAULT_OUTPUT_WIDTH      100
 
+// bytes read/encoded at a time (must be a multiple of 3, so that only the last
+// block is padded)
+#define ENCODE_BLOCK_SIZE         (3 * 4096)
+#define ENCODE_B64_SIZE           ((ENCODE_BLOCK_SIZE / 3) * 4)
+
 // ----------------------------------------------------------------------------
 
 utBool encodeDownloadEncode(const char *fromFile, const char *clientFile, int fileWidth)
 {
     
-    /* read data */
-    UInt8 data[200000];
-    long dataLen = ioReadFile(fromFile, data, sizeof(data));
-    if (dataLen <= 0L) {
-        // read error
+    /* open file */
+    FILE *file = ioOpenStream(fromFile, IO_OPEN_READ);
+    if (!file) {
+        // open error
         fprintf(stderr, "Unable to read file: %s\n", fromFile);
         return utFalse;
     }
     
-    /* Base64 encode */
-    char b64[300000];
-    long b64Len = base64Encode(b64, sizeof(b64), data, dataLen);
-    if (b64Len <= 0L) {
-        // encode error
-        fprintf(stderr, "Unable to encode: %s", fromFile);
-        return utFalse;
+    /* encode/write data a block at a time */
+    // output lines are 'fileWidth' characters, regardless of the block boundaries
+    UInt8 data[ENCODE_BLOCK_SIZE];
+    char b64[ENCODE_B64_SIZE + 1];
+    char line[ENCODE_B64_SIZE * 2]; // encoded block, plus line terminators
+    long totalLen = 0L, col = 0L;
+    for (;;) {
+        
+        /* read block */
+        long dataLen = ioReadStream(file, data, sizeof(data));
+        if (ferror(file)) {
+            // read error
+            fprintf(stderr, "Unable to read file: %s\n", fromFile);
+            ioCloseStream(file);
+            return utFalse;
+        } else
+        if (dataLen <= 0L) {
+            // EOF
+            break;
+        }
+        
+        /* Base64 encode */
+        long b64Len = base64Encode(b64, sizeof(b64), data, dataLen);
+        if (b64Len <= 0L) {
+            // encode error
+            fprintf(stderr, "Unable to encode: %s", fromFile);
+            ioCloseStream(file);
+            return utFalse;
+        }
+        
+        /* write filename (once the file is known to have data) */
+        if (totalLen == 0L) {
+            printf("%s\n", clientFile);
+        }
+        totalLen += dataLen;
+        
+        /* write data */
+        long b = 0L, n = 0L;
+        for (;(b64Len - b) > 0L;) {
+            long len = (long)fileWidth - col;
+            if (len > (b64Len - b)) { len = b64Len - b; }
+            if ((n + len + 1L) > (long)sizeof(line)) {
+                fwrite(line, 1, n, stdout);
+                n = 0L;
+            }
+            memcpy(&line[n], &b64[b], len);
+            n += len;
+            b += len;
+            col += len;
+            if (col >= (long)fileWidth) {
+                line[n++] = '\n';
+                col = 0L;
+            }
+        }
+        fwrite(line, 1, n, stdout);
+        
     }
+    ioCloseStream(file);
     
-    /* write filename */
-    printf("%s\n", clientFile);
+    /* empty file? */
+    if (totalLen <= 0L) {
+        fprintf(stderr, "Unable to read file: %s\n", fromFile);
+        return utFalse;
+    }
     
-    /* write data */
-    long b = 0L;
-    for (;(b64Len - b) > 0L;) {
-        long len = (long)fileWidth;
-        if (len > (b64Len - b)) { len = b64Len - b; }
-        printf("%.*s\n", (int)len, &b64[b]);
-        b += len;
+    /* terminate last line */
+    if (col > 0L) {
+        printf("\n");
     }
     return utTrue;
 
@@ -41,6 +41,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 
 #include "custom/startup.h"
 #include "custom/log.h"
@@ -141,9 +142,12 @@ const char *geozGetVersion()
 
 // ----------------------------------------------------------------------------
 
+static GeoZone_t *_geozFindZone(const GPSPoint_t *newGP, const GPSFixContext_t *ctx);
+
 /* check new GPS fix for various motion events */
-void geozCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
+void geozCheckGPS(const GPSFixContext_t *ctx)
 {
+    const GPS_t *newFix = ctx->newFix;
     
     /* new fix required */
     if (!newFix) {
@@ -153,7 +157,7 @@ void geozCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
 
     /* in GeoZone? */
     //logDEBUG(LOGSRC,"Zone checking in progress ...");
-    GeoZone_t *inZone = geozInZone(&(newFix->point));
+    GeoZone_t *inZone = _geozFindZone(&(newFix->point), ctx);
     //if (isDebugMode() && inZone) { logDEBUG(LOGSRC,"!!!!!! In Zone %d", inZone->zoneID); }
     
     /* get zones */
@@ -254,6 +258,9 @@ void geozSetCurrentID(GeoZoneID_t zoneID)
     propSetUInt32(PROP_GEOF_CURRENT, (UInt32)zoneID);
 }
 
+/* true if 'P' is more than 'M' meters north/south of 'Z' (cheap reject before the distance calc) */
+#define OUTSIDE_LATITUDE(P,Z,M)     ((fabs((P)->latitude - (Z)->latitude) * (EARTH_RADIUS_METERS * RADIANS)) > (M))
+
 /* convert GeoZone point to GPS point */
 static GPSPoint_t *_geozToGPSPoint(GPSPoint_t *gp, const GeoZonePoint_t *gzp)
 {
@@ -267,7 +274,8 @@ static GPSPoint_t *_geozToGPSPoint(GPSPoint_t *gp, const GeoZonePoint_t *gzp)
 }
 
 /* check new GPS fix for various motion events */
-static utBool _geozInZone(GeoZone_t *geoz, const GPSPoint_t *newGP)
+// If 'ctx' is non-null, 'newGP' must be the context fix point (its radian terms are reused)
+static utBool _geozInZone(GeoZone_t *geoz, const GPSPoint_t *newGP, const GPSFixContext_t *ctx)
 {
     utBool inZone = utFalse;
     if (geoz && newGP && IS_VALID_ZONE(geoz->zoneID)) {
@@ -285,8 +293,8 @@ static utBool _geozInZone(GeoZone_t *geoz, const GPSPoint_t *newGP)
                 
             case GEOF_DUAL_POINT_RADIUS:
                 _geozToGPSPoint(&geozGP_0, &(geoz->point[0]));
-                if (gpsPointIsValid(&geozGP_0)) {
-                    deltaMeters = gpsMetersToPoint(newGP, &geozGP_0);
+                if (gpsPointIsValid(&geozGP_0) && !OUTSIDE_LATITUDE(newGP,&geozGP_0,radiusMeters)) {
+                    deltaMeters = ctx? gpsFixContextMetersToPoint(ctx, &geozGP_0) : gpsMetersToPoint(newGP, &geozGP_0);
                     //logDEBUG(LOGSRC,"  Zone %d A (%.5lf / %.5lf) [%.1lf <= %.1lf]", geoz->zoneID, geozGP_0.latitude, geozGP_0.longitude, deltaMeters, radiusMeters);
                     if (deltaMeters <= radiusMeters) {
                         inZone = utTrue;
@@ -294,8 +302,8 @@ static utBool _geozInZone(GeoZone_t *geoz, const GPSPoint_t *newGP)
                     }
                 }
                 _geozToGPSPoint(&geozGP_1, &(geoz->point[1]));
-                if (gpsPointIsValid(&geozGP_1)) {
-                    deltaMeters = gpsMetersToPoint(newGP, &geozGP_1);
+                if (gpsPointIsValid(&geozGP_1) && !OUTSIDE_LATITUDE(newGP,&geozGP_1,radiusMeters)) {
+                    deltaMeters = ctx? gpsFixContextMetersToPoint(ctx, &geozGP_1) : gpsMetersToPoint(newGP, &geozGP_1);
                     //logDEBUG(LOGSRC,"  Zone %d B (%.5lf / %.5lf) [%.1lf <= %.1lf]", geoz->zoneID, geozGP_1.latitude, geozGP_1.longitude, deltaMeters, radiusMeters);
                     if (deltaMeters <= radiusMeters) {
                         inZone = utTrue;
@@ -356,15 +364,15 @@ static utBool _geozInZone(GeoZone_t *geoz, const GPSPoint_t *newGP)
     return inZone;
 }
 
-/* return the zone where the specified point is located */
-GeoZone_t *geozInZone(const GPSPoint_t *newGP)
+/* return the zone where the specified point (or context fix) is located */
+static GeoZone_t *_geozFindZone(const GPSPoint_t *newGP, const GPSFixContext_t *ctx)
 {
     /* is newGP inside GeoZone? */
     GeoZone_t *gz = (GeoZone_t*)0;
     UInt16 i;
     GEOZ_LOCK {
         for (i = 0; i < usedZones; i++) {
-            if (_geozInZone(&geoZoneList[i], newGP)) {
+            if (_geozInZone(&geoZoneList[i], newGP, ctx)) {
                 gz = &geoZoneList[i];
                 break;
             }
@@ -373,6 +381,12 @@ GeoZone_t *geozInZone(const GPSPoint_t *newGP)
     return gz;
 }
 
+/* return the zone where the specified point is located */
+GeoZone_t *geozInZone(const GPSPoint_t *newGP)
+{
+    return _geozFindZone(newGP, (GPSFixContext_t*)0);
+}
+
 // ----------------------------------------------------------------------------
 
 static void _geozClearAll()
@@ -85,7 +85,7 @@ typedef struct
 
 void geozInitialize(eventAddFtn_t queueEvent);
 
-void geozCheckGPS(const GPS_t *oldFix, const GPS_t *newFix);
+void geozCheckGPS(const GPSFixContext_t *ctx);
 
 void geozSetVersion(const char *v);
 const char *geozGetVersion();
@@ -218,8 +218,9 @@ static void _motionStop(UInt32 nowTime, const GPS_t *newFix)
 }
 
 /* check new GPS fix for various motion events */
-static void _motionCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
+static void _motionCheckGPS(const GPSFixContext_t *ctx)
 {
+    const GPS_t *newFix = ctx->newFix;
     
     /* 'start' definition */
     // defStartType:
@@ -238,7 +239,7 @@ static void _motionCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
     /* check motion start/stop */
     //   - send start/stop/in-motion event
     // PROP_GPS_MIN_SPEED should already be accounted for
-    UInt32 nowTime = utcGetTimeSec();
+    UInt32 nowTime = ctx->nowTime;
     utBool isCurrentlyMoving = utFalse;
     if (defMotionStart > 0.0) { // kph/meters
         
@@ -251,8 +252,8 @@ static void _motionCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
         /* check for currently moving */
         if (defStartType == MOTION_START_GPS_METERS) { // GPS distance
             // check GPS distance (meters)
-            if (gpsIsValid(newFix) && gpsIsValid(&lastMotionFix)) { // validate
-                double deltaMeters = gpsMetersToPoint(&(newFix->point), &(lastMotionFix.point));
+            if (ctx->isValid && gpsIsValid(&lastMotionFix)) { // validate
+                double deltaMeters = gpsFixContextMetersToPoint(ctx, &(lastMotionFix.point));
                 if (deltaMeters >= defMotionStart) {
                     isCurrentlyMoving = utTrue;
                 }
@@ -439,10 +440,10 @@ static void _motionCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
 }
 
 /* check new GPS fix for various motion events */
-void motionCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
+void motionCheckGPS(const GPSFixContext_t *ctx)
 {
     MOTION_LOCK {
-        _motionCheckGPS(oldFix, newFix);
+        _motionCheckGPS(ctx);
     } MOTION_UNLOCK
 }
 
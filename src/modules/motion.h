@@ -40,7 +40,7 @@ extern "C" {
 void motionInitialize(eventAddFtn_t queueEvent);
 void motionResetMovingMessageTimer();
 
-void motionCheckGPS(const GPS_t *oldFix, const GPS_t *newFix);
+void motionCheckGPS(const GPSFixContext_t *ctx);
 
 // ----------------------------------------------------------------------------
 
@@ -178,9 +178,13 @@ static void _queueOdometerEvent(PacketPriority_t priority, StatusCode_t code, co
 // ----------------------------------------------------------------------------
 
 /* periodic check new GPS fix */
-void odomCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
+void odomCheckGPS(const GPSFixContext_t *ctx)
 {
-    // 'newFix' may be NULL
+    // 'ctx->newFix' may be NULL
+    const GPS_t *newFix = ctx->newFix;
+    GPSPoint_t lastPoint;           // last odometer point measured
+    UInt32 lastDeltaMeters = 0L;    // distance to 'lastPoint'
+    gpsPointClear(&lastPoint);
 
     /* get actual odometer, if available */
     UInt32 actualOdomMeters = ROUND(odomGetActualOdometerMeters());
@@ -216,7 +220,15 @@ void odomCheckGPS(const GPS_t *oldFix, const GPS_t *newFix)
         } else
         if (newFix) {
             // GPS based odometer
-            UInt32 deltaMeters = ROUND(gpsMetersToPoint(&(newFix->point), &(gps->point)));
+            // odometers updated at the same fix share the same point
+            UInt32 deltaMeters;
+            if ((gps->point.latitude == lastPoint.latitude) && (gps->point.longitude == lastPoint.longitude)) {
+                deltaMeters = lastDeltaMeters;
+            } else {
+                deltaMeters = ROUND(gpsFixContextMetersToPoint(ctx, &(gps->point)));
+                gpsPointCopy(&lastPoint, &(gps->point));
+                lastDeltaMeters = deltaMeters;
+            }
             if (deltaMeters >= minDeltaMeters) {
                 // I've moved at least the minimum required distance to set a new steak in the ground
                 newOdomMeters = ODOM_IsFirst(i)? deltaMeters : (deltaMeters + oldOdomMeters);
@@ -29,7 +29,7 @@ extern "C" {
 // ----------------------------------------------------------------------------
 
 void odomInitialize(eventAddFtn_t queueEvent);
-void odomCheckGPS(const GPS_t *oldFix, const GPS_t *newFix);
+void odomCheckGPS(const GPSFixContext_t *ctx);
 
 double odomGetActualOdometerMeters();
 double odomGetDeviceDistanceMeters();
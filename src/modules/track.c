@@ -0,0 +1,291 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  In-motion track simplification.
+//  Sits between the GPS rule modules and the event queue.  In-motion events are
+//  held back and only the points needed to keep the reported track within a
+//  maximum cross-track error are queued (a streaming, "opening window" form of
+//  the Douglas-Peucker line simplification).  All other events pass through
+//  unchanged, after any held in-motion point has been queued.
+// ---
+// Notes:
+//  - The last queued point is the 'anchor'.  Each new in-motion point 'P' is held,
+//    and the previously held point (the 'float') is discarded, as long as every
+//    point since the anchor lies within the cross-track error of the segment from
+//    the anchor to 'P'.  Otherwise the float is queued and becomes the new anchor.
+//  - Memory is fixed (TRACK_WINDOW_SIZE points, plus one held event), and the cost
+//    per in-motion event is at most TRACK_WINDOW_SIZE distance checks.
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h" // TARGET_WINCE
+#include "custom/defaults.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "custom/log.h"
+
+#include "tools/stdtypes.h"
+#include "tools/gpstools.h"
+#include "tools/utctools.h"
+#include "tools/threads.h"
+
+#include "base/propman.h"
+#include "base/statcode.h"
+#include "base/events.h"
+
+#include "modules/track.h"
+
+// ----------------------------------------------------------------------------
+
+// maximum number of points held between queued points
+// (the float point is queued when the window is full)
+#ifndef TRACK_WINDOW_SIZE  // <-- a different value could be specified in 'defaults.h'
+#  define TRACK_WINDOW_SIZE         32
+#endif
+
+#define METERS_PER_DEGREE           (EARTH_RADIUS_METERS * RADIANS)
+
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    double          x;              // meters east of anchor
+    double          y;              // meters north of anchor
+} TrackPoint_t;
+
+static utBool               trackInit       = utFalse;
+
+static eventAddFtn_t        ftnQueueEvent   = 0;
+
+static utBool               anchorValid     = utFalse;
+static GPSPoint_t           anchorPoint;
+static double               anchorCosLat    = 1.0;
+static double               anchorHeading   = 0.0;
+static UInt32               anchorTime      = 0L;
+
+static TrackPoint_t         trackWindow[TRACK_WINDOW_SIZE];
+static int                  trackWindowCount = 0;
+
+static utBool               heldValid       = utFalse;
+static Event_t              heldEvent;
+static PacketPriority_t     heldPriority;
+static ClientPacketType_t   heldPktType;
+
+static UInt32               trackInCount    = 0L;
+static UInt32               trackOutCount   = 0L;
+
+static threadMutex_t        trackMutex;
+#define TRACK_LOCK          MUTEX_LOCK(&trackMutex);
+#define TRACK_UNLOCK        MUTEX_UNLOCK(&trackMutex);
+
+// ----------------------------------------------------------------------------
+
+/* initialize track simplification */
+void trackInitialize(eventAddFtn_t queueEvent)
+{
+    if (!trackInit) {
+        trackInit = utTrue;
+        ftnQueueEvent = queueEvent;
+        anchorValid = utFalse;
+        heldValid = utFalse;
+        trackWindowCount = 0;
+        threadMutexInit(&trackMutex);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/* set the anchor to the specified (queued) event */
+static void _trackSetAnchor(const Event_t *er)
+{
+    if (er && gpsPointIsValid(&(er->gpsPoint[0]))) {
+        anchorValid = utTrue;
+        gpsPointCopy(&anchorPoint, &(er->gpsPoint[0]));
+        anchorCosLat  = cos(anchorPoint.latitude * RADIANS);
+        anchorHeading = er->heading;
+        anchorTime    = er->timestamp[0];
+    } else {
+        anchorValid = utFalse;
+    }
+    trackWindowCount = 0;
+}
+
+/* project point onto a plane tangent at the anchor (meters) */
+static void _trackProject(TrackPoint_t *tp, const GPSPoint_t *gp)
+{
+    tp->x = (gp->longitude - anchorPoint.longitude) * anchorCosLat * METERS_PER_DEGREE;
+    tp->y = (gp->latitude  - anchorPoint.latitude) * METERS_PER_DEGREE;
+}
+
+/* return true if all window points are within 'maxErr' meters of the segment anchor->'p' */
+static utBool _trackWithinError(const TrackPoint_t *p, double maxErr)
+{
+    double maxErr2 = maxErr * maxErr;
+    double len2 = (p->x * p->x) + (p->y * p->y);
+    int i;
+    for (i = 0; i < trackWindowCount; i++) {
+        const TrackPoint_t *q = &trackWindow[i];
+        double dx = q->x, dy = q->y;
+        if (len2 > EPSILON) {
+            double t = ((q->x * p->x) + (q->y * p->y)) / len2;
+            if (t > 1.0) { t = 1.0; } else if (t < 0.0) { t = 0.0; }
+            dx -= t * p->x;
+            dy -= t * p->y;
+        }
+        if (((dx * dx) + (dy * dy)) > maxErr2) {
+            return utFalse;
+        }
+    }
+    return utTrue;
+}
+
+/* return the absolute difference between 2 headings (0 to 180 degrees) */
+static double _trackHeadingDelta(double h1, double h2)
+{
+    double d = fmod(fabs(h1 - h2), 360.0);
+    return (d > 180.0)? (360.0 - d) : d;
+}
+
+/* queue an event, and make it the new anchor */
+static utBool _trackQueue(PacketPriority_t priority, ClientPacketType_t pktType, Event_t *er)
+{
+    _trackSetAnchor(er);
+    trackOutCount++;
+    return ftnQueueEvent? (*ftnQueueEvent)(priority, pktType, er) : utFalse;
+}
+
+/* queue the held (float) point, if any */
+static void _trackFlushHeld()
+{
+    if (heldValid) {
+        heldValid = utFalse;
+        _trackQueue(heldPriority, heldPktType, &heldEvent);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/* event queue filter */
+// This function is provided to the GPS rule modules in place of the event queue.
+utBool trackQueueEvent(PacketPriority_t priority, ClientPacketType_t pktType, Event_t *er)
+{
+    utBool rtn = utFalse;
+
+    /* no event? */
+    if (!er) {
+        return utFalse;
+    }
+
+    TRACK_LOCK {
+        double maxErrM = (double)propGetUInt32AtIndex(PROP_MOTION_SIMPLIFY, 0, 0L);
+
+        if ((maxErrM <= 0.0) || (er->statusCode != STATUS_MOTION_IN_MOTION) ||
+            !gpsPointIsValid(&(er->gpsPoint[0]))) {
+
+            // not simplified: queue the held point first, then this event
+            _trackFlushHeld();
+            rtn = _trackQueue(priority, pktType, er);
+            if ((er->statusCode == STATUS_MOTION_IN_MOTION) || (er->statusCode == STATUS_MOTION_START)) {
+                trackInCount++;
+            } else
+            if (er->statusCode == STATUS_MOTION_STOP) {
+                if (trackInCount > trackOutCount) {
+                    logDEBUG(LOGSRC,"Track simplified: %lu of %lu points sent", trackOutCount, trackInCount);
+                }
+                trackInCount  = 0L;
+                trackOutCount = 0L;
+            }
+
+        } else
+        if (!anchorValid) {
+
+            // first in-motion point
+            trackInCount++;
+            rtn = _trackQueue(priority, pktType, er);
+
+        } else {
+
+            double maxHeading = (double)propGetUInt32AtIndex(PROP_MOTION_SIMPLIFY, 1, 0L);
+            UInt32 maxGapSec  = propGetUInt32AtIndex(PROP_MOTION_SIMPLIFY, 2, 0L);
+            TrackPoint_t p;
+            trackInCount++;
+
+            /* check whether the float point must be kept */
+            _trackProject(&p, &(er->gpsPoint[0]));
+            if (heldValid) {
+                utBool keepFloat = utFalse;
+                if (trackWindowCount >= TRACK_WINDOW_SIZE) {
+                    // window full
+                    keepFloat = utTrue;
+                } else
+                if ((maxHeading > 0.0) && (_trackHeadingDelta(anchorHeading, er->heading) > maxHeading)) {
+                    // turned since the anchor
+                    keepFloat = utTrue;
+                } else
+                if (!_trackWithinError(&p, maxErrM)) {
+                    // a held point is too far off the segment anchor->P
+                    keepFloat = utTrue;
+                }
+                if (keepFloat) {
+                    _trackFlushHeld();
+                    _trackProject(&p, &(er->gpsPoint[0])); // relative to new anchor
+                }
+            }
+
+            /* queue, or hold, this point */
+            if ((maxGapSec > 0L) && ((er->timestamp[0] - anchorTime) >= maxGapSec)) {
+                // maximum time between queued points has elapsed
+                heldValid = utFalse;
+                rtn = _trackQueue(priority, pktType, er);
+            } else {
+                memcpy(&heldEvent, er, sizeof(Event_t));
+                heldPriority = priority;
+                heldPktType  = pktType;
+                heldValid    = utTrue;
+                trackWindow[trackWindowCount++] = p;
+                rtn = utTrue;
+            }
+
+        }
+
+    } TRACK_UNLOCK
+
+    return rtn;
+}
+
+// ----------------------------------------------------------------------------
+
+/* periodic check (queue the held point once the maximum gap has elapsed) */
+void trackPeriodic()
+{
+    if (trackInit) {
+        TRACK_LOCK {
+            if (heldValid) {
+                UInt32 maxGapSec = propGetUInt32AtIndex(PROP_MOTION_SIMPLIFY, 2, 0L);
+                if ((maxGapSec > 0L) && ((utcGetTimeSec() - anchorTime) >= maxGapSec)) {
+                    _trackFlushHeld();
+                }
+            }
+        } TRACK_UNLOCK
+    }
+}
+
+// ----------------------------------------------------------------------------
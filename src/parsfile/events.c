@@ -135,6 +135,14 @@ static void _evSetFieldMask(Event_t *er, UInt16 type)
     }
 }
 
+/* set a field in a field selection mask (same size as 'Event_t.fieldMask') */
+void evSetMaskField(UInt8 *fieldMask, UInt16 type)
+{
+    if (fieldMask && (type < 256)) {
+        fieldMask[type / 8] |= (1 << (type % 8));
+    }
+}
+
 utBool evIsFieldSet(Event_t *er, UInt16 type)
 {
     if (er) {
@@ -173,6 +181,28 @@ static CustomDef_t *_evGetCustomDefinitionForType(ClientPacketType_t hdrType)
     return (CustomDef_t*)0;
 }
 
+/* return the payload offset/length of the first field of the specified type */
+// (this allows a field to be read from the raw packet payload without parsing the event)
+utBool evGetFieldOffset(ClientPacketType_t hdrType, UInt16 type, int *ofs, int *len, utBool *hiRes)
+{
+    CustomDef_t *custDef = _evGetCustomDefinitionForType(hdrType);
+    if (custDef) {
+        int i, o = 0;
+        for (i = 0; i < custDef->fldLen; i++) {
+            if (custDef->fld[i].type == type) {
+                if (ofs  ) { *ofs   = o; }
+                if (len  ) { *len   = (int)custDef->fld[i].length; }
+                if (hiRes) { *hiRes = custDef->fld[i].hiRes; }
+                return utTrue;
+            }
+            o += (int)custDef->fld[i].length;
+        }
+    }
+    return utFalse;
+}
+
+// ----------------------------------------------------------------------------
+
 static Event_t * _evClearEvent(Event_t *er)
 {
     if (er) {
@@ -226,6 +256,12 @@ static Event_t * _evClearEvent(Event_t *er)
 
 #define LIMIT_INDEX(N,L)    (((N) >= (L))? ((L) - 1) : (N))
 Event_t *evParseEventPacket(Packet_t *pkt, Event_t *er)
+{
+    return evParseEventFields(pkt, er, (UInt8*)0);
+}
+
+/* parse only the fields selected in 'fieldMask' (all fields if null) */
+Event_t *evParseEventFields(Packet_t *pkt, Event_t *er, const UInt8 *fieldMask)
 {
     
     /* get event format definition */
@@ -253,6 +289,11 @@ Event_t *evParseEventPacket(Packet_t *pkt, Event_t *er)
         utBool isHiRes   = fld[i].hiRes;
         UInt32 uVal32    = 0L;
         Int32 iVal32     = 0L;
+        if (fieldMask && !(fieldMask[fld[i].type / 8] & (1 << (fld[i].type % 8)))) {
+            // field not selected
+            binBufScanf(bf, "%*z", len);
+            continue;
+        }
         switch ((EventFieldType_t)fld[i].type) {
             
             case FIELD_STATUS_CODE      : // hex
@@ -273,8 +273,12 @@ typedef struct {
 utBool evAddCustomDefinition(CustomDef_t *cd);
 
 utBool evIsFieldSet(Event_t *er, UInt16 type);
+void evSetMaskField(UInt8 *fieldMask, UInt16 type);
+
+utBool evGetFieldOffset(ClientPacketType_t hdrType, UInt16 type, int *ofs, int *len, utBool *hiRes);
 
 Event_t *evParseEventPacket(Packet_t *pkt, Event_t *er);
+Event_t *evParseEventFields(Packet_t *pkt, Event_t *er, const UInt8 *fieldMask);
 
 // ----------------------------------------------------------------------------
 
@@ -40,6 +40,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
@@ -49,6 +50,9 @@
 #include "tools/stdtypes.h"
 #include "tools/strtools.h"
 #include "tools/utctools.h"
+#include "tools/gpstools.h"
+#include "tools/threads.h"
+#include "tools/fileidx.h"
 
 #include "base/packet.h"
 #include "base/statcode.h"
@@ -67,10 +71,75 @@
 #define MODE_DATA           1
 #define MODE_FOOTER         2
 
+// approximate size of the file region parsed by each task
+#define PARSE_CHUNK_SIZE    (1024L * 1024L)
+
+// maximum number of chunks parsed ahead of the output
+#define MAX_PENDING_CHUNKS  (THREAD_POOL_MAX_WORKERS * 2)
+
+/* maximum file ranges selected from the file index */
+#define MAX_FILE_RANGES     256
+
 // ----------------------------------------------------------------------------
 
-static char scName[32];
-static const char *statusCodeName(UInt16 code)
+/* growable output buffer */
+typedef struct {
+    char        *buf;
+    long        len;
+    long        size;
+} OutBuffer_t;
+
+static void outPrintf(OutBuffer_t *ob, const char *fmt, ...)
+{
+    va_list ap;
+    while (utTrue) {
+        long avail = ob->size - ob->len;
+        if (avail > 0L) {
+            va_start(ap, fmt);
+            int n = vsnprintf(ob->buf + ob->len, avail, fmt, ap);
+            va_end(ap);
+            if (n < 0) {
+                return; // format error
+            } else
+            if (n < avail) {
+                ob->len += n;
+                return;
+            }
+        }
+        long newSize = (ob->size > 0L)? (ob->size * 2L) : 65536L;
+        char *newBuf = (char*)realloc(ob->buf, newSize);
+        if (!newBuf) {
+            fprintf(stderr, "Unable to allocate output buffer ...\n");
+            return;
+        }
+        ob->buf  = newBuf;
+        ob->size = newSize;
+    }
+}
+
+static void outWrite(OutBuffer_t *ob)
+{
+    if (ob->len > 0L) {
+        fwrite(ob->buf, 1, ob->len, stdout);
+        ob->len = 0L;
+    }
+}
+
+/* broken-down time (thread safe) */
+static struct tm *_getTime(UInt32 utc, utBool local, struct tm *tmBuf)
+{
+    time_t t = (time_t)utc;
+#if defined(TARGET_WINCE)
+    *tmBuf = local? *localtime(&t) : *gmtime(&t);
+#else
+    if (local) { localtime_r(&t, tmBuf); } else { gmtime_r(&t, tmBuf); }
+#endif
+    return tmBuf;
+}
+
+// ----------------------------------------------------------------------------
+
+static const char *statusCodeName(UInt16 code, char *scName)
 {
     switch (code) {
         case STATUS_MOTION_START:           return "StartMotion";
@@ -87,43 +156,129 @@ static const char *statusCodeName(UInt16 code)
 
 // ----------------------------------------------------------------------------
 
-static void printCSV(int mode, Event_t *er)
+/* CSV columns */
+#define COL_DATE            0
+#define COL_TIME            1
+#define COL_CODE            2
+#define COL_LATITUDE        3
+#define COL_LONGITUDE       4
+#define COL_SPEED           5
+#define COL_HEADING         6
+#define COL_ALTITUDE        7
+#define COL_DISTANCE        8
+#define COL_SEQUENCE        9
+#define COL_UTC             10
+
+typedef struct {
+    const char      *name;
+    UInt16          field;      // event field required by this column
+} CsvColumn_t;
+
+static CsvColumn_t csvColumn[] = {
+    { "date"        , FIELD_TIMESTAMP   },  // COL_DATE
+    { "time"        , FIELD_TIMESTAMP   },  // COL_TIME
+    { "code"        , FIELD_STATUS_CODE },  // COL_CODE
+    { "latitude"    , FIELD_GPS_POINT   },  // COL_LATITUDE
+    { "longitude"   , FIELD_GPS_POINT   },  // COL_LONGITUDE
+    { "speed"       , FIELD_SPEED       },  // COL_SPEED
+    { "heading"     , FIELD_HEADING     },  // COL_HEADING
+    { "altitude"    , FIELD_ALTITUDE    },  // COL_ALTITUDE
+    { "distance"    , FIELD_DISTANCE    },  // COL_DISTANCE
+    { "sequence"    , FIELD_SEQUENCE    },  // COL_SEQUENCE
+    { "utc"         , FIELD_TIMESTAMP   },  // COL_UTC
+};
+#define CSV_COLUMN_COUNT    (sizeof(csvColumn)/sizeof(csvColumn[0]))
+
+/* selected columns (default "date,time,code,latitude,longitude,speed,heading") */
+static int csvSelect[CSV_COLUMN_COUNT] = { 
+    COL_DATE, COL_TIME, COL_CODE, COL_LATITUDE, COL_LONGITUDE, COL_SPEED, COL_HEADING 
+};
+static int csvSelectCount = 7;
+
+/* parse comma-separated column names */
+static utBool setCSVColumns(const char *names)
+{
+    char buf[256], *col[CSV_COLUMN_COUNT];
+    strncpy(buf, names, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = 0;
+    int n = strParseArray_sep(buf, col, CSV_COLUMN_COUNT, ','), i, c;
+    for (i = 0; i < n; i++) {
+        for (c = 0; (c < CSV_COLUMN_COUNT) && !strEqualsIgnoreCase(col[i], csvColumn[c].name); c++);
+        if (c >= CSV_COLUMN_COUNT) {
+            fprintf(stderr, "Invalid column: %s\n", col[i]);
+            return utFalse;
+        }
+        csvSelect[i] = c;
+    }
+    csvSelectCount = n;
+    return (n > 0)? utTrue : utFalse;
+}
+
+static void printCSV(OutBuffer_t *out, int mode, Event_t *er)
 {
+    int i;
     
     /* header/footer */
     if (mode == MODE_HEADER) {
         char hdr[600], *h = hdr;
-        sprintf(h,  "date");      h += strlen(h);
-        sprintf(h, ",time");      h += strlen(h);
-        sprintf(h, ",code");      h += strlen(h);
-        sprintf(h, ",latitude");  h += strlen(h);
-        sprintf(h, ",longitude"); h += strlen(h);
-        sprintf(h, ",speed");     h += strlen(h);
-        sprintf(h, ",heading");   h += strlen(h);
-      //sprintf(h, ",alt");       h += strlen(h);
-      //sprintf(h, ",seq");       h += strlen(h);
-        fprintf(stdout, "%s\n", hdr);
+        *h = 0;
+        for (i = 0; i < csvSelectCount; i++) {
+            sprintf(h, "%s%s", (i? "," : ""), csvColumn[csvSelect[i]].name); h += strlen(h);
+        }
+        outPrintf(out, "%s\n", hdr);
         return;
     } else 
     if (mode == MODE_FOOTER) {
         return;
     } else 
     if ((mode == MODE_DATA) && er) {
-        struct tm *tmp = localtime(&er->timestamp[0]);
-        int hr  = tmp->tm_hour, mn = tmp->tm_min, sc = tmp->tm_sec;
-        int dy  = tmp->tm_mday, mo = tmp->tm_mon + 1, yr = 1900 + tmp->tm_year;
-        const char *codeName = statusCodeName(er->statusCode);
+        struct tm tmBuf, *tmp = (struct tm*)0;
+        char scName[32];
         char cvs[600], *c = cvs;
-        sprintf(c,  "%02d/%02d/%02d", yr, mo, dy);        c += strlen(c);
-        sprintf(c, ",%02d:%02d:%02d", hr, mn, sc);        c += strlen(c);
-        sprintf(c, ",%s"    , codeName);                  c += strlen(c);
-        sprintf(c, ",%.5lf" , er->gpsPoint[0].latitude);  c += strlen(c);
-        sprintf(c, ",%.5lf" , er->gpsPoint[0].longitude); c += strlen(c);
-        sprintf(c, ",%.1lf" , er->speedKPH);              c += strlen(c);
-        sprintf(c, ",%.1lf" , er->heading);               c += strlen(c);
-      //sprintf(c, ",%.0lf" , er->altitude);              c += strlen(c);
-      //sprintf(c, ",%04lX" , er->sequence);              c += strlen(c);
-        fprintf(stdout, "%s\n", cvs);
+        for (i = 0; i < csvSelectCount; i++) {
+            int col = csvSelect[i];
+            if (i > 0) { *c++ = ','; }
+            if (((col == COL_DATE) || (col == COL_TIME)) && !tmp) {
+                tmp = _getTime(er->timestamp[0], utTrue, &tmBuf);
+            }
+            switch (col) {
+                case COL_DATE:
+                    sprintf(c, "%02d/%02d/%02d", 1900 + tmp->tm_year, tmp->tm_mon + 1, tmp->tm_mday);
+                    break;
+                case COL_TIME:
+                    sprintf(c, "%02d:%02d:%02d", tmp->tm_hour, tmp->tm_min, tmp->tm_sec);
+                    break;
+                case COL_CODE:
+                    sprintf(c, "%s", statusCodeName(er->statusCode, scName));
+                    break;
+                case COL_LATITUDE:
+                    sprintf(c, "%.5lf", er->gpsPoint[0].latitude);
+                    break;
+                case COL_LONGITUDE:
+                    sprintf(c, "%.5lf", er->gpsPoint[0].longitude);
+                    break;
+                case COL_SPEED:
+                    sprintf(c, "%.1lf", er->speedKPH);
+                    break;
+                case COL_HEADING:
+                    sprintf(c, "%.1lf", er->heading);
+                    break;
+                case COL_ALTITUDE:
+                    sprintf(c, "%.0lf", er->altitude);
+                    break;
+                case COL_DISTANCE:
+                    sprintf(c, "%.1lf", er->distanceKM);
+                    break;
+                case COL_SEQUENCE:
+                    sprintf(c, "%04lX", er->sequence);
+                    break;
+                case COL_UTC:
+                    sprintf(c, "%lu", er->timestamp[0]);
+                    break;
+            }
+            c += strlen(c);
+        }
+        outPrintf(out, "%s\n", cvs);
         return;
     }
     
@@ -131,7 +286,7 @@ static void printCSV(int mode, Event_t *er)
 
 // ----------------------------------------------------------------------------
 
-static void printGPX(int mode, Event_t *er)
+static void printGPX(OutBuffer_t *out, int mode, Event_t *er)
 {
     // Docs:
     //   http://www.topografix.com/gpx_manual.asp
@@ -142,79 +297,80 @@ static void printGPX(int mode, Event_t *er)
     /* header/footer */
     if (mode == MODE_HEADER) { // header
         UInt32 nowTime = utcGetTimeSec();
-        struct tm *tmp = gmtime((time_t*)&nowTime);
+        struct tm tmBuf, *tmp = _getTime(nowTime, utFalse, &tmBuf);
         int hr  = tmp->tm_hour, mn = tmp->tm_min, sc = tmp->tm_sec;
         int dy  = tmp->tm_mday, mo = tmp->tm_mon + 1, yr = 1900 + tmp->tm_year;
-        fprintf(stdout, "<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>\n");
-        fprintf(stdout, "<gpx\n");
-        fprintf(stdout, "  version=\"1.0\"\n");
-        fprintf(stdout, "  creator=\"ParseFile - http://www.opendmtp.org\"\n");
-        fprintf(stdout, "  xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n");
-        fprintf(stdout, "  xmlns=\"http://www.topografix.com/GPX/1/0\"\n");
-        fprintf(stdout, "  xsi:schemaLocation=\"http://www.topografix.com/GPX/1/0 http://www.topografix.com/GPX/1/0/gpx.xsd\">\n");
-        fprintf(stdout, " <time>%04d-%02d-%02dT%02d:%02d:%02dZ</time>\n", yr, mo, dy, hr, mn, sc); // UTC ISO 8601
-        fprintf(stdout, " <trk>\n");
-        fprintf(stdout, " <trkseg>\n");
+        outPrintf(out, "<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>\n");
+        outPrintf(out, "<gpx\n");
+        outPrintf(out, "  version=\"1.0\"\n");
+        outPrintf(out, "  creator=\"ParseFile - http://www.opendmtp.org\"\n");
+        outPrintf(out, "  xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n");
+        outPrintf(out, "  xmlns=\"http://www.topografix.com/GPX/1/0\"\n");
+        outPrintf(out, "  xsi:schemaLocation=\"http://www.topografix.com/GPX/1/0 http://www.topografix.com/GPX/1/0/gpx.xsd\">\n");
+        outPrintf(out, " <time>%04d-%02d-%02dT%02d:%02d:%02dZ</time>\n", yr, mo, dy, hr, mn, sc); // UTC ISO 8601
+        outPrintf(out, " <trk>\n");
+        outPrintf(out, " <trkseg>\n");
         return;
     } else 
     if (mode == MODE_FOOTER) { // footer
-        fprintf(stdout, " </trkseg>\n");
-        fprintf(stdout, " </trk>\n");
-        fprintf(stdout, "</gpx>\n");
+        outPrintf(out, " </trkseg>\n");
+        outPrintf(out, " </trk>\n");
+        outPrintf(out, "</gpx>\n");
         return;
     } else
     if ((mode == MODE_DATA) && er) { // data point
-        struct tm *tmp = gmtime((time_t*)&er->timestamp[0]);
+        struct tm tmBuf, *tmp = _getTime(er->timestamp[0], utFalse, &tmBuf);
         int hr  = tmp->tm_hour, mn = tmp->tm_min, sc = tmp->tm_sec;
         int dy  = tmp->tm_mday, mo = tmp->tm_mon + 1, yr = 1900 + tmp->tm_year;
         double lat = er->gpsPoint[0].latitude;
         double lon = er->gpsPoint[0].longitude;
-        fprintf(stdout, "  <trkpt lat=\"%.6lf\" lon=\"%.6lf\">\n", lat, lon);
+        outPrintf(out, "  <trkpt lat=\"%.6lf\" lon=\"%.6lf\">\n", lat, lon);
         if (evIsFieldSet(er, FIELD_ALTITUDE)) {
-            fprintf(stdout, "    <ele>%.1lf</ele>\n", er->altitude);
+            outPrintf(out, "    <ele>%.1lf</ele>\n", er->altitude);
         }
-        fprintf(stdout, "    <time>%04d-%02d-%02dT%02d:%02d:%02dZ</time>\n", yr, mo, dy, hr, mn, sc); // ISO 8601
+        outPrintf(out, "    <time>%04d-%02d-%02dT%02d:%02d:%02dZ</time>\n", yr, mo, dy, hr, mn, sc); // ISO 8601
         if (evIsFieldSet(er, FIELD_HEADING)) {
             // only available in <trkpt>
-            fprintf(stdout, "    <course>%.1lf</course>\n", er->heading); // degrees
+            outPrintf(out, "    <course>%.1lf</course>\n", er->heading); // degrees
         }
         if (evIsFieldSet(er, FIELD_SPEED)) {
             // only available in <trkpt>
-            fprintf(stdout, "    <speed>%.1lf</speed>\n", (double)((er->speedKPH * 1000.0) / 3600.0)); // (m/s)
+            outPrintf(out, "    <speed>%.1lf</speed>\n", (double)((er->speedKPH * 1000.0) / 3600.0)); // (m/s)
         }
         if (evIsFieldSet(er, FIELD_GPS_MAG_VARIATION)) {
-            fprintf(stdout, "    <magvar>%.1lf</magvar>\n", er->gpsMagVariation); // degrees
+            outPrintf(out, "    <magvar>%.1lf</magvar>\n", er->gpsMagVariation); // degrees
         }
         if (evIsFieldSet(er, FIELD_GPS_GEOID_HEIGHT)) {
-            fprintf(stdout, "    <geoidheight>%.1lf</geoidheight>\n", er->gpsGeoidHeight); // meters
+            outPrintf(out, "    <geoidheight>%.1lf</geoidheight>\n", er->gpsGeoidHeight); // meters
         }
-        fprintf(stdout, "    <sym>%s</sym>\n", statusCodeName(er->statusCode));
+        char scName[32];
+        outPrintf(out, "    <sym>%s</sym>\n", statusCodeName(er->statusCode, scName));
         if (evIsFieldSet(er, FIELD_GPS_QUALITY) || evIsFieldSet(er, FIELD_GPS_TYPE)) {
             if (er->gpsQuality == 1) {
                 char *s = (er->gps2D3D == 2)? "2d" : ((er->gps2D3D == 3)?"3d" : "none");
-                fprintf(stdout, "    <fix>%s</fix>\n", s); // 'none'|'2d'|'3d'
+                outPrintf(out, "    <fix>%s</fix>\n", s); // 'none'|'2d'|'3d'
             } else {
                 char *s = (er->gpsQuality == 2)? "dgps" : ((er->gpsQuality == 3)? "pps" : "none");
-                fprintf(stdout, "    <fix>%s</fix>\n", s); // 'none'|'dgps'|'pps'
+                outPrintf(out, "    <fix>%s</fix>\n", s); // 'none'|'dgps'|'pps'
             }
         }
         if (evIsFieldSet(er, FIELD_GPS_SATELLITES)) {
-            fprintf(stdout, "    <sat>%lu</sat>\n", er->gpsSatellites); // count
+            outPrintf(out, "    <sat>%lu</sat>\n", er->gpsSatellites); // count
         }
         if (evIsFieldSet(er, FIELD_GPS_HDOP)) {
-            fprintf(stdout, "    <hdop>%.1lf</hdop>\n", er->gpsHDOP); // dec
+            outPrintf(out, "    <hdop>%.1lf</hdop>\n", er->gpsHDOP); // dec
         }
         if (evIsFieldSet(er, FIELD_GPS_VDOP)) {
-            fprintf(stdout, "    <vdop>%.1lf</vdop>\n", er->gpsVDOP); // dec
+            outPrintf(out, "    <vdop>%.1lf</vdop>\n", er->gpsVDOP); // dec
         }
         if (evIsFieldSet(er, FIELD_GPS_PDOP)) {
-            fprintf(stdout, "    <pdop>%.1lf</pdop>\n", er->gpsPDOP); // dec
+            outPrintf(out, "    <pdop>%.1lf</pdop>\n", er->gpsPDOP); // dec
         }
         if (evIsFieldSet(er, FIELD_GPS_DGPS_UPDATE)) {
-            fprintf(stdout, "    <ageofdgpsdata>%lu</ageofdgpsdata>\n", er->gpsDgpsUpdate); // sec
+            outPrintf(out, "    <ageofdgpsdata>%lu</ageofdgpsdata>\n", er->gpsDgpsUpdate); // sec
         }
         // <dgpsid> dgpsStationType </dgpsid>       // n/a
-        fprintf(stdout, "  </trkpt>\n");
+        outPrintf(out, "  </trkpt>\n");
         return;
     }
     
@@ -222,25 +378,25 @@ static void printGPX(int mode, Event_t *er)
 
 // ----------------------------------------------------------------------------
 
-static void printGoogleXML(int mode, Event_t *er)
+static void printGoogleXML(OutBuffer_t *out, int mode, Event_t *er)
 {
     
     /* header/footer */
     if (mode == MODE_HEADER) {
-        fprintf(stdout, "<markers>\n");
+        outPrintf(out, "<markers>\n");
         return;
     } else 
     if (mode == MODE_FOOTER) {
-        fprintf(stdout, "</markers>\n");
+        outPrintf(out, "</markers>\n");
         return;
     } else
     if ((mode == MODE_DATA) && er) {
-        struct tm *tmp = localtime(&er->timestamp[0]);
+        struct tm tmBuf, *tmp = _getTime(er->timestamp[0], utTrue, &tmBuf);
         int hr  = tmp->tm_hour, mn = tmp->tm_min, sc = tmp->tm_sec;
         int dy  = tmp->tm_mday, mo = tmp->tm_mon + 1, yr = 1900 + tmp->tm_year;
-        char xml[600], *c = xml;
+        char xml[600], *c = xml, scName[32];
         sprintf(c, "  <marker"); c += strlen(c);
-        sprintf(c, " name=\"%s\""            , statusCodeName(er->statusCode)); c += strlen(c);
+        sprintf(c, " name=\"%s\""            , statusCodeName(er->statusCode, scName)); c += strlen(c);
         sprintf(c, " lat=\"%.5lf\""          , er->gpsPoint[0].latitude); c += strlen(c);
         sprintf(c, " lon=\"%.5lf\""          , er->gpsPoint[0].longitude); c += strlen(c);
         sprintf(c, " kph=\"%.1lf\""          , er->speedKPH); c += strlen(c);
@@ -251,7 +407,7 @@ static void printGoogleXML(int mode, Event_t *er)
         sprintf(c, " time=\"%02d:%02d:%02d\"", hr, mn, sc); c += strlen(c);
       //sprintf(c, " seq=\"%04lX\"" , er->sequence); c += strlen(c);
         sprintf(c, "/>"); c += strlen(c);
-        fprintf(stdout, "%s\n", xml);
+        outPrintf(out, "%s\n", xml);
         return;
     }
     
@@ -259,6 +415,381 @@ static void printGoogleXML(int mode, Event_t *er)
 
 // ----------------------------------------------------------------------------
 
+/* track points collected for the distance summary (structure-of-arrays) */
+typedef struct {
+    double      *lat;
+    double      *lon;
+    int         count;
+    int         size;
+} PointList_t;
+
+static PointList_t distPoints = { (double*)0, (double*)0, 0, 0 };
+
+static utBool addPoint(PointList_t *pl, double lat, double lon)
+{
+    if (pl->count >= pl->size) {
+        int newSize = (pl->size > 0)? (pl->size * 2) : 1024;
+        double *newLat = (double*)realloc(pl->lat, newSize * sizeof(double));
+        double *newLon = newLat? (double*)realloc(pl->lon, newSize * sizeof(double)) : (double*)0;
+        if (!newLat || !newLon) {
+            if (newLat) { pl->lat = newLat; }
+            fprintf(stderr, "Unable to allocate distance points ...\n");
+            return utFalse;
+        }
+        pl->lat  = newLat;
+        pl->lon  = newLon;
+        pl->size = newSize;
+    }
+    pl->lat[pl->count] = lat;
+    pl->lon[pl->count] = lon;
+    pl->count++;
+    return utTrue;
+}
+
+static void addDistancePoint(PointList_t *pl, const Event_t *er)
+{
+    if (gpsPointIsValid(&(er->gpsPoint[0]))) {
+        addPoint(pl, er->gpsPoint[0].latitude, er->gpsPoint[0].longitude);
+    }
+}
+
+static void printDistance()
+{
+    double meters = gpsPolylineMeters(distPoints.lat, distPoints.lon, distPoints.count, (double*)0);
+    fprintf(stderr, "Distance: %.3lf km [%d points]\n", meters / 1000.0, distPoints.count);
+}
+
+// ----------------------------------------------------------------------------
+
+/* print a record in the selected format */
+static int printFormat = FORMAT_CSV;
+static void printRecord(OutBuffer_t *out, int mode, Event_t *er)
+{
+    switch (printFormat) {
+        case FORMAT_CSV:
+            printCSV(out, mode, er);
+            break;
+        case FORMAT_GPX:
+            printGPX(out, mode, er);
+            break;
+        case FORMAT_GOOGLE_XML:
+            printGoogleXML(out, mode, er);
+            break;
+    } 
+}
+
+// ----------------------------------------------------------------------------
+// Event filters are evaluated on the raw packet payload (the status code, 
+// timestamp, and GPS point are located from the event packet format definition)
+// so that rejected packets are never fully parsed.
+
+#define MAX_FILTER_CODES    16
+
+typedef struct {
+    utBool          active;
+    UInt32          fromTime;           // 0 if not specified
+    UInt32          toTime;             // 0 if not specified
+    UInt16          code[MAX_FILTER_CODES];
+    int             codeCount;
+    utBool          bbox;
+    double          minLat, minLon, maxLat, maxLon;
+} EventFilter_t;
+
+static EventFilter_t filter;
+
+/* big-endian unsigned value */
+static UInt32 _rawUInt32(const UInt8 *b, int len)
+{
+    UInt32 v = 0L;
+    for (; len > 0; len--, b++) { v = (v << 8) | *b; }
+    return v;
+}
+
+/* return the payload offset/length of a field (true if found within 'maxLen') */
+static utBool _rawField(ClientPacketType_t hdrType, UInt16 type, int *ofs, int *len, int *need)
+{
+    if (!evGetFieldOffset(hdrType, type, ofs, len, (utBool*)0)) {
+        return utFalse;
+    }
+    if ((*ofs + *len) > *need) { *need = *ofs + *len; }
+    return utTrue;
+}
+
+/* return 1 if the packet at 'ofs' passes the filter, 0 if it does not, or -1 if unknown */
+static int _filterPacket(const UInt8 *data, long dataLen, long ofs, long *pktLen)
+{
+    ClientPacketType_t hdrType;
+    UInt8 payload[PACKET_MAX_PAYLOAD_LENGTH];
+    int scOfs = 0, scLen = 0, tsOfs = 0, tsLen = 0, gpOfs = 0, gpLen = 0, need = 0;
+
+    /* header */
+    if (parsePeekPacket(data, dataLen, ofs, &hdrType, payload, 0, pktLen) < 0) {
+        return -1; // let the packet parser report the error
+    }
+
+    /* field locations */
+    // (events which do not have a filtered field are rejected, as are non-event packets)
+    if ((filter.fromTime || filter.toTime) && !_rawField(hdrType, FIELD_TIMESTAMP, &tsOfs, &tsLen, &need)) {
+        return 0;
+    }
+    if ((filter.codeCount > 0) && !_rawField(hdrType, FIELD_STATUS_CODE, &scOfs, &scLen, &need)) {
+        return 0;
+    }
+    if (filter.bbox && !_rawField(hdrType, FIELD_GPS_POINT, &gpOfs, &gpLen, &need)) {
+        return 0;
+    }
+    if (need > sizeof(payload)) {
+        return -1;
+    }
+
+    /* decode only the leading payload bytes */
+    if (parsePeekPacket(data, dataLen, ofs, &hdrType, payload, need, pktLen) < need) {
+        return -1;
+    }
+
+    /* time range */
+    if (tsLen > 0) {
+        UInt32 ts = _rawUInt32(payload + tsOfs, tsLen);
+        if ((filter.fromTime && (ts < filter.fromTime)) || (filter.toTime && (ts > filter.toTime))) {
+            return 0;
+        }
+    }
+
+    /* status codes */
+    if (scLen > 0) {
+        UInt16 sc = (UInt16)_rawUInt32(payload + scOfs, scLen);
+        int c;
+        for (c = 0; (c < filter.codeCount) && (filter.code[c] != sc); c++);
+        if (c >= filter.codeCount) {
+            return 0;
+        }
+    }
+
+    /* bounding box */
+    if (gpLen > 0) {
+        GPSPoint_t gp;
+        if (gpLen >= 8) {
+            gpsPointDecode8(&gp, payload + gpOfs);
+        } else
+        if (gpLen >= 6) {
+            gpsPointDecode6(&gp, payload + gpOfs);
+        } else {
+            return 0;
+        }
+        if ((gp.latitude  < filter.minLat) || (gp.latitude  > filter.maxLat) ||
+            (gp.longitude < filter.minLon) || (gp.longitude > filter.maxLon)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* parse "YYYY/MM/DD[,hh:mm[:ss]]" (local time), or seconds since 1970 */
+static UInt32 _parseTime(const char *s, utBool endOfDay)
+{
+    int yr = 0, mo = 0, dy = 0, hr = 0, mn = 0, sc = 0;
+    int n = sscanf(s, "%d/%d/%d,%d:%d:%d", &yr, &mo, &dy, &hr, &mn, &sc);
+    if (n < 3) {
+        return strParseUInt32(s, 0L);
+    } else {
+        struct tm tmBuf;
+        memset(&tmBuf, 0, sizeof(tmBuf));
+        if ((n == 3) && endOfDay) {
+            hr = 23; mn = 59; sc = 59;
+        }
+        tmBuf.tm_year  = yr - 1900;
+        tmBuf.tm_mon   = mo - 1;
+        tmBuf.tm_mday  = dy;
+        tmBuf.tm_hour  = hr;
+        tmBuf.tm_min   = mn;
+        tmBuf.tm_sec   = sc;
+        tmBuf.tm_isdst = -1;
+        time_t t = mktime(&tmBuf);
+        return (t > 0)? (UInt32)t : 0L;
+    }
+}
+
+/* parse comma-separated status codes (hex, decimal, or name) */
+static utBool _parseCodes(const char *codes)
+{
+    static UInt16 namedCode[] = {
+        STATUS_MOTION_START, STATUS_MOTION_IN_MOTION, STATUS_MOTION_STOP, STATUS_MOTION_DORMANT, 
+        STATUS_MOTION_EXCESS_SPEED, STATUS_GEOFENCE_ARRIVE, STATUS_GEOFENCE_DEPART
+    };
+    char buf[256], *code[MAX_FILTER_CODES], scName[32];
+    strncpy(buf, codes, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = 0;
+    int n = strParseArray_sep(buf, code, MAX_FILTER_CODES, ','), i, c;
+    for (i = 0; i < n; i++) {
+        if (isdigit(*code[i])) {
+            filter.code[i] = (UInt16)(strStartsWithIgnoreCase(code[i],"0x")? 
+                strParseHex32(code[i], 0L) : strParseUInt32(code[i], 0L));
+        } else {
+            int max = sizeof(namedCode)/sizeof(namedCode[0]);
+            for (c = 0; (c < max) && !strEqualsIgnoreCase(code[i], statusCodeName(namedCode[c], scName)); c++);
+            if (c >= max) {
+                fprintf(stderr, "Invalid status code: %s\n", code[i]);
+                return utFalse;
+            }
+            filter.code[i] = namedCode[c];
+        }
+    }
+    filter.codeCount = n;
+    return (n > 0)? utTrue : utFalse;
+}
+
+// ----------------------------------------------------------------------------
+// The file is divided into chunks starting on packet boundaries.  Each chunk is
+// parsed/formatted into its own output buffer (by the thread pool), and the 
+// buffers are written in file order.
+
+typedef struct {
+    threadTask_t    task;
+    long            start;      // offset of first packet
+    utBool          first;      // first chunk of a file range
+    long            end;        // offset of the next chunk
+    long            last;       // offset following the last parsed packet
+    int             err;        // error which stopped this chunk (SRVERR_OK if none)
+    OutBuffer_t     out;        // formatted records
+    PointList_t     points;     // distance points
+} ParseChunk_t;
+
+static const UInt8  *fileData       = (UInt8*)0;
+static long         fileDataLen     = 0L;
+static utBool       showDistance    = utFalse;
+static UInt8        *fieldMask      = (UInt8*)0;    // fields to parse (null for all)
+
+static void _parseChunk(void *arg)
+{
+    ParseChunk_t *pc = (ParseChunk_t*)arg;
+    Packet_t pkt;
+    Event_t er;
+    long ofs = pc->start;
+    pc->err = SRVERR_OK;
+    pc->out.len = 0L;
+    pc->points.count = 0;
+    while (ofs < pc->end) {
+        if (filter.active) {
+            long pktLen = 0L;
+            if (_filterPacket(fileData, fileDataLen, ofs, &pktLen) == 0) {
+                ofs += pktLen;
+                continue;
+            }
+        }
+        int err = parseNextPacket(fileData, fileDataLen, &ofs, &pkt);
+        if (err != SRVERR_OK) {
+            pc->err = err;
+            break;
+        }
+        if (evParseEventFields(&pkt, &er, fieldMask)) {
+            printRecord(&(pc->out), MODE_DATA, &er);
+            if (showDistance) {
+                addDistancePoint(&(pc->points), &er);
+            }
+        } else {
+            //fprintf(stderr, "Skipping non-Event [%04X] ...\n", pkt.hdrType);
+        }
+    }
+    pc->last = ofs;
+}
+
+/* parse all packets in the file ranges (returns the error which stopped parsing) */
+static int _parseFile(int workers, const FileRange_t *range, int rangeCount)
+{
+    static ParseChunk_t chunk[MAX_PENDING_CHUNKS];
+    threadPool_t pool;
+    utBool usePool = utFalse;
+    int maxPending = 1, head = 0, tail = 0, err = SRVERR_OK, r = 0;
+    long nextStart = (rangeCount > 0)? range[0].start : 0L, lastEnd = 0L;
+    
+    /* start workers */
+    if (workers <= 0) { workers = threadGetCPUCount(); }
+    if ((workers > 1) && (fileDataLen > PARSE_CHUNK_SIZE)) {
+        int n = threadPoolInit(&pool, "Parse", workers, -1);
+        if (n > 1) {
+            usePool = utTrue;
+            maxPending = n * 2;
+            if (maxPending > MAX_PENDING_CHUNKS) { maxPending = MAX_PENDING_CHUNKS; }
+        } else
+        if (n > 0) {
+            threadPoolFree(&pool);
+        }
+    }
+    memset(chunk, 0, sizeof(chunk));
+
+    /* parse chunks */
+    while (utTrue) {
+        
+        /* start chunks */
+        while ((r < rangeCount) && ((head - tail) < maxPending)) {
+            ParseChunk_t *pc = &chunk[head % MAX_PENDING_CHUNKS];
+            long rangeEnd = range[r].end;
+            pc->start = nextStart;
+            pc->first = (nextStart == range[r].start)? utTrue : utFalse;
+            pc->end   = ((nextStart + PARSE_CHUNK_SIZE) < rangeEnd)?
+                parseSyncPacket(fileData, fileDataLen, nextStart + PARSE_CHUNK_SIZE) : rangeEnd;
+            if (pc->end > rangeEnd) { pc->end = rangeEnd; }
+            nextStart = pc->end;
+            if ((nextStart >= rangeEnd) && (++r < rangeCount)) {
+                nextStart = range[r].start;
+            }
+            threadTaskInit(&(pc->task), &_parseChunk, (void*)pc, 0);
+            if (!usePool || (threadPoolSubmit(&pool, &(pc->task), -1L) != 0)) {
+                _parseChunk((void*)pc);
+            }
+            head++;
+        }
+        if (head == tail) {
+            // end of file
+            if (fileDataLen <= 0L) { err = SRVERR_TIMEOUT; }
+            break;
+        }
+        
+        /* output next chunk */
+        ParseChunk_t *pc = &chunk[tail % MAX_PENDING_CHUNKS];
+        if (usePool) {
+            threadPoolWaitTask(&pool, &(pc->task), -1L);
+        }
+        if (!pc->first && (pc->start != lastEnd)) {
+            // the previous chunk ended past the start of this chunk (a false resync)
+            pc->start = lastEnd;
+            _parseChunk((void*)pc);
+        }
+        outWrite(&(pc->out));
+        if (showDistance) {
+            int p;
+            for (p = 0; p < pc->points.count; p++) {
+                addPoint(&distPoints, pc->points.lat[p], pc->points.lon[p]);
+            }
+        }
+        lastEnd = pc->last;
+        tail++;
+        if (pc->err != SRVERR_OK) {
+            // stop at the first error (as if the file were read sequentially)
+            err = pc->err;
+            break;
+        }
+        
+    }
+    
+    /* stop workers */
+    if (usePool) {
+        threadPoolFree(&pool); // waits for pending chunks
+    }
+    int c;
+    for (c = 0; c < MAX_PENDING_CHUNKS; c++) {
+        if (chunk[c].out.buf) { free(chunk[c].out.buf); }
+        if (chunk[c].points.lat) { free(chunk[c].points.lat); }
+        if (chunk[c].points.lon) { free(chunk[c].points.lon); }
+    }
+    memset(chunk, 0, sizeof(chunk));
+    return err;
+    
+}
+
+// ----------------------------------------------------------------------------
+
 static void _usage(const char *pgm, int exitCode)
 {
     fprintf(stderr, "Usage: \n");
@@ -268,6 +799,19 @@ static void _usage(const char *pgm, int exitCode)
     fprintf(stderr, "    [-csv]         - output points in CSV format (default)\n");
     fprintf(stderr, "    [-gpx]         - output points in GPX format\n");
     fprintf(stderr, "    [-google]      - output points in XML format for Google Maps\n");
+    fprintf(stderr, "    [-distance]    - display total distance travelled (to stderr)\n");
+    fprintf(stderr, "    [-threads <n>] - number of parsing threads (default is the number of CPUs)\n");
+    fprintf(stderr, "    [-from <time>] - only events at/after time ('YYYY/MM/DD[,hh:mm:ss]' or epoch)\n");
+    fprintf(stderr, "    [-to <time>]   - only events at/before time ('YYYY/MM/DD[,hh:mm:ss]' or epoch)\n");
+    fprintf(stderr, "    [-code <code>[,<code>...]]\n");
+    fprintf(stderr, "                   - only events with status code (ie. '0xF020' or 'InMotion')\n");
+    fprintf(stderr, "    [-bbox <minLat>,<minLon>,<maxLat>,<maxLon>]\n");
+    fprintf(stderr, "                   - only events within bounding box\n");
+    fprintf(stderr, "    [-device <id>] - only events from device ('[<account>/]<device>', requires index)\n");
+    fprintf(stderr, "    [-noindex]     - do not use the file index ('<file>%s') for '-from/-to'\n", FIDX_FILE_EXT);
+    fprintf(stderr, "    [-columns <col>[,<col>...]]\n");
+    fprintf(stderr, "                   - CSV columns: date,time,code,latitude,longitude,speed,\n");
+    fprintf(stderr, "                     heading,altitude,distance,sequence,utc\n");
     fprintf(stderr, "\n");
     exit(exitCode);
 }
@@ -279,8 +823,9 @@ static void _usage(const char *pgm, int exitCode)
 // main entry point
 int main(int argc, char *argv[])
 {
-    const char *fileName = (char*)0;
-    int printFormat = FORMAT_CSV;
+    const char *fileName = (char*)0, *deviceID = (char*)0;
+    utBool useIndex = utTrue;
+    int workers = 0;
     setlocale(LC_ALL, "POSIX");
     setDebugMode(utTrue);
 
@@ -309,6 +854,78 @@ int main(int argc, char *argv[])
         } else
         if (strEquals(argv[i], "-google")) {
             printFormat = FORMAT_GOOGLE_XML;
+        } else
+        if (strEquals(argv[i], "-distance")) {
+            showDistance = utTrue;
+        } else
+        if (strEquals(argv[i], "-from") || strEquals(argv[i], "-to")) {
+            // -from <time>, -to <time>
+            utBool from = strEquals(argv[i], "-from");
+            i++;
+            UInt32 t = (i < argc)? _parseTime(argv[i], !from) : 0L;
+            if (t == 0L) {
+                fprintf(stderr, "Missing/invalid time ...\n");
+                _usage(argv[0], 1);
+            }
+            if (from) { filter.fromTime = t; } else { filter.toTime = t; }
+            filter.active = utTrue;
+        } else
+        if (strEquals(argv[i], "-code")) {
+            // -code <code>[,<code>...]
+            i++;
+            if ((i >= argc) || !_parseCodes(argv[i])) {
+                fprintf(stderr, "Missing/invalid status code ...\n");
+                _usage(argv[0], 1);
+            }
+            filter.active = utTrue;
+        } else
+        if (strEquals(argv[i], "-bbox")) {
+            // -bbox <minLat>,<minLon>,<maxLat>,<maxLon>
+            char buf[128], *v[4];
+            i++;
+            strncpy(buf, ((i < argc)? argv[i] : ""), sizeof(buf) - 1);
+            buf[sizeof(buf) - 1] = 0;
+            if (strParseArray_sep(buf, v, 4, ',') != 4) {
+                fprintf(stderr, "Missing/invalid bounding box ...\n");
+                _usage(argv[0], 1);
+            }
+            filter.minLat = strParseDouble(v[0], 0.0);
+            filter.minLon = strParseDouble(v[1], 0.0);
+            filter.maxLat = strParseDouble(v[2], 0.0);
+            filter.maxLon = strParseDouble(v[3], 0.0);
+            filter.bbox   = utTrue;
+            filter.active = utTrue;
+        } else
+        if (strEquals(argv[i], "-device")) {
+            // -device [<account>/]<device>
+            i++;
+            if ((i < argc) && (*argv[i] != '-')) {
+                deviceID = argv[i];
+            } else {
+                fprintf(stderr, "Missing device ...\n");
+                _usage(argv[0], 1);
+            }
+        } else
+        if (strEquals(argv[i], "-noindex")) {
+            useIndex = utFalse;
+        } else
+        if (strEquals(argv[i], "-columns")) {
+            // -columns <col>[,<col>...]
+            i++;
+            if ((i >= argc) || !setCSVColumns(argv[i])) {
+                fprintf(stderr, "Missing/invalid columns ...\n");
+                _usage(argv[0], 1);
+            }
+        } else
+        if (strEquals(argv[i], "-threads")) {
+            // -threads <n>
+            i++;
+            if ((i < argc) && isdigit(*argv[i])) {
+                workers = (int)strParseUInt32(argv[i], 0L);
+            } else {
+                fprintf(stderr, "Missing thread count ...\n");
+                _usage(argv[0], 1);
+            }
         } else {
             fprintf(stderr, "Invalid option: %s\n", argv[i]);
             _usage(argv[0], 1);
@@ -320,64 +937,75 @@ int main(int argc, char *argv[])
         _usage(argv[0], 1);
     }
     
+    /* device selection requires the index */
+    if (deviceID && !useIndex) {
+        fprintf(stderr, "'-device' requires the file index\n");
+        _usage(argv[0], 1);
+    }
+
     /* open file */
     if (!parseOpen(fileName)) {
         exit(1);
     }
+    fileData = parseGetData(&fileDataLen);
+
+    /* file ranges */
+    // (the index locates the device/time range without reading the rest of the file)
+    static FileRange_t range[MAX_FILE_RANGES];
+    int rangeCount = -1;
+    if (useIndex && (deviceID || filter.fromTime || filter.toTime)) {
+        rangeCount = fidxQuery(fileName, fileDataLen, deviceID, filter.fromTime, filter.toTime, range, MAX_FILE_RANGES);
+        if ((rangeCount < 0) && deviceID) {
+            fprintf(stderr, "Missing/invalid index file: %s%s\n", fileName, FIDX_FILE_EXT);
+            parseClose();
+            exit(1);
+        }
+    }
+    if (rangeCount < 0) {
+        range[0].start = 0L;
+        range[0].end   = fileDataLen;
+        rangeCount = 1;
+    }
     
     /* header */
-    switch (printFormat) {
-        case FORMAT_CSV:
-            printCSV(MODE_HEADER, (Event_t*)0);
-            break;
-        case FORMAT_GPX:
-            printGPX(MODE_HEADER, (Event_t*)0);
-            break;
-        case FORMAT_GOOGLE_XML:
-            printGoogleXML(MODE_HEADER, (Event_t*)0);
-            break;
-    } 
+    OutBuffer_t out;
+    memset(&out, 0, sizeof(out));
+    printRecord(&out, MODE_HEADER, (Event_t*)0);
+    outWrite(&out);
 
-    /* read packets */
-    Packet_t _packet, *pkt = &_packet;
-    while (utTrue) {
-        int err = parseReadPacket(pkt);
-        if (err != SRVERR_OK) { break; }
-        Event_t er;
-        if (evParseEventPacket(pkt, &er)) {
-
-            /* data record */
-            switch (printFormat) {
-                case FORMAT_CSV:
-                    printCSV(MODE_DATA, &er);
-                    break;
-                case FORMAT_GPX:
-                    printGPX(MODE_DATA, &er);
-                    break;
-                case FORMAT_GOOGLE_XML:
-                    printGoogleXML(MODE_DATA, &er);
-                    break;
-            } 
-            
-        } else {
-            
-            //fprintf(stderr, "Skipping non-Event [%04X] ...\n", pkt->hdrType);
-            
+    /* fields required for the output (CSV only) */
+    UInt8 csvMask[256/8];
+    if (printFormat == FORMAT_CSV) {
+        memset(csvMask, 0, sizeof(csvMask));
+        for (i = 0; i < csvSelectCount; i++) {
+            evSetMaskField(csvMask, csvColumn[csvSelect[i]].field);
+        }
+        if (showDistance) {
+            evSetMaskField(csvMask, FIELD_GPS_POINT);
         }
+        fieldMask = csvMask;
+    }
+
+    /* read packets */
+    threadInitialize();
+    int err = _parseFile(workers, range, rangeCount);
+    if ((err == SRVERR_CHECKSUM_FAILED) || (err == SRVERR_PARSE_ERROR)) {
+        fprintf(stderr, "Packet parse error: %d\n", err);
+    } else
+    if ((err != SRVERR_OK) && (err != SRVERR_TIMEOUT)) {
+        fprintf(stderr, "Packet read error: %d\n", err);
     }
     
     /* footer */
-    switch (printFormat) {
-        case FORMAT_CSV:
-            printCSV(MODE_FOOTER, (Event_t*)0);
-            break;
-        case FORMAT_GPX:
-            printGPX(MODE_FOOTER, (Event_t*)0);
-            break;
-        case FORMAT_GOOGLE_XML:
-            printGoogleXML(MODE_FOOTER, (Event_t*)0);
-            break;
-    } 
+    printRecord(&out, MODE_FOOTER, (Event_t*)0);
+    outWrite(&out);
+    if (out.buf) { free(out.buf); }
+    parseClose();
+    
+    /* distance summary */
+    if (showDistance) {
+        printDistance();
+    }
     
     /* end of output */
     return 0;
@@ -18,6 +18,9 @@
 // ----------------------------------------------------------------------------
 // Description:
 //  Read/Parse DMTP packets from a file buffer.
+//  The file is mapped into memory, and packets may be parsed from any packet
+//  boundary (see 'parseSyncPacket'), so that regions of the file may be parsed
+//  in parallel.
 // ---
 // Change History:
 //  2006/07/13  Martin D. Flynn
@@ -32,6 +35,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#if !defined(TARGET_WINCE)
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#endif
 
 #include "tools/stdtypes.h"
 #include "tools/strtools.h"
@@ -46,13 +54,29 @@
 
 // ----------------------------------------------------------------------------
 
-static FILE *parseFile = (FILE*)0;
+/* maximum ASCII encoded packet length (including the '$' header) */
+#define PARSE_MAX_ASCII_LENGTH      600
+
+/* number of consecutive valid packets required to resync at an arbitrary offset */
+#define PARSE_SYNC_COUNT            4
+
+// ----------------------------------------------------------------------------
+// The file is mapped into memory (or read into a buffer where mapping is not
+// available) so that separate threads may parse separate regions of the file.
+
+static utBool       parseFileOpen   = utFalse;
+static UInt8        *parseData      = (UInt8*)0;
+static long         parseDataLen    = 0L;
+static long         parseOffset     = 0L;
+#if !defined(TARGET_WINCE)
+static utBool       parseMapped     = utFalse;
+#endif
 
 // ----------------------------------------------------------------------------
 
 utBool parseIsOpen()
 {
-    return (parseFile)? utTrue : utFalse;
+    return parseFileOpen;
 }
 
 utBool parseOpen(const char *fileName)
@@ -65,12 +89,44 @@ utBool parseOpen(const char *fileName)
         parseClose();
     }
     
-    /* open */
-    parseFile = ioOpenStream(fileName, IO_OPEN_READ);
-    if (!parseFile) {
+    /* file size */
+    long fileSize = ioGetFileSize(fileName, -1);
+    if (fileSize < 0L) {
         fprintf(stderr, "Unable to open file\n");
         return utFalse;
     }
+    
+    /* map/read file */
+    parseData    = (UInt8*)0;
+    parseDataLen = 0L;
+    parseOffset  = 0L;
+    if (fileSize > 0L) {
+#if defined(TARGET_WINCE)
+        parseData = (UInt8*)malloc(fileSize);
+        if (!parseData || (ioReadFile(fileName, parseData, fileSize) != fileSize)) {
+            fprintf(stderr, "Unable to read file\n");
+            if (parseData) { free(parseData); }
+            parseData = (UInt8*)0;
+            return utFalse;
+        }
+#else
+        int fd = open(fileName, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "Unable to open file\n");
+            return utFalse;
+        }
+        void *m = mmap((void*)0, (size_t)fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping remains valid
+        if (m == MAP_FAILED) {
+            fprintf(stderr, "Unable to map file\n");
+            return utFalse;
+        }
+        parseData   = (UInt8*)m;
+        parseMapped = utTrue;
+#endif
+        parseDataLen = fileSize;
+    }
+    parseFileOpen = utTrue;
 
     /* return successful */
     return utTrue;
@@ -80,107 +136,121 @@ utBool parseOpen(const char *fileName)
 utBool parseClose()
 {
     if (parseIsOpen()) {
-        ioCloseStream(parseFile);
-        parseFile = (FILE*)0;
+        if (parseData) {
+#if defined(TARGET_WINCE)
+            free(parseData);
+#else
+            if (parseMapped) { munmap((void*)parseData, (size_t)parseDataLen); }
+            parseMapped = utFalse;
+#endif
+        }
+        parseData     = (UInt8*)0;
+        parseDataLen  = 0L;
+        parseOffset   = 0L;
+        parseFileOpen = utFalse;
         return utTrue;
     } else {
         return utFalse;
     }
 }
 
-// ----------------------------------------------------------------------------
-
-static long _parseRead(UInt8 *buf, int bufLen)
+/* return the file data (valid until 'parseClose') */
+const UInt8 *parseGetData(long *dataLen)
 {
-    
-    /* no data was requested */
-    if (bufLen == 0) {
-        fprintf(stderr, "NULL buffer");
-        return 0;
-    }
-    
-    /* port open? */
-    if (!parseIsOpen()) {
-        fprintf(stderr, "Parse file not open!!!");
-        return -1;
-    }
-    
-    /* return bytes read */
-    long readLen = 0;
-    readLen = ioReadStream(parseFile, buf, bufLen);
-    return readLen;
-    
+    if (dataLen) { *dataLen = parseDataLen; }
+    return parseData;
 }
 
-static int _parseReadPacketBuffer(UInt8 *buf, int bufLen)
+// ----------------------------------------------------------------------------
+
+/* return the length of the packet at 'ofs' (including any terminating '\r') */
+// (errors are the same as those previously returned when reading the file stream)
+static long _parsePacketLength(const UInt8 *data, long dataLen, long ofs, int *err)
 {
-    UInt8 *b = buf;
-    long readLen = 0, len;
+    const UInt8 *buf = data + ofs;
+    long avail = dataLen - ofs;
     
     /* read header */
-    // This will read the header/type/length of a binary encoded packet, or
-    // the '$' and 2 ASCII hex digits of an ASCII encoded packet.
-    len = _parseRead(b, PACKET_HEADER_LENGTH);
-    if (len < 0) {
-        return SRVERR_TRANSPORT_ERROR;
+    // This is the header/type/length of a binary encoded packet, or the '$' and 
+    // 2 ASCII hex digits of an ASCII encoded packet.
+    if (avail <= 0L) {
+        // eof
+        *err = SRVERR_TIMEOUT;
+        return -1L;
     } else
-    if (len == 0) {
-        // timeout/eof
-        return SRVERR_TIMEOUT;
+    if (avail < PACKET_HEADER_LENGTH) {
+        // partial packet
+        *err = SRVERR_TRANSPORT_ERROR;
+        return -1L;
     }
 
-    /* make sure entire header has been read */
-    if (len < PACKET_HEADER_LENGTH) {
-        // partial packet read (just close socket)
-        return SRVERR_TRANSPORT_ERROR;
+    /* payload */
+    *err = SRVERR_OK;
+    if (buf[0] == PACKET_ASCII_ENCODING_CHAR) {
+        // ASCII encoded, terminated by '\r'
+        long maxLen = (avail < PARSE_MAX_ASCII_LENGTH)? avail : PARSE_MAX_ASCII_LENGTH;
+        const UInt8 *eol = (const UInt8*)memchr(buf + PACKET_HEADER_LENGTH, PACKET_ASCII_ENCODING_EOL, maxLen - PACKET_HEADER_LENGTH);
+        if (eol) {
+            return (eol - buf) + 1L;
+        } else
+        if (avail < PARSE_MAX_ASCII_LENGTH) {
+            // eof (partial packet)
+            *err = SRVERR_TIMEOUT;
+            return -1L;
+        } else {
+            // overflow - unlikely
+            *err = SRVERR_PACKET_LENGTH;
+            return -1L;
+        }
+    } else {
+        long len = PACKET_HEADER_LENGTH + (long)buf[PACKET_HEADER_LENGTH - 1];
+        if (len > avail) {
+            // partial packet
+            *err = SRVERR_TRANSPORT_ERROR;
+            return -1L;
+        }
+        return len;
     }
-    b += PACKET_HEADER_LENGTH;
     
-    /* read payload */
-    if (buf[0] == PACKET_ASCII_ENCODING_CHAR) {
-        // ASCII encoded, read until '\r'
-        for (; (b - buf) < bufLen; b++) {
-            len = _parseRead(b, 1);
-            if (len < 0) {
-                return SRVERR_TRANSPORT_ERROR;
-            } else
-            if (len == 0) {
-                // timeout (partial packet read)
-                return SRVERR_TIMEOUT;
-            }
-            if (*b == PACKET_ASCII_ENCODING_EOL) {
-                *b = 0;
+}
+
+/* return the offset of the first packet at, or after, 'ofs' */
+// A packet start is accepted if it is followed by PARSE_SYNC_COUNT valid packets
+// (or valid packets up to the end of the data).  ASCII packets must also follow
+// a '\r', since a '$' cannot otherwise appear in an encoded packet.
+long parseSyncPacket(const UInt8 *data, long dataLen, long ofs)
+{
+    long q;
+    if (ofs <= 0L) {
+        return 0L;
+    }
+    for (q = ofs; q < dataLen; q++) {
+        if (data[q] == PACKET_ASCII_ENCODING_CHAR) {
+            if (data[q - 1] != PACKET_ASCII_ENCODING_EOL) { continue; }
+        } else
+        if (data[q] != PACKET_HEADER_BASIC) {
+            continue;
+        }
+        long p = q;
+        int k, err = SRVERR_OK;
+        for (k = 0; (k < PARSE_SYNC_COUNT) && (p < dataLen); k++) {
+            if ((data[p] != PACKET_ASCII_ENCODING_CHAR) && (data[p] != PACKET_HEADER_BASIC)) {
+                err = SRVERR_PARSE_ERROR;
                 break;
             }
+            long len = _parsePacketLength(data, dataLen, p, &err);
+            if (len < 0L) { break; }
+            p += len;
         }
-        if ((b - buf) < bufLen) {
-            readLen = (b - buf);
-        } else {
-            // overflow (just close socket) - unlikely
-            return SRVERR_PACKET_LENGTH;
-        }
-    } else
-    if (buf[PACKET_HEADER_LENGTH - 1] != 0) {
-        // read 'b[2]' bytes
-        UInt16 payloadLen = (UInt16)buf[PACKET_HEADER_LENGTH - 1];
-        len = _parseRead(b, payloadLen);
-        if (len < 0) {
-            return SRVERR_TRANSPORT_ERROR;
-        }
-        if (len < payloadLen) {
-            // timeout / transport-error (partial packet read)
-            return SRVERR_TRANSPORT_ERROR;
+        if (err == SRVERR_OK) {
+            return q;
         }
-        readLen = PACKET_HEADER_LENGTH + len;
-    } else {
-        readLen = PACKET_HEADER_LENGTH;
     }
-    
-    /* return length */
-    return SRVERR_OK;
-    
+    return dataLen;
 }
 
+// ----------------------------------------------------------------------------
+
 static int _parseParsePacket(Packet_t *pkt, const UInt8 *pktBuf)
 {
     
@@ -214,12 +284,20 @@ static int _parseParsePacket(Packet_t *pkt, const UInt8 *pktBuf)
                 if (pktBufLen > 6) { // $E0FF:XXXX...
                     // encoded character, plus data
                     if (pktBuf[5] == ENCODING_BASE64_CHAR) {
-                        int len = (UInt8)base64Decode(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
-                        pkt->dataLen = (len >= 0)? (UInt8)len : 0;
+                        int len = (int)base64Decode(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
+                        if (len < 0) {
+                            // invalid Base64 data (or too long): ERROR_PACKET_PAYLOAD
+                            return SRVERR_PARSE_ERROR;
+                        }
+                        pkt->dataLen = (UInt8)len;
                     } else
                     if (pktBuf[5] == ENCODING_HEX_CHAR) {
-                        int len = (UInt8)strParseHex(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
-                        pkt->dataLen = (len >= 0)? (UInt8)len : 0;
+                        int len = strParseHex(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
+                        if ((len * 2) != (pktBufLen - 6)) {
+                            // invalid hex data (odd length, or too long): ERROR_PACKET_PAYLOAD
+                            return SRVERR_PARSE_ERROR;
+                        }
+                        pkt->dataLen = (UInt8)len;
                     } else
                     if (pktBuf[5] == ENCODING_CSV_CHAR) {
                         // unsupported encoding: ERROR_PACKET_ENCODING
@@ -260,25 +338,117 @@ static int _parseParsePacket(Packet_t *pkt, const UInt8 *pktBuf)
     return SRVERR_OK;
 }
 
+/* parse the packet at '*ofs', and advance '*ofs' to the following packet */
+// This may be called by separate threads for separate regions of the data.
+int parseNextPacket(const UInt8 *data, long dataLen, long *ofs, Packet_t *pkt)
+{
+    int err = SRVERR_OK;
+    
+    /* packet length */
+    long len = _parsePacketLength(data, dataLen, *ofs, &err);
+    if (len < 0L) {
+        return err;
+    }
+    
+    /* parse packet */
+    const UInt8 *pktBuf = data + *ofs;
+    if (*pktBuf == PACKET_ASCII_ENCODING_CHAR) {
+        // null-terminated copy ('\r' is replaced with '0')
+        UInt8 buf[PARSE_MAX_ASCII_LENGTH];
+        memcpy(buf, pktBuf, len - 1);
+        buf[len - 1] = 0;
+        err = _parseParsePacket(pkt, buf);
+    } else {
+        err = _parseParsePacket(pkt, pktBuf);
+    }
+    if (err == SRVERR_OK) {
+        *ofs += len;
+    }
+    return err;
+    
+}
+
+/* decode the header, and up to 'payloadLen' bytes of the payload, of the packet at 'ofs' */
+// Returns the number of payload bytes decoded, or -1 if the packet could not be
+// decoded.  The packet is not validated ('parseNextPacket' reports any errors).
+// This allows a packet to be filtered without parsing the entire payload.
+int parsePeekPacket(const UInt8 *data, long dataLen, long ofs, 
+    ClientPacketType_t *hdrType, UInt8 *payload, int payloadLen, long *pktLen)
+{
+    int err = SRVERR_OK;
+    
+    /* packet length */
+    long len = _parsePacketLength(data, dataLen, ofs, &err);
+    if (len < 0L) {
+        return -1;
+    }
+    if (pktLen) { *pktLen = len; }
+    
+    /* header/payload */
+    const UInt8 *pktBuf = data + ofs;
+    if (*pktBuf == PACKET_ASCII_ENCODING_CHAR) {
+        UInt8 hdr[2];
+        long textLen = len - 1L; // without '\r'
+        if ((textLen < 5L) || (strParseHex(pktBuf + 1, 4, hdr, sizeof(hdr)) != 2)) {
+            return -1;
+        }
+        *hdrType = CLIENT_HEADER_TYPE(hdr[0],hdr[1]);
+        if ((payloadLen <= 0) || (textLen <= 6L)) {
+            return 0;
+        }
+        const UInt8 *cs = (const UInt8*)memchr(pktBuf + 6, '*', textLen - 6L);
+        int encLen = (int)((cs? (cs - pktBuf) : textLen) - 6L); // without checksum
+        if (pktBuf[5] == ENCODING_HEX_CHAR) {
+            return strParseHex(pktBuf + 6, encLen, payload, payloadLen);
+        } else
+        if (pktBuf[5] == ENCODING_BASE64_CHAR) {
+            UInt8 buf[PACKET_MAX_PAYLOAD_LENGTH + 3];
+            int b64Len = ((payloadLen + 2) / 3) * 4;
+            if (b64Len > encLen) { b64Len = encLen; }
+            int n = (int)base64Decode(pktBuf + 6, b64Len, buf, sizeof(buf));
+            if (n < 0) {
+                return -1;
+            }
+            if (n > payloadLen) { n = payloadLen; }
+            memcpy(payload, buf, n);
+            return n;
+        } else {
+            return -1;
+        }
+    } else
+    if (*pktBuf == PACKET_HEADER_BASIC) {
+        int n = (int)pktBuf[PACKET_HEADER_LENGTH - 1];
+        *hdrType = CLIENT_HEADER_TYPE(pktBuf[0],pktBuf[1]);
+        if (n > payloadLen) { n = (payloadLen > 0)? payloadLen : 0; }
+        if (n > 0) {
+            memcpy(payload, pktBuf + PACKET_HEADER_LENGTH, n);
+        }
+        return n;
+    } else {
+        return -1;
+    }
+    
+}
+
 int parseReadPacket(Packet_t *pkt)
 {
-    UInt8 buf[600];
     
-    /* read client packet */
-    int err = _parseReadPacketBuffer(buf, sizeof(buf));
+    /* file open? */
+    if (!parseIsOpen()) {
+        fprintf(stderr, "Parse file not open!!!");
+        return SRVERR_TRANSPORT_ERROR;
+    }
+    
+    /* read/parse next packet */
+    int err = parseNextPacket(parseData, parseDataLen, &parseOffset, pkt);
     if (err == SRVERR_TIMEOUT) {
         // eof
-        return err;
+    } else
+    if ((err == SRVERR_CHECKSUM_FAILED) || (err == SRVERR_PARSE_ERROR)) {
+        fprintf(stderr, "Packet parse error: %d\n", err);
     } else
     if (err != SRVERR_OK) {
         fprintf(stderr, "Packet read error: %d\n", err);
-        return err;
-    }
-    
-    /* parse packet */
-    err = _parseParsePacket(pkt, buf);
-    if (err != SRVERR_OK) {
-        fprintf(stderr, "Packet parse error: %d\n", err);
     }
     return err;
 
@@ -39,6 +39,12 @@ utBool parseIsOpen();
 utBool parseOpen(const char *fileName);
 utBool parseClose();
 
+const UInt8 *parseGetData(long *dataLen);
+long parseSyncPacket(const UInt8 *data, long dataLen, long ofs);
+int parseNextPacket(const UInt8 *data, long dataLen, long *ofs, Packet_t *pkt);
+int parsePeekPacket(const UInt8 *data, long dataLen, long ofs, 
+    ClientPacketType_t *hdrType, UInt8 *payload, int payloadLen, long *pktLen);
+
 int parseReadPacket(Packet_t *pkt);
 
 // ----------------------------------------------------------------------------
@@ -228,9 +228,11 @@ enum ClientErrors_enum {
     //      Invalid speficied upload file offset
     // Payload:
     //      0:2 - This error code
+    //      2:3 - The file offset received so far
     // Notes:
     //      Sent to the server when the specified data offset leaves a gap between this
-    //      and the previous record.
+    //      and the previous record.  The upload is not cancelled, the server resends
+    //      the data from the specified offset.
 
     ERROR_UPLOAD_OFFSET_OVERFLOW        = 0xF414,
     // Description:
@@ -34,20 +34,25 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <math.h>
 
 #include "tools/stdtypes.h"
 #include "tools/strtools.h"
 #include "tools/base64.h"
 #include "tools/checksum.h"
 #include "tools/io.h"
+#include "tools/gpstools.h"
+#include "tools/threads.h"
 
 #include "base/props.h"
+#include "base/statcode.h"
 
 #include "server/upload.h"
 #include "server/packet.h"
 #include "server/protocol.h"
 #include "server/log.h"
 #include "server/server.h"
+#include "server/events.h"
 #include "server/geozone.h"
 
 // ----------------------------------------------------------------------------
@@ -113,6 +118,96 @@ static void _printGeozone(ServerGeozone_t *gz)
 }
 #endif
 
+/* read the next geozone record (or directive) from the file */
+static char *_readGeozoneRecord(FILE *file, char *zoneRecord, int zoneRecordLen, int *line)
+{
+    for (;;) {
+        (*line)++;
+        
+        /* read line from file */
+        int len = ioReadLine(file, zoneRecord, zoneRecordLen);
+        if (len <= 0) {
+            // EOF / read error
+            return (char*)0;
+        }
+
+        /* trim record */
+        char *zr = strTrim(zoneRecord);
+
+        /* ignore blank records and comments */
+        if (!*zr || (*zr == '#')) {
+            // ignore blank records and comments
+            continue;
+        }
+        
+        /* scan for trailing comments */
+        char *c = zr;
+        while (*c && (*c != '#')) { c++; }
+        if (*c == '#') {
+            // trailing comment found
+            *c = 0;
+        }
+        return zr;
+        
+    }
+}
+
+/* parse and validate a geozone record */
+static utBool _parseGeozone(char *zr, ServerGeozone_t *gz, int line)
+{
+    
+    /* parse record */
+    // zoneID,type,radius,lat0,lon0,lat1,lon1
+    char *zoneFld[16];
+    strParseArray(zr, zoneFld, 10);
+    gz->zoneID = (GeoZoneID_t)strParseUInt32(zoneFld[0], (UInt32)NO_ZONE);
+    gz->type   = (UInt16)(strParseUInt32(zoneFld[1], GEOF_DUAL_POINT_RADIUS) & 0x7);
+    gz->radius = (UInt16)(strParseUInt32(zoneFld[2], 300L) & 0x1FFF); // meters
+    gz->pt[0].latitude  = strParseDouble(zoneFld[3],  0.0);
+    gz->pt[0].longitude = strParseDouble(zoneFld[4],  0.0);
+    gz->pt[1].latitude  = strParseDouble(zoneFld[5],  0.0);
+    gz->pt[1].longitude = strParseDouble(zoneFld[6],  0.0);
+
+    /* validate zone */
+    if (gz->zoneID <= 0) {
+        // NO_ZONE ids are not allowed
+        logERROR(LOGSRC,"[line %d] Invalid ZoneID (must be greater than 0)", line);
+        return utFalse;
+    } else
+    if ((gz->type != 0) && (gz->type != 1)) {
+        // invalid type
+        logERROR(LOGSRC,"[line %d] Invalid Zone type (must be either '0' or '1')", line);
+        return utFalse;
+    } else
+    if ((gz->radius <= 0) || (gz->radius > 0x1FFF)) {
+        // this will only occur if radius is 0, since the size is already bounded
+        logERROR(LOGSRC,"[line %d] Invalid radius (must be > 0 and <= 8191)", line);
+        return utFalse;
+    } else
+    if ((gz->pt[0].latitude == 0.0) && (gz->pt[0].longitude == 0.0) && (gz->type != 0)) {
+        // type==0 is the only type that can have a zero Lat/Lng.
+        logERROR(LOGSRC,"[line %d] Invalid Lat/Lng for specified type (first point)", line);
+        return utFalse;
+    } else
+    if ((gz->pt[1].latitude == 0.0) && (gz->pt[1].longitude == 0.0) && (gz->type != 0)) {
+        // type==0 is the only type that can have a zero Lat/Lng.
+        logERROR(LOGSRC,"[line %d] Invalid Lat/Lng for specified type (second point)", line);
+        return utFalse;
+    } else
+    if (((gz->pt[0].latitude != 0.0) || (gz->pt[0].longitude != 0.0)) && !gpsPointIsValid(&(gz->pt[0]))) {
+        // (90 > Lat > -90) or (180 > Lng > -180) range test failed
+        logERROR(LOGSRC,"[line %d] Invalid Lat/Lng (first point)", line);
+        return utFalse;
+    } else
+    if (((gz->pt[1].latitude != 0.0) || (gz->pt[1].longitude != 0.0)) && !gpsPointIsValid(&(gz->pt[1]))) {
+        // (90 > Lat > -90) or (180 > Lng > -180) range test failed
+        logERROR(LOGSRC,"[line %d] Invalid Lat/Lng (second point)", line);
+        return utFalse;
+    }
+    return utTrue;
+    
+}
+
 /* parse and upload geozones to client */
 static UInt16 _uploadFile(const char *geozFile, utBool performUpload)
 {
@@ -148,34 +243,16 @@ static UInt16 _uploadFile(const char *geozFile, utBool performUpload)
     int line = 0;
     int usedZones = 0;
     utBool autoSave = utTrue;
-    char zoneRecord[80], *zoneFld[16];
+    char zoneRecord[80];
     for (;;) {
-        line++;
         
-        /* read line from file */
-        int len = ioReadLine(file, zoneRecord, sizeof(zoneRecord));
-        if (len <= 0) {
+        /* read next record */
+        char *zr = _readGeozoneRecord(file, zoneRecord, sizeof(zoneRecord), &line);
+        if (!zr) {
             // EOF / read error
             logINFO(LOGSRC,"[line %d] EOF: %s", line, geozFile);
             break;
         }
-
-        /* trim record */
-        char *zr = strTrim(zoneRecord);
-
-        /* ignore blank records and comments */
-        if (!*zr || (*zr == '#')) {
-            // ignore blank records and comments
-            continue;
-        }
-        
-        /* scan for trailing comments */
-        char *c = zr;
-        while (*c && (*c != '#')) { c++; }
-        if (*c == '#') {
-            // trailing comment found
-            *c = 0;
-        }
         logINFO(LOGSRC,"[line %d] %s", line, zr);
 
         /* execute directives: "@CLEAR", "@VERSION", "@SAVE", "@NOSAVE" */
@@ -222,56 +299,14 @@ static UInt16 _uploadFile(const char *geozFile, utBool performUpload)
         }
 
         /* parse record */
-        // zoneID,type,radius,lat0,lon0,lat1,lon1
-        strParseArray(zr, zoneFld, 10);
         ServerGeozone_t geozData, *gz = &geozData; // &geozList[usedZones];
-        gz->zoneID = (GeoZoneID_t)strParseUInt32(zoneFld[0], (UInt32)NO_ZONE);
-        gz->type   = (UInt16)(strParseUInt32(zoneFld[1], GEOF_DUAL_POINT_RADIUS) & 0x7);
-        gz->radius = (UInt16)(strParseUInt32(zoneFld[2], 300L) & 0x1FFF); // meters
-        gz->pt[0].latitude  = strParseDouble(zoneFld[3],  0.0);
-        gz->pt[0].longitude = strParseDouble(zoneFld[4],  0.0);
-        gz->pt[1].latitude  = strParseDouble(zoneFld[5],  0.0);
-        gz->pt[1].longitude = strParseDouble(zoneFld[6],  0.0);
+        if (!_parseGeozone(zr, gz, line)) {
+            // error already displayed
+            continue;
+        }
 #ifdef PRINT_GEOZONE
         _printGeozone(gz);
 #endif
-
-        /* validate zone */
-        if (gz->zoneID <= 0) {
-            // NO_ZONE ids are not allowed
-            logERROR(LOGSRC,"[line %d] Invalid ZoneID (must be greater than 0)", line);
-            continue;
-        } else
-        if ((gz->type != 0) && (gz->type != 1)) {
-            // invalid type
-            logERROR(LOGSRC,"[line %d] Invalid Zone type (must be either '0' or '1')", line);
-            continue;
-        } else
-        if ((gz->radius <= 0) || (gz->radius > 0x1FFF)) {
-            // this will only occur if radius is 0, since the size is already bounded
-            logERROR(LOGSRC,"[line %d] Invalid radius (must be > 0 and <= 8191)", line);
-            continue;
-        } else
-        if ((gz->pt[0].latitude == 0.0) && (gz->pt[0].longitude == 0.0) && (gz->type != 0)) {
-            // type==0 is the only type that can have a zero Lat/Lng.
-            logERROR(LOGSRC,"[line %d] Invalid Lat/Lng for specified type (first point)", line);
-            continue;
-        } else
-        if ((gz->pt[1].latitude == 0.0) && (gz->pt[1].longitude == 0.0) && (gz->type != 0)) {
-            // type==0 is the only type that can have a zero Lat/Lng.
-            logERROR(LOGSRC,"[line %d] Invalid Lat/Lng for specified type (second point)", line);
-            continue;
-        } else
-        if (((gz->pt[0].latitude != 0.0) || (gz->pt[0].longitude != 0.0)) && !gpsPointIsValid(&(gz->pt[0]))) {
-            // (90 > Lat > -90) or (180 > Lng > -180) range test failed
-            logERROR(LOGSRC,"[line %d] Invalid Lat/Lng (first point)", line);
-            continue;
-        } else
-        if (((gz->pt[1].latitude != 0.0) || (gz->pt[1].longitude != 0.0)) && !gpsPointIsValid(&(gz->pt[1]))) {
-            // (90 > Lat > -90) or (180 > Lng > -180) range test failed
-            logERROR(LOGSRC,"[line %d] Invalid Lat/Lng (second point)", line);
-            continue;
-        }
         
         /* count zone */
         usedZones++;
@@ -322,5 +357,689 @@ utBool geozUploadGeozones(const char *file)
     return _uploadFile(file, utTrue);
 }
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+// Server-side geozone arrival/departure evaluation
+// This provides the same arrival/departure semantics as the client module 
+// "modules/geozone.c" (including the arrival/departure delays and the 'set-back'
+// of the generated event to the point where the boundary crossing was detected),
+// but is evaluated on the server against the events received from all clients.
+// This is intended for clients which do not support geozones, or for zone sets
+// which are too large to upload to the client.
+// Zones are indexed in a uniform lat/lon grid so that each event is only checked
+// against the few zones located in the same grid cell.  Zones which would occupy
+// too many grid cells are checked on every event.  Grid columns wrap at +/-180
+// degrees, so that radius zones crossing the 180th meridian are found from either side.
+// The current zone and pending arrival/departure state is maintained per device.
+// Generated arrival/departure events are passed to the event handler after the
+// evaluation lock has been released (the handler typically writes to a file).
+
+// grid cell size (degrees)
+#define GEOZ_GRID_DEGREES       0.05
+#define GEOZ_GRID_ROWS          ((UInt32)(180.0 / GEOZ_GRID_DEGREES) + 1L)
+#define GEOZ_GRID_COLS          ((UInt32)((360.0 / GEOZ_GRID_DEGREES) + 0.5)) // wraps at +/-180
+
+// zones requiring more than this number of cells are placed in the 'large' list
+#define GEOZ_GRID_MAX_CELLS     1024L
+
+// approximate meters per degree of latitude
+#define METERS_PER_DEGREE       (EARTH_RADIUS_METERS * RADIANS)
+
+// true if arrival/departure should be set-back to actual arrival/departure point
+#define SETBACK_POINT           (utTrue)
+
+#define IS_VALID_ZONE(Z)        ((Z) != NO_ZONE)
+#define NO_CELL_KEY             ((UInt32)0xFFFFFFFFL)
+
+/* grid cell: zone indexes are stored in 'evalCellZones[first..first+count-1]' */
+typedef struct {
+    UInt32                  key;        // (row * GEOZ_GRID_COLS) + col
+    UInt32                  first;      // first index into 'evalCellZones'
+    UInt32                  count;      // number of zones in this cell
+    UInt32                  lastZone;   // last zone added (prevents duplicates)
+} GeozCell_t;
+
+/* saved point of a pending arrival/departure */
+typedef struct {
+    GPSPoint_t              point;
+    UInt32                  fixtime;    // 0 if not pending
+    UInt32                  timestamp;
+    double                  speedKPH;
+    double                  heading;
+    double                  altitude;
+} GeozFix_t;
+
+/* arrival/departure events generated by a single check */
+// (collected while the evaluation lock is held, and passed to the handler afterwards)
+typedef struct {
+    int                     count;
+    Event_t                 event[2];   // departure, arrival
+} GeozEvents_t;
+
+/* per-device geozone state */
+typedef struct {
+    char                    key[(MAX_ID_SIZE + 1) * 2];
+    GeoZoneID_t             curZoneID;
+    GeozFix_t               arrive;
+    GeozFix_t               depart;
+} GeozDevice_t;
+
+static threadMutex_t            evalMutex;
+static utBool                   evalMutexInit       = utFalse;
+#define EVAL_LOCK               MUTEX_LOCK(&evalMutex);
+#define EVAL_UNLOCK             MUTEX_UNLOCK(&evalMutex);
+
+static ServerGeozone_t          *evalZones          = (ServerGeozone_t*)0;
+static UInt32                   evalZoneCount       = 0L;
+static GeozCell_t               *evalCells          = (GeozCell_t*)0;
+static UInt32                   evalCellSize        = 0L; // power of 2
+static UInt32                   evalCellUsed        = 0L;
+static UInt32                   *evalCellZones      = (UInt32*)0;
+static UInt32                   *evalLargeZones     = (UInt32*)0;
+static UInt32                   evalLargeCount      = 0L;
+
+static GeozDevice_t             *evalDevices        = (GeozDevice_t*)0;
+static UInt32                   evalDeviceSize      = 0L; // power of 2
+static UInt32                   evalDeviceCount     = 0L;
+
+static UInt32                   evalArriveDelay     = 0L;
+static UInt32                   evalDepartDelay     = 0L;
+
+static protEventCallbackFtn_t   evalEventHandler    = 0;
+
+// ----------------------------------------------------------------------------
+
+/* hash a 32-bit value */
+static UInt32 _geozHash32(UInt32 k)
+{
+    k = (k ^ 61L) ^ (k >> 16);
+    k = (k + (k << 3)) & 0xFFFFFFFFL;
+    k = k ^ (k >> 4);
+    k = (k * 0x27D4EB2DL) & 0xFFFFFFFFL;
+    k = k ^ (k >> 15);
+    return k;
+}
+
+/* hash a string (FNV-1a) */
+static UInt32 _geozHashString(const char *s)
+{
+    UInt32 h = 2166136261L;
+    for (; *s; s++) {
+        h = ((h ^ (UInt8)*s) * 16777619L) & 0xFFFFFFFFL;
+    }
+    return h;
+}
+
+/* return the smallest power of 2 which is >= 'n' */
+static UInt32 _geozPow2(UInt32 n)
+{
+    UInt32 p = 16L;
+    while (p < n) { p <<= 1; }
+    return p;
+}
+
+// ----------------------------------------------------------------------------
+
+/* return grid row for latitude */
+static UInt32 _geozGridRow(double lat)
+{
+    if (lat <= -90.0) { return 0L; }
+    if (lat >=  90.0) { return GEOZ_GRID_ROWS - 1L; }
+    return (UInt32)((lat + 90.0) / GEOZ_GRID_DEGREES);
+}
+
+/* return grid column for longitude (not wrapped, see '_geozWrapCol') */
+// A zone box which crosses +/-180 degrees extends beyond the range of columns.
+static Int32 _geozGridCol(double lon)
+{
+    return (Int32)floor((lon + 180.0) / GEOZ_GRID_DEGREES);
+}
+
+/* wrap grid column into the range [0..GEOZ_GRID_COLS-1] */
+static UInt32 _geozWrapCol(Int32 col)
+{
+    Int32 c = col % (Int32)GEOZ_GRID_COLS;
+    return (UInt32)((c < 0L)? (c + (Int32)GEOZ_GRID_COLS) : c);
+}
+
+/* return the (unwrapped) grid column range of a box, at most one full turn */
+static void _geozGridCols(const GPSPoint_t box[2], Int32 *c0, Int32 *c1)
+{
+    *c0 = _geozGridCol(box[0].longitude);
+    *c1 = _geozGridCol(box[1].longitude);
+    if ((*c1 - *c0) >= (Int32)GEOZ_GRID_COLS) {
+        *c1 = *c0 + (Int32)GEOZ_GRID_COLS - 1L;
+    }
+}
+
+/* find (or add) the specified cell */
+static GeozCell_t *_geozGetCell(UInt32 key, utBool add)
+{
+    UInt32 mask = evalCellSize - 1L, h = _geozHash32(key) & mask;
+    for (;; h = (h + 1L) & mask) {
+        GeozCell_t *cell = &evalCells[h];
+        if (cell->key == key) {
+            return cell;
+        } else
+        if (cell->key == NO_CELL_KEY) {
+            if (add) {
+                cell->key = key;
+                evalCellUsed++;
+                return cell;
+            }
+            return (GeozCell_t*)0;
+        }
+    }
+}
+
+/* allocate an empty cell table */
+static GeozCell_t *_geozAllocCells(UInt32 size)
+{
+    GeozCell_t *cells = (GeozCell_t*)malloc(size * sizeof(GeozCell_t));
+    if (cells) {
+        UInt32 i;
+        for (i = 0; i < size; i++) {
+            cells[i].key = NO_CELL_KEY;
+            cells[i].first = cells[i].count = cells[i].lastZone = 0L;
+        }
+    }
+    return cells;
+}
+
+/* double the size of the cell table (keep load factor below 70%) */
+static utBool _geozGrowCells()
+{
+    UInt32 oldSize = evalCellSize, i;
+    GeozCell_t *oldCells = evalCells;
+    GeozCell_t *newCells = _geozAllocCells(oldSize * 2L);
+    if (!newCells) {
+        return utFalse;
+    }
+    evalCells = newCells;
+    evalCellSize = oldSize * 2L;
+    evalCellUsed = 0L;
+    for (i = 0; i < oldSize; i++) {
+        if (oldCells[i].key != NO_CELL_KEY) {
+            GeozCell_t *cell = _geozGetCell(oldCells[i].key, utTrue);
+            memcpy(cell, &oldCells[i], sizeof(GeozCell_t));
+        }
+    }
+    free(oldCells);
+    return utTrue;
+}
+
+/* bounding box of a zone component: [0]=south/west, [1]=north/east */
+static int _geozBounds(const ServerGeozone_t *gz, GPSPoint_t box[2][2])
+{
+    int n = 0, p;
+    if (gz->type == GEOF_BOUNDED_RECT) {
+        // pt[0] is NorthWest, pt[1] is SouthEast
+        gpsPoint(&box[0][0], gz->pt[1].latitude, gz->pt[0].longitude);
+        gpsPoint(&box[0][1], gz->pt[0].latitude, gz->pt[1].longitude);
+        n = 1;
+    } else {
+        // GEOF_DUAL_POINT_RADIUS: one box for each valid point
+        double dLat = (double)gz->radius / METERS_PER_DEGREE;
+        for (p = 0; p < 2; p++) {
+            const GPSPoint_t *pt = &(gz->pt[p]);
+            if (gpsPointIsValid(pt)) {
+                double cosLat = cos(pt->latitude * RADIANS);
+                double dLon = (cosLat > 0.01)? (dLat / cosLat) : 360.0;
+                gpsPoint(&box[n][0], pt->latitude - dLat, pt->longitude - dLon);
+                gpsPoint(&box[n][1], pt->latitude + dLat, pt->longitude + dLon);
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+/* index zone into the grid ('fill' is false on the counting pass) */
+static utBool _geozIndexZone(UInt32 zn, utBool fill)
+{
+    const ServerGeozone_t *gz = &evalZones[zn];
+    GPSPoint_t box[2][2];
+    int b, n = _geozBounds(gz, box);
+
+    /* too many cells? */
+    UInt32 cellCount = 0L;
+    for (b = 0; b < n; b++) {
+        Int32 c0, c1;
+        _geozGridCols(box[b], &c0, &c1);
+        UInt32 rows = _geozGridRow(box[b][1].latitude) - _geozGridRow(box[b][0].latitude) + 1L;
+        cellCount += rows * (UInt32)(c1 - c0 + 1L);
+    }
+    if ((n == 0) || (cellCount > GEOZ_GRID_MAX_CELLS)) {
+        if (fill) {
+            evalLargeZones[evalLargeCount] = zn;
+        }
+        evalLargeCount++;
+        return utTrue;
+    }
+
+    /* add to each cell */
+    for (b = 0; b < n; b++) {
+        UInt32 r, r0 = _geozGridRow(box[b][0].latitude), r1 = _geozGridRow(box[b][1].latitude);
+        Int32 c, c0, c1;
+        _geozGridCols(box[b], &c0, &c1);
+        for (r = r0; r <= r1; r++) {
+            for (c = c0; c <= c1; c++) {
+                if (!fill && ((evalCellUsed * 10L) >= (evalCellSize * 7L)) && !_geozGrowCells()) {
+                    return utFalse;
+                }
+                GeozCell_t *cell = _geozGetCell((r * GEOZ_GRID_COLS) + _geozWrapCol(c), !fill);
+                if (cell->count && (cell->lastZone == zn)) {
+                    continue; // already in this cell (overlapping dual-point boxes)
+                }
+                if (fill) {
+                    evalCellZones[cell->first + cell->count] = zn;
+                }
+                cell->count++;
+                cell->lastZone = zn;
+            }
+        }
+    }
+    return utTrue;
+
+}
+
+/* rebuild the grid index */
+static utBool _geozBuildIndex()
+{
+    UInt32 i, zn;
+
+    /* release old index */
+    free(evalCells);     evalCells      = (GeozCell_t*)0;
+    free(evalCellZones); evalCellZones  = (UInt32*)0;
+    free(evalLargeZones);evalLargeZones = (UInt32*)0;
+    evalCellSize = 0L;
+    evalCellUsed = 0L;
+    evalLargeCount = 0L;
+    if (evalZoneCount == 0L) {
+        return utTrue;
+    }
+
+    /* cell table (counting pass) */
+    // a typical small zone occupies 1 to 4 cells
+    evalCellSize = _geozPow2(evalZoneCount * 4L);
+    evalCells = _geozAllocCells(evalCellSize);
+    if (!evalCells) {
+        logERROR(LOGSRC,"Unable to allocate geozone grid");
+        evalCellSize = 0L;
+        return utFalse;
+    }
+    for (zn = 0; zn < evalZoneCount; zn++) {
+        if (!_geozIndexZone(zn, utFalse)) {
+            logERROR(LOGSRC,"Unable to allocate geozone grid");
+            return utFalse;
+        }
+    }
+
+    /* assign cell offsets */
+    UInt32 total = 0L;
+    for (i = 0; i < evalCellSize; i++) {
+        if (evalCells[i].key != NO_CELL_KEY) {
+            evalCells[i].first = total;
+            total += evalCells[i].count;
+            evalCells[i].count = 0L;
+        }
+    }
+
+    /* fill pass */
+    evalCellZones  = (UInt32*)malloc((total + 1L) * sizeof(UInt32));
+    evalLargeZones = (UInt32*)malloc((evalLargeCount + 1L) * sizeof(UInt32));
+    if (!evalCellZones || !evalLargeZones) {
+        logERROR(LOGSRC,"Unable to allocate geozone grid");
+        return utFalse;
+    }
+    evalLargeCount = 0L;
+    for (zn = 0; zn < evalZoneCount; zn++) {
+        _geozIndexZone(zn, utTrue);
+    }
+    logINFO(LOGSRC,"Indexed %lu Geozones [cells=%lu, entries=%lu, large=%lu]", 
+        evalZoneCount, evalCellUsed, total, evalLargeCount);
+    return utTrue;
+
+}
+
+// ----------------------------------------------------------------------------
+
+/* return true if the point is inside the specified zone */
+static utBool _geozInZone(const ServerGeozone_t *gz, const GPSPoint_t *gp)
+{
+    // same tests as the client "modules/geozone.c"
+    int p;
+    switch (gz->type) {
+        case GEOF_DUAL_POINT_RADIUS:
+            for (p = 0; p < 2; p++) {
+                if (gpsPointIsValid(&(gz->pt[p]))) {
+                    // quick latitude rejection before the haversine calculation
+                    double dLat = fabs(gp->latitude - gz->pt[p].latitude) * METERS_PER_DEGREE;
+                    if ((dLat <= (double)gz->radius) && 
+                        (gpsMetersToPoint(gp, &(gz->pt[p])) <= (double)gz->radius)) {
+                        return utTrue;
+                    }
+                }
+            }
+            return utFalse;
+        case GEOF_BOUNDED_RECT:
+            // (will fail if zone spans +/- 180 degrees)
+            if (gp->latitude  > gz->pt[0].latitude ) { return utFalse; } // North of top
+            if (gp->latitude  < gz->pt[1].latitude ) { return utFalse; } // South of bottom
+            if (gp->longitude < gz->pt[0].longitude) { return utFalse; } // West of left
+            if (gp->longitude > gz->pt[1].longitude) { return utFalse; } // East of right
+            return utTrue;
+    }
+    return utFalse;
+}
+
+/* return the first zone (in file order) which contains the specified point */
+static const ServerGeozone_t *_geozFindZone(const GPSPoint_t *gp)
+{
+    UInt32 i, found = evalZoneCount;
+
+    /* zones in the same grid cell (in ascending order) */
+    if (evalCellSize > 0L) {
+        UInt32 key = (_geozGridRow(gp->latitude) * GEOZ_GRID_COLS) + _geozWrapCol(_geozGridCol(gp->longitude));
+        GeozCell_t *cell = _geozGetCell(key, utFalse);
+        if (cell) {
+            const UInt32 *zl = &evalCellZones[cell->first];
+            for (i = 0; i < cell->count; i++) {
+                if (_geozInZone(&evalZones[zl[i]], gp)) {
+                    found = zl[i];
+                    break;
+                }
+            }
+        }
+    }
+
+    /* large zones */
+    for (i = 0; (i < evalLargeCount) && (evalLargeZones[i] < found); i++) {
+        if (_geozInZone(&evalZones[evalLargeZones[i]], gp)) {
+            found = evalLargeZones[i];
+            break;
+        }
+    }
+
+    return (found < evalZoneCount)? &evalZones[found] : (ServerGeozone_t*)0;
+}
+
+// ----------------------------------------------------------------------------
+
+/* find (or add) the specified device */
+static GeozDevice_t *_geozGetDevice(const char *key, utBool *isNew)
+{
+
+    /* grow table (keep load factor below 70%) */
+    if (((evalDeviceCount + 1L) * 10L) >= (evalDeviceSize * 7L)) {
+        UInt32 oldSize = evalDeviceSize, newSize = _geozPow2(evalDeviceSize * 2L), i;
+        GeozDevice_t *oldDev = evalDevices;
+        GeozDevice_t *newDev = (GeozDevice_t*)malloc(newSize * sizeof(GeozDevice_t));
+        if (!newDev) {
+            logERROR(LOGSRC,"Unable to allocate geozone device table");
+            return (GeozDevice_t*)0;
+        }
+        memset(newDev, 0, newSize * sizeof(GeozDevice_t));
+        for (i = 0; i < oldSize; i++) {
+            if (*oldDev[i].key) {
+                UInt32 h = _geozHashString(oldDev[i].key) & (newSize - 1L);
+                while (*newDev[h].key) { h = (h + 1L) & (newSize - 1L); }
+                memcpy(&newDev[h], &oldDev[i], sizeof(GeozDevice_t));
+            }
+        }
+        free(oldDev);
+        evalDevices = newDev;
+        evalDeviceSize = newSize;
+    }
+
+    /* find device */
+    UInt32 mask = evalDeviceSize - 1L, h = _geozHashString(key) & mask;
+    for (;; h = (h + 1L) & mask) {
+        GeozDevice_t *dev = &evalDevices[h];
+        if (!*dev->key) {
+            strncpy(dev->key, key, sizeof(dev->key) - 1);
+            evalDeviceCount++;
+            *isNew = utTrue;
+            return dev;
+        } else
+        if (strEquals(dev->key, key)) {
+            *isNew = utFalse;
+            return dev;
+        }
+    }
+
+}
+
+/* save event point */
+static void _geozSaveFix(GeozFix_t *fix, const Event_t *ev)
+{
+    gpsPointCopy(&(fix->point), &(ev->gpsPoint[0]));
+    fix->timestamp = ev->timestamp[0];
+    fix->fixtime   = (ev->timestamp[0] > ev->gpsAge)? (ev->timestamp[0] - ev->gpsAge) : ev->timestamp[0];
+    if (fix->fixtime == 0L) { fix->fixtime = 1L; } // must be non-zero
+    fix->speedKPH  = ev->speedKPH;
+    fix->heading   = ev->heading;
+    fix->altitude  = ev->altitude;
+}
+
+/* generate an arrival/departure event */
+static void _geozQueueEvent(GeozEvents_t *gevs, UInt16 code, const GeozFix_t *fix, const Event_t *ev, GeoZoneID_t zoneID)
+{
+    if (evalEventHandler && (gevs->count < 2)) {
+        Event_t *gev = &(gevs->event[gevs->count++]);
+        memcpy(gev, ev, sizeof(Event_t));
+        gev->statusCode = code;
+        gev->geofenceID[0] = (UInt32)zoneID;
+        if (SETBACK_POINT && fix) {
+            gpsPointCopy(&(gev->gpsPoint[0]), &(fix->point));
+            gev->timestamp[0] = fix->timestamp;
+            gev->gpsAge       = fix->timestamp - fix->fixtime;
+            gev->speedKPH     = fix->speedKPH;
+            gev->heading      = fix->heading;
+            gev->altitude     = fix->altitude;
+        }
+    }
+}
+
+/* check device state against new event (same logic as 'geozCheckGPS' on the client) */
+static void _geozCheckDevice(GeozEvents_t *gevs, GeozDevice_t *dev, const Event_t *ev, GeoZoneID_t newZoneID)
+{
+    GeoZoneID_t curZoneID = dev->curZoneID;
+    UInt32 nowSec = ev->timestamp[0];
+    
+    /* GeoZone changed? */
+    // Only trigger an arrival/departure if we're moving from inside the CURRENT zone 
+    // to outside ALL zones, or from outside ALL zones to inside ANY zone.
+    if (IS_VALID_ZONE(curZoneID) == IS_VALID_ZONE(newZoneID)) {
+        // state has not changed
+        dev->arrive.fixtime = 0L;
+        dev->depart.fixtime = 0L;
+        return;
+    }
+
+    /* check departure */
+    if (IS_VALID_ZONE(curZoneID)) {
+        if (dev->depart.fixtime == 0L) {
+            // This is the first 'departure' event
+            _geozSaveFix(&(dev->depart), ev);
+        }
+        if ((evalDepartDelay == 0L) || ((dev->depart.fixtime + evalDepartDelay) <= nowSec)) {
+            _geozQueueEvent(gevs, STATUS_GEOFENCE_DEPART, &(dev->depart), ev, curZoneID);
+            dev->curZoneID = NO_ZONE;
+            dev->depart.fixtime = 0L;
+        }
+    } else {
+        dev->depart.fixtime = 0L;
+    }
+
+    /* check arrival */
+    if (IS_VALID_ZONE(newZoneID)) {
+        if (dev->arrive.fixtime == 0L) {
+            // This is the first 'arrival' event
+            _geozSaveFix(&(dev->arrive), ev);
+        }
+        if ((evalArriveDelay == 0L) || ((dev->arrive.fixtime + evalArriveDelay) <= nowSec)) {
+            dev->curZoneID = newZoneID;
+            _geozQueueEvent(gevs, STATUS_GEOFENCE_ARRIVE, &(dev->arrive), ev, newZoneID);
+            dev->arrive.fixtime = 0L;
+        }
+    } else {
+        dev->arrive.fixtime = 0L;
+    }
+
+}
+
+// ----------------------------------------------------------------------------
+
+/* set the handler which receives generated arrival/departure events */
+void geozSetEvalEventHandler(protEventCallbackFtn_t ftn)
+{
+    evalEventHandler = ftn;
+}
+
+/* set arrival/departure delays (seconds) */
+void geozSetEvalDelays(UInt32 arriveSec, UInt32 departSec)
+{
+    evalArriveDelay = arriveSec;
+    evalDepartDelay = departSec;
+}
+
+/* load the server-side evaluation zones (same file format as the upload file) */
+int geozLoadEvalGeozones(const char *geozFile)
+{
+    
+    /* init lock */
+    if (!evalMutexInit) {
+        threadMutexInit(&evalMutex);
+        evalMutexInit = utTrue;
+    }
+
+    /* open file */
+    if (!geozFile || !*geozFile) {
+        logERROR(LOGSRC,"Geozone file not specified");
+        return -1;
+    }
+    FILE *file = ioOpenStream(geozFile, IO_OPEN_READ);
+    if (!file) {
+        logERROR(LOGSRC,"Error openning file: %s", geozFile);
+        return -1;
+    }
+
+    /* read zones */
+    // directives are ignored here
+    UInt32 maxZones = 1024L, count = 0L;
+    ServerGeozone_t *zones = (ServerGeozone_t*)malloc(maxZones * sizeof(ServerGeozone_t));
+    int line = 0;
+    char zoneRecord[80], *zr;
+    while (zones && (zr = _readGeozoneRecord(file, zoneRecord, sizeof(zoneRecord), &line))) {
+        if (*zr == '@') {
+            continue;
+        }
+        if (count >= maxZones) {
+            ServerGeozone_t *z = (ServerGeozone_t*)realloc(zones, (maxZones * 2L) * sizeof(ServerGeozone_t));
+            if (!z) { 
+                free(zones);
+                zones = (ServerGeozone_t*)0;
+                break;
+            }
+            zones = z;
+            maxZones *= 2L;
+        }
+        ServerGeozone_t *gz = &zones[count];
+        if (_parseGeozone(zr, gz, line)) {
+            if ((gz->type == GEOF_DUAL_POINT_RADIUS) && !gpsPointIsValid(&(gz->pt[0]))) {
+                // move the valid point into point[0] (as the client does)
+                gpsPointCopy(&(gz->pt[0]), &(gz->pt[1]));
+                gpsPointClear(&(gz->pt[1]));
+            } else
+            if (gz->type == GEOF_BOUNDED_RECT) {
+                // move larger latitude/smaller longitude to point[0] (as the client does)
+                double tmp;
+                if (gz->pt[0].latitude < gz->pt[1].latitude) {
+                    tmp = gz->pt[0].latitude;
+                    gz->pt[0].latitude = gz->pt[1].latitude;
+                    gz->pt[1].latitude = tmp;
+                }
+                if (gz->pt[0].longitude > gz->pt[1].longitude) {
+                    tmp = gz->pt[0].longitude;
+                    gz->pt[0].longitude = gz->pt[1].longitude;
+                    gz->pt[1].longitude = tmp;
+                }
+            }
+            count++;
+        }
+    }
+    ioCloseStream(file);
+    if (!zones) {
+        logERROR(LOGSRC,"Unable to allocate geozones: %s", geozFile);
+        return -1;
+    }
+
+    /* install zones */
+    utBool ok = utFalse;
+    EVAL_LOCK {
+        free(evalZones);
+        evalZones = zones;
+        evalZoneCount = count;
+        ok = _geozBuildIndex();
+        if (!ok) {
+            free(evalZones);
+            evalZones = (ServerGeozone_t*)0;
+            evalZoneCount = 0L;
+            _geozBuildIndex();
+        }
+    } EVAL_UNLOCK
+    logINFO(LOGSRC,"Loaded %lu evaluation Geozones: %s", count, geozFile);
+    return ok? (int)count : -1;
+
+}
+
+/* evaluate the event against the loaded zones for the specified device */
+// The generated arrival/departure events are passed to the handler set with 
+// 'geozSetEvalEventHandler' (with a null packet).
+void geozCheckEvent(const char *accountID, const char *deviceID, const Event_t *ev)
+{
+    
+    /* nothing to check? */
+    if (!ev || !evalMutexInit || !gpsPointIsValid(&(ev->gpsPoint[0]))) {
+        return;
+    }
+    
+    /* ignore client generated (and our own) arrival/departure events */
+    if ((ev->statusCode == STATUS_GEOFENCE_ARRIVE) || (ev->statusCode == STATUS_GEOFENCE_DEPART)) {
+        return;
+    }
+
+    /* device key */
+    char key[(MAX_ID_SIZE + 1) * 2];
+    snprintf(key, sizeof(key), "%s/%s", (accountID?accountID:""), (deviceID?deviceID:""));
+
+    GeozEvents_t gevs;
+    gevs.count = 0;
+    EVAL_LOCK {
+        const ServerGeozone_t *gz = _geozFindZone(&(ev->gpsPoint[0]));
+        GeoZoneID_t newZoneID = gz? gz->zoneID : NO_ZONE;
+        utBool isNew = utFalse;
+        GeozDevice_t *dev = _geozGetDevice(key, &isNew);
+        if (!dev) {
+            // unable to allocate
+        } else
+        if (isNew) {
+            // The first event received for this device only establishes the current
+            // zone (the device state prior to this event is unknown).
+            dev->curZoneID = newZoneID;
+        } else {
+            _geozCheckDevice(&gevs, dev, ev, newZoneID);
+        }
+    } EVAL_UNLOCK
+
+    /* dispatch generated events (the handler may write to files, etc) */
+    int i;
+    for (i = 0; (i < gevs.count) && evalEventHandler; i++) {
+        (*evalEventHandler)((Packet_t*)0, &(gevs.event[i]));
+    }
+
+}
+
 // ----------------------------------------------------------------------------
 #endif // INCLUDE_GEOZONE
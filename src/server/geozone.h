@@ -22,6 +22,8 @@
 
 #include "server/defaults.h"
 #include "server/server.h"
+#include "server/events.h"
+#include "server/protocol.h"
 
 #if defined(INCLUDE_GEOZONE)
 //#warning Including GeoZone support
@@ -66,6 +68,14 @@ utBool geozUploadGeozones(const char *file);
 void geozSetGeozoneFile(const char *file);
 void geozUploadGeozonesNow();
 
+// ----------------------------------------------------------------------------
+// server-side arrival/departure evaluation
+
+int geozLoadEvalGeozones(const char *file);
+void geozSetEvalDelays(UInt32 arriveSec, UInt32 departSec);
+void geozSetEvalEventHandler(protEventCallbackFtn_t ftn);
+void geozCheckEvent(const char *accountID, const char *deviceID, const Event_t *ev);
+
 // ----------------------------------------------------------------------------
 
 #endif // INCLUDE_GEOZONE
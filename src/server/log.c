@@ -18,6 +18,8 @@
 // ----------------------------------------------------------------------------
 // Description:
 //  Debug/Info logging.
+//  Per-category levels, per-second sampling of the per-packet/per-event categories,
+//  and optional asynchronous output (see 'logStartThread').
 // ---
 // Change History:
 //  2006/01/04  Martin D. Flynn
@@ -36,6 +38,7 @@
 #include "tools/utctools.h"
 #include "tools/strtools.h"
 #include "tools/buffer.h"
+#include "tools/threads.h"
 #include "tools/io.h"
 
 #include "server/log.h"
@@ -47,6 +50,16 @@
 #define SUSPEND_BUFFER_SIZE         7000L
 #define MAX_LOG_STRING_SIZE         1000  // unlikely it will ever be this large
 
+// messages per second logged in the per-packet/per-event categories before the
+// remainder are suppressed (and counted)
+#define DEFAULT_SAMPLE_RATE         20L
+
+// asynchronous output queue
+#define ASYNC_BUFFER_SIZE           64000L
+#define ASYNC_WRITE_SIZE            4096
+#define ASYNC_NOTIFY_SIZE           (ASYNC_BUFFER_SIZE / 4)
+#define ASYNC_WRITE_DELAY_MS        100L  // maximum delay before queued output is written
+
 // ----------------------------------------------------------------------------
 
 /* extract the source file name from the full path (ie. from '__FILE__') */
@@ -74,10 +87,95 @@ const char *logSrcFile(const char *fn)
 
 // ----------------------------------------------------------------------------
 
+/* category levels */
+int logCategoryLevel[LOGCAT_COUNT] = {
+    LOGLVL_INFO,        // LOGCAT_SERVER
+    LOGLVL_INFO,        // LOGCAT_PACKET  (per-packet trace is off unless enabled)
+    LOGLVL_INFO,        // LOGCAT_EVENT
+};
+
+static const char *logCategoryName[LOGCAT_COUNT] = { "server", "packet", "event" };
+static const char *logLevelName[] = { "debug", "info", "warn", "error", "critical", "none" };
+static const char *logLevelType[] = { "DEBUG: ", "INFO: ", "WARN: ", "ERROR: ", "CRITICAL: " };
+
+/* category sampling */
+typedef struct {
+    UInt32      rate;       // maximum messages per second (0 for unlimited)
+    UInt32      second;     // current sampling second
+    UInt32      count;      // messages logged during 'second'
+    UInt32      dropped;    // messages suppressed during 'second'
+} LogSample_t;
+
+static LogSample_t logCategorySample[LOGCAT_COUNT] = {
+    { 0L,                  0L, 0L, 0L },    // LOGCAT_SERVER
+    { DEFAULT_SAMPLE_RATE, 0L, 0L, 0L },    // LOGCAT_PACKET
+    { DEFAULT_SAMPLE_RATE, 0L, 0L, 0L },    // LOGCAT_EVENT
+};
+
+static utBool               logDidInit = utFalse;
+static threadMutex_t        logSampleMutex;
+#define SAMPLE_LOCK         if (logDidInit) { MUTEX_LOCK(&logSampleMutex); }
+#define SAMPLE_UNLOCK       if (logDidInit) { MUTEX_UNLOCK(&logSampleMutex); }
+
+/* initialize (must be called before threads that log are created) */
+void logInitialize()
+{
+    if (!logDidInit) {
+        threadMutexInit(&logSampleMutex);
+        logDidInit = utTrue;
+    }
+}
+
+/* set category level */
+void logSetCategoryLevel(int cat, int level)
+{
+    if ((cat >= 0) && (cat < LOGCAT_COUNT)) {
+        if (level < LOGLVL_DEBUG) { level = LOGLVL_DEBUG; }
+        if (level > LOGLVL_NONE ) { level = LOGLVL_NONE;  }
+        logCategoryLevel[cat] = level;
+    }
+}
+
+/* set category sampling rate (messages per second, 0 for unlimited) */
+void logSetCategoryRate(int cat, UInt32 perSec)
+{
+    if ((cat >= 0) && (cat < LOGCAT_COUNT)) {
+        logCategorySample[cat].rate = perSec;
+    }
+}
+
+/* parse "<category>=<level>[:<rate>],..." (ie. "packet=debug:100,event=none") */
+utBool logParseCategoryLevels(const char *spec)
+{
+    char buf[128], *fld[LOGCAT_COUNT * 2];
+    int n, f;
+    strncpy(buf, (spec? spec : ""), sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = 0;
+    n = strParseArray_sep(buf, fld, sizeof(fld)/sizeof(fld[0]), ',');
+    for (f = 0; f < n; f++) {
+        char *cs = fld[f], *ls = strchr(cs, '='), *rs;
+        int cat, lvl;
+        if (!ls) { return utFalse; }
+        *ls++ = 0;
+        if ((rs = strchr(ls, ':')) != (char*)0) { *rs++ = 0; }
+        for (cat = 0; (cat < LOGCAT_COUNT) && !strEqualsIgnoreCase(cs, logCategoryName[cat]); cat++);
+        for (lvl = 0; (lvl <= LOGLVL_NONE) && !strEqualsIgnoreCase(ls, logLevelName[lvl]); lvl++);
+        if ((cat >= LOGCAT_COUNT) || (lvl > LOGLVL_NONE)) {
+            return utFalse;
+        }
+        logSetCategoryLevel(cat, lvl);
+        if (rs) {
+            logSetCategoryRate(cat, strParseUInt32(rs, logCategorySample[cat].rate));
+        }
+    }
+    return utTrue;
+}
+
+// ----------------------------------------------------------------------------
+
 /* maintain debug mode */
-static utBool _isDebugMode = utFalse;
-utBool isDebugMode() { return _isDebugMode; }
-void setDebugMode(utBool mode) { _isDebugMode = mode; }
+utBool isDebugMode() { return logIsEnabled(LOGCAT_SERVER, LOGLVL_DEBUG); }
+void setDebugMode(utBool mode) { logSetCategoryLevel(LOGCAT_SERVER, mode? LOGLVL_DEBUG : LOGLVL_INFO); }
 
 // ----------------------------------------------------------------------------
 // allow temporary suspension of logging
@@ -110,6 +208,152 @@ void logSetSuspend(utBool suspend)
 }
 #endif
 
+// ----------------------------------------------------------------------------
+// asynchronous output
+// Formatted messages are queued and written/flushed by a separate thread, so the
+// caller (typically the protocol thread) never blocks on the output stream.
+
+static utBool               logRunThread = utFalse;     // output thread loop
+static utBool               logQueueOutput = utFalse;   // messages are queued for the thread
+static threadThread_t       logThread;
+static threadMutex_t        logMutex;
+static threadCond_t         logCond;
+static struct timespec      logCondWaitTime;
+static CircleBuffer_t       *logQueue = (CircleBuffer_t*)0;
+static UInt32               logQueueDropCount = 0L;
+static utBool               logThreadWaiting = utFalse;
+#define LOG_LOCK            MUTEX_LOCK(&logMutex);
+#define LOG_UNLOCK          MUTEX_UNLOCK(&logMutex);
+#define LOG_WAIT(T)         CONDITION_TIMED_WAIT(&logCond,&logMutex,utcGetAbsoluteTimespec(&logCondWaitTime,(T)));
+#define LOG_NOTIFY          CONDITION_NOTIFY(&logCond);
+
+/* write the next block of queued output (returns bytes written) */
+static int _logWriteQueued(FILE *output)
+{
+    char b[ASYNC_WRITE_SIZE];
+    int n = 0;
+    LOG_LOCK {
+        n = bufferGetData(logQueue, b, sizeof(b));
+    } LOG_UNLOCK
+    if (n > 0) {
+        fwrite(b, 1, n, output);
+    }
+    return (n > 0)? n : 0;
+}
+
+/* thread main */
+// Output is written in batches.  The thread is only notified once a quarter of
+// the queue is in use, otherwise it writes whatever has been queued every
+// ASYNC_WRITE_DELAY_MS (waking for every message costs more than the write).
+static void _logThreadRunnable(void *arg)
+{
+    while (logRunThread) {
+
+        /* write everything queued, then flush */
+        while (_logWriteQueued(stdout) > 0);
+        ioFlushStream(stdout);
+
+        /* wait for more */
+        LOG_LOCK {
+            if (logRunThread && (bufferGetLength(logQueue) < ASYNC_NOTIFY_SIZE)) {
+                logThreadWaiting = utTrue;
+                LOG_WAIT(ASYNC_WRITE_DELAY_MS);
+                logThreadWaiting = utFalse;
+            }
+        } LOG_UNLOCK
+
+    }
+    threadExit();
+}
+
+/* stop the output thread, and write any queued output now */
+// Called at exit.  The thread is stopped before the queue is written, so that
+// queued output is written by one thread only (and in order).  Messages logged
+// after the queue has been written are output synchronously.
+void logFlush()
+{
+    if (logRunThread) {
+        LOG_LOCK {
+            logRunThread = utFalse;
+            LOG_NOTIFY
+        } LOG_UNLOCK
+        threadJoin(&logThread);
+    }
+    if (logQueueOutput) {
+        LOG_LOCK {
+            char b[ASYNC_WRITE_SIZE];
+            int n;
+            while ((n = bufferGetData(logQueue, b, sizeof(b))) > 0) {
+                fwrite(b, 1, n, stdout);
+            }
+            logQueueOutput = utFalse;
+        } LOG_UNLOCK
+    }
+    ioFlushStream(stdout);
+}
+
+/* start asynchronous output thread */
+utBool logStartThread()
+{
+
+    /* thread already running? */
+    if (logQueueOutput) {
+        return utTrue;
+    }
+
+    /* init */
+    threadMutexInit(&logMutex);
+    threadConditionInit(&logCond);
+    logQueue = bufferCreate(ASYNC_BUFFER_SIZE);
+    if (!logQueue) {
+        return utFalse;
+    }
+
+    /* create thread */
+    logRunThread = utTrue;
+    if (threadCreate(&logThread,&_logThreadRunnable,0,"ServerLog") == 0) {
+        // thread started successfully
+        logQueueOutput = utTrue;
+        atexit(&logFlush);
+        return utTrue;
+    } else {
+        logRunThread = utFalse;
+        return utFalse;
+    }
+
+}
+
+/* output a formatted message */
+static void _logOutput(FILE *output, const char *s, int sLen)
+{
+    utBool queued = utFalse;
+    if (logQueueOutput) {
+        LOG_LOCK {
+            if (logQueueOutput) { // (not yet stopped at exit)
+                if (logQueueDropCount > 0L) {
+                    // report dropped messages ahead of this message (once there is room)
+                    char d[80];
+                    sprintf(d, "WARN: %lu log messages dropped (output queue full)\n", logQueueDropCount);
+                    if (bufferPutData(logQueue, d, strlen(d)) > 0) {
+                        logQueueDropCount = 0L;
+                    }
+                }
+                if (bufferPutData(logQueue, s, sLen) < sLen) {
+                    logQueueDropCount++;
+                }
+                if (logThreadWaiting && (bufferGetLength(logQueue) >= ASYNC_NOTIFY_SIZE)) {
+                    LOG_NOTIFY
+                }
+                queued = utTrue;
+            }
+        } LOG_UNLOCK
+    }
+    if (!queued) {
+        fwrite(s, 1, sLen, output);  // check returned error codes?
+        ioFlushStream(output);
+    }
+}
+
 // ----------------------------------------------------------------------------
 
 static void _logVMsg(const UInt8 *ftn, int line, const char *type, const char *fmt, va_list ap)
@@ -167,19 +411,81 @@ static void _logVMsg(const UInt8 *ftn, int line, const char *type, const char *f
         return;
     }
 #endif
-    fprintf(output, "%s", strBuf);  // check returned error codes?
-#endif
+    _logOutput(output, strBuf, (int)(sb - strBuf));
+#else
     
     /* flush output */
     ioFlushStream(output);
+#endif
+
+}
+
+// ----------------------------------------------------------------------------
+
+/* return true if the next message in this category should be logged */
+// Messages beyond the category rate (per second) are suppressed, and a single
+// count of the suppressed messages is logged when the next second starts.
+utBool logSample(int cat)
+{
+    LogSample_t *ls;
+    UInt32 nowSec, dropped = 0L;
+    utBool sample = utTrue;
+    if ((cat < 0) || (cat >= LOGCAT_COUNT)) {
+        return utTrue;
+    }
+    ls = &logCategorySample[cat];
+    if (ls->rate == 0L) {
+        return utTrue;
+    }
+    nowSec = utcGetTimeSec();
+    SAMPLE_LOCK {
+        if (nowSec != ls->second) {
+            dropped     = ls->dropped;
+            ls->second  = nowSec;
+            ls->count   = 0L;
+            ls->dropped = 0L;
+        }
+        if (ls->count >= ls->rate) {
+            ls->dropped++;
+            sample = utFalse;
+        } else {
+            ls->count++;
+        }
+    } SAMPLE_UNLOCK
+    if (dropped > 0L) {
+        logINFO(LOGSRC,"(%lu '%s' messages suppressed)", dropped, logCategoryName[cat]);
+    }
+    return sample;
+}
+
+/* log a message at the specified level (the caller has already checked the level) */
+void logPrintf_(const char *ftn, int line, int level, const char *fmt, ...)
+{
+    if ((level >= LOGLVL_DEBUG) && (level < LOGLVL_NONE)) {
+        va_list ap;
+        va_start(ap, fmt);
+        _logVMsg((const UInt8*)ftn, line, logLevelType[level], fmt, ap);
+        va_end(ap);
+    }
+}
 
+/* log a message in the specified category */
+void logCategory_(int cat, int level, const char *ftn, int line, const char *fmt, ...)
+{
+    if ((cat >= 0) && (cat < LOGCAT_COUNT) && (level >= LOGLVL_DEBUG) && (level < LOGLVL_NONE) &&
+        logIsEnabled(cat,level) && logSample(cat)) {
+        va_list ap;
+        va_start(ap, fmt);
+        _logVMsg((const UInt8*)ftn, line, logLevelType[level], fmt, ap);
+        va_end(ap);
+    }
 }
 
 // ----------------------------------------------------------------------------
 
 void logDebug_(const UInt8 *ftn, int line, const char *fmt, ...)
 {
-    if (isDebugMode()) {
+    if (logIsEnabled(LOGCAT_SERVER,LOGLVL_DEBUG)) {
         va_list ap;
         va_start(ap, fmt);
         _logVMsg(ftn, line, "DEBUG: ", fmt, ap);
@@ -189,34 +495,42 @@ void logDebug_(const UInt8 *ftn, int line, const char *fmt, ...)
 
 void logInfo_(const UInt8 *ftn, int line, const char *fmt, ...)
 {
-    va_list ap;
-    va_start(ap, fmt);
-    _logVMsg(ftn, line, "INFO: ", fmt, ap);
-    va_end(ap);
+    if (logIsEnabled(LOGCAT_SERVER,LOGLVL_INFO)) {
+        va_list ap;
+        va_start(ap, fmt);
+        _logVMsg(ftn, line, "INFO: ", fmt, ap);
+        va_end(ap);
+    }
 }
 
 void logWarning_(const UInt8 *ftn, int line, const char *fmt, ...)
 {
-    va_list ap;
-    va_start(ap, fmt);
-    _logVMsg(ftn, line, "WARN: ", fmt, ap);
-    va_end(ap);
+    if (logIsEnabled(LOGCAT_SERVER,LOGLVL_WARNING)) {
+        va_list ap;
+        va_start(ap, fmt);
+        _logVMsg(ftn, line, "WARN: ", fmt, ap);
+        va_end(ap);
+    }
 }
 
 void logError_(const UInt8 *ftn, int line, const char *fmt, ...)
 {
-    va_list ap;
-    va_start(ap, fmt);
-    _logVMsg(ftn, line, "ERROR: ", fmt, ap);
-    va_end(ap);
+    if (logIsEnabled(LOGCAT_SERVER,LOGLVL_ERROR)) {
+        va_list ap;
+        va_start(ap, fmt);
+        _logVMsg(ftn, line, "ERROR: ", fmt, ap);
+        va_end(ap);
+    }
 }
 
 void logCritical_(const UInt8 *ftn, int line, const char *fmt, ...)
 {
-    va_list ap;
-    va_start(ap, fmt);
-    _logVMsg(ftn, line, "CRITICAL: ", fmt, ap);
-    va_end(ap);
+    if (logIsEnabled(LOGCAT_SERVER,LOGLVL_CRITICAL)) {
+        va_list ap;
+        va_start(ap, fmt);
+        _logVMsg(ftn, line, "CRITICAL: ", fmt, ap);
+        va_end(ap);
+    }
 }
 
 // ----------------------------------------------------------------------------
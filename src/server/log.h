@@ -28,7 +28,34 @@ const char *logSrcFile(const char *fn);
 
 // ----------------------------------------------------------------------------
 
+/* log levels */
+#define LOGLVL_DEBUG        0
+#define LOGLVL_INFO         1
+#define LOGLVL_WARNING      2
+#define LOGLVL_ERROR        3
+#define LOGLVL_CRITICAL     4
+#define LOGLVL_NONE         5
+
+/* log categories (each category has its own level and sampling rate) */
+#define LOGCAT_SERVER       0   // general server/protocol messages (logDEBUG, logINFO, ...)
+#define LOGCAT_PACKET       1   // per-packet trace ([RX]/[TX] packets, headers)
+#define LOGCAT_EVENT        2   // per-event messages
+#define LOGCAT_COUNT        3
+
+/* current category levels */
+// (checked inline so that disabled messages cost nothing more than a compare)
+extern int logCategoryLevel[LOGCAT_COUNT];
+#define logIsEnabled(C,L)   ((L) >= logCategoryLevel[(C)])
+
+void logSetCategoryLevel(int cat, int level);
+void logSetCategoryRate(int cat, UInt32 perSec);
+utBool logParseCategoryLevels(const char *spec);
+utBool logSample(int cat);
+
+// ----------------------------------------------------------------------------
+
 /* the logging module also maintains the debug mode */
+// (debug mode is the 'debug' level of the LOGCAT_SERVER category)
 utBool isDebugMode();
 void setDebugMode(utBool mode);
 
@@ -41,12 +68,24 @@ void setDebugMode(utBool mode);
 #define logERROR        logError_
 #define logCRITICAL     logCritical_
 #define logPRINTF       logPrintf_
+#define logCATEGORY     logCategory_
 
 void logDebug_(const UInt8 *ftn, int line, const char *fmt, ...);
 void logInfo_(const UInt8 *ftn, int line, const char *fmt, ...);
 void logWarning_(const UInt8 *ftn, int line, const char *fmt, ...);
 void logError_(const UInt8 *ftn, int line, const char *fmt, ...);
 void logCritical_(const UInt8 *ftn, int line, const char *fmt, ...);
+void logCategory_(int cat, int level, const char *ftn, int line, const char *fmt, ...);
+void logPrintf_(const char *ftn, int line, int level, const char *fmt, ...);
+
+// ----------------------------------------------------------------------------
+
+/* initialize (before threads are created) */
+void logInitialize();
+
+/* asynchronous output */
+utBool logStartThread();
+void logFlush();
 
 // ----------------------------------------------------------------------------
 
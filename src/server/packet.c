@@ -331,16 +331,20 @@ int pktEncodePacket(Buffer_t *dest, Packet_t *pkt, PacketEncoding_t encoding)
 /* print/log a packet */
 void pktPrintPacket(Packet_t *pkt, const char *msg, PacketEncoding_t encoding)
 {
+    // packet trace is off unless the 'packet' category is set to 'debug'
+    if (!logIsEnabled(LOGCAT_PACKET,LOGLVL_DEBUG) || !logSample(LOGCAT_PACKET)) {
+        return;
+    }
     UInt8 buf[PACKET_MAX_ENCODED_LENGTH];
     Buffer_t bb, *dest = binBuffer(&bb, buf, sizeof(buf), BUFFER_DESTINATION);
     if (!msg) { msg = ""; }
     int len = pktEncodePacket(dest, pkt, encoding);
     if (len >= 0) {
         if (*buf == PACKET_ASCII_ENCODING_CHAR) {
-            logDEBUG(LOGSRC,"%s %.*s [%d]", msg, len - 1, buf, len); 
+            logPRINTF(LOGSRC,LOGLVL_DEBUG,"%s %.*s [%d]", msg, len - 1, buf, len); 
         } else {
             UInt8 hex[PACKET_MAX_ENCODED_LENGTH];
-            logDEBUG(LOGSRC,"%s 0x%s [%d]", msg, strEncodeHex(hex, sizeof(hex), buf, len), len); 
+            logPRINTF(LOGSRC,LOGLVL_DEBUG,"%s 0x%s [%d]", msg, strEncodeHex(hex, sizeof(hex), buf, len), len); 
         }
     } else {
         logWARNING(LOGSRC,"%s <InvalidPacket> [%d]", msg, len);
@@ -77,6 +77,8 @@ static TimerSec_t lastEventTimer    = 0L;
 static utBool clientKeepAlive       = utTrue;   // utFalse
 static utBool clientSpeaksFirst     = utFalse;  // utTrue
 
+static UInt32 clientPersistIdleSec  = 0L;       // keep connection open between sessions
+
 // ----------------------------------------------------------------------------
 
 static utBool serverNeedsMoreInfo   = utFalse;
@@ -305,6 +307,14 @@ utBool protSetPropUInt8(UInt16 propKey, UInt8 val)
 
 static protEventCallbackFtn_t  ftnEventHandler = 0;
 
+/* keep the client connection open after End-Of-Transmission */
+// The connection is closed if the client does not start another session within
+// 'idleSec' seconds (0 to close after each session).
+void protocolSetPersistent(UInt32 idleSec)
+{
+    clientPersistIdleSec = idleSec;
+}
+
 void protocolSetEventHandler(protEventCallbackFtn_t ftn)
 {
     ftnEventHandler = ftn;
@@ -402,6 +412,7 @@ void protocolLoop(
     utBool cliSpeaksFirst)
 {
     TimerSec_t revokeSpeakFreelyTimer = 0L;
+    TimerSec_t sessionIdleTimer = 0L; // persistent connection idle since (0 if in session)
     UInt32 haveEvents = 0L;
     Packet_t packet, *pkt = &packet;
     utBool clientNeedsInit = utFalse;
@@ -432,8 +443,12 @@ void protocolLoop(
                 continue;
             }
             logINFO(LOGSRC,"Server port opened: %s", portName);
+            sessionIdleTimer = 0L;
             *clientAccountID = 0;
             *clientDeviceID = 0;
+#if defined(INCLUDE_UPLOAD)
+            uploadResume(); // an interrupted upload resumes from the client offset
+#endif
             revokeSpeakFreelyTimer = utcGetTimer();
             if (!clientSpeaksFirst) {
                 // If the client does not speak first, then we must nudge the client
@@ -460,10 +475,19 @@ void protocolLoop(
                 }
                 if (!rtn) {
                     logERROR(LOGSRC,"Upload failed!");
+                } else {
+                    // the client acknowledges the file record with the offset to start from
+                    serverWritePacketFmt(PKT_SERVER_EOB_DONE,"%1u",(UInt32)0L);
+                    isSpeakFreelyMode = utFalse;
                 }
                 pendingFileUpload = (char*)0;
                 pendingFileClient = (char*)0;
             } else
+            if (uploadCheck()) {
+                // upload resumed, or unacknowledged data resent
+                serverWritePacketFmt(PKT_SERVER_EOB_DONE,"%1u",(UInt32)0L);
+                isSpeakFreelyMode = utFalse;
+            } else
 #endif
             if (protHasPendingPackets()) {
                 logINFO(LOGSRC,"Sending pending packet during client keep-alive ...");
@@ -502,6 +526,13 @@ void protocolLoop(
         } else
         if (err == SRVERR_TIMEOUT) {
             // read timeout
+            if (sessionIdleTimer != 0L) {
+                // persistent connection, waiting for the next session
+                if (utcIsTimerExpired(sessionIdleTimer,clientPersistIdleSec)) {
+                    logINFO(LOGSRC,"Persistent connection idle timeout\n\n");
+                    serverClose();
+                }
+            } else
             if (!clientKeepAlive) {
                 serverWritePacketFmt(PKT_SERVER_EOT,"");
                 logINFO(LOGSRC,"End-Of-Transmission\n\n");
@@ -553,6 +584,17 @@ void protocolLoop(
         // reset timer when we hear from the client
         revokeSpeakFreelyTimer = utcGetTimer();
 
+        /* new session on a persistent connection */
+        if (sessionIdleTimer != 0L) {
+            logINFO(LOGSRC,"Persistent connection, new session");
+            sessionIdleTimer = 0L;
+            *clientAccountID = 0;
+            *clientDeviceID = 0;
+            clientNeedsInit = utTrue;
+            serverNeedsMoreInfo = utFalse;
+            isSpeakFreelyMode = utFalse;
+        }
+
         /* print received packet */
         pktPrintPacket(pkt, "[RX]", ENCODING_CSV);
         
@@ -614,6 +656,15 @@ void protocolLoop(
                 if (pkt->dataLen >= 2) {
                     UInt32 diagKey = 0L;
                     binScanf(pkt->data, pkt->dataLen, "%2x", &diagKey);
+#if defined(INCLUDE_UPLOAD)
+                    if ((diagKey == DIAG_UPLOAD_ACK) && uploadIsActive()) {
+                        // next upload window sent, the client must respond
+                        if (uploadHandleAck(pkt->data + 2, (UInt16)(pkt->dataLen - 2))) {
+                            serverNeedsMoreInfo = utTrue;
+                        }
+                        break;
+                    }
+#endif
                     protocolHandleDiag((UInt16)diagKey, pkt->data + 2, (UInt16)(pkt->dataLen - 2));
                 } else {
                     // invalid diagnostic packet (just ignore)
@@ -624,6 +675,13 @@ void protocolLoop(
                 if (pkt->dataLen >= 2) {
                     UInt32 errKey = 0L;
                     binScanf(pkt->data, pkt->dataLen, "%2x", &errKey);
+#if defined(INCLUDE_UPLOAD)
+                    if (((errKey & 0xFF00) == (ERROR_UPLOAD_TYPE & 0xFF00)) && uploadIsActive()) {
+                        if (uploadHandleError((UInt16)errKey, pkt->data + 2, (UInt16)(pkt->dataLen - 2))) {
+                            serverNeedsMoreInfo = utTrue;
+                        }
+                    }
+#endif
                     protocolHandleError((UInt16)errKey, pkt->data + 2, (UInt16)(pkt->dataLen - 2));
                 } else {
                     // invalid error packet (just ignore)
@@ -646,6 +704,14 @@ void protocolLoop(
                     haveEvents = 0;
                     lastEventTimer = 0L;
                 }
+#if defined(INCLUDE_UPLOAD)
+                if (((UInt16)pkt->hdrType == PKT_CLIENT_EOB_DONE) && uploadIsActive()) {
+                    // a file record not acknowledged in this block is followed by the rest of the file
+                    if (uploadHandleEOB()) {
+                        serverNeedsMoreInfo = utTrue;
+                    }
+                }
+#endif
                 if (clientNeedsInit) {
                     // send any desired client initialization
                     clientNeedsInit = utFalse;
@@ -677,7 +743,13 @@ void protocolLoop(
                     // client is finished, close socket
                     serverWritePacketFmt(PKT_SERVER_EOT,"");
                     logINFO(LOGSRC,"End-Of-Transmission\n\n");
-                    serverClose();
+                    if (clientPersistIdleSec > 0L) {
+                        // leave the connection open for the client's next session
+                        // (the EOT is sent before the next read)
+                        sessionIdleTimer = utcGetTimer();
+                    } else {
+                        serverClose();
+                    }
                 } else {
                     // client isn't done yet, tell client to continue
                     serverWritePacketFmt(PKT_SERVER_EOB_DONE,"");
@@ -32,6 +32,7 @@ typedef void (*protEventCallbackFtn_t)(Packet_t *pkt, Event_t *ev);
 
 // ----------------------------------------------------------------------------
 
+const char *protGetAccountID();
 const char *protGetDeviceID();
 
 // ----------------------------------------------------------------------------
@@ -64,6 +65,7 @@ void protocolLoop(
     utBool cliKeepAlive, 
     utBool cliSpeaksFirst);
     
+void protocolSetPersistent(UInt32 idleSec);
 void protocolSetEventHandler(protEventCallbackFtn_t ftn);
 void protocolSetClientInitHandler(protClientInitCallbackFtn_t ftn);
 void protocolSetPropertyHandler(protDataCallbackFtn_t ftn);
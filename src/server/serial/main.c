@@ -42,6 +42,7 @@
 #include "tools/strtools.h"
 #include "tools/utctools.h"
 #include "tools/io.h"
+#include "tools/fileidx.h"
 #include "tools/threads.h"
 
 #include "base/props.h"     // included for property definitions
@@ -214,6 +215,19 @@ static void mainHandleClientInit()
 
 static char savePacketFile[80] = "./scomserv.dmt";
 static utBool saveAsCSV = utFalse;
+static int saveIndexInterval = FIDX_DEFAULT_INTERVAL;
+static FileIndex_t saveIndex;
+
+/* append a record to the saved event file (and its time/device index) */
+static void _saveRecord(const UInt8 *rec, long recLen, const Event_t *ev)
+{
+    long len = ioAppendFile(savePacketFile, rec, recLen);
+    if (len > 0L) {
+        char device[FIDX_MAX_DEVICE_SIZE];
+        snprintf(device, sizeof(device), "%s/%s", protGetAccountID(), protGetDeviceID());
+        fidxAddRecord(&saveIndex, device, ev->timestamp[0], len);
+    }
+}
 
 static char scName[32];
 static const char *statusCodeName(UInt16 code)
@@ -250,39 +264,45 @@ static const char *statusCodeName(UInt16 code)
 static void mainHandleEvent(Packet_t *pkt, Event_t *ev)
 {
     
-    /* create CSV formatted record */
+    /* create CSV formatted record (only if it is logged or saved) */
+    // (the event category level and sampling are checked first, as in 'pktPrintPacket')
+    utBool logEvent = (logIsEnabled(LOGCAT_EVENT,LOGLVL_INFO) && logSample(LOGCAT_EVENT))? utTrue : utFalse;
     UInt8 csv[256], *c = csv;
-    struct tm *tmp = localtime(&(ev->timestamp[0]));
-    int hr  = tmp->tm_hour, mn = tmp->tm_min, sc = tmp->tm_sec;
-    int dy  = tmp->tm_mday, mo = tmp->tm_mon + 1, yr = 1900 + tmp->tm_year;
-    const char *codeName = statusCodeName(ev->statusCode);
-    sprintf(c,  "%02d/%02d/%02d", yr, mo, dy);                c += strlen(c);
-    sprintf(c, ",%02d:%02d:%02d", hr, mn, sc);                c += strlen(c);
-    sprintf(c, ",%s"            , codeName);                  c += strlen(c);
-    sprintf(c, ",%.5lf"         , ev->gpsPoint[0].latitude);  c += strlen(c);
-    sprintf(c, ",%.5lf"         , ev->gpsPoint[0].longitude); c += strlen(c);
-    sprintf(c, ",%.1lf"         , ev->speedKPH);              c += strlen(c);
-    sprintf(c, ",%.1lf"         , ev->heading);               c += strlen(c);
-    sprintf(c, ",%.0lf"         , ev->altitude);              c += strlen(c);
-    sprintf(c, ",%.1lf"         , ev->topSpeedKPH);           c += strlen(c);
-    sprintf(c, ",%s"            , ev->entity[1]);             c += strlen(c);
-    sprintf(c, ",%s"            , ev->entity[0]);             c += strlen(c);
+    if (logEvent || (pkt && *savePacketFile && saveAsCSV)) {
+        struct tm *tmp = localtime(&(ev->timestamp[0]));
+        int hr  = tmp->tm_hour, mn = tmp->tm_min, sc = tmp->tm_sec;
+        int dy  = tmp->tm_mday, mo = tmp->tm_mon + 1, yr = 1900 + tmp->tm_year;
+        const char *codeName = statusCodeName(ev->statusCode);
+        sprintf(c,  "%02d/%02d/%02d", yr, mo, dy);                c += strlen(c);
+        sprintf(c, ",%02d:%02d:%02d", hr, mn, sc);                c += strlen(c);
+        sprintf(c, ",%s"            , codeName);                  c += strlen(c);
+        sprintf(c, ",%.5lf"         , ev->gpsPoint[0].latitude);  c += strlen(c);
+        sprintf(c, ",%.5lf"         , ev->gpsPoint[0].longitude); c += strlen(c);
+        sprintf(c, ",%.1lf"         , ev->speedKPH);              c += strlen(c);
+        sprintf(c, ",%.1lf"         , ev->heading);               c += strlen(c);
+        sprintf(c, ",%.0lf"         , ev->altitude);              c += strlen(c);
+        sprintf(c, ",%.1lf"         , ev->topSpeedKPH);           c += strlen(c);
+        sprintf(c, ",%s"            , ev->entity[1]);             c += strlen(c);
+        sprintf(c, ",%s"            , ev->entity[0]);             c += strlen(c);
+    }
 
     /* print event */
-    logINFO(LOGSRC,"Event [%02X]: %s", ev->sequence, csv);
+    if (logEvent) {
+        logPRINTF(LOGSRC,LOGLVL_INFO,"Event [%02X]: %s", ev->sequence, csv);
+    }
 
     /* save packet */
     if (pkt && *savePacketFile) {
         if (saveAsCSV) {
             sprintf(c, "\n"); c += strlen(c); // record terminator
-            ioAppendFile(savePacketFile, csv, c - csv);
+            _saveRecord(csv, c - csv, ev);
         } else {
             UInt8 buf[PACKET_MAX_ENCODED_LENGTH];
             Buffer_t bb, *dest = binBuffer(&bb, buf, sizeof(buf), BUFFER_DESTINATION);
             int len = pktEncodePacket(dest, pkt, ENCODING_HEX);
             if (len > 0) {
                 //logINFO(LOGSRC,"Appending packet to file [%s]", savePacketFile);
-                ioAppendFile(savePacketFile, buf, len);
+                _saveRecord(buf, len, ev);
             } else {
                 logWARNING(LOGSRC,"Invalid event packet, unable to encode!");
             }
@@ -615,6 +635,9 @@ static void _usage(const char *pgm, int exitCode)
     fprintf(stdout, "   %s ...\n", pgm);
     fprintf(stdout, "    [-comlog]          - Enable commPort data logging\n");
     fprintf(stdout, "    [-com <port>]      - Server serial port\n");
+    fprintf(stdout, "    [-log <cat>=<level>[:<rate>],...]\n");
+    fprintf(stdout, "                       - Log category levels (ie. '-log packet=debug:0')\n");
+    fprintf(stdout, "    [-index <events>]  - Events between output file index entries (0 disables)\n");
     fprintf(stdout, "\n");
     exit(exitCode);
 }
@@ -627,6 +650,7 @@ int main(int argc, char *argv[])
 
     /* init */
     threadMutexInit(&protoMutex);
+    logInitialize();
     memset(comPortID, 0, sizeof(comPortID));
     /* header */
     fprintf(stdout, "Sample serial port server [Version %s]\n", VERSION);
@@ -643,6 +667,24 @@ int main(int argc, char *argv[])
             // -comlog
             comLog = utTrue;
         } else
+        if (strEquals(argv[i], "-log")) {
+            // -log <cat>=<level>[:<rate>],...
+            i++;
+            if ((i >= argc) || !logParseCategoryLevels(argv[i])) {
+                fprintf(stderr, "Invalid log levels ...\n");
+                _usage(argv[0], 1);
+            }
+        } else
+        if (strEquals(argv[i], "-index")) {
+            // -index <events>
+            i++;
+            if ((i < argc) && isdigit(*argv[i])) {
+                saveIndexInterval = (int)strParseUInt32(argv[i], 0L);
+            } else {
+                fprintf(stderr, "Missing index interval ...\n");
+                _usage(argv[0], 1);
+            }
+        } else
         if (strEquals(argv[i], "-com")) {
             // -com <port>
             i++;
@@ -670,6 +712,11 @@ int main(int argc, char *argv[])
     // this must be called before threads are created
     threadInitialize();
 
+    /* output file index */
+    if (*savePacketFile && (saveIndexInterval > 0)) {
+        fidxInit(&saveIndex, savePacketFile, saveIndexInterval);
+    }
+
     /* custom event packet format */
     // (add custom event packet definitions here)
     /* protocol handlers */
@@ -277,12 +277,24 @@ static int _serverParsePacket(Packet_t *pkt, const UInt8 *pktBuf)
                 if (pktBufLen > 6) { // $E0FF:XXXX...
                     // encoded character, plus data
                     if (pktBuf[5] == ENCODING_BASE64_CHAR) {
-                        int len = (UInt8)base64Decode(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
-                        pkt->dataLen = (len >= 0)? (UInt8)len : 0;
+                        int len = (int)base64Decode(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
+                        if (len < 0) {
+                            // invalid Base64 data (or too long): ERROR_PACKET_PAYLOAD
+                            logERROR(LOGSRC,"Invalid Base64 payload");
+                            serverWriteError("%2x%2x", (UInt32)NAK_PACKET_PAYLOAD, (UInt32)pkt->hdrType);
+                            return SRVERR_PARSE_ERROR;
+                        }
+                        pkt->dataLen = (UInt8)len;
                     } else
                     if (pktBuf[5] == ENCODING_HEX_CHAR) {
-                        int len = (UInt8)strParseHex(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
-                        pkt->dataLen = (len >= 0)? (UInt8)len : 0;
+                        int len = strParseHex(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
+                        if ((len * 2) != (pktBufLen - 6)) {
+                            // invalid hex data (odd length, or too long): ERROR_PACKET_PAYLOAD
+                            logERROR(LOGSRC,"Invalid Hex payload");
+                            serverWriteError("%2x%2x", (UInt32)NAK_PACKET_PAYLOAD, (UInt32)pkt->hdrType);
+                            return SRVERR_PARSE_ERROR;
+                        }
+                        pkt->dataLen = (UInt8)len;
                     } else
                     if (pktBuf[5] == ENCODING_CSV_CHAR) {
                         // unsupported encoding: ERROR_PACKET_ENCODING
@@ -371,11 +383,14 @@ utBool serverWritePacket(Packet_t *pkt)
     Buffer_t bb, *dest = binBuffer(&bb, buf, sizeof(buf), BUFFER_DESTINATION);
     int len = pktEncodePacket(dest, pkt, clientPacketEncoding);
     if (len > 0) {
+        if (!logIsEnabled(LOGCAT_PACKET,LOGLVL_DEBUG) || !logSample(LOGCAT_PACKET)) {
+            // packet trace disabled
+        } else
         if (*buf == PACKET_ASCII_ENCODING_CHAR) {
-            logDEBUG(LOGSRC,"[TX] %.*s\n", len - 1, buf); 
+            logPRINTF(LOGSRC,LOGLVL_DEBUG,"[TX] %.*s\n", len - 1, buf); 
         } else {
             UInt8 hex[PACKET_MAX_ENCODED_LENGTH];
-            logDEBUG(LOGSRC,"[TX] 0x%s\n", strEncodeHex(hex, sizeof(hex), buf, len)); 
+            logPRINTF(LOGSRC,LOGLVL_DEBUG,"[TX] 0x%s\n", strEncodeHex(hex, sizeof(hex), buf, len)); 
         }
         int wrtLen = _serverWrite(buf, len);
         if (wrtLen == len) {
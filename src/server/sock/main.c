@@ -41,6 +41,7 @@
 #include "tools/strtools.h"
 #include "tools/utctools.h"
 #include "tools/io.h"
+#include "tools/fileidx.h"
 #include "tools/threads.h"
 
 #include "base/props.h"
@@ -83,6 +84,23 @@ static CustomDef_t CustomPacket_50 = {
 
 static char savePacketFile[80] = "./scomserv.dmt";
 static utBool saveAsCSV = utFalse;
+static int saveIndexInterval = FIDX_DEFAULT_INTERVAL;
+static FileIndex_t saveIndex;
+
+/* append a record to the saved event file (and its time/device index) */
+static void _saveRecord(const UInt8 *rec, long recLen, const Event_t *ev)
+{
+    long len = ioAppendFile(savePacketFile, rec, recLen);
+    if (len > 0L) {
+        char device[FIDX_MAX_DEVICE_SIZE];
+        snprintf(device, sizeof(device), "%s/%s", protGetAccountID(), protGetDeviceID());
+        fidxAddRecord(&saveIndex, device, ev->timestamp[0], len);
+    }
+}
+
+#if defined(INCLUDE_GEOZONE)
+static utBool evalGeozones = utFalse;
+#endif
 
 static char scName[32];
 static const char *statusCodeName(UInt16 code)
@@ -127,45 +145,60 @@ static void mainHandleEvent(Packet_t *pkt, Event_t *ev)
     // STATUS_ON
     // STATUS_OFF
     
-    /* create CSV formatted record */
+    /* create CSV formatted record (only if it is logged or saved) */
+    // (the event category level and sampling are checked first, as in 'pktPrintPacket')
+    utBool logEvent = (logIsEnabled(LOGCAT_EVENT,LOGLVL_INFO) && logSample(LOGCAT_EVENT))? utTrue : utFalse;
     UInt8 csv[120], *c = csv;
-    struct tm *tmp = localtime(&(ev->timestamp[0]));
-    int hr  = tmp->tm_hour, mn = tmp->tm_min, sc = tmp->tm_sec;
-    int dy  = tmp->tm_mday, mo = tmp->tm_mon + 1, yr = 1900 + tmp->tm_year;
-    const char *codeName = statusCodeName(ev->statusCode);
-    sprintf(c,  "%02d/%02d/%02d", yr, mo, dy);                c += strlen(c);
-    sprintf(c, ",%02d:%02d:%02d", hr, mn, sc);                c += strlen(c);
-    sprintf(c, ",%s"            , codeName);                  c += strlen(c);
-    sprintf(c, ",%.5lf"         , ev->gpsPoint[0].latitude);  c += strlen(c);
-    sprintf(c, ",%.5lf"         , ev->gpsPoint[0].longitude); c += strlen(c);
-    sprintf(c, ",%.1lf"         , ev->speedKPH);              c += strlen(c);
-    sprintf(c, ",%.1lf"         , ev->heading);               c += strlen(c);
-    sprintf(c, ",%.0lf"         , ev->altitude);              c += strlen(c);
-    sprintf(c, ",%s"            , ev->string[0]);             c += strlen(c);
-    sprintf(c, ",%s"            , ev->string[1]);             c += strlen(c);
-    sprintf(c, ",%.1lf"         , ev->topSpeedKPH);           c += strlen(c);
+    if (logEvent || (*savePacketFile && saveAsCSV)) {
+        struct tm *tmp = localtime(&(ev->timestamp[0]));
+        int hr  = tmp->tm_hour, mn = tmp->tm_min, sc = tmp->tm_sec;
+        int dy  = tmp->tm_mday, mo = tmp->tm_mon + 1, yr = 1900 + tmp->tm_year;
+        const char *codeName = statusCodeName(ev->statusCode);
+        sprintf(c,  "%02d/%02d/%02d", yr, mo, dy);                c += strlen(c);
+        sprintf(c, ",%02d:%02d:%02d", hr, mn, sc);                c += strlen(c);
+        sprintf(c, ",%s"            , codeName);                  c += strlen(c);
+        sprintf(c, ",%.5lf"         , ev->gpsPoint[0].latitude);  c += strlen(c);
+        sprintf(c, ",%.5lf"         , ev->gpsPoint[0].longitude); c += strlen(c);
+        sprintf(c, ",%.1lf"         , ev->speedKPH);              c += strlen(c);
+        sprintf(c, ",%.1lf"         , ev->heading);               c += strlen(c);
+        sprintf(c, ",%.0lf"         , ev->altitude);              c += strlen(c);
+        sprintf(c, ",%s"            , ev->string[0]);             c += strlen(c);
+        sprintf(c, ",%s"            , ev->string[1]);             c += strlen(c);
+        sprintf(c, ",%.1lf"         , ev->topSpeedKPH);           c += strlen(c);
+    }
 
     /* print event */
-    logINFO(LOGSRC,"Event [%02X]: %s", ev->sequence, csv);
+    if (logEvent) {
+        logPRINTF(LOGSRC,LOGLVL_INFO,"Event [%02X]: %s", ev->sequence, csv);
+    }
 
     /* save packet */
-    if (pkt && *savePacketFile) {
+    // (server generated geozone events do not have a packet, and are saved only in CSV format)
+    if (*savePacketFile && (pkt || saveAsCSV)) {
         if (saveAsCSV) {
             sprintf(c, "\n"); c += strlen(c); // record terminator
-            ioAppendFile(savePacketFile, csv, c - csv);
+            _saveRecord(csv, c - csv, ev);
         } else {
             UInt8 buf[PACKET_MAX_ENCODED_LENGTH];
             Buffer_t bb, *dest = binBuffer(&bb, buf, sizeof(buf), BUFFER_DESTINATION);
             int len = pktEncodePacket(dest, pkt, ENCODING_HEX);
             if (len > 0) {
                 //logINFO(LOGSRC,"Appending packet to file [%s]", savePacketFile);
-                ioAppendFile(savePacketFile, buf, len);
+                _saveRecord(buf, len, ev);
             } else {
                 logWARNING(LOGSRC,"Invalid event packet, unable to encode!");
             }
         }
     }
 
+#if defined(INCLUDE_GEOZONE)
+    /* server-side geozone arrival/departure */
+    // generated events are passed back to this function (and are not re-checked)
+    if (pkt && evalGeozones) {
+        geozCheckEvent(protGetAccountID(), protGetDeviceID(), ev);
+    }
+#endif
+
 }
 
 // ----------------------------------------------------------------------------
@@ -213,6 +246,21 @@ static void _usage(const char *pgm, int exitCode)
     fprintf(stdout, "     [-udp <port>]          - Server UDP port (not yet fully implemented)\n");
     fprintf(stdout, "     [-output <file> [csv]] - Name of file where events packets are to be stored\n");
     fprintf(stdout, "                            - Specify 'csv' to store output file in CSV format\n");
+    fprintf(stdout, "     [-index <events>]      - Events between output file index entries (0 disables)\n");
+    fprintf(stdout, "     [-persist [<seconds>]] - Keep the client connection open between sessions\n");
+    fprintf(stdout, "                            - Optional maximum idle seconds (default 3600)\n");
+    fprintf(stdout, "     [-log <cat>=<level>[:<rate>],...]\n");
+    fprintf(stdout, "                            - Log category levels (cat: server|packet|event,\n");
+    fprintf(stdout, "                            - level: debug|info|warn|error|critical|none,\n");
+    fprintf(stdout, "                            - rate: maximum messages per second, 0 for unlimited,\n");
+    fprintf(stdout, "                            - default 20 for packet|event)\n");
+    fprintf(stdout, "                            - ie. '-log packet=debug:0' to trace all packets\n");
+    fprintf(stdout, "     [-logsync]             - Write log messages synchronously\n");
+#if defined(INCLUDE_GEOZONE)
+    fprintf(stdout, "     [-geozone <file> [<arrive>[,<depart>]]]\n");
+    fprintf(stdout, "                            - Generate Arrival/Departure events for the zones in file\n");
+    fprintf(stdout, "                            - Optional arrival/departure delays in seconds\n");
+#endif
     fprintf(stdout, "Note:\n");
     fprintf(stdout, "   To used this simple server with the socket media transport implementation\n");
     fprintf(stdout, "   of the 'dmtp' client, you must run the client with the '-duplex' option in\n");
@@ -231,13 +279,14 @@ int main(int argc, char *argv[])
     /* init */
     memset(sockPortName, 0, sizeof(sockPortName));
     threadMutexInit(&protoMutex);
+    logInitialize();
 
     /* header */
     fprintf(stdout, "Sample server socket transport\n");
 
     /* command line arguments */
     int i;
-    utBool udp = utFalse, tcp = utFalse;
+    utBool udp = utFalse, tcp = utFalse, logAsync = utTrue;
     for (i = 1; i < argc; i++) {
         if (strEquals(argv[i], "-help") || strEquals(argv[i], "-h")) {
             // -h[elp]
@@ -296,6 +345,61 @@ int main(int argc, char *argv[])
         if (strEquals(argv[i], "-csv")) {
             saveAsCSV = utTrue;
         } else 
+        if (strEquals(argv[i], "-log")) {
+            // -log <cat>=<level>[:<rate>],...
+            i++;
+            if ((i >= argc) || !logParseCategoryLevels(argv[i])) {
+                fprintf(stderr, "Invalid log levels ...\n");
+                _usage(argv[0], 1);
+            }
+        } else
+        if (strEquals(argv[i], "-index")) {
+            // -index <events>
+            i++;
+            if ((i < argc) && isdigit(*argv[i])) {
+                saveIndexInterval = (int)strParseUInt32(argv[i], 0L);
+            } else {
+                fprintf(stderr, "Missing index interval ...\n");
+                _usage(argv[0], 1);
+            }
+        } else
+        if (strEquals(argv[i], "-logsync")) {
+            logAsync = utFalse;
+        } else
+        if (strEquals(argv[i], "-persist")) {
+            // -persist [<seconds>]
+            UInt32 idleSec = 3600L;
+            if (((i + 1) < argc) && isdigit(*argv[i + 1])) {
+                i++;
+                idleSec = strParseUInt32(argv[i], idleSec);
+            }
+            protocolSetPersistent(idleSec);
+        } else 
+#if defined(INCLUDE_GEOZONE)
+        if (strEquals(argv[i], "-geozone")) {
+            // -geozone <filename> [<arrive>[,<depart>]]
+            i++;
+            if ((i < argc) && (*argv[i] != '-')) {
+                if (geozLoadEvalGeozones(argv[i]) < 0) {
+                    fprintf(stderr, "Unable to load geozone file: %s\n", argv[i]);
+                    _usage(argv[0], 1);
+                }
+                // parse delays, if specified
+                if (((i + 1) < argc) && isdigit(*argv[i + 1])) {
+                    i++;
+                    char *delay[2] = { (char*)0, (char*)0 };
+                    strParseArray_sep(argv[i], delay, 2, ',');
+                    UInt32 arrive = strParseUInt32(delay[0], 0L);
+                    UInt32 depart = delay[1]? strParseUInt32(delay[1], 0L) : arrive;
+                    geozSetEvalDelays(arrive, depart);
+                }
+                evalGeozones = utTrue;
+            } else {
+                fprintf(stderr, "Missing geozone filename ...\n");
+                _usage(argv[0], 1);
+            }
+        } else
+#endif
         {
             fprintf(stderr, "Invalid option: %s\n", argv[i]);
             _usage(argv[0], 1);
@@ -306,6 +410,17 @@ int main(int argc, char *argv[])
     fprintf(stdout, "Simple Socket Server\n");
     fprintf(stdout, "Events will be saved to '%s' [CSV=%s]\n", savePacketFile, (saveAsCSV?"true":"false"));
     
+    /* output file index */
+    if (*savePacketFile && (saveIndexInterval > 0)) {
+        fidxInit(&saveIndex, savePacketFile, saveIndexInterval);
+    }
+
+    /* asynchronous log output */
+    // (the protocol thread does not wait on stdout)
+    if (logAsync && !logStartThread()) {
+        logWARNING(LOGSRC,"Unable to start log thread, logging synchronously");
+    }
+
     /* custom event packet format */
     evAddCustomDefinition(&CustomPacket_50);
     
@@ -315,6 +430,9 @@ int main(int argc, char *argv[])
     //protocolSetPropertyHandler(&mainHandleProperty);
     //protocolSetDiagHandler(&mainHandleDiag);
     protocolSetErrorHandler(&mainHandleError);
+#if defined(INCLUDE_GEOZONE)
+    geozSetEvalEventHandler(&mainHandleEvent);
+#endif
 
     /* start server */
     if (tcp) {
@@ -111,6 +111,7 @@ utBool serverOpen(const char *portName, utBool portLog)
 utBool serverClose()
 {
     if (serverIsOpen()) {
+        socketFlushTCP(&serverSocket);
         socketCloseClient(&serverSocket);
         //socketCloseServer(&serverSocket);
         return utTrue;
@@ -263,16 +264,28 @@ static int _serverParsePacket(Packet_t *pkt, const UInt8 *pktBuf)
                 return SRVERR_PARSE_ERROR;
             } else {
                 pkt->hdrType = CLIENT_HEADER_TYPE(buf[0],buf[1]);
-                logERROR(LOGSRC,"Header %04X", pkt->hdrType);
+                logCATEGORY(LOGCAT_PACKET,LOGLVL_DEBUG,LOGSRC,"Header %04X", pkt->hdrType);
                 if (pktBufLen > 6) { // $E0FF:XXXX...
                     // encoded character, plus data
                     if (pktBuf[5] == ENCODING_BASE64_CHAR) {
-                        int len = (UInt8)base64Decode(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
-                        pkt->dataLen = (len >= 0)? (UInt8)len : 0;
+                        int len = (int)base64Decode(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
+                        if (len < 0) {
+                            // invalid Base64 data (or too long): ERROR_PACKET_PAYLOAD
+                            logERROR(LOGSRC,"Invalid Base64 payload");
+                            serverWriteError("%2x%2x", (UInt32)NAK_PACKET_PAYLOAD, (UInt32)pkt->hdrType);
+                            return SRVERR_PARSE_ERROR;
+                        }
+                        pkt->dataLen = (UInt8)len;
                     } else
                     if (pktBuf[5] == ENCODING_HEX_CHAR) {
-                        int len = (UInt8)strParseHex(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
-                        pkt->dataLen = (len >= 0)? (UInt8)len : 0;
+                        int len = strParseHex(pktBuf + 6, pktBufLen - 6, pkt->data, sizeof(pkt->data));
+                        if ((len * 2) != (pktBufLen - 6)) {
+                            // invalid hex data (odd length, or too long): ERROR_PACKET_PAYLOAD
+                            logERROR(LOGSRC,"Invalid Hex payload");
+                            serverWriteError("%2x%2x", (UInt32)NAK_PACKET_PAYLOAD, (UInt32)pkt->hdrType);
+                            return SRVERR_PARSE_ERROR;
+                        }
+                        pkt->dataLen = (UInt8)len;
                     } else
                     if (pktBuf[5] == ENCODING_CSV_CHAR) {
                         // unsupported encoding: ERROR_PACKET_ENCODING
@@ -349,8 +362,9 @@ static int _serverWrite(const UInt8 *buf, int bufLen)
     }
 
     /* write packet */
+    // queued packets are sent before the next read (or on close)
     int len = 0;
-    len = socketWriteTCP(&serverSocket, buf, bufLen);
+    len = socketQueueTCP(&serverSocket, buf, bufLen);
     return len;
     
 }
@@ -361,11 +375,14 @@ utBool serverWritePacket(Packet_t *pkt)
     Buffer_t bb, *dest = binBuffer(&bb, buf, sizeof(buf), BUFFER_DESTINATION);
     int len = pktEncodePacket(dest, pkt, clientPacketEncoding);
     if (len > 0) {
+        if (!logIsEnabled(LOGCAT_PACKET,LOGLVL_DEBUG) || !logSample(LOGCAT_PACKET)) {
+            // packet trace disabled
+        } else
         if (*buf == PACKET_ASCII_ENCODING_CHAR) {
-            logINFO(LOGSRC,"[TX] %.*s", len - 1, buf); 
+            logPRINTF(LOGSRC,LOGLVL_DEBUG,"[TX] %.*s", len - 1, buf); 
         } else {
             UInt8 hex[PACKET_MAX_ENCODED_LENGTH];
-            logINFO(LOGSRC,"[TX] 0x%s", strEncodeHex(hex, sizeof(hex), buf, len)); 
+            logPRINTF(LOGSRC,LOGLVL_DEBUG,"[TX] 0x%s", strEncodeHex(hex, sizeof(hex), buf, len)); 
         }
         int wrtLen = _serverWrite(buf, len);
         if (wrtLen == len) {
@@ -39,6 +39,7 @@
 #include "tools/strtools.h"
 #include "tools/base64.h"
 #include "tools/checksum.h"
+#include "tools/utctools.h"
 #include "tools/io.h"
 
 #include "server/server.h"
@@ -46,20 +47,73 @@
 #include "server/packet.h"
 #include "server/protocol.h"
 #include "server/log.h"
+#include "server/cerrors.h"
 
 // ----------------------------------------------------------------------------
 // these must match the values used by the client
 
-#define UPLOAD_MAX_FILE_SIZE          250000L
+#define UPLOAD_MAX_FILE_SIZE          0xFFFFFFL     // 3-byte record offset
 #define UPLOAD_MAX_FILENAME_SIZE      64
 #define UPLOAD_MAX_ENCODED_FILE_SIZE  (((UPLOAD_MAX_FILE_SIZE + 2L) / 3L) * 4L) // close approximation
 
+// encoded file read block size, and number of Base64 characters decoded at a time
+// (the decode block size must be a multiple of 4)
+#define UPLOAD_READ_BLOCK_SIZE        8192
+#define UPLOAD_DECODE_BLOCK_SIZE      1024
+
 #define UPLOAD_TYPE_FILE              0x01
 #define UPLOAD_TYPE_DATA              0x02
 #define UPLOAD_TYPE_END               0x03
 
 // ----------------------------------------------------------------------------
 
+// bytes sent beyond the last client acknowledgement 
+// (the client acknowledges every 1024 bytes)
+#define UPLOAD_WINDOW_SIZE            4096L
+
+// smallest resend window (the client must still reach its acknowledgement interval)
+#define UPLOAD_MIN_WINDOW_SIZE        1024L
+
+// data bytes per record (leave some room for the overhead)
+#define UPLOAD_RECORD_SIZE            245
+
+// seconds without an acknowledgement before the unacknowledged data is resent
+#define UPLOAD_ACK_TIMEOUT_SEC        30L
+#define UPLOAD_MAX_RETRIES            8
+
+typedef enum {
+    UPLOAD_IDLE         = 0,    // no upload
+    UPLOAD_ANNOUNCE     = 1,    // file record to be sent (new connection)
+    UPLOAD_ANNOUNCED    = 2,    // file record sent, waiting for resume offset
+    UPLOAD_SENDING      = 3,    // sending data window
+    UPLOAD_ENDING       = 4,    // end record sent, waiting for acknowledgement
+} UploadState_t;
+
+typedef struct {
+    UploadState_t       state;
+    char                accountID[MAX_ID_SIZE + 1];
+    char                deviceID[MAX_ID_SIZE + 1];
+    char                clientFile[UPLOAD_MAX_FILENAME_SIZE + 1];
+    UInt8               *data;
+    Int32               dataLen;
+    ChecksumFletcher_t  cksum;
+    Int32               ackOfs;         // data acknowledged by the client
+    Int32               sentOfs;        // data sent
+    Int32               window;         // bytes sent beyond 'ackOfs'
+    Int32               resendOfs;      // offset of the last resend (-1 if none)
+    int                 resends;        // repeated resends from 'resendOfs'
+    utBool              holdEnd;        // end record held back until the data is acknowledged
+    TimerSec_t          ackTimer;       // time of last progress
+    int                 retries;        // timeouts without progress
+    utBool              acked;          // the client acknowledges upload records
+    utBool              resumed;        // the client resumed from a partial file
+    utBool              restarted;      // restarted from 0 after a checksum error
+} Upload_t;
+
+static Upload_t upload = { UPLOAD_IDLE };
+
+// ----------------------------------------------------------------------------
+
 //static char uploadEncodedFilename[80] = { 0 };
 //
 //void uploadSetEncodedFile(const char *file)
@@ -119,48 +173,310 @@
 
 // ----------------------------------------------------------------------------
 
-utBool uploadSendData(const char *clientFileName, const UInt8 *data, Int32 dataLen)
+/* clear upload state */
+static void _uploadFree()
 {
-    UInt32 ofs = 0L;
-    UInt8 buf[PACKET_MAX_PAYLOAD_LENGTH];
-    int bufLen;
-    
-    /* null client file name? */
-    if (!clientFileName) {
-        return utFalse;
+    if (upload.data) {
+        free(upload.data);
     }
+    memset(&upload, 0, sizeof(upload));
+    upload.state = UPLOAD_IDLE;
+}
 
-    /* file name */
-    bufLen = binPrintf(buf, sizeof(buf), "%1x%3x%*s", (UInt32)UPLOAD_TYPE_FILE, (UInt32)dataLen, (int)UPLOAD_MAX_FILENAME_SIZE, clientFileName);
+/* send file record (the client replies with the offset to resume from) */
+static utBool _uploadSendFileRecord()
+{
+    UInt8 buf[PACKET_MAX_PAYLOAD_LENGTH];
+    int bufLen = binPrintf(buf, sizeof(buf), "%1x%3x%*s", (UInt32)UPLOAD_TYPE_FILE, (UInt32)upload.dataLen, (int)UPLOAD_MAX_FILENAME_SIZE, upload.clientFile);
     if (!protUploadPacket(buf, bufLen)) {
         return utFalse;
     }
-    // Ideally, we should wait for an acknowledgement from the client that the filename
-    // was acceptable.
+    upload.state = UPLOAD_ANNOUNCED;
+    upload.ackTimer = utcGetTimer();
+    return utTrue;
+}
+
+/* send data records up to a window beyond the acknowledged offset, then the end record */
+static utBool _uploadSendWindow()
+{
+    UInt8 buf[PACKET_MAX_PAYLOAD_LENGTH];
+    int bufLen;
+    utBool sent = utFalse;
 
     /* data */
-    while (ofs < dataLen) {
-        int len = 245; // leave some room for the overhead
-        if (len > (dataLen - ofs)) {
-            len = dataLen - ofs;
+    while ((upload.sentOfs < upload.dataLen) && (upload.sentOfs < (upload.ackOfs + upload.window))) {
+        int len = UPLOAD_RECORD_SIZE;
+        if (len > (upload.dataLen - upload.sentOfs)) {
+            len = upload.dataLen - upload.sentOfs;
         }
-        bufLen = binPrintf(buf, sizeof(buf), "%1x%3x%*b", (UInt32)UPLOAD_TYPE_DATA, (UInt32)ofs, (int)len, &data[ofs]);
+        bufLen = binPrintf(buf, sizeof(buf), "%1x%3x%*b", (UInt32)UPLOAD_TYPE_DATA, (UInt32)upload.sentOfs, (int)len, &upload.data[upload.sentOfs]);
         if (!protUploadPacket(buf, bufLen)) {
-            return utFalse;
+            return sent;
         }
-        ofs += len;
+        upload.sentOfs += len;
+        sent = utTrue;
     }
 
     /* end */
-    bufLen = binPrintf(buf, sizeof(buf), "%1x%3x%1x%1x", (UInt32)UPLOAD_TYPE_END, (UInt32)dataLen, (UInt32)0, (UInt32)0);
-    if (!protUploadPacket(buf, bufLen)) {
-        return utFalse;
+    if ((upload.sentOfs >= upload.dataLen) && (upload.state == UPLOAD_SENDING) && (!upload.holdEnd || !sent)) {
+        ChecksumFletcher_t fcs;
+        _cksumGetFletcherChecksum(&upload.cksum, &fcs);
+        bufLen = binPrintf(buf, sizeof(buf), "%1x%3x%1x%1x", (UInt32)UPLOAD_TYPE_END, (UInt32)upload.dataLen, (UInt32)fcs.C[0], (UInt32)fcs.C[1]);
+        if (protUploadPacket(buf, bufLen)) {
+            upload.state = UPLOAD_ENDING;
+            sent = utTrue;
+        }
+    }
+
+    if (sent) {
+        upload.ackTimer = utcGetTimer();
+    }
+    return sent;
+
+}
+
+/* resend from the specified offset */
+// A loss pattern which repeats with the number of records resent would lose the same
+// record on every resend.  When records are lost again at the same offset, the window
+// is halved (down to the smallest window), and the number of records resent then
+// alternates by one (the end record, or one data record, is held back on every other
+// resend), so that the same record is not lost on consecutive resends.
+static utBool _uploadResend(Int32 ofs)
+{
+    if (ofs != upload.resendOfs) {
+        upload.resends = 0;
+        upload.window  = UPLOAD_WINDOW_SIZE;
+    } else {
+        upload.resends++;
+        upload.window  = UPLOAD_WINDOW_SIZE >> ((upload.resends < 8)? upload.resends : 8);
+        if (upload.window <= UPLOAD_MIN_WINDOW_SIZE) {
+            upload.window = UPLOAD_MIN_WINDOW_SIZE + ((upload.resends & 1)? 0L : (Int32)UPLOAD_RECORD_SIZE);
+        }
+        logWARNING(LOGSRC,"Upload records lost again at %ld, window %ld", ofs, upload.window);
+    }
+    upload.holdEnd   = (upload.resends & 1)? utTrue : utFalse;
+    upload.resendOfs = ofs;
+    upload.state     = UPLOAD_SENDING;
+    upload.ackOfs    = ofs;
+    upload.sentOfs   = ofs;
+    return _uploadSendWindow();
+}
+
+/* send all remaining records in a single pass (clients that do not acknowledge upload records) */
+// Clients built before upload acknowledgements were added reply to the file record
+// with only an end-of-block, and expect the data and end records to follow.  The
+// upload is done once the end record has been sent.
+static utBool _uploadSendLegacy()
+{
+    logINFO(LOGSRC,"Upload not acknowledged, sending in a single pass: %s", upload.clientFile);
+    upload.state   = UPLOAD_SENDING;
+    upload.ackOfs  = upload.dataLen; // no window
+    upload.sentOfs = 0L;
+    utBool sent = _uploadSendWindow();
+    if (upload.state == UPLOAD_ENDING) {
+        logINFO(LOGSRC,"Upload sent: %s [%ld bytes]", upload.clientFile, upload.dataLen);
+        _uploadFree();
+    } else {
+        // resent when the client reconnects
+        upload.state = UPLOAD_ANNOUNCE;
     }
-    // Ideally, we should wait for an acknowledgement from the client that the upload 
-    // was successful.
+    return sent;
+}
+
+/* start upload of 'data' (which is freed when the upload ends) */
+static utBool _uploadStart(const char *clientFileName, UInt8 *data, Int32 dataLen)
+{
+
+    /* reset any previous upload */
+    if (upload.state != UPLOAD_IDLE) {
+        logWARNING(LOGSRC,"Upload of '%s' replaced", upload.clientFile);
+    }
+    _uploadFree();
+
+    /* upload state */
+    strncpy(upload.accountID, protGetAccountID(), sizeof(upload.accountID) - 1);
+    strncpy(upload.deviceID, protGetDeviceID(), sizeof(upload.deviceID) - 1);
+    strncpy(upload.clientFile, clientFileName, sizeof(upload.clientFile) - 1);
+    upload.data    = data;
+    upload.dataLen = dataLen;
+    upload.window  = UPLOAD_WINDOW_SIZE;
+    upload.resendOfs = -1L;
+    _cksumResetFletcher(&upload.cksum);
+    _cksumCalcFletcher(&upload.cksum, data, (int)dataLen);
 
-    /* success */
+    /* file name */
+    if (!_uploadSendFileRecord()) {
+        // resumed when the client reconnects
+        upload.state = UPLOAD_ANNOUNCE;
+    }
     return utTrue;
+
+}
+
+// ----------------------------------------------------------------------------
+
+/* return true if an upload is in progress */
+utBool uploadIsActive()
+{
+    return (upload.state != UPLOAD_IDLE)? utTrue : utFalse;
+}
+
+/* resume upload on a new client connection */
+void uploadResume()
+{
+    if (upload.state != UPLOAD_IDLE) {
+        upload.state = UPLOAD_ANNOUNCE;
+        upload.retries = 0;
+    }
+}
+
+/* send the file record to a reconnected client, or resend unacknowledged data */
+// Returns true if records were sent (the client should be asked to respond).
+utBool uploadCheck()
+{
+    switch (upload.state) {
+        case UPLOAD_IDLE:
+            return utFalse;
+        case UPLOAD_ANNOUNCE:
+            // resume only to the same client
+            if (!strEquals(upload.accountID, protGetAccountID()) || !strEquals(upload.deviceID, protGetDeviceID())) {
+                return utFalse;
+            }
+            logINFO(LOGSRC,"Resuming upload: %s [%ld/%ld]", upload.clientFile, upload.ackOfs, upload.dataLen);
+            return _uploadSendFileRecord();
+        default:
+            if (!utcIsTimerExpired(upload.ackTimer, UPLOAD_ACK_TIMEOUT_SEC)) {
+                return utFalse;
+            } else
+            if (++upload.retries > UPLOAD_MAX_RETRIES) {
+                logERROR(LOGSRC,"Upload not acknowledged, cancelled: %s", upload.clientFile);
+                _uploadFree();
+                return utFalse;
+            }
+            if ((upload.state == UPLOAD_ANNOUNCED) && !upload.acked) {
+                return _uploadSendLegacy();
+            }
+            logWARNING(LOGSRC,"Upload acknowledgement timeout, resending from %ld", upload.ackOfs);
+            if (upload.state == UPLOAD_ANNOUNCED) {
+                return _uploadSendFileRecord();
+            }
+            return _uploadResend(upload.ackOfs);
+    }
+}
+
+/* handle client DIAG_UPLOAD_ACK (returns true if records were sent) */
+utBool uploadHandleAck(const UInt8 *data, UInt16 dataLen)
+{
+    UInt32 rcdType = 0L, ofs = 0L;
+    int fldCnt = binScanf(data, dataLen, "%1x%3x", &rcdType, &ofs);
+    if ((fldCnt < 2) || (upload.state == UPLOAD_IDLE) || (upload.state == UPLOAD_ANNOUNCE)) {
+        return utFalse;
+    }
+    upload.acked = utTrue;
+    if (rcdType == UPLOAD_TYPE_FILE) {
+        // resume from the client offset
+        if (upload.state != UPLOAD_ANNOUNCED) {
+            return utFalse;
+        } else
+        if ((Int32)ofs > upload.dataLen) {
+            ofs = 0L;
+        }
+        if (ofs > 0L) {
+            logINFO(LOGSRC,"Upload resumed at %lu/%ld", ofs, upload.dataLen);
+        }
+        upload.state   = UPLOAD_SENDING;
+        upload.ackOfs  = (Int32)ofs;
+        upload.sentOfs = (Int32)ofs;
+        upload.window  = UPLOAD_WINDOW_SIZE;
+        upload.holdEnd = utFalse;
+        upload.resendOfs = -1L;
+        upload.retries = 0;
+        upload.resumed = (ofs > 0L)? utTrue : utFalse;
+        return _uploadSendWindow();
+    } else
+    if (rcdType == UPLOAD_TYPE_END) {
+        logINFO(LOGSRC,"Upload complete: %s [%ld bytes]", upload.clientFile, upload.dataLen);
+        _uploadFree();
+        return utFalse;
+    } else
+    if ((Int32)ofs > upload.ackOfs) {
+        upload.ackOfs  = (Int32)ofs;
+        upload.window  = UPLOAD_WINDOW_SIZE;
+        upload.holdEnd = utFalse;
+        upload.retries = 0;
+        if (upload.sentOfs < upload.ackOfs) { upload.sentOfs = upload.ackOfs; }
+        return _uploadSendWindow();
+    } else {
+        return utFalse;
+    }
+}
+
+/* handle client end-of-block (returns true if records were sent) */
+// A client that acknowledges upload records replies to the file record before its
+// end-of-block.  Otherwise the rest of the file is sent as older clients expect it.
+utBool uploadHandleEOB()
+{
+    if ((upload.state == UPLOAD_ANNOUNCED) && !upload.acked) {
+        return _uploadSendLegacy();
+    } else {
+        return utFalse;
+    }
+}
+
+/* handle client upload error (returns true if records were sent) */
+utBool uploadHandleError(UInt16 errKey, const UInt8 *data, UInt16 dataLen)
+{
+    if (upload.state == UPLOAD_IDLE) {
+        return utFalse;
+    } else
+    if (errKey == ERROR_UPLOAD_OFFSET_GAP) {
+        // records were lost, resend from the client offset
+        UInt32 ofs = 0L;
+        if (binScanf(data, dataLen, "%3x", &ofs) < 1) {
+            ofs = (UInt32)upload.ackOfs;
+        }
+        logWARNING(LOGSRC,"Upload gap, resending from %lu", ofs);
+        return _uploadResend(((Int32)ofs <= upload.dataLen)? (Int32)ofs : 0L);
+    } else
+    if ((errKey == ERROR_UPLOAD_CHECKSUM) && upload.resumed && !upload.restarted) {
+        // the client partial file was not from this upload (and has been deleted)
+        logWARNING(LOGSRC,"Resumed upload checksum error, restarting: %s", upload.clientFile);
+        upload.ackOfs    = 0L;
+        upload.sentOfs   = 0L;
+        upload.retries   = 0;
+        upload.resumed   = utFalse;
+        upload.restarted = utTrue;
+        if (!_uploadSendFileRecord()) {
+            upload.state = UPLOAD_ANNOUNCE;
+            return utFalse;
+        }
+        return utTrue;
+    } else {
+        logERROR(LOGSRC,"Upload failed [error %04X]: %s", errKey, upload.clientFile);
+        _uploadFree();
+        return utFalse;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/* start upload to the client (the data is sent as the client acknowledges it) */
+utBool uploadSendData(const char *clientFileName, const UInt8 *data, Int32 dataLen)
+{
+    
+    /* null client file name? */
+    if (!clientFileName || !data || (dataLen <= 0L)) {
+        return utFalse;
+    }
+
+    /* copy data */
+    UInt8 *copy = (UInt8*)malloc(dataLen);
+    if (!copy) {
+        logERROR(LOGSRC,"Out of memory");
+        return utFalse;
+    }
+    memcpy(copy, data, dataLen);
+    return _uploadStart(clientFileName, copy, dataLen);
     
 }
 
@@ -203,138 +519,170 @@ utBool uploadSendEncodedFile(const char *localFileName)
         return utFalse;
     }
     
-    /* read fileName */
+    /* decoded data buffer (at most 3/4 of the encoded file size) */
+    long dataSize = ((encodedFileSize + 3L) / 4L) * 3L;
+    UInt8 *data = (UInt8*)malloc(dataSize);
+    if (!data) {
+        logERROR(LOGSRC,"Out of memory");
+        ioCloseStream(file);
+        return utFalse;
+    }
+    long dataLen = 0L;
+
+    /* read file a block at a time */
+    // Base64 characters are collected in 'b64' and decoded a full block at a time
     unsigned char clientFileName[40], *fn = clientFileName;
+    utBool haveFileName = utFalse;
     utBool commentLine = utFalse; // support leading comment lines
+    UInt8 buf[UPLOAD_READ_BLOCK_SIZE];
+    char b64[UPLOAD_DECODE_BLOCK_SIZE];
+    int b64Len = 0, lastEqualChars = 0;
+    long readLen = 0L, b64Total = 0L;
     for (;;) {
         
-        /* read single character */
-        unsigned char ch[1];
-        long len = ioReadStream(file, ch, 1);
-        if (len <= 0) {
-            // EOF / read error
+        /* read a block */
+        long maxLen = encodedFileSize - readLen; // (the file size may have changed)
+        if (maxLen > (long)sizeof(buf)) { maxLen = sizeof(buf); }
+        long len = (maxLen > 0L)? ioReadStream(file, buf, maxLen) : 0L;
+        if (ferror(file)) {
+            // read error
             logERROR(LOGSRC,"Encoded upload file read error");
             ioCloseStream(file);
+            free(data);
             return utFalse;
+        } else
+        if (len <= 0L) {
+            // EOF
+            break;
         }
+        readLen += len;
         
-        /* line terminator */
-        if ((*ch == '\r') || (*ch == '\n')) {
+        UInt8 *ch = buf, *chEnd = buf + len;
+        
+        /* read fileName */
+        for (; !haveFileName && (ch < chEnd); ch++) {
+            
+            /* line terminator */
+            if ((*ch == '\r') || (*ch == '\n')) {
+                if (commentLine) {
+                    // comment-line terminated (trailing line-terminator may still be remaining)
+                    commentLine = utFalse;
+                } else
+                if (fn == clientFileName) {
+                    // filename is empty (found a leading line terminator)
+                } else {
+                    // we now have the client filename
+                    *fn = 0;
+                    haveFileName = utTrue;
+                }
+                continue;
+            }
+            
+            /* inside a comment line? */
             if (commentLine) {
-                // comment-line terminated (trailing line-terminator may still be remaining)
-                commentLine = utFalse;
+                // ignore all characters (except line terminators) on a comment line
                 continue;
-            } else
-            if (fn == clientFileName) {
-                // filename is empty (found a leading line terminator)
+            }
+            
+            /* start of a comment line */
+            // (valid only if no filename characters have been parsed)
+            if ((fn == clientFileName) && (*ch == '#')) {
+                // filename is empty, and we found a leading '#'
+                commentLine = utTrue;
                 continue;
-            } else {
-                // we now have the client filename
-                *fn = 0;
-                break;
             }
-        }
-        
-        /* inside a comment line? */
-        if (commentLine) {
-            // ignore all characters (except line terminators) on a comment line
-            continue;
-        }
-        
-        /* start of a comment line */
-        // (valid only if no filename characters have been parsed)
-        if ((fn == clientFileName) && (*ch == '#')) {
-            // filename is empty, and we found a leading '#'
-            commentLine = utTrue;
-            continue;
-        }
-        
-        /* invalid filename character */
-        if (!isalnum(*ch) && (*ch != '/') && (*ch != '-') && (*ch != '_')) {
-            // invalid filename
-            logERROR(LOGSRC,"Invalid characters in encoded upload client filename");
-            ioCloseStream(file);
-            return utFalse;
-        }
-        
-        /* save character */
-        *fn++ = *ch;
-        if ((fn - clientFileName) >= (sizeof(clientFileName) - 1)) {
-            // filename too large
-            logERROR(LOGSRC,"Encoded upload client filename is too large");
-            ioCloseStream(file);
-            return utFalse;
-        }
-        
-    }
-    
-    /* read Base64 data */
-    UInt8 b64[UPLOAD_MAX_ENCODED_FILE_SIZE], *b = b64;
-    int lastEqualChars = 0;
-    for (;;) {
-        
-        /* read a single character */
-        long len = ioReadStream(file, b, 1);
-        if (len <= 0) {
-            if (feof(file)) {
-                // normal EOF
-                break;
-            } else {
-                // read error
-                logERROR(LOGSRC,"Encoded upload file read error");
+            
+            /* invalid filename character */
+            if (!isalnum(*ch) && (*ch != '/') && (*ch != '-') && (*ch != '_')) {
+                // invalid filename
+                logERROR(LOGSRC,"Invalid characters in encoded upload client filename");
                 ioCloseStream(file);
+                free(data);
                 return utFalse;
             }
+            
+            /* save character */
+            *fn++ = *ch;
+            if ((fn - clientFileName) >= (sizeof(clientFileName) - 1)) {
+                // filename too large
+                logERROR(LOGSRC,"Encoded upload client filename is too large");
+                ioCloseStream(file);
+                free(data);
+                return utFalse;
+            }
+            
         }
         
-        /* ignore line terminators */
-        if ((*b == '\n') || (*b == '\r') || (*b == 0)) {
-            // ignore line terminators ('\n','\r')
-            // ('0' included because I've seen some editors place nulls at the end of a file)
-            continue;
-        }
-        
-        /* check for Base64 terminating character */
-        if ((*b == '=') && (lastEqualChars < 2)) {
-            // No encoding characters should following the last 2 '='s (if present)
-            lastEqualChars++;
-            b++;
-            continue;
-        }
-        
-        /* check for invalid Base64 characters */
-        if (lastEqualChars || (!isalnum(*b) && (*b != '+') && (*b != '/'))) {
-            // invalid Base64 character
-            logERROR(LOGSRC,"Invalid Base64 characters in encoded upload file");
-            ioCloseStream(file);
-            return utFalse;
+        /* read Base64 data */
+        for (; ch < chEnd; ch++) {
+            
+            /* ignore line terminators */
+            if ((*ch == '\n') || (*ch == '\r') || (*ch == 0)) {
+                // ignore line terminators ('\n','\r')
+                // ('0' included because I've seen some editors place nulls at the end of a file)
+                continue;
+            }
+            
+            /* check for Base64 terminating character */
+            if ((*ch == '=') && (lastEqualChars < 2)) {
+                // No encoding characters should following the last 2 '='s (if present)
+                lastEqualChars++;
+            } else
+            if (lastEqualChars || (!isalnum(*ch) && (*ch != '+') && (*ch != '/'))) {
+                // invalid Base64 character
+                logERROR(LOGSRC,"Invalid Base64 characters in encoded upload file");
+                ioCloseStream(file);
+                free(data);
+                return utFalse;
+            }
+            
+            /* save character, and decode a full block */
+            // (the block size is a multiple of 4, so only the last block may be partial)
+            b64[b64Len++] = (char)*ch;
+            b64Total++;
+            if (b64Len >= sizeof(b64)) {
+                long n = base64Decode(b64, b64Len, &data[dataLen], dataSize - dataLen);
+                if (n < 0L) {
+                    logERROR(LOGSRC,"Invalid encoded upload file Base64 data length");
+                    ioCloseStream(file);
+                    free(data);
+                    return utFalse;
+                }
+                dataLen += n;
+                b64Len = 0;
+            }
+            
         }
         
-        /* save character and advance */
-        b++;
-        
     }
     ioCloseStream(file);
     
     /* test data length */
-    long b64Len = b - b64;
-    if (b64Len <= 0L) {
-        // read error
+    if (!haveFileName || (b64Total <= 0L)) {
+        // EOF / read error
         logERROR(LOGSRC,"Encoded upload file read error");
+        free(data);
         return utFalse;
     }
     
-    /* decode Base64 data in-place */
-    UInt8 *data = b64;
-    long dataLen = base64Decode(b64, b64Len, data, sizeof(b64));
+    /* decode remaining Base64 data */
+    if (b64Len > 0) {
+        long n = base64Decode(b64, b64Len, &data[dataLen], dataSize - dataLen);
+        if (n < 0L) {
+            dataLen = -1L;
+        } else {
+            dataLen += n;
+        }
+    }
     if (dataLen <= 0L) {
         // invalid data length
         logERROR(LOGSRC,"Invalid encoded upload file Base64 data length");
+        free(data);
         return utFalse;
     }
 
     /* send to client */
-    return uploadSendData(clientFileName, data, dataLen);
+    return _uploadStart(clientFileName, data, dataLen);
     
 }
 // ----------------------------------------------------------------------------
@@ -373,30 +721,23 @@ utBool uploadSendFile(const char *localFileName, const char *clientFileName)
     }
         
     /* read Binary data */
-    UInt8 data[UPLOAD_MAX_FILE_SIZE], *b = data;
-    for (;;) {
-        long len = ioReadStream(file, b, 1);
-        if (len <= 0L) {
-            if (feof(file)) {
-                break; // EOF
-            } else {
-                logERROR(LOGSRC,"Upload file read error");
-                ioCloseStream(file); // read error
-                return utFalse;
-            }
-        }
-        b++;
+    UInt8 *data = (UInt8*)malloc(localFileSize);
+    if (!data) {
+        logERROR(LOGSRC,"Out of memory");
+        ioCloseStream(file);
+        return utFalse;
     }
+    long dataLen = ioReadStream(file, data, localFileSize);
     ioCloseStream(file);
-    long dataLen = b - data;
     if (dataLen <= 0L) {
         // read error
         logERROR(LOGSRC,"Upload file read error");
+        free(data);
         return utFalse;
     }
 
     /* send data to client */
-    utBool ok = uploadSendData(clientFileName, data, dataLen);
+    utBool ok = _uploadStart(clientFileName, data, dataLen);
     //logINFO(LOGSRC,"Upload file size = %ld", dataLen);
     return ok;
     
@@ -28,11 +28,22 @@
 #if defined(INCLUDE_UPLOAD)
 //#warning Including upload support
 
+// client upload record acknowledgement (must match the client 'base/cdiags.h')
+#define DIAG_UPLOAD_ACK               0xF001
+
 utBool uploadSendEncodedFile(const char *localFileName);
 
 utBool uploadSendFile(const char *localFileName, const char *clientFileName);
 utBool uploadSendData(const char *clientFileName, const UInt8 *data, Int32 dataLen);
 
+utBool uploadIsActive();
+void uploadResume();
+utBool uploadCheck();
+
+utBool uploadHandleAck(const UInt8 *data, UInt16 dataLen);
+utBool uploadHandleEOB();
+utBool uploadHandleError(UInt16 errKey, const UInt8 *data, UInt16 dataLen);
+
 #endif // INCLUDE_UPLOAD
 
 // ----------------------------------------------------------------------------
@@ -50,15 +50,27 @@ static UInt8 *_b64GetMap()
     return Base64Map;
 }
 
-static int _b64IndexOf(UInt8 ch) 
-{
-    if ((ch >= 'A') && (ch <= 'Z')) { return  0 + (ch - 'A'); }
-    if ((ch >= 'a') && (ch <= 'z')) { return 26 + (ch - 'a'); }
-    if ((ch >= '0') && (ch <= '9')) { return 52 + (ch - '0'); }
-    if (ch == '+')                  { return 62;              }
-    if (ch == '/')                  { return 63;              }
-    return 0; // invalid character found (map it to '0')
-}
+/* character to 6-bit value (-1 for characters outside the Base64 alphabet) */
+static const signed char Base64Index[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
+    52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-1,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
+    15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,
+    -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
+    41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+};
+
+#define B64_INDEX(C)    ((long)Base64Index[(UInt8)(C)])
 
 // ----------------------------------------------------------------------------
 
@@ -73,22 +85,27 @@ long base64Encode(char *b64Out, long b64OutLen, const UInt8 *dataIn, long dataIn
         return -1L; 
     }
 
-    /* encode */
+    /* encode full 3-byte groups */
     long i, d = 0L;
     UInt8 *b64Map = _b64GetMap();
-    for (i = 0L; (i < dataInLen) /*&& ((d + 4L) <= b64OutLen)*/; i += 3L) {
+    long fullLen = dataInLen - (dataInLen % 3L);
+    for (i = 0L; i < fullLen; i += 3L) {
+        UInt32 reg24 = ((UInt32)dataIn[i] << 16) | ((UInt32)dataIn[i+1L] << 8) | (UInt32)dataIn[i+2L];
+        b64Out[d+0L] = b64Map[(reg24 >> 18) & 0x3F];
+        b64Out[d+1L] = b64Map[(reg24 >> 12) & 0x3F];
+        b64Out[d+2L] = b64Map[(reg24 >>  6) & 0x3F];
+        b64Out[d+3L] = b64Map[(reg24      ) & 0x3F];
+        d += 4L;
+    }
 
-        /* place next 3 bytes into register */
-        UInt32                  reg24  = ((UInt32)dataIn[i+0L] << 16) & 0xFF0000;
-        if ((i+1L)<dataInLen) { reg24 |= ((UInt32)dataIn[i+1L] <<  8) & 0x00FF00; }
-        if ((i+2L)<dataInLen) { reg24 |= ((UInt32)dataIn[i+2L]      ) & 0x0000FF; }
-        
-        /* encode data 6 bits at a time */
-        b64Out[d++] =                     b64Map[(reg24 >> 18) & 0x3F];
-        b64Out[d++] =                     b64Map[(reg24 >> 12) & 0x3F];
-        b64Out[d++] = ((i+1L)<dataInLen)? b64Map[(reg24 >>  6) & 0x3F] : BASE64_PAD;
-        b64Out[d++] = ((i+2L)<dataInLen)? b64Map[(reg24      ) & 0x3F] : BASE64_PAD;
-        
+    /* encode remaining 1 or 2 bytes (padded) */
+    if (i < dataInLen) {
+        UInt32 reg24 = (UInt32)dataIn[i] << 16;
+        if ((i+1L) < dataInLen) { reg24 |= (UInt32)dataIn[i+1L] << 8; }
+        b64Out[d++] = b64Map[(reg24 >> 18) & 0x3F];
+        b64Out[d++] = b64Map[(reg24 >> 12) & 0x3F];
+        b64Out[d++] = ((i+1L) < dataInLen)? b64Map[(reg24 >> 6) & 0x3F] : BASE64_PAD;
+        b64Out[d++] = BASE64_PAD;
     }
     
     /* terminate an return length */
@@ -100,6 +117,8 @@ long base64Encode(char *b64Out, long b64OutLen, const UInt8 *dataIn, long dataIn
 // ----------------------------------------------------------------------------
     
 /* decode string */
+// Returns the number of bytes decoded, or -1 if the output buffer is too small,
+// or if the string contains a character outside the Base64 alphabet.
 long base64Decode(const char *b64In, long b64InLen, UInt8 *dataOut, long dataOutlen)
 {
     
@@ -120,20 +139,38 @@ long base64Decode(const char *b64In, long b64InLen, UInt8 *dataOut, long dataOut
         return -1L;
     }
     
-    /* decode */
+    /* decode full 4-character groups */
+    // invalid characters are -1 in the table, so OR'ing the 4 lookups together
+    // leaves a negative value if any one of them is invalid.
     long i, d = 0L;
-    for (i = 0L; (i < b64InLen) /*&& ((d + 3) <= dataOutlen)*/; i += 4L) {
-        
-        /* place next 3 bytes into register */
-        UInt32                 reg24  = (_b64IndexOf(b64In[i+0L]) << 18) & 0xFC0000;
-        if ((i+1L)<b64InLen) { reg24 |= (_b64IndexOf(b64In[i+1L]) << 12) & 0x03F000; }
-        if ((i+2L)<b64InLen) { reg24 |= (_b64IndexOf(b64In[i+2L]) <<  6) & 0x000FC0; }
-        if ((i+3L)<b64InLen) { reg24 |= (_b64IndexOf(b64In[i+3L])      ) & 0x00003F; }
-
-                               dataOut[d++] = (UInt8)((reg24 >> 16) & 0xFF);
-        if ((i+2L)<b64InLen) { dataOut[d++] = (UInt8)((reg24 >>  8) & 0xFF); }
-        if ((i+3L)<b64InLen) { dataOut[d++] = (UInt8)((reg24      ) & 0xFF); }
+    long fullLen = b64InLen & ~3L;
+    for (i = 0L; i < fullLen; i += 4L) {
+        long c0 = B64_INDEX(b64In[i+0L]), c1 = B64_INDEX(b64In[i+1L]);
+        long c2 = B64_INDEX(b64In[i+2L]), c3 = B64_INDEX(b64In[i+3L]);
+        if ((c0 | c1 | c2 | c3) < 0L) {
+            return -1L; // invalid character
+        }
+        UInt32 reg24 = ((UInt32)c0 << 18) | ((UInt32)c1 << 12) | ((UInt32)c2 << 6) | (UInt32)c3;
+        dataOut[d+0L] = (UInt8)(reg24 >> 16);
+        dataOut[d+1L] = (UInt8)(reg24 >>  8);
+        dataOut[d+2L] = (UInt8)(reg24      );
+        d += 3L;
+    }
 
+    /* decode remaining 1 to 3 characters */
+    if (i < b64InLen) {
+        UInt32 reg24 = 0L;
+        long n;
+        for (n = 0L; (i + n) < b64InLen; n++) {
+            long c = B64_INDEX(b64In[i+n]);
+            if (c < 0L) {
+                return -1L; // invalid character
+            }
+            reg24 |= (UInt32)c << (18 - (6 * n));
+        }
+        // (1)X?, (2)XX==, (3)XXX=
+                       dataOut[d++] = (UInt8)((reg24 >> 16) & 0xFF);
+        if (n >= 3L) { dataOut[d++] = (UInt8)((reg24 >>  8) & 0xFF); }
     }
 
     return d;
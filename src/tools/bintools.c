@@ -177,7 +177,7 @@ UInt8 *binEncodeInt32(UInt8 *buf, int cnt, UInt32 val, utBool signExtend)
         /* fill excess space */
         if (cnt > 4) {
             UInt8 fill = (signExtend && (val & 0x80000000L))? 0xFF : 0x00;
-            memset(buf, cnt - 4, fill);
+            memset(buf, fill, cnt - 4);
             buf += cnt - 4;
             cnt = 4;
         }
@@ -48,6 +48,17 @@
 
 // ----------------------------------------------------------------------------
 
+// Data is copied into/out of the buffer in (at most) two contiguous segments.  
+// The producer copies data before publishing the new 'head', and the consumer 
+// copies data before publishing the new 'tail' (see BUFFER_SPSC).
+#if defined(__GNUC__)
+#  define BUFFER_BARRIER()      __sync_synchronize()
+#else
+#  define BUFFER_BARRIER()
+#endif
+
+// ----------------------------------------------------------------------------
+
 /* create buffer */
 CircleBuffer_t *bufferCreate(long size)
 {
@@ -71,11 +82,13 @@ void bufferDestroy(CircleBuffer_t *cb)
 }
 
 /* clear all data in buffer */
+// (this is a consumer operation, all data currently in the buffer is discarded)
 void bufferClear(CircleBuffer_t *cb)
 {
     if (cb) {
-        cb->head = 0L; // next available char
-        cb->tail = 0L; // fist valid char
+        long head = cb->head;
+        BUFFER_BARRIER();
+        cb->tail = head;
     }
 }
 
@@ -94,48 +107,115 @@ long bufferGetLength(CircleBuffer_t *cb)
     // return length of data currently in buffer
     if (!cb) {
         return 0;
-    } else
-    if (cb->head >= cb->tail) {
-        return cb->head - cb->tail;
     } else {
-        return cb->size - (cb->tail - cb->head);
+        long head = cb->head, tail = cb->tail;
+        return (head >= tail)? (head - tail) : (cb->size - (tail - head));
     }
 }
 
 // ----------------------------------------------------------------------------
 
+/* return the number of bytes available for reading, given head/tail */
+#define _BUFFER_LENGTH(C,H,T)   (((H) >= (T))? ((H) - (T)) : ((C)->size - ((T) - (H))))
+
+/* copy data from buffer position 'pos' (does not advance 'tail') */
+static void _bufferCopyOut(CircleBuffer_t *cb, long pos, UInt8 *d, long len)
+{
+    long first = cb->size - pos;
+    if (len <= first) {
+        memcpy(d, &cb->buff[pos], len);
+    } else {
+        memcpy(d, &cb->buff[pos], first);
+        memcpy(&d[first], cb->buff, len - first);
+    }
+}
+
+/* return length of string at 'pos' (not incl terminator), and whether it is terminated */
+static long _bufferStringLength(CircleBuffer_t *cb, long pos, long avail, utBool *terminated)
+{
+    long first = cb->size - pos;
+    if (first > avail) { first = avail; }
+    const UInt8 *p = (const UInt8*)memchr(&cb->buff[pos], 0, first);
+    if (p) {
+        *terminated = utTrue;
+        return p - &cb->buff[pos];
+    }
+    if (avail > first) {
+        p = (const UInt8*)memchr(cb->buff, 0, avail - first);
+        if (p) {
+            *terminated = utTrue;
+            return first + (p - cb->buff);
+        }
+    }
+    *terminated = utFalse;
+    return avail;
+}
+
+/* add data to the buffer (caller has checked available space) */
+static void _bufferPut(CircleBuffer_t *cb, const UInt8 *s, long len)
+{
+    long head  = cb->head;
+    long first = cb->size - head;
+    if (len <= first) {
+        memcpy(&cb->buff[head], s, len);
+        head += len;
+        if (head >= cb->size) { head = 0L; }
+    } else {
+        memcpy(&cb->buff[head], s, first);
+        memcpy(cb->buff, &s[first], len - first);
+        head = len - first;
+    }
+    BUFFER_BARRIER();
+    cb->head = head; // publish
+}
+
+/* remove 'len' bytes from the buffer */
+static void _bufferAdvanceTail(CircleBuffer_t *cb, long tail, long len)
+{
+    tail += len;
+    if (tail >= cb->size) { tail -= cb->size; }
+    BUFFER_BARRIER();
+    cb->tail = tail; // publish
+}
+
+/* return number of bytes which may be added to the buffer */
+static long _bufferGetFree(CircleBuffer_t *cb)
+{
+    long tail = cb->tail;
+    BUFFER_BARRIER();
+    return bufferGetSize(cb) - _BUFFER_LENGTH(cb, cb->head, tail);
+}
+
+/* return number of bytes available in the buffer, and the current tail */
+static long _bufferGetAvail(CircleBuffer_t *cb, long *tail)
+{
+    long head = cb->head;
+    BUFFER_BARRIER();
+    *tail = cb->tail;
+    return _BUFFER_LENGTH(cb, head, *tail);
+}
+
+// ----------------------------------------------------------------------------
+
 /* put character into buffer */
 utBool bufferPutChar(CircleBuffer_t *cb, UInt8 c)
 {
-    
-    /* save pointer to current head */
-    UInt8 *p = &cb->buff[cb->head];
-    
-    /* advance head */
-    int newHead = cb->head + 1;
-    if (newHead >= cb->size) { 
-        //logDEBUG(LOGSRC,"bufferPutChar", "Buffer wrap-around");
-        newHead = 0; 
-    }
-    if (newHead == cb->tail) {
+    if (_bufferGetFree(cb) <= 0L) {
         return utFalse; // buffer overflow
     }
-    
-    /* save char */
-    *p = c;
-    cb->head = newHead;
+    _bufferPut(cb, &c, 1L);
     return utTrue;
-    
 }
 
 /* get character from buffer */
 int bufferGetChar(CircleBuffer_t *cb)
 {
-    if (cb->head == cb->tail) {
+    long tail;
+    if (_bufferGetAvail(cb, &tail) <= 0L) {
         return -1;
     } else {
-        UInt8 c = cb->buff[cb->tail++];
-        if (cb->tail >= cb->size) { cb->tail = 0; }
+        UInt8 c = cb->buff[tail];
+        _bufferAdvanceTail(cb, tail, 1L);
         return c;
     }
 }
@@ -147,17 +227,14 @@ int bufferPutData(CircleBuffer_t *cb, const void *data, int dataLen)
 {
     
     /* precheck availability in buffer */
-    if (dataLen >= (bufferGetSize(cb) - bufferGetLength(cb))) {
+    if (dataLen >= _bufferGetFree(cb)) {
         return 0;
     }
     
     /* add data */
-    int i;
-    UInt8 *s = (UInt8*)data;
-    for (i = 0; i < dataLen; i++) {
-        bufferPutChar(cb, s[i]);
+    if (dataLen > 0) {
+        _bufferPut(cb, (const UInt8*)data, dataLen);
     }
-    
     return dataLen;
     
 }
@@ -165,25 +242,22 @@ int bufferPutData(CircleBuffer_t *cb, const void *data, int dataLen)
 /* get data block from buffer */
 int bufferGetData(CircleBuffer_t *cb, void *data, int dataLen)
 {
+    long tail, avail;
     if (!cb) {
         return -1;
     } else
-    if (bufferGetLength(cb) <= 0) {
+    if ((avail = _bufferGetAvail(cb, &tail)) <= 0L) {
         return 0;
     } else {
         UInt8 *d = (UInt8*)data;
-        int i = 0;
-        for (;i < dataLen; i++) {
-            int c = bufferGetChar(cb);
-            if (c < 0) {
-                // we've run out of buffer before we got to the end of the data
-                memset(&d[i], 0, dataLen - i); // clear remainder of buffer
-                break;
-            } else {
-                d[i] = (UInt8)c;
-            }
+        int len = (dataLen <= avail)? dataLen : (int)avail;
+        _bufferCopyOut(cb, tail, d, len);
+        _bufferAdvanceTail(cb, tail, len);
+        if (len < dataLen) {
+            // we've run out of buffer before we got to the end of the data
+            memset(&d[len], 0, dataLen - len); // clear remainder of buffer
         }
-        return i;
+        return len;
     }
 }
 
@@ -195,27 +269,36 @@ utBool bufferPutString(CircleBuffer_t *cb, const char *s)
     
     /* precheck availability in buffer */
     int slen = strlen(s) + 1; // include terminator in length
-    if (slen >= (bufferGetSize(cb) - bufferGetLength(cb))) {
+    if (slen >= _bufferGetFree(cb)) {
         return utFalse;
     }
     
-    /* add string */
-    // could be optimized (most of the time this strng will not wrap around)
-    for (; (*s); s++) {
-        bufferPutChar(cb, *s);
-    }
-    
-    /* add string terminator */
-    bufferPutChar(cb, 0);
-    
+    /* add string, and terminator */
+    _bufferPut(cb, (const UInt8*)s, slen);
     return utTrue;
     
 }
 
+/* copy the next string (up to 'dlen - 1' chars) into 'd', return the number of bytes consumed */
+static long _bufferCopyString(CircleBuffer_t *cb, long tail, long avail, char *d, int dlen, int *len)
+{
+    utBool term = utFalse;
+    long slen = _bufferStringLength(cb, tail, avail, &term);
+    long clen = (slen < (long)(dlen - 1))? slen : (long)(dlen - 1);
+    if (d && (dlen > 0)) {
+        _bufferCopyOut(cb, tail, (UInt8*)d, clen);
+        d[clen] = 0; // terminate
+    }
+    *len = (int)clen;
+    return (term && (clen == slen))? (clen + 1L) : clen; // incl terminator
+}
+
 /* get null-terminated string from buffer */
+// If the string is longer than 'dlen - 1', the remainder is returned on the next call.
 int bufferGetString(CircleBuffer_t *cb, char *d, int dlen)
 {
-    if (bufferGetLength(cb) <= 0) {
+    long tail, avail = _bufferGetAvail(cb, &tail);
+    if (avail <= 0L) {
         
         /* buffer is empty */
         return 0;
@@ -223,33 +306,13 @@ int bufferGetString(CircleBuffer_t *cb, char *d, int dlen)
     } else {
         
         /* if destination string is NULL, then just throw away the next string */
-        if (!d) { dlen = bufferGetSize(cb); }
+        if (!d) { dlen = bufferGetSize(cb) + 1; }
         
         /* get */
-        int i = 0;
-        for (; i < (dlen - 1); i++) { // <-- save room for terminator
-            int c = bufferGetChar(cb);
-            if (c < 0) {
-                // we've run out of buffer before we got to the terminator
-                if (d) { d[i] = 0; } // terminate
-                break;
-            } else
-            if (c == 0) {
-                // here's the terminator
-                if (d) { d[i] = 0; } // terminate
-                break;
-            } else {
-                if (d) { d[i] = (UInt8)c; }
-            }
-        }
-        
-        /* check final termination */
-        if (i >= (dlen - 1)) {
-            // we've run out of space in the destination string
-            if (d) { d[dlen - 1] = 0; } // make sure string is terminated
-        }
-        
-        return strlen(d);
+        int len = 0;
+        long used = _bufferCopyString(cb, tail, avail, d, dlen, &len);
+        _bufferAdvanceTail(cb, tail, used);
+        return len;
         
     }
 }
@@ -259,49 +322,19 @@ int bufferGetString(CircleBuffer_t *cb, char *d, int dlen)
 /* copy the next string into the buffer, do not advance buffer pointers */
 char *bufferCopyString(CircleBuffer_t *cb, char *d, int dlen)
 {
-    if (bufferGetLength(cb) <= 0) {
+    long tail, avail = _bufferGetAvail(cb, &tail);
+    if ((avail <= 0L) || !d) {
         
         /* buffer is empty */
         return (char*)0;
         
     } else {
         
-        /* save current head/tail values */
-        int oldHead = cb->head;
-        int oldTail = cb->tail;
-        
-        /* if destination string is NULL, then just throw away the next string */
-        if (!d) { dlen = bufferGetSize(cb); }
-        
         /* copy */
-        int i = 0;
-        for (; i < (dlen - 1); i++) { // <-- save room for terminator
-            int c = bufferGetChar(cb);
-            if (c < 0) {
-                // we've run out of buffer before we got to the terminator
-                if (d) { d[i] = 0; } // terminate
-                break;
-            } else
-            if (c == 0) {
-                // here's the terminator
-                if (d) { d[i] = 0; } // terminate
-                break;
-            } else {
-                if (d) { d[i] = (UInt8)c; }
-            }
-        }
-        
-        /* check final termination */
-        if (i >= (dlen - 1)) {
-            // we've run out of space in the destination string
-            if (d) { d[dlen - 1] = 0; } // make sure string is terminated
-        }
-        
-        /* restore prior values */
-        cb->head = oldHead;
-        cb->tail = oldTail;
-        
+        int len = 0;
+        _bufferCopyString(cb, tail, avail, d, dlen, &len);
         return d;
+        
     }
 }
 
@@ -311,11 +344,17 @@ char *bufferCopyString(CircleBuffer_t *cb, char *d, int dlen)
 int bufferGetStringCount(CircleBuffer_t *cb)
 {
     int count = 0;
-    int t = cb->tail;
-    for (;t != cb->head;) {
-        if (!cb->buff[t]) { count++; }
-        t++;
-        if (t > cb->size) { t = 0; }
+    long tail, avail = _bufferGetAvail(cb, &tail);
+    while (avail > 0L) {
+        utBool term = utFalse;
+        long slen = _bufferStringLength(cb, tail, avail, &term);
+        if (!term) {
+            break;
+        }
+        count++;
+        tail  += slen + 1L;
+        avail -= slen + 1L;
+        if (tail >= cb->size) { tail -= cb->size; }
     }
     return count;
 }
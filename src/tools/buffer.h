@@ -27,10 +27,18 @@ extern "C" {
 
 // ----------------------------------------------------------------------------
 
+// With a single producer thread (bufferPut...) and a single consumer thread
+// (bufferGet..., bufferClear), the buffer may be accessed without a lock when
+// BUFFER_SPSC is defined.  The 'head' is only modified by the producer, and the
+// 'tail' is only modified by the consumer.
+#if defined(__GNUC__)
+#  define BUFFER_SPSC
+#endif
+
 typedef struct
 {
-    long                head;
-    long                tail;
+    volatile long       head;    // next available byte (modified by producer only)
+    volatile long       tail;    // first valid byte (modified by consumer only)
     long                size;
     UInt8               buff[1]; // Len='0' is preferred, but some compiler don't allow this
 } CircleBuffer_t;
@@ -38,6 +46,7 @@ typedef struct
 // ----------------------------------------------------------------------------
 
 CircleBuffer_t *bufferCreate(long size);
+void bufferDestroy(CircleBuffer_t *cb);
 long bufferGetSize(CircleBuffer_t *cb);
 long bufferGetLength(CircleBuffer_t *cb);
 void bufferClear(CircleBuffer_t *cb);
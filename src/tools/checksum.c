@@ -90,8 +90,12 @@ int cksumCalcCharXOR(const char *d, ChecksumXOR_t *cksum)
 
 // ----------------------------------------------------------------------------
 
+// The 'cksum...Fletcher' functions use this single shared context, and are retained
+// for compatibility.  Each protocol instance/connection should own its own
+// 'ChecksumFletcher_t' context and use the '_cksum...Fletcher' functions instead.
 static ChecksumFletcher_t    fletcherCalc = { { 0, 0 } };
 
+/* reset the Fletcher checksum context */
 void _cksumResetFletcher(ChecksumFletcher_t *fcsv)
 {
     fcsv->C[0] = 0;
@@ -112,6 +116,7 @@ ChecksumFletcher_t *cksumGetFletcherValues(ChecksumFletcher_t *fcs)
 
 // ----------------------------------------------------------------------------
 
+/* return the Fletcher checksum value for the context (in 'fcs') */
 ChecksumFletcher_t *_cksumGetFletcherChecksum(ChecksumFletcher_t *fcsv, ChecksumFletcher_t *fcs)
 {
     fcs->C[0] = fcsv->C[0] - fcsv->C[1];
@@ -128,15 +133,34 @@ ChecksumFletcher_t *cksumGetFletcherChecksum(ChecksumFletcher_t *fcs)
 
 // ----------------------------------------------------------------------------
 
+/* add the specified bytes to the Fletcher checksum context */
+// The sums are only needed modulo 256, so they are accumulated in 32-bit registers
+// (which wrap modulo 2^32, a multiple of 256) and reduced to 8 bits once at the end.
+// Bytes are added 8 at a time, using:
+//   C1 += (n * C0) + (n * b[0]) + ((n-1) * b[1]) + ... + (1 * b[n-1])
+//   C0 += b[0] + b[1] + ... + b[n-1]
 void _cksumCalcFletcher(ChecksumFletcher_t *fcsv, const UInt8 *buf, int bufLen)
 {
-    int i;
-    for (i = 0; i < bufLen; i++) {
-        fcsv->C[0] += buf[i];
-        fcsv->C[1] += fcsv->C[0];
+    UInt32 c0 = (UInt32)fcsv->C[0];
+    UInt32 c1 = (UInt32)fcsv->C[1];
+    const UInt8 *b = buf, *bEnd = buf + ((bufLen > 0)? bufLen : 0);
+    for (; (bEnd - b) >= 8; b += 8) {
+        c1 += (c0 << 3) + 
+            (8 * (UInt32)b[0]) + (7 * (UInt32)b[1]) + (6 * (UInt32)b[2]) + (5 * (UInt32)b[3]) +
+            (4 * (UInt32)b[4]) + (3 * (UInt32)b[5]) + (2 * (UInt32)b[6]) +      (UInt32)b[7];
+        c0 += (UInt32)b[0] + (UInt32)b[1] + (UInt32)b[2] + (UInt32)b[3] +
+              (UInt32)b[4] + (UInt32)b[5] + (UInt32)b[6] + (UInt32)b[7];
     }
+    for (; b < bEnd; b++) {
+        c0 += *b;
+        c1 += c0;
+    }
+    fcsv->C[0] = (UInt8)(c0 & 0xFF);
+    fcsv->C[1] = (UInt8)(c1 & 0xFF);
 }
 
+/* add the specified bytes to the shared Fletcher checksum */
+// Not reentrant, use '_cksumCalcFletcher' with a caller owned context instead.
 void cksumCalcFletcher(const UInt8 *buf, int bufLen)
 {
     _cksumCalcFletcher(&fletcherCalc, buf, bufLen);
@@ -144,10 +168,11 @@ void cksumCalcFletcher(const UInt8 *buf, int bufLen)
 
 // ----------------------------------------------------------------------------
 
+/* return true if the checksum value for the context matches 'fcsTest' */
 utBool _cksumEqualsFletcher(ChecksumFletcher_t *fcsCalc, ChecksumFletcher_t *fcsTest)
 {
     ChecksumFletcher_t fcsa;
-    _cksumGetFletcherChecksum(&fcsa, fcsCalc);
+    _cksumGetFletcherChecksum(fcsCalc, &fcsa);
     return ((fcsa.C[0] == fcsTest->C[0]) && (fcsa.C[1] == fcsTest->C[1]))? utTrue : utFalse;
 }
 
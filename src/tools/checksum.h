@@ -31,6 +31,8 @@ extern "C" {
 
 typedef UInt8   ChecksumXOR_t;
 
+// Fletcher checksum running sums (the context passed to the '_cksum...Fletcher'
+// functions), or the final 2 byte checksum value.
 typedef struct {
     UInt8       C[2];
 } ChecksumFletcher_t;
@@ -1270,61 +1270,6 @@ const char *comPortName(ComPort_t *com)
 
 // ----------------------------------------------------------------------------
 
-/* the the timeout vtime */
-#if defined(TARGET_WINCE)
-// not supported 
-#else
-static utBool _comPortSetVtimeMS(ComPort_t *com, long timeoutMS)
-{
-    if (comPortIsOpen(com)) {
-        struct termios options;
-        tcgetattr(com->read_fd, &options);
-        if (timeoutMS <= 0L) {
-            options.c_cc[VTIME] = 0L;                   // block forever
-        } else {
-            long deciSec = (timeoutMS + 99L) / 100L;    // millisec => decisec (round up)
-            if (deciSec <= 0L) {
-                options.c_cc[VTIME] = 1;                // don't let it be zero
-            } else
-            if (deciSec <= 255L) {
-                options.c_cc[VTIME] = deciSec;          // range 1 <= VTIME <= 255
-            } else {
-                // internal error
-                logWARNING(LOGSRC,"Warning: VTIME cannot be > 255 [%ld]", deciSec);
-                options.c_cc[VTIME] = 255;              // max 255
-            }
-        }
-        com->lastVtimeMS = (long)options.c_cc[VTIME] * 100L; // deciSec => milliSec
-        if (tcsetattr(com->read_fd, TCSANOW, &options) == 0) {
-            // success
-            errno = 0;
-            return utTrue;
-        } else {
-            // error (error in 'errno')
-            return utFalse;
-        }
-    } else {
-        errno = EBADF;
-        return utFalse;
-    }
-}
-#endif // !defined(TARGET_WINCE)
-
-#if defined(TARGET_WINCE)
-// not supported
-#else
-static long _comPortGetVtimeMS(ComPort_t *com)
-{
-    if (comPortIsOpen(com)) {
-        return com->lastVtimeMS;
-    } else {
-        return -1L;
-    }
-}
-#endif // !defined(TARGET_WINCE)
-
-// ----------------------------------------------------------------------------
-
 /* return the 'read' ComPort file descriptor */
 #if defined(TARGET_WINCE)
 // not supported
@@ -1550,7 +1495,12 @@ int comPortGetAvail(ComPort_t *com, long timeoutMS)
 {
     // Do not check 'com->push' here!
     // This routine is for checking to see if we have data available on the 
-    // physical com port.
+    // physical com port (which includes data already read into 'rxBuf').
+
+    /* already buffered? */
+    if (com->rxLen > 0) {
+        return com->rxLen;
+    }
 
     /* no timeout? */
     if (timeoutMS <= 0L) {
@@ -1560,14 +1510,11 @@ int comPortGetAvail(ComPort_t *com, long timeoutMS)
     }
     
     /* wait until data is available */
-    fd_set rfds;
-    struct timeval tv;
-    FD_ZERO(&rfds);
-    FD_SET(com->read_fd, &rfds);
-    tv.tv_sec  = timeoutMS / 1000L;
-    tv.tv_usec = (timeoutMS % 1000L) * 1000L;
-    select(com->read_fd + 1, &rfds, 0, 0, &tv);
-    if (!FD_ISSET(com->read_fd, &rfds)) { return 0; } // timeout
+    struct pollfd pfd;
+    pfd.fd      = com->read_fd;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, (int)timeoutMS) <= 0) { return 0; } // timeout
 
     /* return number of available bytes */
     // since the above did not timeout, we will have at least 1 byte available.
@@ -1575,7 +1522,7 @@ int comPortGetAvail(ComPort_t *com, long timeoutMS)
     int nBytesAvail;
     int request = BYTES_AVAIL_IOCTIL_REQUEST;
     int status = ioctl(com->read_fd, request, &nBytesAvail);
-    return (status >= 0)? nBytesAvail : 1;
+    return ((status >= 0) && (nBytesAvail > 0))? nBytesAvail : 1;
 #else
     return 1;
 #endif
@@ -1585,11 +1532,158 @@ int comPortGetAvail(ComPort_t *com, long timeoutMS)
 
 // ----------------------------------------------------------------------------
 
+/* fill the ComPort read buffer */
+// The port is left with VMIN=0/VTIME=0, and the wait is performed by 'poll', so
+// a single 'read' returns everything the driver has queued (up to the buffer size).
+// Returns the number of bytes read, '0' on timeout, or '-1' on error/EOF.
+#if defined(TARGET_WINCE)
+// not supported
+#else
+#define MAX_POLL_MS   25500L
+static int _comPortFill(ComPort_t *com, long timeoutMS)
+{
+    for (;;) {
+
+        /* closed (externally)? */
+        if (!comPortIsOpen(com)) {
+            com->error = COMERR_EOF;
+            errno = ENODEV;
+            return -1;
+        }
+
+        /* wait for data */
+        // A negative timeout waits indefinitely, however the wait is sliced so that
+        // we can keep track of when the port is closed (externally).
+        long pms = ((timeoutMS < 0L) || (timeoutMS > MAX_POLL_MS))? MAX_POLL_MS : timeoutMS;
+        struct pollfd pfd;
+        pfd.fd      = com->read_fd;
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+        int p = poll(&pfd, 1, (int)pms);
+        if (p < 0) {
+            if (errno == EINTR) { continue; }
+            int sv_errno = errno;
+            logWARNING(LOGSRC,"ComPort error %s : [%d] %s", com->dev, sv_errno, strerror(sv_errno));
+            com->error = COMERR_EOF;
+            errno = sv_errno;
+            return -1;
+        } else
+        if (p == 0) {
+            if (timeoutMS < 0L) {
+                continue; // wait some more
+            } else
+            if (timeoutMS > pms) {
+                timeoutMS -= pms;
+                continue; // wait some more
+            }
+            com->error = COMERR_TIMEOUT;
+            errno = ETIME;
+            return 0;
+        }
+
+        /* read everything available */
+        errno = 0; // clear 'errno'
+        int r = read(com->read_fd, com->rxBuf, sizeof(com->rxBuf));
+        if (r > 0) {
+            com->rxHead = 0;
+            com->rxLen  = r;
+            return r;
+        } else
+        if (r == 0) {
+            // 'poll' reported the port readable (or hung-up), yet nothing was read: EOF
+            com->error = COMERR_EOF;
+            errno = ENODEV;
+            logWARNING(LOGSRC,"ComPort error %s (EOF?) : [%d] %s", com->dev, com->error, strerror(com->error));
+            return -1;
+        } else
+        if ((errno == EINTR) || (errno == EAGAIN)) {
+            continue;
+        } else {
+            // error: com port closed?
+            int sv_errno = errno;
+            com->error = COMERR_EOF;
+            logWARNING(LOGSRC,"ComPort error %s : [%d] %s", com->dev, sv_errno, strerror(sv_errno));
+            errno = sv_errno;
+            return -1;
+        }
+
+    }
+}
+#endif // defined(TARGET_WINCE)
+
+/* echo a received character (ECHO must be on) */
+#if defined(TARGET_WINCE)
+// not supported
+#else
+static void _comPortEcho(ComPort_t *com, UInt8 ch)
+{
+    if (ch == KEY_RETURN) {
+        // follow CR with LF
+        comPortWrite(com, "\r\n", 2);
+    } else
+    if (KEY_IsBackspace(ch) && COMOPT_IsBackspace(com)) {
+        // single character backspace
+        comPortWrite(com, "\b \b", 3);
+    } else
+    if ((ch == KEY_CONTROL_D) && COMOPT_IsBackspace(com)) {
+        // handled by the caller
+    } else
+    if (ch == KEY_ESCAPE) {
+        if (!COMOPT_IgnoreEscape(com)) {
+            // echo escape character
+            comPortWrite(com, &ch, 1);
+        }
+    } else {
+        // echo simple character
+        comPortWrite(com, &ch, 1);
+    }
+}
+#endif // defined(TARGET_WINCE)
+
+/* read a single byte from the push-back character, or read buffer */
+// Returns '1' if a byte was read, '0' on timeout, or '-1' on error/EOF.
+// 'timeoutMS' is only used if the read buffer is empty.
+#if defined(TARGET_WINCE)
+// not supported
+#else
+static int _comPortReadByte(ComPort_t *com, UInt8 *ch, long timeoutMS)
+{
+    if (com->push > 0) {
+        com->last = (UInt8)com->push;
+        com->push = -1; // clear push
+    } else {
+        if (com->rxLen <= 0) {
+            if (timeoutMS == 0L) {
+                com->error = COMERR_TIMEOUT;
+                errno = ETIME;
+                return 0;
+            }
+            int r = _comPortFill(com, timeoutMS);
+            if (r <= 0) {
+                // timeout/error (com->error/errno already set)
+                return r;
+            }
+        }
+        com->last = com->rxBuf[com->rxHead++];
+        com->rxLen--;
+        if (COMOPT_IsEcho(com)) {
+            _comPortEcho(com, com->last);
+        }
+        if (COMOPT_IsLogDebug(com) && com->logger) { 
+            (*com->logger)(&com->last,1); 
+        }
+    }
+    *ch = com->last;
+    return 1;
+}
+#endif // defined(TARGET_WINCE)
+
+// ----------------------------------------------------------------------------
+
 /* read specified number of bytes from ComPort */
 #if defined(TARGET_WINCE)
 // not yet implemented
 #else
-#define MAX_VTIME_MS   25500L
 int comPortRead(ComPort_t *com, UInt8 *buf, int len, long timeoutMS)
 {
     // Possible (non-exclusive) 'errno' values:
@@ -1618,12 +1712,29 @@ int comPortRead(ComPort_t *com, UInt8 *buf, int len, long timeoutMS)
     /* read bytes */
     int n = 0;
     for (;n < len;) {
-        
+
+        /* copy buffered bytes */
+        if ((com->push <= 0) && (com->rxLen > 0) && !COMOPT_IsEcho(com)) {
+            // bulk copy (no per-byte handling required)
+            int c = ((len - n) < com->rxLen)? (len - n) : com->rxLen;
+            const UInt8 *b = &com->rxBuf[com->rxHead];
+            if (buf) { memcpy(&buf[n], b, c); }
+            if (COMOPT_IsLogDebug(com) && com->logger) { 
+                (*com->logger)(b,c); 
+            }
+            com->last    = b[c - 1];
+            com->rxHead += c;
+            com->rxLen  -= c;
+            n += c;
+            continue;
+        }
+
         /* timeout? */
+        // only checked when we would otherwise need to wait for more data
         long tms = timeoutMS;
-        if (tms >= 0L) {
+        if ((tms >= 0L) && (com->push <= 0) && (com->rxLen <= 0)) {
             tms -= utcGetDeltaMillis(0, &startTime); // subtract elapsed time
-            if ((tms <= 0L) && (com->push <= 0) && (com->avail <= 0)) { // timeout
+            if (tms <= 0L) { // timeout
                 if (buf) { buf[n] = 0; }
                 errno = ETIME; // not necessary, since we're returning a value >= 0
                 com->error = COMERR_TIMEOUT;
@@ -1631,151 +1742,26 @@ int comPortRead(ComPort_t *com, UInt8 *buf, int len, long timeoutMS)
             }
         }
 
-        /* poll/read */
-        if (com->push > 0) {
-            
-            /* use previously pushed char */
-            com->last = (UInt8)com->push;
-            com->push = -1; // clear push
-            if (buf) { buf[n] = com->last; }
-            n++;
-            
-        } else {
-            
-            /* poll (check for available data) */
-            //logDEBUG(LOGSRC,FTN, "avail=%d, tms=%ld", com->avail, tms);
-            if ((com->avail <= 0) && (tms > 0L)) {
-                if (COMOPT_IsVTimeout(com)) {
-                    // Note: 'tms' will be rounded up to the next highest 100ms, and
-                    // will be clipped at 25500 ms (max value for VTIME).
-                    if (!_comPortSetVtimeMS(com, tms)) {
-                        // ENODEV/EIO is likely here (for 'rfcomm0')
-                        int sv_errno = errno;
-                        logWARNING(LOGSRC,"ComPort error %s : [%d] %s", com->dev, sv_errno, strerror(sv_errno));
-                        if (buf) { buf[n] = 0; }
-                        errno = sv_errno;
-                        return -1;
-                    }
-                } else {
-                    // wait for available data
-                    int avail = comPortGetAvail(com, tms);
-                    if (avail <= 0) {
-                        // timeout/error
-                        if (buf) { buf[n] = 0; }
-                        errno = ETIME;
-                        com->error = COMERR_TIMEOUT; // may be EOF
-                        return n;
-                    }
-                    com->avail = avail;
-                }
-            } else {
-                if (COMOPT_IsVTimeout(com)) {
-                    // Either data is available for reading (without blocking), or the
-                    // caller wishes this function to block forever (ie. no timeout)
-                    // However, set a minimum timeout anyway to allow us to keep track
-                    // of when the port is closed (externally). We'll still not return
-                    // until the number of requested bytes have been read.
-                    if (!_comPortSetVtimeMS(com, MAX_VTIME_MS)) {
-                        // ENODEV/EIO is likely here (for 'rfcomm0')
-                        int sv_errno = errno;
-                        logWARNING(LOGSRC,"ComPort error %s : [%d] %s", com->dev, sv_errno, strerror(sv_errno));
-                        if (buf) { buf[n] = 0; }
-                        errno = sv_errno;
-                        return -1;
-                    }
-                } else {
-                    //logDEBUG(LOGSRC,FTN, "blocking wait (avail = %d)", com->avail);
-                }
-            }
-            
-            /* read 1 byte */
-            // Either ...
-            // - VTIME is in effect and we'll possibly be timing out, or
-            // - a character available (avail > 0) and it will be returned, or
-            // - we will be blocking here until a character becomes available, or
-            // - we will get an error.
-            struct timeval readTS;
-            utcGetTimestamp(&readTS);
-            errno = 0; // clear 'errno'
-            int r = read(com->read_fd, &com->last, 1); // VTIME may be in effect
-            if (r < 0) {
-                // error: com port closed?
-                if (buf) { buf[n] = 0; } // terminate buffer
-                com->avail = 0;
-                com->error = COMERR_EOF;
-                // error already in 'errno'
-                logWARNING(LOGSRC,"ComPort error %s : [%d] %s", com->dev, com->error, strerror(com->error));
-                return -1;
-            } else
-            if (r == 0) {
-                // A read length of 0 can mean an EOF, or a TIMEOUT if VTIME is in effect.
-                //int readErrno = errno;
-                //logDEBUG(LOGSRC,"Read EOF/TIMEOUT? %s: [%d]%s", com->dev, readErrno, strerror(readErrno));
-                com->avail = 0; // in any case nothing is available
-                if (COMOPT_IsVTimeout(com)) {
-                    long vtimeMS = _comPortGetVtimeMS(com);
-                    long deltaMS = utcGetDeltaMillis(0, &readTS) + 50L; // allow 50ms window
-                    // Allow a margin on the timeout window when checking for EOF.
-                    // If the elapsed time is less than what the timeout was set for, then
-                    // an EOF is likely, but lets be sure of it by setting a wide enough
-                    // time window.  The worst case is that the EOF occurred close enough
-                    // to the expired timeout that we may try to read of a closed file
-                    // descriptor again.  Hopefully, however, the next time around we will
-                    // again get an EOF error right away and return accordingly.
-                    if (deltaMS < vtimeMS) {
-                        // this means that we were interrupted before timeout occured, EOF likely.
-                        //logDEBUG(LOGSRC,"VTIME (%ld<%ld) ... [%s]", deltaMS, vtimeMS, com->dev);
-                        if (buf) { buf[n] = 0; }
-                        com->error = COMERR_EOF;
-                        errno = ENODEV;
-                        return -1;
-                    } else {
-                        // assume timeout, continue loop
-                    }
-                } else {
-                    // assume an EOF
-                    if (buf) { buf[n] = 0; }
-                    com->error = COMERR_EOF;
-                    errno = ENODEV;
-                    logWARNING(LOGSRC,"ComPort error %s (EOF?) : [%d] %s", com->dev, com->error, strerror(com->error));
-                    return -1;
-                }
-            } else
-            if (r == 1) {
-                if (buf) { buf[n] = com->last; }
-                n++;
-                if (com->avail > 0) { com->avail--; } // decrement available
-                if (COMOPT_IsEcho(com)) {
-                    // perform the following iff ECHO is on
-                    if (com->last == KEY_RETURN) {
-                        // follow CR with LF
-                        comPortWrite(com, "\r\n", 2);
-                    } else
-                    if (KEY_IsBackspace(com->last) && COMOPT_IsBackspace(com)) {
-                        // single character backspace
-                        comPortWrite(com, "\b \b", 3);
-                    } else
-                    if ((com->last == KEY_CONTROL_D) && COMOPT_IsBackspace(com)) {
-                        // backspace over all that we've just entered
-                        for (; n > 1; n--) { comPortWrite(com, "\b \b", 3); }
-                        if (buf) { buf[0] = com->last; }
-                        n = 1;
-                    } else
-                    if (com->last == KEY_ESCAPE) {
-                        if (!COMOPT_IgnoreEscape(com)) {
-                            // echo escape character
-                            comPortWrite(com, &com->last, 1);
-                        }
-                    } else {
-                        // echo simple character
-                        comPortWrite(com, &com->last, 1);
-                    }
-                }
-                if (COMOPT_IsLogDebug(com) && com->logger) { 
-                    (*com->logger)(&com->last,1); 
-                }
-            }
-            
+        /* read 1 byte (push-back, echo, or wait for data) */
+        UInt8 ch;
+        int r = _comPortReadByte(com, &ch, tms);
+        if (r < 0) {
+            // error: com port closed? (com->error/errno already set)
+            if (buf) { buf[n] = 0; } // terminate buffer
+            return -1;
+        } else
+        if (r == 0) {
+            // timeout
+            if (buf) { buf[n] = 0; }
+            return n;
+        }
+        if (buf) { buf[n] = ch; }
+        n++;
+        if ((ch == KEY_CONTROL_D) && COMOPT_IsEcho(com) && COMOPT_IsBackspace(com)) {
+            // backspace over all that we've just entered
+            for (; n > 1; n--) { comPortWrite(com, "\b \b", 3); }
+            if (buf) { buf[0] = ch; }
+            n = 1;
         }
        
     }
@@ -2002,8 +1988,9 @@ int _comPortReadLine(ComPort_t *com, char *buf, int startNdx, int maxLen, long t
     for (;n < maxLen;) {
         
         /* check accumulated timeout */
+        // only checked when we would otherwise need to wait for more data
         long tms = timeoutMS;
-        if (tms >= 0L) {
+        if ((tms >= 0L) && (com->push <= 0) && (com->rxLen <= 0)) {
             tms -= utcGetDeltaMillis(0, &startTime); // subtract elapsed time
             if (tms <= 0L) { 
                 // accumulated timeout
@@ -2013,9 +2000,9 @@ int _comPortReadLine(ComPort_t *com, char *buf, int startNdx, int maxLen, long t
             }
         }
         
-        /* read byte */
+        /* read byte (from the read buffer, if available) */
         UInt8 ch, last = com->last; // save last last
-        int r = comPortRead(com, &ch, 1, tms);
+        int r = _comPortReadByte(com, &ch, tms);
         if (r < 0) {
             // error: com port closed?
             if (buf) { buf[n] = 0; }
@@ -2113,8 +2100,9 @@ int comPortReadSequence(ComPort_t *com, const UInt8 *seq, long timeoutMS)
     for (;seq[h] != 0;) {
         
         /* check accumulated timeout */
+        // only checked when we would otherwise need to wait for more data
         long tms = timeoutMS;
-        if (tms >= 0L) {
+        if ((tms >= 0L) && (com->push <= 0) && (com->rxLen <= 0)) {
             tms -= utcGetDeltaMillis(0, &startTime); // subtract elapsed time
             if (tms <= 0L) { 
                 // accumulated timeout
@@ -2123,9 +2111,9 @@ int comPortReadSequence(ComPort_t *com, const UInt8 *seq, long timeoutMS)
             }
         }
         
-        /* read data */
+        /* read data (from the read buffer, if available) */
         UInt8 ch;
-        int len = comPortRead(com, &ch, 1, tms);
+        int len = _comPortReadByte(com, &ch, tms);
         if (len < 0) {
             // com port closed?
             logINFO(LOGSRC,"ComPort closed?\n");
@@ -2221,8 +2209,9 @@ int comPortFlush(ComPort_t *com, long timeoutMS)
     // flush data received, but not read
     //logDEBUG(LOGSRC,"tcflush ...");
     tcflush(com->read_fd, TCIFLUSH);
-    com->avail =  0; // clear what we know about available bytes
-    com->push  = -1; // clear any 'pushed' bytes
+    com->rxHead =  0; // discard buffered bytes
+    com->rxLen  =  0;
+    com->push   = -1; // clear any 'pushed' bytes
     
     /* forced timeout? */
     // timeout < 0, not allowed
@@ -205,7 +205,7 @@ extern "C" {
 #define COMOPT_ECHO                 (0x0001)
 #define COMOPT_BACKSPACE            (0x0004)
 #define COMOPT_PRINTABLE            (0x0008)
-#define COMOPT_VTIMEOUT             (0x0010)
+#define COMOPT_VTIMEOUT             (0x0010)  // obsolete: reads are 'poll' driven
 #define COMOPT_NOESCAPE             (0x0020)
 
 #define COMOPT_IsLogDebug(C)        ((C)? ((C)->flags & COMOPT_LOGDEBUG ) : 0)
@@ -244,6 +244,11 @@ extern "C" {
 
 // ----------------------------------------------------------------------------
 
+/* read buffer size (Linux, Cygwin, etc) */
+#if !defined(COMPORT_RX_BUFFER_SIZE)
+#  define COMPORT_RX_BUFFER_SIZE    512
+#endif
+
 #if defined(TARGET_WINCE)
 typedef DWORD   ComSpeed_t;
 #else
@@ -261,8 +266,9 @@ typedef struct
     int         read_fd;                // read file descriptor
     int         write_fd;               // write file descriptor
     UInt8       last;                   // last character read
-    int         avail;                  // available bytes (without blocking)
-    long        lastVtimeMS;            // last VTIME * 100 (range 0 <= VTIME <= 25500)
+    UInt8       rxBuf[COMPORT_RX_BUFFER_SIZE]; // bytes read, but not yet returned
+    int         rxHead;                 // index of next byte in 'rxBuf'
+    int         rxLen;                  // number of bytes remaining in 'rxBuf'
 #endif
 
 // --- All
@@ -0,0 +1,275 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  Sparse time/device index for appended record files.
+//  A sidecar file ("<file>.idx") holds one "<offset>,<timestamp>,<device>" line
+//  for the first record of each run of records from the same device, and for
+//  every 'interval' records thereafter.  'fidxQuery' uses the index to return
+//  the byte ranges of the data file which may contain the records of a device
+//  and/or time range, so that the remainder of the file need not be read.
+// ---
+// Notes:
+//  - Record timestamps are assumed to be non-decreasing per device (events are
+//    sent by the client oldest first).  The records of the segment following an
+//    entry are then no later than the next entry for the same device.
+//  - Records preceding the first entry (ie. written before the index was enabled)
+//    are not indexed, and are always included in the query result.
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h" // TARGET_WINCE
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file
+#include "custom/defaults.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "custom/log.h"
+
+#include "tools/stdtypes.h"
+#include "tools/strtools.h"
+#include "tools/io.h"
+#include "tools/fileidx.h"
+
+// ----------------------------------------------------------------------------
+
+#define MAX_ENTRY_LINE_SIZE         (FIDX_MAX_DEVICE_SIZE + 48)
+
+#define TIME_UNBOUNDED              0xFFFFFFFFL
+
+typedef struct
+{
+    long            offset;
+    UInt32          timestamp;
+    UInt32          maxTime;        // timestamp of the next entry for this device
+    char            device[FIDX_MAX_DEVICE_SIZE];
+} FileIndexEntry_t;
+
+// ----------------------------------------------------------------------------
+
+/* set the index file name */
+static utBool _fidxIndexFile(char *indexFile, const char *dataFile)
+{
+    int len = dataFile? strlen(dataFile) : 0;
+    if ((len <= 0) || ((len + strlen(FIDX_FILE_EXT)) >= FIDX_MAX_FILE_SIZE)) {
+        *indexFile = 0;
+        return utFalse;
+    }
+    sprintf(indexFile, "%s%s", dataFile, FIDX_FILE_EXT);
+    return utTrue;
+}
+
+static int _fidxReadEntries(const char *indexFile, long dataLen, FileIndexEntry_t **entry);
+
+/* initialize index for appending to the specified data file */
+// An existing index which does not match the data file (ie. the data file was
+// deleted, truncated, or replaced) is deleted, otherwise the appended entries
+// would follow entries with larger offsets and the index would never be used.
+utBool fidxInit(FileIndex_t *fi, const char *dataFile, int interval)
+{
+    memset(fi, 0, sizeof(FileIndex_t));
+    if ((interval <= 0) || !_fidxIndexFile(fi->indexFile, dataFile)) {
+        return utFalse;
+    }
+    fi->interval = interval;
+    fi->offset = ioGetFileSize(dataFile, -1);
+    if (fi->offset < 0L) { fi->offset = 0L; } // file does not yet exist
+    if (ioExists(fi->indexFile)) {
+        FileIndexEntry_t *entry = (FileIndexEntry_t*)0;
+        if (_fidxReadEntries(fi->indexFile, fi->offset, &entry) < 0) {
+            logWARNING(LOGSRC,"Deleting stale index: %s", fi->indexFile);
+            ioDeleteFile(fi->indexFile);
+        } else
+        if (entry) {
+            free(entry);
+        }
+    }
+    return utTrue;
+}
+
+/* record that a 'recLen' byte record for 'device' has been appended to the data file */
+utBool fidxAddRecord(FileIndex_t *fi, const char *device, UInt32 timestamp, long recLen)
+{
+    utBool rtn = utTrue;
+
+    /* index disabled? */
+    if (!fi || (fi->interval <= 0)) {
+        return utFalse;
+    }
+
+    /* new entry on device change, or every 'interval' records */
+    if (!device) { device = ""; }
+    if ((fi->count >= fi->interval) || strncmp(device, fi->device, FIDX_MAX_DEVICE_SIZE - 1)) {
+        char line[MAX_ENTRY_LINE_SIZE];
+        int len = sprintf(line, "%ld,%lu,%.*s\n", fi->offset, timestamp, FIDX_MAX_DEVICE_SIZE - 1, device);
+        if (ioAppendFile(fi->indexFile, line, len) < 0L) {
+            logWARNING(LOGSRC,"Unable to append index: %s", fi->indexFile);
+            rtn = utFalse;
+        }
+        strCopy(fi->device, sizeof(fi->device), device, -1);
+        fi->count = 0;
+    }
+    fi->count++;
+    fi->offset += recLen;
+    return rtn;
+
+}
+
+// ----------------------------------------------------------------------------
+
+/* return true if the entry device matches "<account>/<device>", or "<device>" */
+static utBool _fidxDeviceMatch(const char *entryDev, const char *device)
+{
+    if (!device || !*device) {
+        return utTrue;
+    } else
+    if (strEquals(entryDev, device)) {
+        return utTrue;
+    } else {
+        const char *d = strchr(entryDev, '/');
+        return (d && strEquals(d + 1, device))? utTrue : utFalse;
+    }
+}
+
+/* add range, merging with the previous range if contiguous */
+static int _fidxAddRange(FileRange_t *range, int count, int maxRange, long start, long end)
+{
+    if (end <= start) {
+        return count;
+    } else
+    if ((count > 0) && (range[count - 1].end == start)) {
+        range[count - 1].end = end;
+        return count;
+    } else
+    if (count >= maxRange) {
+        // out of ranges, extend the last range (includes the gap)
+        range[count - 1].end = end;
+        return count;
+    } else {
+        range[count].start = start;
+        range[count].end   = end;
+        return count + 1;
+    }
+}
+
+/* read the index file entries (returns -1 if the index is missing or does not match the data) */
+static int _fidxReadEntries(const char *indexFile, long dataLen, FileIndexEntry_t **entry)
+{
+    FILE *file = ioOpenStream(indexFile, IO_OPEN_READ);
+    if (!file) {
+        return -1;
+    }
+    int count = 0, max = 0;
+    char line[MAX_ENTRY_LINE_SIZE], *fld[3];
+    *entry = (FileIndexEntry_t*)0;
+    while (ioReadLine(file, line, sizeof(line)) > 0L) {
+        int n = strParseArray_sep(line, fld, 3, ',');
+        if (n < 2) {
+            continue; // invalid line
+        }
+        long ofs = strtol(fld[0], (char**)0, 10);
+        if ((ofs >= dataLen) || ((count > 0) && (ofs < (*entry)[count - 1].offset))) {
+            // stale index (the data file was truncated or replaced)
+            count = -1;
+            break;
+        }
+        if (count >= max) {
+            max = (max > 0)? (max * 2) : 256;
+            FileIndexEntry_t *e = (FileIndexEntry_t*)realloc(*entry, max * sizeof(FileIndexEntry_t));
+            if (!e) {
+                logERROR(LOGSRC,"Out of memory reading index: %s", indexFile);
+                count = -1;
+                break;
+            }
+            *entry = e;
+        }
+        FileIndexEntry_t *e = &(*entry)[count++];
+        e->offset    = ofs;
+        e->timestamp = strParseUInt32(fld[1], 0L);
+        e->maxTime   = TIME_UNBOUNDED;
+        strCopy(e->device, sizeof(e->device), ((n > 2)? fld[2] : ""), -1);
+    }
+    ioCloseStream(file);
+    if ((count < 0) && *entry) {
+        free(*entry);
+        *entry = (FileIndexEntry_t*)0;
+    }
+    return count;
+}
+
+/* return the data file ranges which may contain records for the device/time range */
+// 'device' may be null for all devices, and 'fromTime'/'toTime' may be 0 if unbounded.
+// Returns the number of ranges, or -1 if the data file has no (valid) index.
+int fidxQuery(const char *dataFile, long dataLen, const char *device,
+    UInt32 fromTime, UInt32 toTime, FileRange_t *range, int maxRange)
+{
+    char indexFile[FIDX_MAX_FILE_SIZE];
+    FileIndexEntry_t *entry = (FileIndexEntry_t*)0;
+    int entryCount, count = 0, e;
+
+    /* read index */
+    if (!range || (maxRange <= 0) || !_fidxIndexFile(indexFile, dataFile)) {
+        return -1;
+    }
+    entryCount = _fidxReadEntries(indexFile, dataLen, &entry);
+    if (entryCount < 0) {
+        return -1;
+    }
+
+    /* latest possible time of each segment (the next entry for the same device) */
+    int *devLast = (entryCount > 0)? (int*)malloc(entryCount * sizeof(int)) : (int*)0;
+    if (devLast) {
+        int devCount = 0, d;
+        for (e = entryCount - 1; e >= 0; e--) {
+            for (d = 0; (d < devCount) && !strEquals(entry[devLast[d]].device, entry[e].device); d++);
+            if (d < devCount) {
+                entry[e].maxTime = entry[devLast[d]].timestamp;
+            } else {
+                devCount++;
+            }
+            devLast[d] = e;
+        }
+        free(devLast);
+    }
+
+    /* records preceding the index */
+    count = _fidxAddRange(range, count, maxRange, 0L, (entryCount > 0)? entry[0].offset : dataLen);
+
+    /* matching segments */
+    for (e = 0; e < entryCount; e++) {
+        FileIndexEntry_t *ie = &entry[e];
+        if (!_fidxDeviceMatch(ie->device, device)) {
+            continue;
+        } else
+        if (toTime && (ie->timestamp > toTime)) {
+            continue;
+        } else
+        if (fromTime && (ie->maxTime < fromTime)) {
+            continue;
+        }
+        long end = ((e + 1) < entryCount)? entry[e + 1].offset : dataLen;
+        count = _fidxAddRange(range, count, maxRange, ie->offset, end);
+    }
+
+    if (entry) { free(entry); }
+    return count;
+
+}
+
+// ----------------------------------------------------------------------------
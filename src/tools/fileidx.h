@@ -0,0 +1,69 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+
+#ifndef _FILEIDX_H
+#define _FILEIDX_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tools/stdtypes.h"
+
+// ----------------------------------------------------------------------------
+
+/* index file name is the data file name with this extension appended */
+#define FIDX_FILE_EXT               ".idx"
+
+/* default number of records between index entries */
+#define FIDX_DEFAULT_INTERVAL       64
+
+#define FIDX_MAX_FILE_SIZE          128
+#define FIDX_MAX_DEVICE_SIZE        64
+
+// ----------------------------------------------------------------------------
+
+typedef struct
+{
+    char            indexFile[FIDX_MAX_FILE_SIZE];  // sidecar index file
+    int             interval;                       // records per entry (0 to disable)
+    long            offset;                         // data file offset of the next record
+    int             count;                          // records since last entry
+    char            device[FIDX_MAX_DEVICE_SIZE];   // device of last record
+} FileIndex_t;
+
+typedef struct
+{
+    long            start;                          // offset of first record
+    long            end;                            // offset following last record
+} FileRange_t;
+
+// ----------------------------------------------------------------------------
+
+utBool fidxInit(FileIndex_t *fi, const char *dataFile, int interval);
+utBool fidxAddRecord(FileIndex_t *fi, const char *device, UInt32 timestamp, long recLen);
+
+int fidxQuery(const char *dataFile, long dataLen, const char *device,
+    UInt32 fromTime, UInt32 toTime, FileRange_t *range, int maxRange);
+
+// ----------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+#endif
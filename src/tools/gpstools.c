@@ -126,6 +126,132 @@ utBool gpsPointIsValid(const GPSPoint_t *gp)
     }
 }
 
+// ----------------------------------------------------------------------------
+// Fixed-point distance calculations (FPU-less targets, see GPS_FIXED_POINT)
+// Short distances are calculated in integer microdegrees using an equirectangular
+// projection at the mean latitude.  The cosine is linearly interpolated from a
+// 1 degree table (relative error < 0.004%), and the projection itself is within
+// 0.2% (or 0.3 meters) of the Haversine distance for separations up to
+// GPS_FIXED_MAX_DELTA at latitudes below 80 degrees.
+// Longer distances fall back to the 'double' Haversine calculation.
+
+#if defined(GPS_FIXED_POINT) && !defined(SUPPORT_UInt64)
+#  undef GPS_FIXED_POINT // 64-bit intermediate values are required
+#endif
+#if defined(GPS_FIXED_POINT)
+
+#define MICRODEGREES                1000000L
+#define GPS_FIXED_MAX_DELTA         (MICRODEGREES / 2L)     // 0.5 degrees (about 55km)
+#define CM_PER_MICRODEGREE_E4       111195L                 // 11.1195 cm per microdegree (x 10000)
+
+/* cos(0 to 90 degrees) in 1/65536 units */
+static const Int32 gpsCosTableQ16[91] = {
+    65536, 65526, 65496, 65446, 65376, 65287, 65177, 65048,
+    64898, 64729, 64540, 64332, 64104, 63856, 63589, 63303,
+    62997, 62672, 62328, 61966, 61584, 61183, 60764, 60326,
+    59870, 59396, 58903, 58393, 57865, 57319, 56756, 56175,
+    55578, 54963, 54332, 53684, 53020, 52339, 51643, 50931,
+    50203, 49461, 48703, 47930, 47143, 46341, 45525, 44695,
+    43852, 42995, 42126, 41243, 40348, 39441, 38521, 37590,
+    36647, 35693, 34729, 33754, 32768, 31772, 30767, 29753,
+    28729, 27697, 26656, 25607, 24550, 23486, 22415, 21336,
+    20252, 19161, 18064, 16962, 15855, 14742, 13626, 12505,
+    11380, 10252,  9121,  7987,  6850,  5712,  4572,  3430,
+     2287,  1144,     0
+};
+
+/* convert degrees to (rounded) microdegrees */
+// Integer only (a 'double' multiply would be a soft-float call on FPU-less targets): 
+// the IEEE-754 mantissa is scaled directly.  The top 32 mantissa bits are used, which 
+// is exact to within 0.07 microdegrees.  'deg' is limited to +/-256 degrees.
+static Int32 _gpsMicroDegrees(double deg)
+{
+    UInt64 bits;
+    memcpy(&bits, &deg, sizeof(bits));
+#if defined(__arm__) && !defined(__VFP_FP__)
+    bits = (bits << 32) | (bits >> 32); // FPA 'double' word order
+#endif
+    Int32 exp = (Int32)((bits >> 52) & 0x7FFL) - 1023L; // deg = 1.man * 2^exp
+    UInt32 ud;
+    if (exp < -21L) {
+        ud = 0L; // < 0.5 microdegree (or zero)
+    } else
+    if (exp > 7L) {
+        ud = 256L * MICRODEGREES; // out of range
+    } else {
+        // deg = (man >> 21) * 2^(exp - 31)
+        UInt64 man = (bits & (((UInt64)1 << 52) - 1)) | ((UInt64)1 << 52);
+        UInt64 m = (man >> 21) * MICRODEGREES;
+        int shift = 31 - (int)exp;
+        ud = (UInt32)((m + ((UInt64)1 << (shift - 1))) >> shift);
+    }
+    return (bits >> 63)? -(Int32)ud : (Int32)ud;
+}
+
+/* return cos(latitude) in 1/65536 units */
+static Int32 _gpsCosQ16(Int32 latE6)
+{
+    UInt32 a = (latE6 < 0L)? (UInt32)(-latE6) : (UInt32)latE6;
+    if (a >= (90L * MICRODEGREES)) {
+        return 0L;
+    } else {
+        UInt32 d = a / MICRODEGREES, f = a % MICRODEGREES;
+        Int32 c0 = gpsCosTableQ16[d], c1 = gpsCosTableQ16[d + 1];
+        return c0 - (Int32)(((Int64)(c0 - c1) * f) / MICRODEGREES);
+    }
+}
+
+/* integer square root */
+static UInt32 _gpsSqrt64(UInt64 n)
+{
+    UInt64 r = 0, b = (UInt64)1 << 62;
+    while (b > n) { b >>= 2; }
+    while (b) {
+        if (n >= (r + b)) {
+            n -= r + b;
+            r = (r >> 1) + b;
+        } else {
+            r >>= 1;
+        }
+        b >>= 2;
+    }
+    return (UInt32)r;
+}
+
+/* return east/north centimeters from S to E, false if beyond GPS_FIXED_MAX_DELTA */
+static utBool _gpsFixedDelta(Int32 latS, Int32 lonS, Int32 latE, Int32 lonE, Int64 *xCM, Int64 *yCM)
+{
+    Int32 dLat = latE - latS;
+    Int32 dLon = lonE - lonS;
+    if (dLon > (180L * MICRODEGREES)) {
+        dLon -= 360L * MICRODEGREES; // crossed 180 meridian
+    } else
+    if (dLon < (-180L * MICRODEGREES)) {
+        dLon += 360L * MICRODEGREES;
+    }
+    if ((dLat > GPS_FIXED_MAX_DELTA) || (dLat < -GPS_FIXED_MAX_DELTA) ||
+        (dLon > GPS_FIXED_MAX_DELTA) || (dLon < -GPS_FIXED_MAX_DELTA)   ) {
+        return utFalse;
+    }
+    Int32 cosQ16 = _gpsCosQ16((latS / 2L) + (latE / 2L));
+    *yCM = ((Int64)dLat * CM_PER_MICRODEGREE_E4) / 10000L;
+    *xCM = ((((Int64)dLon * cosQ16) >> 16) * CM_PER_MICRODEGREE_E4) / 10000L;
+    return utTrue;
+}
+
+/* return distance in meters from S to E, or a negative value if beyond GPS_FIXED_MAX_DELTA */
+static double _gpsFixedMeters(Int32 latS, Int32 lonS, Int32 latE, Int32 lonE)
+{
+    Int64 x, y;
+    if (_gpsFixedDelta(latS, lonS, latE, lonE, &x, &y)) {
+        return (double)_gpsSqrt64((UInt64)((x * x) + (y * y))) / 100.0;
+    } else {
+        return -1.0;
+    }
+}
+
+#endif // defined(GPS_FIXED_POINT)
+
 // ----------------------------------------------------------------------------
 
 /* return the distance (in radian) between the specified points */
@@ -142,6 +268,16 @@ double gpsRadiansToPoint(
         return 0.0;
     }
 
+#if defined(GPS_FIXED_POINT)
+    /* short distances in fixed-point */
+    double meters = _gpsFixedMeters(
+        _gpsMicroDegrees(gpS->latitude), _gpsMicroDegrees(gpS->longitude),
+        _gpsMicroDegrees(gpE->latitude), _gpsMicroDegrees(gpE->longitude));
+    if (meters >= 0.0) {
+        return meters / EARTH_RADIUS_METERS;
+    }
+#endif
+
     // Haversine formula (faster and less prone to rounding errors than 'Law of Cosines' algorithm
     // required math functions: sin, cos, atan2, sqrt
     double radLatS, radLonS, radLatE, radLonE, dlat, dlon, a, rad;
@@ -174,6 +310,163 @@ double gpsKilometersToPoint(
     double rad = gpsRadiansToPoint(gpS, gpE);
     return (rad * EARTH_RADIUS_METERS) / 1000.0;
 }
+
+// ----------------------------------------------------------------------------
+
+/* return true if the point can be used in distance calculations */
+static utBool _gpsPointInRange(const GPSPoint_t *gp)
+{
+    return ((gp->latitude  <  90.0) && (gp->latitude  >  -90.0) &&
+            (gp->longitude < 180.0) && (gp->longitude > -180.0))? utTrue : utFalse;
+}
+
+#define LAT_IN_RANGE(Y)     (((Y) <  90.0) && ((Y) >  -90.0))
+#define LON_IN_RANGE(X)     (((X) < 180.0) && ((X) > -180.0))
+
+/* Haversine meters, given the radian lat/lon and cos(lat) of both points */
+// 2*asin(sqrt(a)) is equivalent to 2*atan2(sqrt(a),sqrt(1-a)) for 0 <= a <= 1
+static double _gpsHaversineMeters(double radLatS, double radLonS, double cosLatS,
+    double radLatE, double radLonE, double cosLatE)
+{
+    double sinLat = sin((radLatE - radLatS) / 2.0);
+    double sinLon = sin((radLonE - radLonS) / 2.0);
+    double a = (sinLat * sinLat) + (cosLatS * cosLatE * sinLon * sinLon);
+    return 2.0 * asin(sqrt((a < 1.0)? a : 1.0)) * EARTH_RADIUS_METERS;
+}
+
+/* return the distances (in meters) from one point to an array of points */
+// The points are specified as separate latitude/longitude arrays.  The 'from' point
+// terms are calculated only once.  Out of range points return a distance of '0'.
+// Returns the number of distances calculated ('count'), or -1 if the 'from' point
+// is out of range (in which case all distances are set to '0').
+int gpsMetersToPoints(
+    const GPSPoint_t *gpS,            // From point
+    const double *lat,                // To latitudes [count]
+    const double *lon,                // To longitudes [count]
+    int count,                        // number of points
+    double *meters)                   // Distances [count] (output)
+{
+    int i;
+    if (!_gpsPointInRange(gpS)) {
+        for (i = 0; i < count; i++) { meters[i] = 0.0; }
+        return -1;
+    }
+#if defined(GPS_FIXED_POINT)
+    Int32 latS = _gpsMicroDegrees(gpS->latitude), lonS = _gpsMicroDegrees(gpS->longitude);
+#endif
+    double radLatS = gpS->latitude  * RADIANS;
+    double radLonS = gpS->longitude * RADIANS;
+    double cosLatS = cos(radLatS);
+    for (i = 0; i < count; i++) {
+        if (!LAT_IN_RANGE(lat[i]) || !LON_IN_RANGE(lon[i])) {
+            meters[i] = 0.0;
+            continue;
+        }
+#if defined(GPS_FIXED_POINT)
+        meters[i] = _gpsFixedMeters(latS, lonS, _gpsMicroDegrees(lat[i]), _gpsMicroDegrees(lon[i]));
+        if (meters[i] >= 0.0) {
+            continue;
+        }
+#endif
+        double radLatE = lat[i] * RADIANS;
+        meters[i] = _gpsHaversineMeters(radLatS, radLonS, cosLatS, radLatE, lon[i] * RADIANS, cos(radLatE));
+    }
+    return count;
+}
+
+/* return the total distance (in meters) along a polyline */
+// Each point's trig terms are calculated once and shared by its two segments.
+// If 'segMeters' is non-null, it receives the length of each segment [count - 1].
+// Segments with an out of range end point have a length of '0'.
+double gpsPolylineMeters(
+    const double *lat,                // Latitudes [count]
+    const double *lon,                // Longitudes [count]
+    int count,                        // number of points
+    double *segMeters)                // Segment lengths [count - 1] (output, may be null)
+{
+    double total = 0.0;
+    if (count < 2) {
+        return total;
+    }
+    int i;
+    utBool okS  = (LAT_IN_RANGE(lat[0]) && LON_IN_RANGE(lon[0]))? utTrue : utFalse;
+    utBool cosS = utFalse; // 'cosLatS' calculated
+    double radLatS = lat[0] * RADIANS, radLonS = lon[0] * RADIANS, cosLatS = 0.0;
+    for (i = 1; i < count; i++) {
+        utBool okE  = (LAT_IN_RANGE(lat[i]) && LON_IN_RANGE(lon[i]))? utTrue : utFalse;
+        utBool cosE = utFalse;
+        double radLatE = lat[i] * RADIANS, radLonE = lon[i] * RADIANS, cosLatE = 0.0;
+        double m = 0.0;
+        if (okS && okE) {
+#if defined(GPS_FIXED_POINT)
+            m = _gpsFixedMeters(_gpsMicroDegrees(lat[i-1]), _gpsMicroDegrees(lon[i-1]),
+                _gpsMicroDegrees(lat[i]), _gpsMicroDegrees(lon[i]));
+            if (m < 0.0)
+#endif
+            {
+                if (!cosS) { cosLatS = cos(radLatS); }
+                cosLatE = cos(radLatE);
+                cosE    = utTrue;
+                m = _gpsHaversineMeters(radLatS, radLonS, cosLatS, radLatE, radLonE, cosLatE);
+            }
+        }
+        if (segMeters) { segMeters[i - 1] = m; }
+        total += m;
+        okS = okE; cosS = cosE;
+        radLatS = radLatE; radLonS = radLonE; cosLatS = cosLatE;
+    }
+    return total;
+}
+
+/* initialize the per-fix context for the specified new fix */
+// Only the new fix terms shared by the distance calculations are computed here.
+GPSFixContext_t *gpsFixContextInit(
+    GPSFixContext_t *ctx,             // context to initialize
+    const GPS_t *newFix,              // new fix (may be null)
+    UInt32 nowTime)                   // current time (seconds)
+{
+    memset(ctx, 0, sizeof(GPSFixContext_t));
+    ctx->newFix  = newFix;
+    ctx->nowTime = nowTime;
+    ctx->isValid = gpsIsValid(newFix);
+    if (ctx->isValid) {
+#if defined(GPS_FIXED_POINT)
+        ctx->latE6  = _gpsMicroDegrees(newFix->point.latitude);
+        ctx->lonE6  = _gpsMicroDegrees(newFix->point.longitude);
+#else
+        ctx->radLat = newFix->point.latitude  * RADIANS;
+        ctx->radLon = newFix->point.longitude * RADIANS;
+        ctx->cosLat = cos(ctx->radLat);
+#endif
+    }
+    return ctx;
+}
+
+/* return the distance (in meters) from the context fix to the specified point */
+// Same as 'gpsMetersToPoint(&newFix->point, gpE)', but reuses the new fix terms.
+double gpsFixContextMetersToPoint(
+    const GPSFixContext_t *ctx,       // From (new fix) context
+    const GPSPoint_t *gpE)            // To point
+{
+    if (!ctx->isValid || !_gpsPointInRange(&(ctx->newFix->point)) || !_gpsPointInRange(gpE)) {
+        return 0.0;
+    }
+#if defined(GPS_FIXED_POINT)
+    double meters = _gpsFixedMeters(ctx->latE6, ctx->lonE6,
+        _gpsMicroDegrees(gpE->latitude), _gpsMicroDegrees(gpE->longitude));
+    if (meters >= 0.0) {
+        return meters;
+    }
+    return gpsMetersToPoint(&(ctx->newFix->point), gpE); // long distance
+#else
+    double radLatE = gpE->latitude  * RADIANS;
+    double dlat    = radLatE - ctx->radLat;
+    double dlon    = (gpE->longitude * RADIANS) - ctx->radLon;
+    double a       = SQUARE(sin(dlat/2.0)) + (ctx->cosLat * cos(radLatE) * SQUARE(sin(dlon/2.0)));
+    return 2.0 * atan2(sqrt(a), sqrt(1.0 - a)) * EARTH_RADIUS_METERS;
+#endif
+}
+
 // ----------------------------------------------------------------------------
 
 /* copy source GPS structure to destination */
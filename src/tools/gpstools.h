@@ -79,6 +79,7 @@ typedef struct
 #define NMEA0183_GPRMC              0x00000001L
 #define NMEA0183_GPGGA              0x00000002L
 #define NMEA0183_GPGSA              0x00000004L
+#define NMEA0183_GPVTG              0x00000008L
 
 typedef struct 
 {
@@ -102,6 +103,7 @@ typedef struct
     double          hdop;       // HDOP
     double          vdop;       // VDOP
     UInt16          fixtype;    // Quality [1=GPS, 2=DGPS]
+    UInt16          satellites; // number of satellites used in fix
     UInt32          nmea;       // NMEA-0183 record types in this sample
 } GPS_t;
 
@@ -134,6 +136,22 @@ typedef struct
 
 // ----------------------------------------------------------------------------
 
+// Values derived from a new GPS fix, computed once per fix by 'gpsFixContextInit'
+// and handed to each GPS rule module (motion, odometer, geozone, ...)
+typedef struct
+{
+    const GPS_t     *newFix;        // new fix (may be null)
+    utBool          isValid;        // true if 'newFix' is valid
+    UInt32          nowTime;        // current time (seconds)
+    double          radLat;         // 'newFix' latitude (radians, double only)
+    double          radLon;         // 'newFix' longitude (radians, double only)
+    double          cosLat;         // cos(radLat) (double only)
+    Int32           latE6;          // 'newFix' latitude (microdegrees, GPS_FIXED_POINT only)
+    Int32           lonE6;          // 'newFix' longitude (microdegrees, GPS_FIXED_POINT only)
+} GPSFixContext_t;
+
+// ----------------------------------------------------------------------------
+
 void gpsPointClear(GPSPoint_t *gp);
 GPSPoint_t *gpsPoint(GPSPoint_t *gp, double lat, double lon);
 GPSPoint_t *gpsPointCopy(GPSPoint_t *d, const GPSPoint_t *s);
@@ -150,6 +168,12 @@ double gpsRadiansToPoint(const GPSPoint_t *gpS, const GPSPoint_t *gpE);
 double gpsMetersToPoint(const GPSPoint_t *gpS, const GPSPoint_t *gpE);
 double gpsKilometersToPoint(const GPSPoint_t *gpS, const GPSPoint_t *gpE);
 
+int gpsMetersToPoints(const GPSPoint_t *gpS, const double *lat, const double *lon, int count, double *meters);
+double gpsPolylineMeters(const double *lat, const double *lon, int count, double *segMeters);
+
+GPSFixContext_t *gpsFixContextInit(GPSFixContext_t *ctx, const GPS_t *newFix, UInt32 nowTime);
+double gpsFixContextMetersToPoint(const GPSFixContext_t *ctx, const GPSPoint_t *gpE);
+
 // ----------------------------------------------------------------------------
 // lat/lon encoding/decoding
 
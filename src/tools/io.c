@@ -360,6 +360,25 @@ utBool ioDeleteFile(const char *fn)
     }
 }
 
+/* rename file (an existing 'newName' file is replaced) */
+utBool ioRenameFile(const char *oldName, const char *newName)
+{
+    if (oldName && *oldName && newName && *newName) {
+#if defined(TARGET_WINCE)
+        wchar_t wOld[512], wNew[512];
+        strWideCopy(wOld, sizeof(wOld)/sizeof(wOld[0]), oldName, -1);
+        strWideCopy(wNew, sizeof(wNew)/sizeof(wNew[0]), newName, -1);
+        DeleteFile(wNew);
+        BOOL ok = MoveFile(wOld, wNew);
+        return ok? utTrue : utFalse;
+#else
+        return (rename(oldName, newName) == 0)? utTrue : utFalse;
+#endif
+    } else {
+        return utFalse;
+    }
+}
+
 // ----------------------------------------------------------------------------
 
 /* open stream */
@@ -55,6 +55,7 @@ utBool ioIsDirectory(const char *fn);
 // ----------------------------------------------------------------------------
 
 utBool ioDeleteFile(const char *fn);
+utBool ioRenameFile(const char *oldName, const char *newName);
 long ioGetFileSize(const char *fn, int fd);
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,420 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+// Description:
+//  NMEA-0183 sentence parser.
+//  Splits/validates a sentence in place (single pass, no copy), and merges the
+//  $GPRMC/$GPGGA/$GPGSA/$GPVTG sentences of a single receiver epoch into one
+//  GPS_t fix.  Numeric fields are converted with fixed-point integer arithmetic
+//  (no 'strtod'), which matters on the FPU-less GumStix at 5-10Hz output rates.
+// ---
+// References:
+//  http://www.scientificcomponent.com/nmea0183.htm
+//  http://home.mira.net/~gnb/gps/nmea.html
+// ----------------------------------------------------------------------------
+
+#include "stdafx.h" // TARGET_WINCE
+#define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file
+#include "custom/defaults.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "custom/log.h"
+
+#include "tools/stdtypes.h"
+#include "tools/utctools.h"
+#include "tools/gpstools.h"
+#include "tools/nmea.h"
+
+// ----------------------------------------------------------------------------
+
+#define NMEA_ENCODING_CHAR      '$'
+#define NMEA_CHECKSUM_CHAR      '*'
+#define NMEA_PROPRIETARY_CHAR   'P'
+
+/* ddmm.mmmmm fixed-point scale */
+#define COORD_FRAC_DIGITS       5
+#define COORD_DEGREE_SCALE      10000000L           // 100 (minutes) * 10^5
+#define COORD_MINUTE_SCALE      6000000.0           // 60 * 10^5
+
+static const UInt32 _nmeaPow10[] = { 1L, 10L, 100L, 1000L, 10000L, 100000L };
+
+// ----------------------------------------------------------------------------
+
+/* return the specified field, or an empty string if not present */
+static const char *_nmeaField(const NMEASentence_t *ns, int ndx)
+{
+    return (ndx < ns->count)? ns->fld[ndx] : "";
+}
+
+/* return the value of a hex character, or -1 if invalid */
+static int _nmeaHexNybble(char ch)
+{
+    if ((ch >= '0') && (ch <= '9')) { return ch - '0'; }
+    if ((ch >= 'A') && (ch <= 'F')) { return ch - 'A' + 10; }
+    if ((ch >= 'a') && (ch <= 'f')) { return ch - 'a' + 10; }
+    return -1;
+}
+
+/* parse unsigned decimal "123.456" into fixed-point with 'frac' decimal places */
+// Extra fractional digits are truncated.  Returns false if the field has no digits.
+static utBool _nmeaParseFixed(const char *s, int frac, UInt32 *val)
+{
+    UInt32 v = 0L;
+    utBool digits = utFalse;
+    for (; (*s >= '0') && (*s <= '9'); s++) {
+        v = (v * 10L) + (UInt32)(*s - '0');
+        digits = utTrue;
+    }
+    if (*s == '.') {
+        for (s++; (frac > 0) && (*s >= '0') && (*s <= '9'); s++, frac--) {
+            v = (v * 10L) + (UInt32)(*s - '0');
+            digits = utTrue;
+        }
+    }
+    for (; frac > 0; frac--) { v *= 10L; }
+    *val = v;
+    return digits;
+}
+
+/* parse signed decimal field, returning 'dft' if the field is empty */
+static double _nmeaParseDecimal(const char *s, int frac, double dft)
+{
+    utBool neg = (*s == '-')? utTrue : utFalse;
+    UInt32 v = 0L;
+    if (neg || (*s == '+')) { s++; }
+    if (!_nmeaParseFixed(s, frac, &v)) {
+        return dft;
+    } else {
+        double d = (double)v / (double)_nmeaPow10[frac];
+        return neg? -d : d;
+    }
+}
+
+/* parse "dddmm.mmmmm" and hemisphere into signed degrees */
+static utBool _nmeaParseCoord(const char *s, const char *hemi, char negHemi, double *coord)
+{
+    UInt32 v = 0L;
+    if (!_nmeaParseFixed(s, COORD_FRAC_DIGITS, &v)) {
+        return utFalse;
+    }
+    UInt32 deg = v / COORD_DEGREE_SCALE;
+    UInt32 min = v % COORD_DEGREE_SCALE;
+    if (min >= (UInt32)COORD_MINUTE_SCALE) {
+        return utFalse; // minutes >= 60
+    }
+    double c = (double)deg + ((double)min / COORD_MINUTE_SCALE);
+    *coord = (*hemi == negHemi)? -c : c;
+    return utTrue;
+}
+
+/* parse latitude/longitude starting at field 'ndx' */
+static utBool _nmeaParsePoint(const NMEASentence_t *ns, int ndx, GPSPoint_t *gp)
+{
+    double lat = 0.0, lon = 0.0;
+    if (!_nmeaParseCoord(_nmeaField(ns,ndx+0), _nmeaField(ns,ndx+1), 'S', &lat) ||
+        !_nmeaParseCoord(_nmeaField(ns,ndx+2), _nmeaField(ns,ndx+3), 'W', &lon)   ) {
+        return utFalse;
+    } else
+    if ((lat >= 90.0) || (lat <= -90.0) || (lon >= 180.0) || (lon <= -180.0)) {
+        return utFalse;
+    } else {
+        gp->latitude  = lat;
+        gp->longitude = lon;
+        return utTrue;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/* parse DMY/HMS into UTC Epoch seconds */
+// If 'dmy' is '0', the day is derived from the current system clock.
+UInt32 nmeaGetUTCSeconds(UInt32 dmy, UInt32 hms)
+{
+
+    /* time of day [TOD] */
+    int    HH  = (int)((hms / 10000L) % 100L);
+    int    MM  = (int)((hms / 100L) % 100L);
+    int    SS  = (int)(hms % 100L);
+    UInt32 TOD = (HH * 3600L) + (MM * 60L) + SS;
+
+    /* current UTC day */
+    long DAY = 0L;
+    if (dmy) {
+        int    yy  = (int)(dmy % 100L) + 2000;
+        int    mm  = (int)((dmy / 100L) % 100L);
+        int    dd  = (int)((dmy / 10000L) % 100L);
+        long   yr  = ((long)yy * 1000L) + (long)(((mm - 3) * 1000) / 12);
+        DAY        = ((367L * yr + 625L) / 1000L) - (2L * (yr / 1000L))
+                     + (yr / 4000L) - (yr / 100000L) + (yr / 400000L)
+                     + (long)dd - 719469L;
+    } else {
+        // we don't have the day, so we need to figure out as close as we can what it should be.
+        UInt32 utc = utcGetTimeSec();
+        if (utc < MIN_CLOCK_TIME) {
+            // the system clock time is not valid
+            logWARNING(LOGSRC,"Current clock time is prior to minimum time! [%lu]", utc);
+            DAY = 0L;
+        } else {
+            UInt32 tod = utc % DAY_SECONDS(1);
+            DAY        = utc / DAY_SECONDS(1);
+            Int32  dif = tod - TOD; // difference should be small (ie. < 1 hour)
+            if (labs(dif) > HOUR_SECONDS(12)) { // 12 to 18 hours
+                // > 12 hour difference, assume we've crossed a day boundary
+                if (tod > TOD) {
+                    // tod > TOD likely represents the next day
+                    DAY++;
+                } else {
+                    // tod < TOD likely represents the previous day
+                    DAY--;
+                }
+            }
+        }
+    }
+
+    /* return UTC seconds */
+    UInt32 sec = DAY_SECONDS(DAY) + TOD;
+    return sec;
+
+}
+
+// ----------------------------------------------------------------------------
+
+/* split/validate an NMEA-0183 sentence in place */
+// The ',' separators and '*' are replaced with terminators and 'ns->fld' points into 's'.
+// Returns the sentence type (NMEA0183_GPxxx), '0' if the type is not supported, or
+// NMEA_ERR_xxx on error.  Sentences without a '*HH' checksum are accepted (as with
+// 'cksumIsValidCharXOR').
+int nmeaParseSentence(NMEASentence_t *ns, char *s)
+{
+
+    /* valid sentence? */
+    if (!ns || !s || (*s != NMEA_ENCODING_CHAR)) {
+        return NMEA_ERR_FORMAT;
+    }
+    ns->type  = 0L;
+    ns->count = 0;
+    ns->fld[ns->count++] = s;
+
+    /* split fields, calculating the XOR checksum as we go */
+    UInt8 cksum = 0x00;
+    char *p = s + 1;
+    for (; *p && (*p != NMEA_CHECKSUM_CHAR) && (*p != '\r') && (*p != '\n'); p++) {
+        cksum ^= (UInt8)*p;
+        if (*p == ',') {
+            *p = 0;
+            if (ns->count < NMEA_MAX_FIELDS) {
+                ns->fld[ns->count++] = p + 1;
+            }
+        }
+    }
+
+    /* test checksum */
+    if (*p == NMEA_CHECKSUM_CHAR) {
+        int hi = _nmeaHexNybble(p[1]);
+        int lo = (hi >= 0)? _nmeaHexNybble(p[2]) : -1;
+        *p = 0;
+        if ((lo < 0) || (((hi << 4) | lo) != cksum)) {
+            return NMEA_ERR_CHECKSUM;
+        }
+    } else {
+        *p = 0; // trim CR/LF
+    }
+
+    /* sentence type ("$ttSSS", any talker except proprietary) */
+    const char *id = ns->fld[0];
+    if ((strlen(id) == 6) && (id[1] != NMEA_PROPRIETARY_CHAR)) {
+        const char *t = &id[3];
+        if (!strcmp(t, "RMC")) { ns->type = NMEA0183_GPRMC; } else
+        if (!strcmp(t, "GGA")) { ns->type = NMEA0183_GPGGA; } else
+        if (!strcmp(t, "GSA")) { ns->type = NMEA0183_GPGSA; } else
+        if (!strcmp(t, "VTG")) { ns->type = NMEA0183_GPVTG; }
+    }
+    return (int)ns->type;
+
+}
+
+// ----------------------------------------------------------------------------
+
+/* initialize fix assembler */
+void nmeaParserInit(NMEAParser_t *np, UInt32 typeMask)
+{
+    if (np) {
+        memset(np, 0, sizeof(NMEAParser_t));
+        np->typeMask   = typeMask;
+        np->epochValid = utFalse;
+        np->pdop       = GPS_UNDEFINED_DOP;
+        np->hdop       = GPS_UNDEFINED_DOP;
+        np->vdop       = GPS_UNDEFINED_DOP;
+        np->dopTimer   = 0L;
+        gpsClear(&(np->fix));
+    }
+}
+
+/* start a new epoch if 'tod' differs from the epoch currently being assembled */
+static void _nmeaStartEpoch(NMEAParser_t *np, UInt32 tod)
+{
+    if (np->epochValid && (np->epochTOD == tod)) {
+        return; // same epoch
+    }
+    if (utcIsTimerExpired(np->dopTimer,NMEA_DOP_EXPIRE)) {
+        np->pdop = GPS_UNDEFINED_DOP;
+        np->hdop = GPS_UNDEFINED_DOP;
+        np->vdop = GPS_UNDEFINED_DOP;
+        // do not reset timer
+    }
+    gpsClear(&(np->fix));
+    // DOP is carried forward, since $GPGSA may arrive before the timed sentences of its epoch
+    np->fix.pdop   = np->pdop;
+    np->fix.hdop   = np->hdop;
+    np->fix.vdop   = np->vdop;
+    np->epochTOD   = tod;
+    np->epochValid = utTrue;
+}
+
+/* merge a parsed sentence into the current epoch */
+// Returns NMEA_FIX_MERGED if 'np->fix' was updated.
+int nmeaAddSentence(NMEAParser_t *np, const NMEASentence_t *ns)
+{
+    if (!np || !ns || !(ns->type & np->typeMask)) {
+        return NMEA_FIX_IGNORED;
+    }
+    GPS_t *fix = &(np->fix);
+    UInt32 tod = 0L;
+    switch (ns->type) {
+
+        case NMEA0183_GPRMC: {
+            // $GPRMC,hhmmss.ss,A,ddmm.mmmm,N,dddmm.mmmm,W,knots,course,ddmmyy,magvar,E*HH
+            if (*_nmeaField(ns,2) != 'A') {
+                return NMEA_FIX_NOFIX; // "V" - invalid gps fix
+            }
+            UInt32 dmy = 0L;
+            GPSPoint_t gp;
+            _nmeaParseFixed(_nmeaField(ns,1), 2, &tod);
+            _nmeaParseFixed(_nmeaField(ns,9), 0, &dmy);
+            UInt32 fixtime = nmeaGetUTCSeconds(dmy, tod / 100L);
+            if (fixtime < MIN_CLOCK_TIME) {
+                return NMEA_FIX_BADTIME;
+            } else
+            if (!_nmeaParsePoint(ns, 3, &gp)) {
+                return NMEA_FIX_BADPOINT;
+            }
+            _nmeaStartEpoch(np, tod);
+            double knots  = _nmeaParseDecimal(_nmeaField(ns,7), 3, -1.0);
+            fix->ageTimer = utcGetTimer();
+            fix->fixtime  = fixtime;
+            fix->point    = gp;
+            fix->speedKPH = (knots >= 0.0)? (knots * KILOMETERS_PER_KNOT) : -1.0;
+            fix->heading  = _nmeaParseDecimal(_nmeaField(ns,8), 2, -1.0);
+            if (!(fix->nmea & NMEA0183_GPGGA)) {
+                fix->fixtype = 1; // GPS ($GPGGA quality takes precedence)
+            }
+            fix->nmea    |= NMEA0183_GPRMC;
+            return NMEA_FIX_MERGED;
+        }
+
+        case NMEA0183_GPGGA: {
+            // $GPGGA,hhmmss.ss,ddmm.mmmm,N,dddmm.mmmm,W,quality,sats,hdop,alt,M,geoid,M,age,station*HH
+            UInt32 quality = 0L, sats = 0L;
+            GPSPoint_t gp;
+            _nmeaParseFixed(_nmeaField(ns,6), 0, &quality);
+            if (quality == 0L) {
+                return NMEA_FIX_NOFIX; // "0" - no fix
+            }
+            _nmeaParseFixed(_nmeaField(ns,1), 2, &tod);
+            if (utcIsTimerExpired(np->dopTimer,NMEA_DOP_EXPIRE)) {
+                np->pdop = GPS_UNDEFINED_DOP;
+                np->vdop = GPS_UNDEFINED_DOP;
+            }
+            np->hdop     = _nmeaParseDecimal(_nmeaField(ns,8), 2, GPS_UNDEFINED_DOP);
+            np->dopTimer = utcGetTimer(); // reset timer
+            _nmeaStartEpoch(np, tod);
+            // $GPGGA carries no date: use the $GPRMC fixtime from this epoch if we have it
+            UInt32 fixtime = (fix->nmea & NMEA0183_GPRMC)? fix->fixtime : nmeaGetUTCSeconds(0L, tod / 100L);
+            if (fixtime < MIN_CLOCK_TIME) {
+                return NMEA_FIX_BADTIME;
+            } else
+            if (!_nmeaParsePoint(ns, 2, &gp)) {
+                return NMEA_FIX_BADPOINT;
+            }
+            _nmeaParseFixed(_nmeaField(ns,7), 0, &sats);
+            fix->ageTimer   = utcGetTimer();
+            fix->fixtime    = fixtime;
+            fix->point      = gp;
+            fix->fixtype    = (UInt16)quality; // 1=GPS, 2=DGPS, 3=PPS?, ...
+            fix->satellites = (UInt16)sats;
+            fix->altitude   = _nmeaParseDecimal(_nmeaField(ns,9), 2, GPS_UNDEFINED_ALTITUDE);
+            fix->pdop       = np->pdop;
+            fix->hdop       = np->hdop;
+            fix->vdop       = np->vdop;
+            fix->nmea      |= NMEA0183_GPGGA;
+            return NMEA_FIX_MERGED;
+        }
+
+        case NMEA0183_GPGSA: {
+            // $GPGSA,A,mode,sv1,...,sv12,pdop,hdop,vdop*HH
+            char mode = *_nmeaField(ns,2);
+            if ((mode != '2') && (mode != '3')) {
+                return NMEA_FIX_NOFIX; // "1" - no fix
+            }
+            np->pdop     = _nmeaParseDecimal(_nmeaField(ns,15), 2, GPS_UNDEFINED_DOP);
+            np->hdop     = _nmeaParseDecimal(_nmeaField(ns,16), 2, GPS_UNDEFINED_DOP);
+            np->vdop     = _nmeaParseDecimal(_nmeaField(ns,17), 2, GPS_UNDEFINED_DOP);
+            np->dopTimer = utcGetTimer();
+            fix->pdop    = np->pdop;
+            fix->hdop    = np->hdop;
+            fix->vdop    = np->vdop;
+            if (!(fix->nmea & NMEA0183_GPGGA)) {
+                // $GPGGA satellite count takes precedence
+                int n, sats = 0;
+                for (n = 3; n <= 14; n++) {
+                    if (*_nmeaField(ns,n)) { sats++; }
+                }
+                fix->satellites = (UInt16)sats;
+            }
+            fix->nmea   |= NMEA0183_GPGSA;
+            return NMEA_FIX_MERGED;
+        }
+
+        case NMEA0183_GPVTG: {
+            // $GPVTG,course,T,magcourse,M,knots,N,kph,K[,mode]*HH
+            if (*_nmeaField(ns,2) != 'T') {
+                return NMEA_FIX_IGNORED; // pre-NMEA-2.0 format (no unit fields)
+            } else
+            if (*_nmeaField(ns,9) == 'N') {
+                return NMEA_FIX_NOFIX; // mode "N" - data not valid
+            }
+            double heading = _nmeaParseDecimal(_nmeaField(ns,1), 2, -1.0);
+            double kph     = _nmeaParseDecimal(_nmeaField(ns,7), 3, -1.0);
+            if (kph < 0.0) {
+                double knots = _nmeaParseDecimal(_nmeaField(ns,5), 3, -1.0);
+                kph = (knots >= 0.0)? (knots * KILOMETERS_PER_KNOT) : -1.0;
+            }
+            if (heading >= 0.0) { fix->heading  = heading; }
+            if (kph     >= 0.0) { fix->speedKPH = kph; }
+            fix->nmea |= NMEA0183_GPVTG;
+            return NMEA_FIX_MERGED;
+        }
+
+    }
+    return NMEA_FIX_IGNORED;
+}
+
+// ----------------------------------------------------------------------------
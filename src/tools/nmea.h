@@ -0,0 +1,84 @@
+// ----------------------------------------------------------------------------
+// Copyright 2006-2007, Martin D. Flynn
+// All rights reserved
+// ----------------------------------------------------------------------------
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ----------------------------------------------------------------------------
+
+#ifndef _NMEA_H
+#define _NMEA_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tools/stdtypes.h"
+#include "tools/utctools.h"
+#include "tools/gpstools.h"
+
+// ----------------------------------------------------------------------------
+
+/* maximum sentence fields ($GPGSA has 18) */
+#define NMEA_MAX_FIELDS             24
+
+/* sentence parse errors (returned by 'nmeaParseSentence') */
+#define NMEA_ERR_FORMAT             -1      // not an NMEA-0183 sentence
+#define NMEA_ERR_CHECKSUM           -2      // '*HH' checksum mismatch
+
+/* fix assembly results (returned by 'nmeaAddSentence') */
+#define NMEA_FIX_IGNORED            0       // sentence type not supported/enabled
+#define NMEA_FIX_MERGED             1       // sentence data merged into current epoch
+#define NMEA_FIX_NOFIX              -1      // receiver reports no fix ($GPRMC 'V', $GPGGA '0')
+#define NMEA_FIX_BADTIME            -2      // fixtime prior to MIN_CLOCK_TIME
+#define NMEA_FIX_BADPOINT           -3      // latitude/longitude out of range
+
+/* seconds before last reported PDOP/HDOP/VDOP are discarded */
+#define NMEA_DOP_EXPIRE             60L
+
+// ----------------------------------------------------------------------------
+
+typedef struct
+{
+    UInt32          type;                   // NMEA0183_GPxxx (0 if unsupported)
+    int             count;                  // number of fields (including sentence id)
+    char            *fld[NMEA_MAX_FIELDS];  // pointers into the caller's sentence buffer
+} NMEASentence_t;
+
+typedef struct
+{
+    UInt32          typeMask;               // NMEA0183_GPxxx types to merge
+    GPS_t           fix;                    // epoch currently being assembled
+    UInt32          epochTOD;               // epoch time-of-day (hhmmss * 100 + hundredths)
+    utBool          epochValid;             // true if 'epochTOD' has been set
+    double          pdop;                   // last reported PDOP
+    double          hdop;                   // last reported HDOP
+    double          vdop;                   // last reported VDOP
+    TimerSec_t      dopTimer;               // time of last DOP report
+} NMEAParser_t;
+
+// ----------------------------------------------------------------------------
+
+UInt32 nmeaGetUTCSeconds(UInt32 dmy, UInt32 hms);
+
+int nmeaParseSentence(NMEASentence_t *ns, char *s);
+
+void nmeaParserInit(NMEAParser_t *np, UInt32 typeMask);
+int nmeaAddSentence(NMEAParser_t *np, const NMEASentence_t *ns);
+
+// ----------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+#endif
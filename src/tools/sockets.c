@@ -55,11 +55,13 @@ typedef int socklen_t;
 #  include <termios.h>
 #  include <netdb.h>
 #  include <netinet/in.h>
+#  include <netinet/tcp.h>
 #  include <sys/types.h>
 #  include <sys/ioctl.h>
 #  include <sys/stat.h>
 #  include <sys/socket.h>
 #  include <sys/select.h>
+#  include <sys/uio.h>
 #endif
 
 #include "tools/stdtypes.h"
@@ -108,7 +110,8 @@ typedef int socklen_t;
 // This works fine on Linux and GumStix
 #  include <asm/ioctls.h>
 #  define IOCTIL_REQUEST_BYTES_AVAIL    FIONREAD    // (int*)
-//#  define IOCTIL_REQUEST_NON_BLOCKING FIONBIO     // (int*)
+#  define IOCTIL_REQUEST_NON_BLOCKING   FIONBIO     // (int*)
+#  define SOCKET_SENDMSG                // gathered 'sendmsg' with MSG_NOSIGNAL
 #  define CLOSE_SOCKET(F)               close(F)
 #  define IOCTL_SOCKET(F,R,A)           ioctl(F,R,A)
 #  define IOCTL_ARG_TYPE                int
@@ -153,31 +156,73 @@ void socketInitStruct(Socket_t *sock, const char *host, int port, int type)
 
 // ----------------------------------------------------------------------------
 
-static int socketResolveHost(const char *host, UInt8 *addr, utBool alwaysResolve)
+/* resolved host cache entry */
+typedef struct {
+    char            host[SOCKET_HOST_SIZE];
+    UInt8           addr[6];
+    utBool          hasAddr;        // 'addr' is the last known address
+    TimerSec_t      addrTimer;      // time 'addr' was resolved
+    TimerSec_t      failTimer;      // time of last failed lookup (0 if none)
+    TimerSec_t      usedTimer;      // time of last use (for replacement)
+} SocketResolve_t;
+
+// The resolver cache is used by the (single) protocol thread which opens the
+// transport sockets, and is not otherwise synchronized.
+static SocketResolve_t          resolveCache[SOCKET_DNS_CACHE_SIZE];
+static UInt32                   resolveTTL      = SOCKET_DNS_DEFAULT_TTL;
+static UInt32                   resolveNegTTL   = SOCKET_DNS_DEFAULT_NEG_TTL;
+static SocketResolveStats_t     resolveStats;
+
+/* set the resolved host cache timeouts (0 to disable) */
+void socketSetResolveTTL(UInt32 ttlSec, UInt32 negTtlSec)
 {
-    // Note: 'addr' is assumed to be 6 bytes in length
+    resolveTTL    = ttlSec;
+    resolveNegTTL = negTtlSec;
+}
 
-    /* invalid addr */
-    if (!addr) {
-        return COMERR_SOCKET_HOST;
+/* return the resolved host cache statistics */
+SocketResolveStats_t *socketGetResolveStats(SocketResolveStats_t *stats)
+{
+    if (stats) {
+        memcpy(stats, &resolveStats, sizeof(SocketResolveStats_t));
+        return stats;
+    } else {
+        return &resolveStats;
     }
+}
 
-    /* check for already resolved */
-    if (!alwaysResolve) {
-        // don't resolve if address has already been resolved
-        // [NOTE: may have no effect if the socket structure is initialized to nulls on each open]
-        int i;
-        for (i = 0; i < 6; i++) {
-            if (addr[i]) {
-                return COMERR_SUCCESS;
-            }
-        }
+/* return the cache entry for the specified host (replacing the least recently used) */
+static SocketResolve_t *_socketGetResolveEntry(const char *host)
+{
+    SocketResolve_t *lru = (SocketResolve_t*)0;
+    int i;
+
+    /* host name too long to cache */
+    if (strlen(host) >= sizeof(resolveCache[0].host)) {
+        return (SocketResolve_t*)0;
     }
 
-    /* invalid host name */
-    if (!host || !*host) {
-        return COMERR_SOCKET_HOST;
+    /* find host */
+    for (i = 0; i < SOCKET_DNS_CACHE_SIZE; i++) {
+        SocketResolve_t *dns = &resolveCache[i];
+        if (strEquals(dns->host, host)) {
+            return dns;
+        } else
+        if (!lru || !*dns->host || (*lru->host && (dns->usedTimer < lru->usedTimer))) {
+            lru = dns;
+        }
     }
+
+    /* new entry */
+    memset(lru, 0, sizeof(SocketResolve_t));
+    strcpy(lru->host, host);
+    return lru;
+
+}
+
+/* lookup host address */
+static int _socketLookupHost(const char *host, UInt8 *addr)
+{
     
     /* get host entry */
     struct hostent *he = (struct hostent*)0;
@@ -231,6 +276,83 @@ static int socketResolveHost(const char *host, UInt8 *addr, utBool alwaysResolve
     
 }
 
+static int socketResolveHost(const char *host, UInt8 *addr, utBool alwaysResolve)
+{
+    // Note: 'addr' is assumed to be 6 bytes in length
+
+    /* invalid addr */
+    if (!addr) {
+        return COMERR_SOCKET_HOST;
+    }
+
+    /* check for already resolved */
+    if (!alwaysResolve) {
+        // don't resolve if address has already been resolved
+        // [NOTE: may have no effect if the socket structure is initialized to nulls on each open]
+        int i;
+        for (i = 0; i < 6; i++) {
+            if (addr[i]) {
+                return COMERR_SUCCESS;
+            }
+        }
+    }
+
+    /* invalid host name */
+    if (!host || !*host) {
+        return COMERR_SOCKET_HOST;
+    }
+
+    /* check cache */
+    SocketResolve_t *dns = _socketGetResolveEntry(host);
+    if (dns) {
+        dns->usedTimer = utcGetTimer();
+        if (!alwaysResolve) {
+            if (dns->hasAddr && !utcIsTimerExpired(dns->addrTimer,resolveTTL)) {
+                // recently resolved
+                resolveStats.hits++;
+                memcpy(addr, dns->addr, sizeof(dns->addr));
+                return COMERR_SUCCESS;
+            } else
+            if (!utcIsTimerExpired(dns->failTimer,resolveNegTTL)) {
+                // recently failed, don't try again yet
+                if (dns->hasAddr) {
+                    resolveStats.staleHits++;
+                    memcpy(addr, dns->addr, sizeof(dns->addr));
+                    return COMERR_SUCCESS;
+                }
+                resolveStats.negHits++;
+                return COMERR_SOCKET_HOST;
+            }
+        }
+    }
+
+    /* lookup */
+    int err = _socketLookupHost(host, addr);
+    if (err == COMERR_SUCCESS) {
+        resolveStats.misses++;
+        if (dns) {
+            memcpy(dns->addr, addr, sizeof(dns->addr));
+            dns->hasAddr   = utTrue;
+            dns->addrTimer = utcGetTimer();
+            dns->failTimer = 0L;
+        }
+    } else {
+        resolveStats.failures++;
+        if (dns) {
+            dns->failTimer = utcGetTimer();
+            if (dns->hasAddr) {
+                // use the last known address
+                logWARNING(LOGSRC,"Using last known address: %s", host);
+                resolveStats.staleHits++;
+                memcpy(addr, dns->addr, sizeof(dns->addr));
+                err = COMERR_SUCCESS;
+            }
+        }
+    }
+    return err;
+
+}
+
 // ----------------------------------------------------------------------------
 
 /* enable non-blocking mode */
@@ -265,6 +387,29 @@ utBool socketIsNonBlockingClient(Socket_t *sock)
     }
 }
 
+/* enable TCP keep-alive probes */
+// 'idleSec' is the idle time before the first probe, and the interval between 
+// probes (where supported by the platform, otherwise the system default is used).
+utBool socketEnableKeepAlive(Socket_t *sock, int idleSec)
+{
+    if (sock && (sock->sockfd != INVALID_SOCKET)) {
+        int yes = 1;
+        if (setsockopt(sock->sockfd, SOL_SOCKET, SO_KEEPALIVE, (char*)&yes, sizeof(yes)) == -1) {
+            int err = ERRNO;
+            logERROR(LOGSRC,"Unable to enable keep-alive [errno=%d]", err);
+            return utFalse;
+        }
+#if defined(TCP_KEEPIDLE) && defined(TCP_KEEPINTVL)
+        if (idleSec > 0) {
+            setsockopt(sock->sockfd, IPPROTO_TCP, TCP_KEEPIDLE , (char*)&idleSec, sizeof(idleSec));
+            setsockopt(sock->sockfd, IPPROTO_TCP, TCP_KEEPINTVL, (char*)&idleSec, sizeof(idleSec));
+        }
+#endif
+        return utTrue;
+    }
+    return utFalse;
+}
+
 // ----------------------------------------------------------------------------
 
 /* client: open a UDP socket for writing */
@@ -363,10 +508,9 @@ int socketOpenTCPClient(Socket_t *sock, const char *host, int port)
     }
     
     /* non-blocking mode */
-#if defined(TARGET_WINCE)
-    // set non-blocking AFTER connection
+    // set non-blocking AFTER connection (not supported on all platforms, in
+    // which case 'select' is called before each 'recv'/'send')
     socketEnableNonBlockingClient(sock, utTrue);
-#endif
 
     /* send timeout (SO_SNDTIMEO) */
     //(This is not supported on all platforms)
@@ -471,6 +615,9 @@ int socketAcceptTCPClient(Socket_t *sock)
             // client accept failed
             return COMERR_SOCKET_ACCEPT;
         }
+        sock->nonBlock = utFalse;
+        sock->rxHead = sock->rxLen = sock->txLen = 0;
+        socketEnableNonBlockingClient(sock, utTrue);
         return 0;
     } else {
         return COMERR_SOCKET_FILENO;
@@ -486,8 +633,10 @@ int socketCloseClient(Socket_t *sock)
 {
     if (sock && (sock->sockfd != INVALID_SOCKET)) {
         // SO_LINGER?
+        // (anything still queued for writing is discarded, see 'socketFlushTCP')
         CLOSE_SOCKET(sock->sockfd);
         sock->sockfd = INVALID_SOCKET;
+        sock->rxHead = sock->rxLen = sock->txLen = 0;
     }
     return 0;
 }
@@ -508,6 +657,7 @@ int socketCloseServer(Socket_t *sock)
 // ----------------------------------------------------------------------------
 
 /* return true if any data is available for reading */
+// A negative 'timeoutMS' waits indefinitely
 static utBool socketIsDataAvailable(Socket_t *sock, long timeoutMS)
 {
     if (sock && (sock->sockfd != INVALID_SOCKET)) {
@@ -518,7 +668,9 @@ static utBool socketIsDataAvailable(Socket_t *sock, long timeoutMS)
         tv.tv_sec  = timeoutMS / 1000L;
         tv.tv_usec = (timeoutMS % 1000L) * 1000L;
         RESET_ERRNO; // WSASetLastError(0);
-        select(sock->sockfd + 1, &rfds, 0, 0, &tv);
+        if (select(sock->sockfd + 1, &rfds, 0, 0, ((timeoutMS >= 0L)? &tv : 0)) <= 0) {
+            return utFalse; // timeout/interrupted
+        }
         if (FD_ISSET(sock->sockfd, &rfds)) {
             return utTrue;
         }
@@ -526,20 +678,10 @@ static utBool socketIsDataAvailable(Socket_t *sock, long timeoutMS)
     return utFalse;
 }
 
-/* return number of bytes available for reading */
-static int socketGetAvailableCount(Socket_t *sock)
-{
-    if (sock && (sock->sockfd != INVALID_SOCKET)) {
-        IOCTL_ARG_TYPE nBytesAvail = 0;
-        int status = IOCTL_SOCKET(sock->sockfd, IOCTIL_REQUEST_BYTES_AVAIL, &nBytesAvail);
-        int availBytes = (status >= 0)? (int)nBytesAvail : 0;
-        return availBytes;
-    } else {
-        return -1;
-    }
-}
-
 /* client/server: read TCP */
+// Data is received into the socket read buffer, up to SOCKET_RX_BUFFER_SIZE bytes
+// per 'recv', and subsequent reads are satisfied from that buffer.  Non-blocking
+// sockets are read first, and only 'select' when no data is available.
 int socketReadTCP(Socket_t *sock, UInt8 *buf, int bufSize, long timeoutMS)
 {
     if (sock && (sock->sockfd != INVALID_SOCKET)) {
@@ -548,62 +690,76 @@ int socketReadTCP(Socket_t *sock, UInt8 *buf, int bufSize, long timeoutMS)
         if ((bufSize <= 0) || !buf) {
             return 0;
         }
+
+        /* send any queued data first (the other side may be waiting for it) */
+        if ((sock->txLen > 0) && (socketFlushTCP(sock) < 0)) {
+            return COMERR_SOCKET_WRITE;
+        }
         
         /* current timestamp */
         struct timeval ts;
         utcGetTimestamp(&ts);
 
+        /* blocking sockets must wait for data before reading, if a timeout is in place */
+        utBool waitFirst = (!sock->nonBlock && (timeoutMS > 0L))? utTrue : utFalse;
+        utBool mustWait = waitFirst;
+
         int tot = 0;
         UInt32 zeroLengthRead = 0L;
         while (tot < bufSize) {
+
+            /* copy already received data */
+            if (sock->rxLen > 0) {
+                int len = bufSize - tot;
+                if (len > sock->rxLen) { len = sock->rxLen; }
+                memcpy(buf + tot, sock->rxBuf + sock->rxHead, len);
+                sock->rxHead += len;
+                sock->rxLen  -= len;
+                tot += len;
+                continue;
+            }
             
             /* wait for data */
-            //int avail = 0;
-            if (timeoutMS > 0L) {
-                Int32 deltaMS = utcGetDeltaMillis(&ts, 0);
-                if (deltaMS >= timeoutMS) { 
-                    // timeout
-                    //logWARNING(LOGSRC,"Socket read timeout ... %ld >= %ld", deltaMS, timeoutMS);
-                    //return COMERR_SOCKET_TIMEOUT;
-                    break;
-                }
-                // timeoutMS -= deltaMS; <-- removed to fix timeout problem
-                if (sock->avail <= 0) {
-                    utBool hasData = socketIsDataAvailable(sock, timeoutMS - deltaMS);
-                    sock->avail = socketGetAvailableCount(sock);
-                    //printf("[socket.c] avail=%d [%d]\n", sock->avail, hasData);
-                    if (sock->avail <= 0) {
-                        if (hasData) {
-                            // This means that getting the available count has failed.
-                            // (This seems to always be the case on Cygwin)
-                            sock->avail = 1; // at least 1 byte is available for reading
-                        } else {
-                            // try again on next loop
-                            continue;
-                        }
+            if (mustWait) {
+                long waitMS = -1L; // no timeout
+                if (timeoutMS > 0L) {
+                    Int32 deltaMS = utcGetDeltaMillis(&ts, 0);
+                    if (deltaMS >= timeoutMS) { 
+                        // timeout
+                        //logWARNING(LOGSRC,"Socket read timeout ... %ld >= %ld", deltaMS, timeoutMS);
+                        break;
                     }
-                } else {
-                    // data is already available
-                    // leave sock->avail as-is
+                    waitMS = timeoutMS - deltaMS;
+                }
+                if (!socketIsDataAvailable(sock, waitMS)) {
+                    // try again on next loop
+                    continue;
                 }
-            } else {
-                // no timeout is in place, just read everything we need
-                sock->avail = bufSize - tot;
             }
             
             /* read data */
-            int readLen = bufSize - tot;
-            if (readLen > sock->avail) { readLen = sock->avail; }
+            // large reads are received directly into the caller's buffer
+            UInt8 *rb = sock->rxBuf;
+            int rbSize = sizeof(sock->rxBuf);
+            if ((bufSize - tot) >= rbSize) {
+                rb = buf + tot;
+                rbSize = bufSize - tot;
+            }
             RESET_ERRNO; // WSASetLastError(0);
-            int cnt = recv(sock->sockfd, (char*)(buf + tot), readLen, 0); // MSG_WAITALL);
-            if (cnt < 0) {  // can this be <= 0 to eliminate the check below?
+            int cnt = recv(sock->sockfd, (char*)rb, rbSize, 0);
+            if (cnt < 0) {
                 int err = ERRNO; // WSAGetLastError();
-                if (err == EWOULDBLOCK) {
-                    logERROR(LOGSRC,"'recv' EWOULDBLOCK [errno=%d]", err);
-                } else {
-                    logERROR(LOGSRC,"'recv' error [errno=%d]", err);
+                if ((err == EWOULDBLOCK) || (err == EAGAIN)) {
+                    // nothing available yet (non-blocking)
+                    mustWait = utTrue;
+                    continue;
                 }
-                sock->avail = 0;
+#if defined(EINTR)
+                if (err == EINTR) {
+                    continue;
+                }
+#endif
+                logERROR(LOGSRC,"'recv' error [errno=%d]", err);
                 return COMERR_SOCKET_READ; 
             } else
             if (cnt == 0) {
@@ -613,13 +769,18 @@ int socketReadTCP(Socket_t *sock, UInt8 *buf, int bufSize, long timeoutMS)
                     // 'cnt' will be zero (forever), rather than '-1'  This section 
                     // is a hack which checks this possibility and exits accordingly.
                     logERROR(LOGSRC,"Excessive zero leangth reads!");
-                    sock->avail = 0;
                     return COMERR_SOCKET_READ;
                 }
+                mustWait = utTrue;
             } else {
-                tot += cnt;
-                sock->avail -= cnt;
+                if (rb == sock->rxBuf) {
+                    sock->rxHead = 0;
+                    sock->rxLen  = cnt;
+                } else {
+                    tot += cnt;
+                }
                 zeroLengthRead = 0L;
+                mustWait = waitFirst;
             }
             
         } // while (tot < bufSize)
@@ -643,6 +804,30 @@ int socketReadTCP(Socket_t *sock, UInt8 *buf, int bufSize, long timeoutMS)
     }
 }
 
+/* client/server: return true if the other side has not closed this TCP connection */
+// Intended for checking an idle connection before it is reused.  Unread data
+// is left in place.
+utBool socketIsConnectedTCP(Socket_t *sock)
+{
+    if (sock && (sock->sockfd != INVALID_SOCKET)) {
+        if (sock->rxLen > 0) {
+            // unread data
+            return utTrue;
+        } else
+        if (!socketIsDataAvailable(sock, 0L)) {
+            // nothing received (no EOF)
+            return utTrue;
+        } else {
+            // data, or EOF/error
+            UInt8 b;
+            RESET_ERRNO; // WSASetLastError(0);
+            int cnt = recv(sock->sockfd, (char*)&b, 1, MSG_PEEK);
+            return (cnt > 0)? utTrue : utFalse;
+        }
+    }
+    return utFalse;
+}
+
 #if defined(ENABLE_SERVER_SOCKET)
 /* server: read UDP */
 int socketReadUDP(Socket_t *sock, UInt8 *buf, int bufSize, long timeoutMS)
@@ -675,7 +860,7 @@ int socketReadUDP(Socket_t *sock, UInt8 *buf, int bufSize, long timeoutMS)
 
 // ----------------------------------------------------------------------------
 
-/* return true if any data is available for reading */
+/* return true if the socket is ready for writing */
 static utBool socketIsSendReady(Socket_t *sock, long timeoutMS)
 {
     if (sock && (sock->sockfd != INVALID_SOCKET)) {
@@ -694,8 +879,9 @@ static utBool socketIsSendReady(Socket_t *sock, long timeoutMS)
     return utFalse;
 }
 
-/* client/server: write TCP */
-int socketWriteTCP(Socket_t *sock, const UInt8 *buf, int bufLen)
+/* client/server: gathered write TCP */
+// Returns the total number of bytes written, or < 0 on error.
+int socketWriteVTCP(Socket_t *sock, const SocketVec_t *vec, int vecCnt)
 {
     // On one occasion it appears that 'send(...)' has locked up when GPRS 
     // coverage became unavilable in the middle of the transmission.
@@ -710,30 +896,61 @@ int socketWriteTCP(Socket_t *sock, const UInt8 *buf, int bufLen)
         // extremely unlikely.  If this does become an issue, a 'readTimeoutMS'
         // should be implemented which limits the accumulation of 'select' timeouts.
         long selectTimeoutMS = 10000L;
+
+        /* non-blocking sockets only 'select' after 'send' would block */
+        utBool waitFirst = sock->nonBlock? utFalse : utTrue;
+        utBool mustWait = waitFirst;
         
         /* 'send' loop */
-        int tot = 0;
+        int v = 0, ofs = 0, tot = 0;
         UInt32 zeroLengthSend = 0L;
-        while (tot < bufLen) {
+        for (;;) {
+
+            /* skip buffers already sent */
+            while ((v < vecCnt) && (ofs >= vec[v].len)) { v++; ofs = 0; }
+            if (v >= vecCnt) {
+                break;
+            }
 
             /* check for 'send' ready */
-            if (!socketIsSendReady(sock,selectTimeoutMS)) {
+            if (mustWait && !socketIsSendReady(sock,selectTimeoutMS)) {
                 int err = ERRNO;
                 logERROR(LOGSRC,"Timeout waiting for 'send' [errno=%d]", err);
                 return COMERR_SOCKET_TIMEOUT;
             }
 
             /* send data */
-            int flags = 0;
             RESET_ERRNO; // WSASetLastError(0);
-            int cnt = send(sock->sockfd, (char*)(buf + tot), bufLen - tot, flags);
+#if defined(SOCKET_SENDMSG)
+            struct iovec iov[SOCKET_MAX_VEC];
+            struct msghdr msg;
+            int n;
+            for (n = 0; (n < SOCKET_MAX_VEC) && ((v + n) < vecCnt); n++) {
+                int o = (n == 0)? ofs : 0;
+                iov[n].iov_base = (void*)(vec[v + n].buf + o);
+                iov[n].iov_len  = vec[v + n].len - o;
+            }
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov    = iov;
+            msg.msg_iovlen = n;
+            int cnt = sendmsg(sock->sockfd, &msg, MSG_NOSIGNAL);
+#else
+            int cnt = send(sock->sockfd, (char*)(vec[v].buf + ofs), vec[v].len - ofs, 0);
+#endif
             if (cnt < 0) {
                 int err = ERRNO; // WSAGetLastError();
+                if ((err == EWOULDBLOCK) || (err == EAGAIN)) {
+                    // normal condition in non-blocking mode
+                    mustWait = utTrue;
+                    continue;
+                }
+#if defined(EINTR)
+                if (err == EINTR) {
+                    continue;
+                }
+#endif
                 if (err == ECONNRESET) {
                     logERROR(LOGSRC,"Connection reset by peer [errno=%d]", err);
-                } else
-                if ((err == EWOULDBLOCK) || (err == EAGAIN)) {
-                    logERROR(LOGSRC,"'send' would block [errno=%d]", err);
                 } else {
                     logERROR(LOGSRC,"Socket 'send' error [errno=%d]", err);
                 }
@@ -746,23 +963,92 @@ int socketWriteTCP(Socket_t *sock, const UInt8 *buf, int bufLen)
                     logERROR(LOGSRC,"Too many zero-length 'send's");
                     return COMERR_SOCKET_WRITE;
                 }
-            } else
-            if (cnt < (bufLen - tot)) {
-                // normal condition in non-blocking mode
+            } else {
+                // advance past the sent data (may be a partial write)
+                tot += cnt;
+                while (cnt > 0) {
+                    int rem = vec[v].len - ofs;
+                    if (cnt < rem) {
+                        ofs += cnt;
+                        cnt = 0;
+                    } else {
+                        cnt -= rem;
+                        v++;
+                        ofs = 0;
+                    }
+                }
+                mustWait = waitFirst;
             }
-            tot += cnt;
             
         }
         return tot;
         
     } else {
         
-        // Invalid 'socketWriteTCP' fileno
+        // Invalid 'socketWriteVTCP' fileno
         return COMERR_SOCKET_FILENO;
         
     }
 }
 
+/* client/server: write TCP */
+// Any queued data (see 'socketQueueTCP') is sent first, in the same gathered write.
+int socketWriteTCP(Socket_t *sock, const UInt8 *buf, int bufLen)
+{
+    if (sock && (sock->sockfd != INVALID_SOCKET)) {
+        SocketVec_t vec[2];
+        int n = 0, queued = sock->txLen;
+        if (queued > 0) {
+            vec[n].buf = sock->txBuf;
+            vec[n].len = queued;
+            n++;
+        }
+        vec[n].buf = buf;
+        vec[n].len = (buf && (bufLen > 0))? bufLen : 0;
+        n++;
+        int len = socketWriteVTCP(sock, vec, n);
+        sock->txLen = 0;
+        return (len < 0)? len : (len - queued);
+    } else {
+        // Invalid 'socketWriteTCP' fileno
+        return COMERR_SOCKET_FILENO;
+    }
+}
+
+/* client/server: queue data for a later write */
+// Queued data is sent when the write buffer is full, on the next 'socketWriteTCP',
+// 'socketFlushTCP', or before the next 'socketReadTCP' waits for data.
+int socketQueueTCP(Socket_t *sock, const UInt8 *buf, int bufLen)
+{
+    if (sock && (sock->sockfd != INVALID_SOCKET)) {
+        if (!buf || (bufLen <= 0)) {
+            return 0;
+        } else
+        if (bufLen <= (int)(sizeof(sock->txBuf) - sock->txLen)) {
+            memcpy(sock->txBuf + sock->txLen, buf, bufLen);
+            sock->txLen += bufLen;
+            return bufLen;
+        } else {
+            // write buffer full, send queued data and 'buf' now
+            return socketWriteTCP(sock, buf, bufLen);
+        }
+    } else {
+        // Invalid 'socketQueueTCP' fileno
+        return COMERR_SOCKET_FILENO;
+    }
+}
+
+/* client/server: write queued data */
+int socketFlushTCP(Socket_t *sock)
+{
+    if (sock && (sock->sockfd != INVALID_SOCKET)) {
+        return (sock->txLen > 0)? socketWriteTCP(sock, (UInt8*)0, 0) : 0;
+    } else {
+        // Invalid 'socketFlushTCP' fileno
+        return COMERR_SOCKET_FILENO;
+    }
+}
+
 /* client: write UDP */
 int socketWriteUDP(Socket_t *sock, const UInt8 *buf, int bufLen)
 {
@@ -39,6 +39,46 @@ extern "C" {
 
 // ----------------------------------------------------------------------------
 
+// per-socket TCP read/write buffer sizes
+#if !defined(SOCKET_RX_BUFFER_SIZE)
+#  define SOCKET_RX_BUFFER_SIZE     1024
+#endif
+#if !defined(SOCKET_TX_BUFFER_SIZE)
+#  define SOCKET_TX_BUFFER_SIZE     1024
+#endif
+
+// maximum number of buffers sent in a single gathered write
+#define SOCKET_MAX_VEC              8
+
+// maximum host name length (plus terminator)
+#define SOCKET_HOST_SIZE            64
+
+// ----------------------------------------------------------------------------
+
+// resolved host cache
+#if !defined(SOCKET_DNS_CACHE_SIZE)
+#  define SOCKET_DNS_CACHE_SIZE     4
+#endif
+#define SOCKET_DNS_DEFAULT_TTL      3600L   // seconds a resolved address is used
+#define SOCKET_DNS_DEFAULT_NEG_TTL  60L     // seconds a failed lookup is remembered
+
+/* resolved host cache statistics (see 'socketGetResolveStats') */
+typedef struct {
+    UInt32          hits;       // resolved from the cache
+    UInt32          misses;     // resolved by DNS lookup
+    UInt32          failures;   // DNS lookup failed
+    UInt32          negHits;    // failed from the cache (recent DNS lookup failure)
+    UInt32          staleHits;  // DNS lookup failed, last known address used
+} SocketResolveStats_t;
+
+// ----------------------------------------------------------------------------
+
+/* gathered write buffer (see 'socketWriteVTCP') */
+typedef struct {
+    const UInt8     *buf;
+    int             len;
+} SocketVec_t;
+
 typedef struct {
     int             type;       // SOCK_STREAM, SOCK_DGRAM
 #if defined(ENABLE_SERVER_SOCKET)
@@ -54,8 +94,12 @@ typedef struct {
     int             sockfd;
 #endif
     utBool          nonBlock;
-    int             avail;
-    char            host[32];
+    UInt8           rxBuf[SOCKET_RX_BUFFER_SIZE]; // received, but not yet read
+    int             rxHead;
+    int             rxLen;
+    UInt8           txBuf[SOCKET_TX_BUFFER_SIZE]; // queued, but not yet sent
+    int             txLen;
+    char            host[SOCKET_HOST_SIZE];
     utBool          hostInit;
     UInt8           hostAddr[6];
     int             port;
@@ -80,6 +124,9 @@ typedef struct {
 
 void socketInitStruct(Socket_t *sock, const char *host, int port, int type);
 
+void socketSetResolveTTL(UInt32 ttlSec, UInt32 negTtlSec);
+SocketResolveStats_t *socketGetResolveStats(SocketResolveStats_t *stats);
+
 int socketOpenUDPClient(Socket_t *sock, const char *host, int port);
 int socketOpenTCPClient(Socket_t *sock, const char *host, int port);
 utBool socketIsOpenClient(Socket_t *sock);
@@ -89,9 +136,15 @@ int socketCloseClient(Socket_t *sock);
 utBool socketEnableNonBlockingClient(Socket_t *sock, utBool enabled);
 utBool socketIsNonBlockingClient(Socket_t *sock);
 
+utBool socketEnableKeepAlive(Socket_t *sock, int idleSec);
+utBool socketIsConnectedTCP(Socket_t *sock);
+
 int socketReadTCP(Socket_t *sock, UInt8 *buf, int bufSize, long timeoutMS);
 
 int socketWriteTCP(Socket_t *sock, const UInt8 *buf, int bufLen);
+int socketWriteVTCP(Socket_t *sock, const SocketVec_t *vec, int vecCnt);
+int socketQueueTCP(Socket_t *sock, const UInt8 *buf, int bufLen);
+int socketFlushTCP(Socket_t *sock);
 int socketWriteUDP(Socket_t *sock, const UInt8 *buf, int bufLen);
 
 // ----------------------------------------------------------------------------
@@ -637,20 +637,29 @@ double strParseDouble(const char *s, double dft)
 
 // ----------------------------------------------------------------------------
 
-static int _hexNybble(UInt8 ch)
-{
-    if ((ch >= '0') && (ch <= '9')) {
-        return (int)(ch - '0') & 0xF;
-    } else
-    if ((ch >= 'a') && (ch <= 'f')) {
-        return ((int)(ch - 'a') & 0xF) + 10;
-    } else
-    if ((ch >= 'A') && (ch <= 'F')) {
-        return ((int)(ch - 'A') & 0xF) + 10;
-    } else {
-        return -1;
-    }
-}
+/* character to nybble value (-1 for non-hex characters, including the terminator) */
+static const signed char HexNybble[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+     0, 1, 2, 3, 4, 5, 6, 7, 8, 9,-1,-1,-1,-1,-1,-1,
+    -1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1
+};
+
+static const char HexDigit[] = "0123456789ABCDEF";
+
+#define _hexNybble(C)   ((int)HexNybble[(UInt8)(C)])
 
 /* return true if character is a hex digit */
 utBool strIsHexDigit(char ch)
@@ -664,35 +673,28 @@ int strParseHex(const char *hex, int hexLen, UInt8 *data, int dataLen)
 {
     // The number of valid nybbles is assumed to be even.  
     // If not even, the last byte will not be parsed.
-    if (!hex) {
+    // The string terminator is not a hex digit, so parsing stops there without
+    // first scanning for the string length.
+    if (!hex || !data) {
         return 0;
     } else {
-        int len = (hexLen >= 0)? strLength(hex, hexLen) : strlen(hex);
         const char *h = hex;
+        int len = (hexLen >= 0)? hexLen : 0x7FFFFFFF;
         if ((len >= 2) && (*h == '0') && ((*(h+1) == 'x') || (*(h+1) == 'X'))) {
             h += 2;
             len -= 2;
         }
-        if (len & 1) { len--; } // make sure length is even
-        if (len >= 2) {
-            int i;
-            for (i = 0; (i < len) && ((i/2) < dataLen); i += 2) {
-                int c1 = _hexNybble(h[i]);
-                if (c1 < 0) {
-                    // Invalid Hex char (the first of the pair)
-                    break; // stop parsing
-                }
-                int c2 = _hexNybble(h[i+1]);
-                if (c2 < 0) { 
-                    // Invalid Hex char (the second of the pair)
-                    break; // stop parsing (last byte ignored
-                }
-                data[i/2] = (UInt8)(((c1 << 4) & 0xF0) | (c2 & 0x0F));
+        int d;
+        for (d = 0; (d < dataLen) && (len >= 2); d++, h += 2, len -= 2) {
+            int c1 = _hexNybble(h[0]);
+            int c2 = (c1 >= 0)? _hexNybble(h[1]) : -1;
+            if ((c1 | c2) < 0) {
+                // Invalid Hex char (or end of string)
+                break; // stop parsing (partial byte ignored)
             }
-            return i/2;
-        } else {
-            return 0;
+            data[d] = (UInt8)((c1 << 4) | c2);
         }
+        return d;
     }
 }
 
@@ -708,9 +710,10 @@ char *strEncodeHex(char *hex, int hexLen, const UInt8 *data, int dataLen)
             int i;
             char *h = hex;
             for (i = 0; i < dataLen; i++) {
-                sprintf(h, "%02X", (unsigned int)data[i] & 0xFF);
-                h += strlen(h);
+                *h++ = HexDigit[(data[i] >> 4) & 0xF];
+                *h++ = HexDigit[ data[i]       & 0xF];
             }
+            *h = 0;
         }
         return hex;
     } else {
@@ -25,10 +25,15 @@
 //     -WindowsCE port
 // ----------------------------------------------------------------------------
 
+#if defined(TARGET_LINUX) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE // pthread_setaffinity_np, CPU_SET
+#endif
+
 #include "stdafx.h" // TARGET_WINCE
 #define SKIP_TRANSPORT_MEDIA_CHECK // only if TRANSPORT_MEDIA not used in this file 
 #include "custom/defaults.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -37,6 +42,9 @@
 #if defined(TARGET_WINCE)
 #  include <aygshell.h>
 #  include <kfuncs.h>
+#else
+#  include <unistd.h>
+#  include <sched.h>
 #endif
 
 #include "custom/log.h"
@@ -54,6 +62,13 @@
 // Possible 'magic' words: BEEF, DEAD, CAFE, BABE, C001, D00D, C0DE, FEED, FACE, BADC0FEE
 #define MAGIC_INIT_VALUE    ((UInt32)0xC0DECAFE)
 
+/* full memory barrier (compiler and cpu) */
+#if defined(TARGET_WINCE)
+#  define MEMORY_BARRIER()  MemoryBarrier()
+#else
+#  define MEMORY_BARRIER()  __sync_synchronize()
+#endif
+
 // ----------------------------------------------------------------------------
 
 static int                  threadCreateCount = 0;
@@ -132,6 +147,12 @@ int threadCreate(threadThread_t *thread, void(*runnable)(void*), void *arg, cons
 #else
         int createErr = pthread_create(&(thread->thread),(pthread_attr_t*)0,(void*(*)(void*))runnable,arg);
         if (createErr == 0) {
+#if defined(TARGET_LINUX) && defined(_GNU_SOURCE)
+            // name is visible with 'ps -L' and 'top -H' (limited to 15 chars)
+            char tname[16];
+            strCopy(tname, sizeof(tname), thread->name, -1);
+            pthread_setname_np(thread->thread, tname);
+#endif
             rtn = 0; // success
         }
 #endif
@@ -152,6 +173,57 @@ void threadExit()
 #endif
 }
 
+/* wait for thread to exit */
+int threadJoin(threadThread_t *thread)
+{
+    if (thread && (thread->didInit == MAGIC_INIT_VALUE)) {
+#if defined(TARGET_WINCE)
+        WaitForSingleObject(thread->thread, INFINITE);
+        CloseHandle(thread->thread);
+#else
+        pthread_join(thread->thread, (void**)0);
+#endif
+        thread->didInit = 0L;
+        return 0;
+    } else {
+        logCRITICAL(LOGSRC,"Null or unitialized thread specified");
+        return -1;
+    }
+}
+
+/* bind thread to the specified CPU */
+int threadSetAffinity(threadThread_t *thread, int cpu)
+{
+    if (thread && (thread->didInit == MAGIC_INIT_VALUE) && (cpu >= 0)) {
+#if defined(TARGET_LINUX) && defined(CPU_SET)
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu % threadGetCPUCount(), &cpuSet);
+        return (pthread_setaffinity_np(thread->thread, sizeof(cpuSet), &cpuSet) == 0)? 0 : -1;
+#else
+        // not supported
+        return -1;
+#endif
+    } else {
+        return -1;
+    }
+}
+
+/* return the number of online CPUs */
+int threadGetCPUCount()
+{
+#if defined(TARGET_WINCE)
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    return (sysInfo.dwNumberOfProcessors > 0)? (int)sysInfo.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0L)? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+
 // ----------------------------------------------------------------------------
 
 /* initialize mutex */
@@ -358,6 +430,349 @@ int threadConditionNotify(threadCond_t *cond)
     }
 }
 
+/* notify all threads waiting on condition */
+int threadConditionNotifyAll(threadCond_t *cond)
+{
+    if (cond && (cond->didInit == MAGIC_INIT_VALUE)) {
+#if defined(TARGET_WINCE)
+        /* check waiters */
+        EnterCriticalSection(&(cond->numWaitersLock));
+        int numWaiters = cond->numWaiters;
+        LeaveCriticalSection(&(cond->numWaitersLock));
+        /* release Semaphore */
+        if (numWaiters > 0) {
+            ReleaseSemaphore(cond->semaphore, numWaiters, 0);
+        }
+#else
+        pthread_cond_broadcast(&(cond->semaphore));
+#endif
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/* initialize sequence lock */
+void threadSeqLockInit(threadSeqLock_t *seqLock)
+{
+    if (seqLock) {
+        seqLock->sequence = 0L;
+    }
+}
+
+/* start write (the caller must be the only writer) */
+void threadSeqWriteBegin(threadSeqLock_t *seqLock)
+{
+    seqLock->sequence++; // now odd
+    MEMORY_BARRIER();
+}
+
+/* end write */
+void threadSeqWriteEnd(threadSeqLock_t *seqLock)
+{
+    MEMORY_BARRIER();
+    seqLock->sequence++; // now even
+}
+
+/* start read, returns the sequence to pass to 'threadSeqReadRetry' */
+UInt32 threadSeqReadBegin(threadSeqLock_t *seqLock)
+{
+    UInt32 seq;
+    while ((seq = seqLock->sequence) & 1L) {
+        // write in progress (writes are short, give the writer a chance to finish)
+#if defined(TARGET_WINCE)
+        Sleep(0);
+#else
+        sched_yield();
+#endif
+    }
+    MEMORY_BARRIER();
+    return seq;
+}
+
+/* return true if the data read since 'threadSeqReadBegin' must be re-read */
+utBool threadSeqReadRetry(threadSeqLock_t *seqLock, UInt32 seq)
+{
+    MEMORY_BARRIER();
+    return (seqLock->sequence != seq)? utTrue : utFalse;
+}
+
+// ----------------------------------------------------------------------------
+
+/* initialize bounded work queue ('item' must have room for 'size' entries) */
+int threadQueueInit(threadQueue_t *queue, void **item, int size)
+{
+    if (queue && item && (size > 0)) {
+        memset(queue, 0, sizeof(threadQueue_t));
+        threadMutexInit(&(queue->mutex));
+        threadConditionInit(&(queue->notEmpty));
+        threadConditionInit(&(queue->notFull));
+        queue->item    = item;
+        queue->size    = size;
+        queue->head    = 0;
+        queue->count   = 0;
+        queue->closed  = utFalse;
+        queue->didInit = MAGIC_INIT_VALUE;
+        return 0;
+    } else {
+        logCRITICAL(LOGSRC,"Invalid queue buffer specified");
+        return -1;
+    }
+}
+
+/* free bounded work queue */
+void threadQueueFree(threadQueue_t *queue)
+{
+    if (queue) {
+        if (queue->didInit == MAGIC_INIT_VALUE) {
+            threadConditionFree(&(queue->notFull));
+            threadConditionFree(&(queue->notEmpty));
+            threadMutexFree(&(queue->mutex));
+        }
+        memset(queue, 0, sizeof(threadQueue_t));
+    }
+}
+
+/* wait on queue condition, returns false on timeout */
+static utBool _threadQueueWait(threadCond_t *cond, threadMutex_t *mutex, struct timespec *ts)
+{
+    return (threadConditionTimedWait(cond, mutex, ts) == 0)? utTrue : utFalse;
+}
+
+/* add item to queue */
+// Returns 0 if added, 1 if the queue remained full until the timeout, -1 if the queue is closed.
+int threadQueuePut(threadQueue_t *queue, void *item, long timeoutMS)
+{
+    if (!queue || (queue->didInit != MAGIC_INIT_VALUE)) {
+        logCRITICAL(LOGSRC,"Null or unitialized queue specified");
+        return -1;
+    }
+    int rtn = -1;
+    struct timespec ts, *tsp = (timeoutMS > 0L)? utcGetAbsoluteTimespec(&ts, (UInt32)timeoutMS) : (struct timespec*)0;
+    MUTEX_LOCK(&(queue->mutex)) {
+        while (!queue->closed && (queue->count >= queue->size) && (timeoutMS != 0L)) {
+            if (!_threadQueueWait(&(queue->notFull), &(queue->mutex), tsp)) { break; } // timeout
+        }
+        if (queue->closed) {
+            rtn = -1;
+        } else
+        if (queue->count < queue->size) {
+            queue->item[(queue->head + queue->count) % queue->size] = item;
+            queue->count++;
+            CONDITION_NOTIFY(&(queue->notEmpty));
+            rtn = 0;
+        } else {
+            rtn = 1;
+        }
+    } MUTEX_UNLOCK(&(queue->mutex))
+    return rtn;
+}
+
+/* remove item from queue */
+// Returns 0 if an item was removed, 1 if the queue remained empty until the timeout, 
+// -1 if the queue is closed and empty.
+int threadQueueGet(threadQueue_t *queue, void **item, long timeoutMS)
+{
+    if (!queue || (queue->didInit != MAGIC_INIT_VALUE)) {
+        logCRITICAL(LOGSRC,"Null or unitialized queue specified");
+        return -1;
+    }
+    int rtn = -1;
+    struct timespec ts, *tsp = (timeoutMS > 0L)? utcGetAbsoluteTimespec(&ts, (UInt32)timeoutMS) : (struct timespec*)0;
+    MUTEX_LOCK(&(queue->mutex)) {
+        while (!queue->closed && (queue->count <= 0) && (timeoutMS != 0L)) {
+            if (!_threadQueueWait(&(queue->notEmpty), &(queue->mutex), tsp)) { break; } // timeout
+        }
+        if (queue->count > 0) {
+            // items are still returned after the queue is closed
+            if (item) { *item = queue->item[queue->head]; }
+            queue->head = (queue->head + 1) % queue->size;
+            queue->count--;
+            CONDITION_NOTIFY(&(queue->notFull));
+            rtn = 0;
+        } else {
+            rtn = queue->closed? -1 : 1;
+        }
+    } MUTEX_UNLOCK(&(queue->mutex))
+    return rtn;
+}
+
+/* return number of queued items */
+int threadQueueGetCount(threadQueue_t *queue)
+{
+    int count = 0;
+    if (queue && (queue->didInit == MAGIC_INIT_VALUE)) {
+        MUTEX_LOCK(&(queue->mutex)) {
+            count = queue->count;
+        } MUTEX_UNLOCK(&(queue->mutex))
+    }
+    return count;
+}
+
+/* close queue (queued items may still be removed, waiting threads are released) */
+void threadQueueClose(threadQueue_t *queue)
+{
+    if (queue && (queue->didInit == MAGIC_INIT_VALUE)) {
+        MUTEX_LOCK(&(queue->mutex)) {
+            queue->closed = utTrue;
+            threadConditionNotifyAll(&(queue->notEmpty));
+            threadConditionNotifyAll(&(queue->notFull));
+        } MUTEX_UNLOCK(&(queue->mutex))
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/* initialize thread pool task */
+void threadTaskInit(threadTask_t *task, void (*run)(void*), void *arg, void (*done)(threadTask_t*))
+{
+    if (task) {
+        task->run    = run;
+        task->arg    = arg;
+        task->done   = done;
+        task->isDone = utFalse;
+    }
+}
+
+/* thread pool worker */
+static void _threadPoolRunnable(void *arg)
+{
+    threadPool_t *pool = (threadPool_t*)arg;
+    void *item;
+    while (threadQueueGet(&(pool->queue), &item, -1L) == 0) {
+        threadTask_t *task = (threadTask_t*)item;
+        if (task->run) {
+            (*task->run)(task->arg);
+        }
+        if (task->done) {
+            // called before the task is marked done
+            (*task->done)(task);
+        }
+        MUTEX_LOCK(&(pool->mutex)) {
+            task->isDone = utTrue;
+            if (pool->pending > 0L) { pool->pending--; }
+            threadConditionNotifyAll(&(pool->doneCond));
+        } MUTEX_UNLOCK(&(pool->mutex))
+    }
+    // queue closed
+    threadExit();
+}
+
+/* start thread pool */
+// 'workers' <= 0 starts one worker per online CPU.  If 'firstCPU' >= 0, worker 'N' is
+// bound to CPU 'firstCPU + N' (modulo the number of CPUs).
+// Returns the number of workers started, or -1 on error.
+int threadPoolInit(threadPool_t *pool, const char *name, int workers, int firstCPU)
+{
+    if (!pool) {
+        logCRITICAL(LOGSRC,"Null thread pool buffer specified");
+        return -1;
+    }
+    memset(pool, 0, sizeof(threadPool_t));
+    threadQueueInit(&(pool->queue), pool->queueItem, THREAD_POOL_QUEUE_SIZE);
+    threadMutexInit(&(pool->mutex));
+    threadConditionInit(&(pool->doneCond));
+    pool->didInit = MAGIC_INIT_VALUE;
+
+    /* start workers */
+    if (workers <= 0) { workers = threadGetCPUCount(); }
+    if (workers > THREAD_POOL_MAX_WORKERS) { workers = THREAD_POOL_MAX_WORKERS; }
+    int i;
+    for (i = 0; i < workers; i++) {
+        char wname[sizeof(pool->worker[i].name)];
+        snprintf(wname, sizeof(wname), "%s-%d", (name? name : "Pool"), i);
+        if (threadCreate(&(pool->worker[i]), &_threadPoolRunnable, (void*)pool, wname) != 0) {
+            logERROR(LOGSRC,"Unable to start thread pool worker: %s", wname);
+            break;
+        }
+        if (firstCPU >= 0) {
+            threadSetAffinity(&(pool->worker[i]), firstCPU + i);
+        }
+        pool->workerCount++;
+    }
+    if (pool->workerCount <= 0) {
+        threadPoolFree(pool);
+        return -1;
+    }
+    return pool->workerCount;
+
+}
+
+/* stop thread pool (queued tasks are run before the workers exit) */
+void threadPoolFree(threadPool_t *pool)
+{
+    if (pool && (pool->didInit == MAGIC_INIT_VALUE)) {
+        int i;
+        threadQueueClose(&(pool->queue));
+        for (i = 0; i < pool->workerCount; i++) {
+            threadJoin(&(pool->worker[i]));
+        }
+        threadQueueFree(&(pool->queue));
+        threadConditionFree(&(pool->doneCond));
+        threadMutexFree(&(pool->mutex));
+        memset(pool, 0, sizeof(threadPool_t));
+    }
+}
+
+/* submit task to thread pool */
+// Returns 0 if queued, 1 if the queue remained full until the timeout, -1 on error.
+int threadPoolSubmit(threadPool_t *pool, threadTask_t *task, long timeoutMS)
+{
+    if (!pool || (pool->didInit != MAGIC_INIT_VALUE) || !task) {
+        logCRITICAL(LOGSRC,"Null or unitialized thread pool/task specified");
+        return -1;
+    }
+    task->isDone = utFalse;
+    MUTEX_LOCK(&(pool->mutex)) {
+        pool->pending++;
+    } MUTEX_UNLOCK(&(pool->mutex))
+    int rtn = threadQueuePut(&(pool->queue), (void*)task, timeoutMS);
+    if (rtn != 0) {
+        MUTEX_LOCK(&(pool->mutex)) {
+            pool->pending--;
+        } MUTEX_UNLOCK(&(pool->mutex))
+    }
+    return rtn;
+}
+
+/* wait for submitted task to complete */
+// Returns 0 if the task is done, 1 on timeout, -1 on error.
+int threadPoolWaitTask(threadPool_t *pool, threadTask_t *task, long timeoutMS)
+{
+    if (!pool || (pool->didInit != MAGIC_INIT_VALUE) || !task) {
+        return -1;
+    }
+    struct timespec ts, *tsp = (timeoutMS > 0L)? utcGetAbsoluteTimespec(&ts, (UInt32)timeoutMS) : (struct timespec*)0;
+    utBool done = utFalse;
+    MUTEX_LOCK(&(pool->mutex)) {
+        while (!task->isDone && (timeoutMS != 0L)) {
+            if (threadConditionTimedWait(&(pool->doneCond), &(pool->mutex), tsp) != 0) { break; }
+        }
+        done = task->isDone;
+    } MUTEX_UNLOCK(&(pool->mutex))
+    return done? 0 : 1;
+}
+
+/* wait for all submitted tasks to complete */
+// Returns 0 if idle, 1 on timeout, -1 on error.
+int threadPoolWaitIdle(threadPool_t *pool, long timeoutMS)
+{
+    if (!pool || (pool->didInit != MAGIC_INIT_VALUE)) {
+        return -1;
+    }
+    struct timespec ts, *tsp = (timeoutMS > 0L)? utcGetAbsoluteTimespec(&ts, (UInt32)timeoutMS) : (struct timespec*)0;
+    utBool idle = utFalse;
+    MUTEX_LOCK(&(pool->mutex)) {
+        while ((pool->pending > 0L) && (timeoutMS != 0L)) {
+            if (threadConditionTimedWait(&(pool->doneCond), &(pool->mutex), tsp) != 0) { break; }
+        }
+        idle = (pool->pending == 0L)? utTrue : utFalse;
+    } MUTEX_UNLOCK(&(pool->mutex))
+    return idle? 0 : 1;
+}
+
 // ----------------------------------------------------------------------------
 
 /* sleep for the specified amount of milliseconds */
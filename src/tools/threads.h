@@ -79,6 +79,62 @@ typedef struct
 #endif
 } threadCond_t;
 
+// ------------------------------------
+/* sequence lock structure */
+// Single writer, lock-free readers.  Readers copy the protected data, then retry
+// if a write occurred while they were copying.
+typedef struct 
+{
+    volatile UInt32         sequence;   // odd while a write is in progress
+} threadSeqLock_t;
+
+// ------------------------------------
+/* bounded work queue structure */
+// Multiple producers/consumers.  The item array is supplied by the caller.
+typedef struct 
+{
+    UInt32                  didInit;
+    threadMutex_t           mutex;
+    threadCond_t            notEmpty;
+    threadCond_t            notFull;
+    void                    **item;     // ring of 'size' entries
+    int                     size;
+    int                     head;       // index of next item to remove
+    int                     count;      // number of queued items
+    utBool                  closed;     // no more items will be added
+} threadQueue_t;
+
+// ------------------------------------
+/* thread pool task structure */
+// Owned by the caller, and must remain valid until it is done.
+typedef struct threadTask_struct
+{
+    void                    (*run)(void *arg);
+    void                    *arg;
+    void                    (*done)(struct threadTask_struct *task); // optional completion callback
+    volatile utBool         isDone;
+} threadTask_t;
+
+// ------------------------------------
+/* thread pool structure */
+#if !defined(THREAD_POOL_MAX_WORKERS)
+#  define THREAD_POOL_MAX_WORKERS   8
+#endif
+#if !defined(THREAD_POOL_QUEUE_SIZE)
+#  define THREAD_POOL_QUEUE_SIZE    64
+#endif
+typedef struct 
+{
+    UInt32                  didInit;
+    threadQueue_t           queue;
+    void                    *queueItem[THREAD_POOL_QUEUE_SIZE];
+    threadThread_t          worker[THREAD_POOL_MAX_WORKERS];
+    int                     workerCount;
+    threadMutex_t           mutex;      // guards 'pending' and task 'isDone'
+    threadCond_t            doneCond;
+    UInt32                  pending;    // tasks submitted, but not yet done
+} threadPool_t;
+
 // ----------------------------------------------------------------------------
 
 #define THREAD_SRC                  __FILE__,__LINE__
@@ -108,6 +164,9 @@ typedef struct
 /* get thread count */
 int threadGetCount();
 
+/* get number of online CPUs */
+int threadGetCPUCount();
+
 // ----------------------------------------------------------------------------
 
 /* create thread */
@@ -116,6 +175,12 @@ int threadCreate(threadThread_t *thread, void(*runnable)(void*), void *arg, cons
 /* exit thread */
 void threadExit();
 
+/* wait for thread to exit */
+int threadJoin(threadThread_t *thread);
+
+/* bind thread to the specified CPU */
+int threadSetAffinity(threadThread_t *thread, int cpu);
+
 /* add function to thread-stop list */
 utBool threadAddThreadStopFtn(void (*ftn)(void*), void *arg);
 
@@ -139,6 +204,45 @@ void threadConditionFree(threadCond_t *cond);
 int threadConditionWait(threadCond_t *cond, threadMutex_t *mutex);
 int threadConditionTimedWait(threadCond_t *cv, threadMutex_t *mutex, struct timespec *tm);
 int threadConditionNotify(threadCond_t *cond);
+int threadConditionNotifyAll(threadCond_t *cond);
+
+// ----------------------------------------------------------------------------
+
+/* sequence lock support */
+void threadSeqLockInit(threadSeqLock_t *seqLock);
+void threadSeqWriteBegin(threadSeqLock_t *seqLock);
+void threadSeqWriteEnd(threadSeqLock_t *seqLock);
+UInt32 threadSeqReadBegin(threadSeqLock_t *seqLock);
+utBool threadSeqReadRetry(threadSeqLock_t *seqLock, UInt32 seq);
+// do {
+//    seq = threadSeqReadBegin(&exampleSeq);
+//    memcpy(&data, &exampleData, sizeof(data));
+// } while (threadSeqReadRetry(&exampleSeq, seq));
+
+// ----------------------------------------------------------------------------
+
+/* bounded work queue support */
+// timeoutMS: <0 waits indefinitely, 0 does not wait
+int threadQueueInit(threadQueue_t *queue, void **item, int size);
+void threadQueueFree(threadQueue_t *queue);
+int threadQueuePut(threadQueue_t *queue, void *item, long timeoutMS);
+int threadQueueGet(threadQueue_t *queue, void **item, long timeoutMS);
+int threadQueueGetCount(threadQueue_t *queue);
+void threadQueueClose(threadQueue_t *queue);
+
+// ----------------------------------------------------------------------------
+
+/* thread pool support */
+void threadTaskInit(threadTask_t *task, void (*run)(void*), void *arg, void (*done)(threadTask_t*));
+int threadPoolInit(threadPool_t *pool, const char *name, int workers, int firstCPU);
+void threadPoolFree(threadPool_t *pool);
+int threadPoolSubmit(threadPool_t *pool, threadTask_t *task, long timeoutMS);
+int threadPoolWaitTask(threadPool_t *pool, threadTask_t *task, long timeoutMS);
+int threadPoolWaitIdle(threadPool_t *pool, long timeoutMS);
+// threadTaskInit(&task, &_exampleRun, exampleArg, 0);
+// if (threadPoolSubmit(&examplePool, &task, -1L) == 0) {
+//    threadPoolWaitTask(&examplePool, &task, -1L);
+// }
 
 // ----------------------------------------------------------------------------
 
@@ -59,6 +59,14 @@ static Int32 systemTimeOffet = 0L;
 /* system startup time */
 static UInt32 startupTime = 0L;
 
+/* virtual clock (GPS replay) */
+// When set, 'utcGetTimeSec'/'utcGetTimestamp' return the virtual time instead of the
+// system clock time.  The virtual time is advanced by the caller (ie. the GPS replay
+// reader), so timers and event timestamps follow the replayed data.
+static volatile utBool virtualTimeEnabled = utFalse;
+static struct timeval virtualTime = { 0L, 0L };
+static threadSeqLock_t virtualTimeSeqLock = { 0L };
+
 void utcMarkStartupTime()
 {
     // this could set time startup time to '0' (or near zero) if the system
@@ -154,6 +162,14 @@ static struct timeval *_utcGetTimestamp(struct timeval *tv)
 /* get a timestamp with millisecond resolution (adjusted for UTC time) */
 struct timeval *utcGetTimestamp(struct timeval *tv)
 {
+    if (tv && virtualTimeEnabled) {
+        UInt32 seq;
+        do {
+            seq = threadSeqReadBegin(&virtualTimeSeqLock);
+            tv->tv_sec  = virtualTime.tv_sec;
+            tv->tv_usec = virtualTime.tv_usec;
+        } while (threadSeqReadRetry(&virtualTimeSeqLock, seq));
+    } else
     if (tv) {
         _utcGetTimestamp(tv);
 #if !defined(ENABLE_SET_TIME)
@@ -223,6 +239,10 @@ static UInt32 _utcGetTimeSec()
 /* return current time in seconds (adjusted for UTC) */
 UInt32 utcGetTimeSec()
 {
+    if (virtualTimeEnabled) {
+        struct timeval tv;
+        return (UInt32)utcGetTimestamp(&tv)->tv_sec;
+    }
     UInt32 ts = _utcGetTimeSec();
 #if !defined(ENABLE_SET_TIME)
     ts = ts + systemTimeOffet;
@@ -246,6 +266,11 @@ utBool utcSetTimeSec(UInt32 utcSec)
     //   It shouldn't be set on every new GPS fix, but rather only when the current
     //   system clock has drifted beyond some acceptable tolarance (eg. 5 seconds).
 
+    /* the virtual clock is only changed by 'utcSetVirtualTime' */
+    if (virtualTimeEnabled) {
+        return utFalse;
+    }
+
     /* get the elapsed time since startup */
     UInt32 preAdjustedTime = utcGetTimeSec();
     UInt32 startupTimeDeltaSec = preAdjustedTime - startupTime;
@@ -302,6 +327,43 @@ utBool utcSetTimeSec(UInt32 utcSec)
 
 }
 
+// ----------------------------------------------------------------------------
+
+/* set (and enable) the virtual clock time */
+// Called by a single thread only (ie. the GPS replay reader).  The virtual time may only
+// move forward.  When first enabled, the startup time is adjusted so that existing timers
+// retain their current age.  The virtual time is always written through the seqlock, and
+// is enabled only after the first time has been published.
+void utcSetVirtualTime(UInt32 utcSec, UInt32 millis)
+{
+    utBool enable = !virtualTimeEnabled;
+    if (enable ||
+        (utcSec > (UInt32)virtualTime.tv_sec) || 
+        ((utcSec == (UInt32)virtualTime.tv_sec) && ((millis * 1000L) > (UInt32)virtualTime.tv_usec))) {
+        UInt32 startupTimeDeltaSec = enable? (utcGetTimeSec() - startupTime) : 0L;
+        threadSeqWriteBegin(&virtualTimeSeqLock);
+        virtualTime.tv_sec  = utcSec;
+        virtualTime.tv_usec = (millis % 1000L) * 1000L;
+        if (enable) {
+            startupTime = (utcSec > startupTimeDeltaSec)? (utcSec - startupTimeDeltaSec) : 0L;
+        }
+        threadSeqWriteEnd(&virtualTimeSeqLock);
+        if (enable) {
+            // 'threadSeqWriteEnd' is a full barrier, the time is visible before the flag
+            virtualTimeEnabled = utTrue;
+            char ts[32];
+            utcFormatDateTime(ts, utcSec);
+            logINFO(LOGSRC,"Virtual clock: %s UTC", ts);
+        }
+    }
+}
+
+/* return true if the virtual clock is in effect */
+utBool utcIsVirtualTime()
+{
+    return virtualTimeEnabled;
+}
+
 // ----------------------------------------------------------------------------
 // Timers:
 // These functions exist to eliminate the inaccuracy on the system clock
@@ -350,11 +412,13 @@ utBool utcIsTimerExpired(TimerSec_t timerSec, Int32 intervalSec)
 // ----------------------------------------------------------------------------
 
 /* get an absolute time 'offsetMS' milliseconds into the future */
+// The returned time is based on the unadjusted system clock, as required by
+// 'pthread_cond_timedwait' (ie. it is not affected by 'utcSetTimeSec' or the virtual clock).
 struct timespec *utcGetAbsoluteTimespec(struct timespec *ts, UInt32 offsetMS)
 {
     if (ts) {
         struct timeval tv;
-        utcGetTimestamp(&tv);
+        _utcGetTimestamp(&tv);
         ts->tv_sec  = tv.tv_sec;
         ts->tv_nsec = tv.tv_usec * 1000L;               // micro -> nano
         if (offsetMS >= 1000L) {                        // at least 1 second?
@@ -111,6 +111,9 @@ struct timeval *utcGetTimestampDelta(struct timeval *tv, Int32 deltaMS);
 
 struct timespec *utcGetAbsoluteTimespec(struct timespec *ts, UInt32 offsetMS);
 
+void utcSetVirtualTime(UInt32 utcSec, UInt32 millis);
+utBool utcIsVirtualTime();
+
 // ----------------------------------------------------------------------------
 
 #ifdef __cplusplus